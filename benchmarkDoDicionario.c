@@ -0,0 +1,1092 @@
+// ================================ DEFINIÇÕES DO SISTEMA ============================
+
+// Ativa as extensões POSIX/GNU (getopt, mkstemp, dup) antes de incluir qualquer biblioteca.
+#define _GNU_SOURCE
+
+// ================================ BIBLIOTECAS INCLUÍDAS ============================
+
+// Biblioteca personalizada para operações específicas do dicionário.
+#include "dicionario.h"
+
+// Biblioteca padrão do C para funções gerais, como alocação de memória.
+#include <stdlib.h>
+
+// Biblioteca padrão do C para entrada e saída de dados.
+#include <stdio.h>
+
+// Biblioteca padrão de strings do C.
+#include <string.h>
+
+// Biblioteca padrão do C para medir o tempo.
+#include <time.h>
+
+// Biblioteca POSIX para getopt, dup e unlink.
+#include <unistd.h>
+
+// ================================ CONSTANTES DO BENCHMARK ==========================
+
+// Tamanhos dos dicionários sintéticos medidos quando a opção -n não é dada.
+#define TAMANHOS_BENCHMARK "10000,100000,1000000,5000000"
+
+// Amostras por operação: no máximo MAX_AMOSTRAS_BENCHMARK, parando ao fim do tempo (opção -s) mas nunca antes de
+// MIN_AMOSTRAS_BENCHMARK.
+#define MAX_AMOSTRAS_BENCHMARK 100000
+#define MIN_AMOSTRAS_BENCHMARK 5
+#define SEGUNDOS_POR_OPERACAO 1.0
+
+// Palavras do texto gerado para a verificação ortográfica (uma em cada FRACAO_ERRADAS_TEXTO é desconhecida) e
+// repetições da verificação e do hash do ficheiro.
+#define PALAVRAS_TEXTO_BENCHMARK 1000000
+#define FRACAO_ERRADAS_TEXTO 10
+#define REPETICOES_FICHEIRO 3
+
+// Linhas alteradas no ficheiro do dicionário antes de cada recarga incremental.
+#define ALTERACOES_RECARGA 100
+
+// Inserções duráveis (cada uma espera pelo diário) medidas com uma thread, e threads que inserem ao mesmo tempo,
+// cada uma com ALTERACOES_DIARIO inserções, para medir o group commit.
+#define ALTERACOES_DIARIO 200
+#define THREADS_DIARIO 8
+
+// Caracteres do prefixo procurado e palavras visitadas, no máximo, por cada procura por prefixo.
+#define COMPRIMENTO_PREFIXO_BENCHMARK 3
+#define LIMITE_PREFIXO_BENCHMARK 100
+
+// Sugestões pedidas por cada autocompletar.
+#define SUGESTOES_BENCHMARK 10
+
+// Candidatas de cada lote medido pelo cálculo vetorizado da distância de edição e o limite usado.
+#define CANDIDATAS_LOTE_BENCHMARK 64
+#define LIMITE_LOTE_BENCHMARK 2
+
+// Versão do formato do JSON produzido (incrementar quando os campos mudarem de significado).
+#define FORMATO_BENCHMARK 1
+
+// ================================ ESTRUTURAS DO BENCHMARK ==========================
+
+// Struct que define uma lista de palavras terminadas em '\0', guardadas seguidas num só buffer.
+typedef struct
+{
+    char *texto;             // Palavras seguidas, cada uma terminada em '\0'.
+    size_t usado, capacidade;
+    FatiaPalavra *palavras;  // Fatias que apontam para o texto.
+    size_t total, capacidadePalavras;
+} ListaPalavras;
+
+// Struct que define um conjunto de dados medido: o dicionário e as palavras usadas nas operações.
+typedef struct
+{
+    char nome[FILENAME_MAX];
+    Dicionario *dicionario;
+    ListaPalavras existentes;   // Palavras do dicionário (consultas com sucesso).
+    ListaPalavras desconhecidas; // Palavras que não estão no dicionário (falhas, inserções e procuras aproximadas).
+    size_t palavras;            // Palavras distintas no dicionário.
+    double nsConstrucao;        // Tempo de construção por palavra.
+} ConjuntoBenchmark;
+
+// Tipo das operações medidas: executam uma vez a operação sobre uma palavra e devolvem quantos resultados produziu.
+typedef size_t (*OperacaoBenchmark)(Dicionario *dicionario, const char *palavra);
+
+// Estado do gerador pseudoaleatório (xorshift64*), fixo para que todas as execuções meçam as mesmas palavras.
+static uint64_t estadoAleatorio;
+
+// Segundos por operação (opção -s).
+static double segundosPorOperacao = SEGUNDOS_POR_OPERACAO;
+
+// Indica se a operação já escrita no JSON precisa de uma vírgula antes da próxima.
+static bool primeiraOperacao;
+
+// ================================ AUXILIARES ======================================
+
+// Devolve o tempo monotónico em nanossegundos.
+static uint64_t agoraNs(void)
+{
+    struct timespec instante;
+    clock_gettime(CLOCK_MONOTONIC, &instante);
+    return (uint64_t)instante.tv_sec * 1000000000u + (uint64_t)instante.tv_nsec;
+}
+
+// Devolve o próximo número do gerador pseudoaleatório.
+static uint64_t proximoAleatorio(void)
+{
+    estadoAleatorio ^= estadoAleatorio >> 12;
+    estadoAleatorio ^= estadoAleatorio << 25;
+    estadoAleatorio ^= estadoAleatorio >> 27;
+    return estadoAleatorio * 0x2545F4914F6CDD1DULL;
+}
+
+// Gera uma palavra sintética com entre 2 e 13 letras, escolhidas com uma frequência parecida com a de um texto real.
+static int gerarPalavra(char *palavra)
+{
+    static const char letras[] = "eeeeeeeeeeeetttttttttaaaaaaaaoooooooiiiiiiinnnnnnnsssssshhhhhhrrrrrrddddlllluuuc"
+                                 "ccmmmwwffggyyppbbvkjxqz";
+    uint64_t aleatorio = proximoAleatorio();
+    int comprimento = 2 + (int)(aleatorio % 6) + (int)((aleatorio >> 8) % 7);
+
+    for (int i = 0; i < comprimento; i++)
+        palavra[i] = letras[proximoAleatorio() % (sizeof(letras) - 1)];
+    palavra[comprimento] = '\0';
+    return comprimento;
+}
+
+// Acrescenta uma palavra a uma lista. Devolve falso se faltar memória.
+static bool acrescentarPalavra(ListaPalavras *lista, const char *palavra, size_t comprimento)
+{
+    if (lista->usado + comprimento + 1 > lista->capacidade)
+    {
+        size_t capacidade = lista->capacidade ? lista->capacidade * 2 : 1 << 16;
+        while (capacidade < lista->usado + comprimento + 1)
+            capacidade *= 2;
+        char *maior = (char *)realloc(lista->texto, capacidade);
+        if (maior == NULL)
+            return false;
+        lista->texto = maior;
+        lista->capacidade = capacidade;
+    }
+    if (lista->total == lista->capacidadePalavras)
+    {
+        size_t capacidade = lista->capacidadePalavras ? lista->capacidadePalavras * 2 : 4096;
+        FatiaPalavra *maiores = (FatiaPalavra *)realloc(lista->palavras, capacidade * sizeof(FatiaPalavra));
+        if (maiores == NULL)
+            return false;
+        lista->palavras = maiores;
+        lista->capacidadePalavras = capacidade;
+    }
+
+    memcpy(lista->texto + lista->usado, palavra, comprimento);
+    lista->texto[lista->usado + comprimento] = '\0';
+
+    // O texto pode mudar de sítio ao crescer: as fatias guardam deslocamentos até ao fim (ver fixarFatias).
+    lista->palavras[lista->total].inicio = (const char *)(uintptr_t)lista->usado;
+    lista->palavras[lista->total].comprimento = (int)comprimento;
+    lista->palavras[lista->total].peso = 0;
+    lista->usado += comprimento + 1;
+    lista->total++;
+    return true;
+}
+
+// Converte os deslocamentos guardados por acrescentarPalavra em ponteiros para o texto (depois da última palavra).
+static void fixarFatias(ListaPalavras *lista)
+{
+    for (size_t i = 0; i < lista->total; i++)
+        lista->palavras[i].inicio = lista->texto + (uintptr_t)lista->palavras[i].inicio;
+}
+
+// Liberta uma lista de palavras.
+static void libertarLista(ListaPalavras *lista)
+{
+    free(lista->texto);
+    free(lista->palavras);
+    memset(lista, 0, sizeof(ListaPalavras));
+}
+
+// Guarda cada palavra enumerada do dicionário numa lista (usado para os dicionários reais).
+static bool guardarPalavraEnumerada(const char *palavra, void *contexto)
+{
+    return acrescentarPalavra((ListaPalavras *)contexto, palavra, strlen(palavra));
+}
+
+// Conta as palavras de uma enumeração.
+static bool contarPalavra(const char *palavra, void *contexto)
+{
+    (void)palavra;
+    (*(size_t *)contexto)++;
+    return true;
+}
+
+// Conta as palavras de uma procura por prefixo até LIMITE_PREFIXO_BENCHMARK.
+static bool contarPalavraLimitada(const char *palavra, void *contexto)
+{
+    (void)palavra;
+    return ++*(size_t *)contexto < LIMITE_PREFIXO_BENCHMARK;
+}
+
+// Conta as palavras de uma procura por distância.
+static void contarPalavraDistancia(const char *palavra, int distancia, void *contexto)
+{
+    (void)palavra;
+    (void)distancia;
+    (*(size_t *)contexto)++;
+}
+
+// Conta as sugestões de um autocompletar.
+static void contarPalavraPeso(const char *palavra, uint32_t peso, void *contexto)
+{
+    (void)palavra;
+    (void)peso;
+    (*(size_t *)contexto)++;
+}
+
+// Compara dois tempos (para qsort).
+static int compararTempos(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Escreve um texto como string JSON.
+static void escreverTextoJson(FILE *saida, const char *texto)
+{
+    fputc('"', saida);
+    for (; *texto != '\0'; texto++)
+    {
+        if (*texto == '"' || *texto == '\\')
+            fprintf(saida, "\\%c", *texto);
+        else if ((unsigned char)*texto < 0x20)
+            fprintf(saida, "\\u%04x", *texto);
+        else
+            fputc(*texto, saida);
+    }
+    fputc('"', saida);
+}
+
+// ================================ OPERAÇÕES MEDIDAS ================================
+
+static size_t operacaoConsultar(Dicionario *dicionario, const char *palavra)
+{
+    return contemPalavra(dicionario, palavra);
+}
+
+// Consulta na Trie de ponteiros sem o filtro, descendo desde a raiz (todas as comparações do primeiro nível).
+static size_t operacaoConsultarRaiz(Dicionario *dicionario, const char *palavra)
+{
+    return consultarPalavraIterativo(dicionario->raiz, palavra);
+}
+
+// Consulta na Trie de ponteiros sem o filtro, começando no nó do primeiro caractere dado pela tabela da raiz.
+static size_t operacaoConsultarTabela(Dicionario *dicionario, const char *palavra)
+{
+    return consultarPalavraIterativo(dicionario->tabelaRaiz[(unsigned char)palavra[0]], palavra);
+}
+
+// Consulta no índice dobrado: a palavra é dobrada e a Trie das formas é percorrida uma vez.
+static size_t operacaoConsultarDobrada(Dicionario *dicionario, const char *palavra)
+{
+    return contemPalavraDobrada(dicionario, palavra, strlen(palavra));
+}
+
+static size_t operacaoInserir(Dicionario *dicionario, const char *palavra)
+{
+    inserirPalavra(dicionario, palavra);
+    return 1;
+}
+
+static size_t operacaoRemover(Dicionario *dicionario, const char *palavra)
+{
+    removerPalavra(dicionario, palavra);
+    return 1;
+}
+
+static size_t operacaoPrefixo(Dicionario *dicionario, const char *palavra)
+{
+    char prefixo[COMPRIMENTO_PREFIXO_BENCHMARK + 1];
+    size_t encontradas = 0;
+
+    snprintf(prefixo, sizeof(prefixo), "%s", palavra);
+    procurarPorPrefixo(dicionario, prefixo, contarPalavraLimitada, &encontradas);
+    return encontradas;
+}
+
+// Autocompleta o prefixo com os primeiros 'comprimento' caracteres da palavra (as SUGESTOES_BENCHMARK de maior peso).
+static size_t operacaoAutocompletar(Dicionario *dicionario, const char *palavra, int comprimento)
+{
+    char prefixo[MAX_TAMANHO_PALAVRA];
+    size_t encontradas = 0;
+
+    snprintf(prefixo, sizeof(prefixo), "%.*s", comprimento, palavra);
+    melhoresComPrefixo(dicionario, prefixo, SUGESTOES_BENCHMARK, contarPalavraPeso, &encontradas);
+    return encontradas;
+}
+
+static size_t operacaoAutocompletar1(Dicionario *dicionario, const char *palavra)
+{
+    return operacaoAutocompletar(dicionario, palavra, 1);
+}
+
+static size_t operacaoAutocompletar3(Dicionario *dicionario, const char *palavra)
+{
+    return operacaoAutocompletar(dicionario, palavra, 3);
+}
+
+static size_t operacaoPrefixoMaisLongo(Dicionario *dicionario, const char *palavra)
+{
+    char *prefixo = prefixoMaisLongo(dicionario, palavra);
+    size_t comprimento = prefixo != NULL ? strlen(prefixo) : 0;
+    free(prefixo);
+    return comprimento > 0;
+}
+
+static size_t operacaoDistancia(Dicionario *dicionario, const char *palavra, int distancia)
+{
+    size_t encontradas = 0;
+    procurarPorDistancia(dicionario, palavra, distancia, DISTANCIA_MAXIMA, contarPalavraDistancia, &encontradas);
+    return encontradas;
+}
+
+static size_t operacaoDistancia1(Dicionario *dicionario, const char *palavra)
+{
+    return operacaoDistancia(dicionario, palavra, 1);
+}
+
+static size_t operacaoDistancia2(Dicionario *dicionario, const char *palavra)
+{
+    return operacaoDistancia(dicionario, palavra, 2);
+}
+
+static size_t operacaoDistancia3(Dicionario *dicionario, const char *palavra)
+{
+    return operacaoDistancia(dicionario, palavra, 3);
+}
+
+// ================================ MEDIÇÃO =========================================
+
+// Escreve uma operação medida no JSON: média, percentis e resultados, por unidade ("operacao", "palavra", ...), e os
+// nós visitados por unidade segundo as estatísticas do dicionário.
+static void escreverOperacao(FILE *saida, const char *nome, const char *unidade, uint64_t *tempos, size_t amostras,
+                             double nsPorUnidade, size_t resultados, double nosPorUnidade)
+{
+    qsort(tempos, amostras, sizeof(uint64_t), compararTempos);
+
+    fprintf(saida, "%s\n        {\"operacao\": \"%s\", \"unidade\": \"%s\", \"amostras\": %zu, \"ns_por_op\": %.1f, "
+                   "\"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"max\": %llu, \"resultados\": %zu, "
+                   "\"nos_visitados_por_op\": %.1f}",
+            primeiraOperacao ? "" : ",", nome, unidade, amostras, nsPorUnidade,
+            (unsigned long long)tempos[amostras / 2], (unsigned long long)tempos[amostras * 9 / 10],
+            (unsigned long long)tempos[amostras * 99 / 100], (unsigned long long)tempos[amostras - 1], resultados,
+            nosPorUnidade);
+    primeiraOperacao = false;
+    fflush(saida);
+}
+
+// Mede uma operação sobre as palavras de uma lista (por ordem, dando a volta se preciso), uma chamada por amostra.
+// 'maximo' limita as amostras (0 para MAX_AMOSTRAS_BENCHMARK); se 'exato' for verdadeiro, o tempo não as limita.
+// Devolve as amostras medidas.
+static size_t medirOperacao(FILE *saida, const char *nome, ConjuntoBenchmark *conjunto, const ListaPalavras *lista,
+                            OperacaoBenchmark operacao, size_t maximo, bool exato)
+{
+    if (maximo == 0 || maximo > MAX_AMOSTRAS_BENCHMARK)
+        maximo = MAX_AMOSTRAS_BENCHMARK;
+    if (lista->total == 0)
+        return 0;
+
+    uint64_t *tempos = (uint64_t *)malloc(maximo * sizeof(uint64_t));
+    if (tempos == NULL)
+        return 0;
+
+    EstatisticasDicionario estatisticas;
+    reiniciarEstatisticasDicionario();
+
+    uint64_t limite = (uint64_t)(segundosPorOperacao * 1e9);
+    uint64_t inicio = agoraNs(), anterior = inicio;
+    size_t amostras = 0, resultados = 0;
+
+    // Cada amostra é cronometrada sozinha; a média usa o tempo total, que inclui a leitura do relógio.
+    while (amostras < maximo && (exato || amostras < MIN_AMOSTRAS_BENCHMARK || anterior - inicio < limite))
+    {
+        resultados += operacao(conjunto->dicionario, lista->palavras[amostras % lista->total].inicio);
+        uint64_t agora = agoraNs();
+        tempos[amostras++] = agora - anterior;
+        anterior = agora;
+    }
+
+    obterEstatisticasDicionario(&estatisticas);
+    escreverOperacao(saida, nome, "operacao", tempos, amostras, (double)(anterior - inicio) / (double)amostras,
+                     resultados, (double)estatisticas.nosVisitados / (double)amostras);
+    free(tempos);
+    return amostras;
+}
+
+// Gera um ficheiro de texto com palavras do dicionário e algumas desconhecidas, para a verificação ortográfica.
+// Devolve falso se o ficheiro não puder ser criado; 'nome' recebe o caminho.
+static bool gerarTextoVerificacao(const ConjuntoBenchmark *conjunto, char *nome, size_t tamanhoNome)
+{
+    snprintf(nome, tamanhoNome, "%s/benchmarkDoDicionarioXXXXXX", getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp");
+    int descritor = mkstemp(nome);
+    if (descritor < 0)
+        return false;
+
+    FILE *ficheiro = fdopen(descritor, "w");
+    if (ficheiro == NULL)
+    {
+        close(descritor);
+        unlink(nome);
+        return false;
+    }
+
+    for (size_t i = 0; i < PALAVRAS_TEXTO_BENCHMARK; i++)
+    {
+        const ListaPalavras *lista = (i % FRACAO_ERRADAS_TEXTO == 0 && conjunto->desconhecidas.total > 0)
+                                         ? &conjunto->desconhecidas
+                                         : &conjunto->existentes;
+        fputs(lista->palavras[proximoAleatorio() % lista->total].inicio, ficheiro);
+        fputc(i % 12 == 11 ? '\n' : ' ', ficheiro);
+    }
+
+    return fclose(ficheiro) == 0;
+}
+
+// Mede a verificação ortográfica em lote (por palavra) e o hash do ficheiro (por KiB) sobre um texto gerado.
+static void medirFicheiro(FILE *saida, ConjuntoBenchmark *conjunto)
+{
+    char nome[FILENAME_MAX];
+    uint64_t tempos[REPETICOES_FICHEIRO], total = 0;
+    EstatisticasDicionario estatisticas;
+    ResultadoVerificacao resultado = {0, 0, 0, 0, 0.0};
+    OpcoesVerificacao opcoes = {NULL, NULL, 0, 1, false, false};
+
+    if (conjunto->existentes.total == 0 || !gerarTextoVerificacao(conjunto, nome, sizeof(nome)))
+        return;
+
+    reiniciarEstatisticasDicionario();
+    for (int i = 0; i < REPETICOES_FICHEIRO; i++)
+    {
+        uint64_t inicio = agoraNs();
+        verificarOrtografiaEmLote(conjunto->dicionario, nome, &opcoes, &resultado);
+        uint64_t fim = agoraNs();
+        tempos[i] = resultado.palavras > 0 ? (fim - inicio) / resultado.palavras : 0;
+        total += fim - inicio;
+    }
+    obterEstatisticasDicionario(&estatisticas);
+    escreverOperacao(saida, "verificacao_ortografica", "palavra", tempos, REPETICOES_FICHEIRO,
+                     resultado.palavras > 0 ? (double)total / (double)(resultado.palavras * REPETICOES_FICHEIRO) : 0.0,
+                     resultado.erradas,
+                     resultado.palavras > 0 ? (double)estatisticas.nosVisitados / (double)(resultado.palavras * REPETICOES_FICHEIRO) : 0.0);
+
+    total = 0;
+    for (int i = 0; i < REPETICOES_FICHEIRO; i++)
+    {
+        uint64_t inicio = agoraNs();
+        free(gerarHashFicheiro(nome));
+        uint64_t fim = agoraNs();
+        tempos[i] = resultado.bytes > 0 ? (fim - inicio) * 1024 / resultado.bytes : 0;
+        total += fim - inicio;
+    }
+    escreverOperacao(saida, "hash_ficheiro", "kib", tempos, REPETICOES_FICHEIRO,
+                     resultado.bytes > 0 ? (double)total * 1024.0 / (double)(resultado.bytes * REPETICOES_FICHEIRO) : 0.0,
+                     resultado.bytes, 0.0);
+
+    unlink(nome);
+}
+
+// Mede a distância de edição limitada de cada palavra desconhecida a um lote de palavras do dicionário (por
+// candidata), pelo cálculo em lote (vetorizado quando há AVX2/SSE2) e pelo núcleo escalar, uma candidata de cada vez.
+static void medirDistanciaLote(FILE *saida, ConjuntoBenchmark *conjunto)
+{
+    const char *candidatas[CANDIDATAS_LOTE_BENCHMARK];
+    int comprimentos[CANDIDATAS_LOTE_BENCHMARK], distancias[CANDIDATAS_LOTE_BENCHMARK];
+    PadraoBitParalelo padrao;
+
+    if (conjunto->existentes.total == 0 || conjunto->desconhecidas.total == 0)
+        return;
+
+    uint64_t *tempos = (uint64_t *)malloc(MAX_AMOSTRAS_BENCHMARK * sizeof(uint64_t));
+    if (tempos == NULL)
+        return;
+
+    for (size_t i = 0; i < CANDIDATAS_LOTE_BENCHMARK; i++)
+    {
+        candidatas[i] = conjunto->existentes.palavras[proximoAleatorio() % conjunto->existentes.total].inicio;
+        comprimentos[i] = (int)strlen(candidatas[i]);
+    }
+
+    for (int vetorizado = 1; vetorizado >= 0; vetorizado--)
+    {
+        uint64_t limite = (uint64_t)(segundosPorOperacao * 1e9);
+        uint64_t inicio = agoraNs(), anterior = inicio;
+        size_t amostras = 0, resultados = 0;
+
+        while (amostras < MAX_AMOSTRAS_BENCHMARK && (amostras < MIN_AMOSTRAS_BENCHMARK || anterior - inicio < limite))
+        {
+            const char *palavra = conjunto->desconhecidas.palavras[amostras % conjunto->desconhecidas.total].inicio;
+            if (prepararPadraoBitParalelo(&padrao, palavra, (int)strlen(palavra)))
+            {
+                if (vetorizado)
+                    distanciaEdicaoLote(&padrao, candidatas, comprimentos, CANDIDATAS_LOTE_BENCHMARK,
+                                        LIMITE_LOTE_BENCHMARK, distancias);
+                else
+                    for (size_t i = 0; i < CANDIDATAS_LOTE_BENCHMARK; i++)
+                        distancias[i] = distanciaEdicaoLimitada(&padrao, candidatas[i], comprimentos[i],
+                                                                LIMITE_LOTE_BENCHMARK);
+                for (size_t i = 0; i < CANDIDATAS_LOTE_BENCHMARK; i++)
+                    resultados += distancias[i] <= LIMITE_LOTE_BENCHMARK;
+            }
+            uint64_t agora = agoraNs();
+            tempos[amostras++] = (agora - anterior) / CANDIDATAS_LOTE_BENCHMARK;
+            anterior = agora;
+        }
+
+        escreverOperacao(saida, vetorizado ? "distancia_lote" : "distancia_lote_escalar", "candidata", tempos, amostras,
+                         (double)(anterior - inicio) / (double)(amostras * CANDIDATAS_LOTE_BENCHMARK), resultados, 0.0);
+    }
+
+    free(tempos);
+}
+
+// Escreve as linhas de um dicionário (uma palavra por linha) num ficheiro. Devolve falso se não for possível.
+static bool escreverLinhas(const char *nome, const char *const *linhas, size_t total)
+{
+    FILE *ficheiro = fopen(nome, "w");
+    if (ficheiro == NULL)
+        return false;
+
+    for (size_t i = 0; i < total; i++)
+    {
+        fputs(linhas[i], ficheiro);
+        fputc('\n', ficheiro);
+    }
+    return fclose(ficheiro) == 0;
+}
+
+// Mede a recarga incremental: o dicionário é escrito num ficheiro e carregado num dicionário à parte; antes de cada
+// recarga, ALTERACOES_RECARGA linhas passam a ter palavras desconhecidas (o tempo de escrita não é medido).
+static void medirRecarga(FILE *saida, ConjuntoBenchmark *conjunto)
+{
+    char nome[FILENAME_MAX];
+    uint64_t tempos[REPETICOES_FICHEIRO], total = 0;
+    ResultadoRecarga resultado;
+    size_t alteradas = 0;
+
+    size_t totalLinhas = conjunto->existentes.total;
+    if (totalLinhas == 0 || conjunto->desconhecidas.total == 0)
+        return;
+
+    snprintf(nome, sizeof(nome), "%s/benchmarkDoDicionarioXXXXXX", getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp");
+    int descritor = mkstemp(nome);
+    if (descritor < 0)
+        return;
+    close(descritor);
+
+    const char **linhas = (const char **)malloc(totalLinhas * sizeof(const char *));
+    Dicionario *dicionario = inicializarDicionario();
+    if (linhas == NULL || dicionario == NULL)
+    {
+        free(linhas);
+        destruirDicionario(dicionario);
+        unlink(nome);
+        return;
+    }
+    for (size_t i = 0; i < totalLinhas; i++)
+        linhas[i] = conjunto->existentes.palavras[i].inicio;
+
+    // A primeira recarga guarda a cópia do ficheiro com que as seguintes são comparadas.
+    bool preparado = escreverLinhas(nome, linhas, totalLinhas) && carregarFicheiroMapeado(dicionario, nome, NULL) &&
+                     recarregarFicheiro(dicionario, nome, &resultado);
+
+    for (int i = 0; preparado && i < REPETICOES_FICHEIRO; i++)
+    {
+        for (int j = 0; j < ALTERACOES_RECARGA; j++)
+        {
+            linhas[proximoAleatorio() % totalLinhas] =
+                conjunto->desconhecidas.palavras[(size_t)(i * ALTERACOES_RECARGA + j) % conjunto->desconhecidas.total].inicio;
+        }
+        if (!escreverLinhas(nome, linhas, totalLinhas))
+            break;
+
+        uint64_t inicio = agoraNs();
+        recarregarFicheiro(dicionario, nome, &resultado);
+        uint64_t fim = agoraNs();
+        tempos[i] = fim - inicio;
+        total += fim - inicio;
+        alteradas += resultado.inseridas + resultado.removidas + resultado.pesosAlterados;
+
+        if (i == REPETICOES_FICHEIRO - 1)
+            escreverOperacao(saida, "recarga_incremental", "recarga", tempos, REPETICOES_FICHEIRO,
+                             (double)total / REPETICOES_FICHEIRO, alteradas, 0.0);
+    }
+
+    free(linhas);
+    destruirDicionario(dicionario);
+    unlink(nome);
+}
+
+// Mede a compactação da Trie sobre um dicionário próprio: as palavras são inseridas uma a uma, pela ordem aleatória
+// da lista, e três em cada quatro são removidas antes de compactar. As consultas às que ficaram são medidas antes e
+// depois, e cada fatia da compactação é cronometrada sozinha.
+static bool medirCompactacao(FILE *saida, ConjuntoBenchmark *conjunto, ResultadoCompactacao *resultado)
+{
+    ConjuntoBenchmark compactado = *conjunto;
+    ListaPalavras restantes = {NULL, 0, 0, NULL, 0, 0};
+    CompactacaoTrie compactacao;
+    size_t total = conjunto->existentes.total, amostras = 0, capacidade = 64;
+
+    if (total == 0)
+        return false;
+
+    compactado.dicionario = inicializarDicionario();
+    restantes.palavras = (FatiaPalavra *)malloc((total / 4 + 1) * sizeof(FatiaPalavra));
+    uint64_t *tempos = (uint64_t *)malloc(capacidade * sizeof(uint64_t));
+    if (compactado.dicionario == NULL || restantes.palavras == NULL || tempos == NULL)
+    {
+        destruirDicionario(compactado.dicionario);
+        free(restantes.palavras);
+        free(tempos);
+        return false;
+    }
+
+    for (size_t i = 0; i < total; i++)
+        inserirPalavra(compactado.dicionario, conjunto->existentes.palavras[i].inicio);
+    for (size_t i = 0; i < total; i++)
+    {
+        if (i % 4 == 0)
+            restantes.palavras[restantes.total++] = conjunto->existentes.palavras[i];
+        else
+            removerPalavra(compactado.dicionario, conjunto->existentes.palavras[i].inicio);
+    }
+
+    medirOperacao(saida, "consulta_antes_compactacao", &compactado, &restantes, operacaoConsultar, 0, false);
+
+    bool iniciada = iniciarCompactacaoTrie(compactado.dicionario, &compactacao);
+    uint64_t inicio = agoraNs(), anterior = inicio;
+    for (bool terminada = !iniciada; !terminada;)
+    {
+        terminada = avancarCompactacaoTrie(compactado.dicionario, &compactacao, NOS_POR_FATIA_COMPACTACAO);
+        uint64_t agora = agoraNs();
+
+        if (amostras == capacidade)
+        {
+            uint64_t *maior = (uint64_t *)realloc(tempos, 2 * capacidade * sizeof(uint64_t));
+            if (maior == NULL)
+            {
+                cancelarCompactacaoTrie(&compactacao);
+                compactacao.resultado.falhou = true;
+                break;
+            }
+            tempos = maior;
+            capacidade *= 2;
+        }
+        tempos[amostras++] = agora - anterior;
+        anterior = agora;
+    }
+
+    bool concluida = iniciada && !compactacao.resultado.falhou;
+    if (concluida)
+    {
+        *resultado = compactacao.resultado;
+        escreverOperacao(saida, "compactacao_fatia", "fatia", tempos, amostras,
+                         (double)(anterior - inicio) / (double)amostras, resultado->nosPodados, 0.0);
+        medirOperacao(saida, "consulta_depois_compactacao", &compactado, &restantes, operacaoConsultar, 0, false);
+    }
+
+    free(tempos);
+    free(restantes.palavras);
+    destruirDicionario(compactado.dicionario);
+    return concluida;
+}
+
+// Struct auxiliar com o trabalho de uma thread da medição do diário.
+typedef struct
+{
+    Dicionario *dicionario;
+    const ListaPalavras *palavras;
+    size_t inicio;     // Primeira palavra inserida pela thread.
+    uint64_t duracao;  // Tempo das ALTERACOES_DIARIO inserções (ns).
+} TrabalhoDiario;
+
+// Insere ALTERACOES_DIARIO palavras, esperando por cada uma no diário.
+static void *inserirDuraveis(void *argumento)
+{
+    TrabalhoDiario *trabalho = (TrabalhoDiario *)argumento;
+
+    uint64_t inicio = agoraNs();
+    for (size_t i = 0; i < ALTERACOES_DIARIO; i++)
+        inserirPalavraDuravel(trabalho->dicionario,
+                              trabalho->palavras->palavras[(trabalho->inicio + i) % trabalho->palavras->total].inicio);
+    trabalho->duracao = agoraNs() - inicio;
+    return NULL;
+}
+
+// Mede as inserções duráveis num dicionário à parte, com o diário de um ficheiro temporário: primeiro uma thread (um
+// fdatasync por inserção), depois THREADS_DIARIO threads no modo concorrente, que partilham as sincronizações.
+static void medirDiario(FILE *saida, ConjuntoBenchmark *conjunto)
+{
+    char nome[FILENAME_MAX], nomeDiario[FILENAME_MAX + sizeof(EXTENSAO_DIARIO)];
+    uint64_t tempos[ALTERACOES_DIARIO], total = 0;
+    TrabalhoDiario trabalhos[THREADS_DIARIO];
+    pthread_t threads[THREADS_DIARIO];
+    EstatisticasDiario estatisticas;
+
+    if (conjunto->desconhecidas.total == 0)
+        return;
+
+    snprintf(nome, sizeof(nome), "%s/benchmarkDoDicionarioXXXXXX", getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp");
+    int descritor = mkstemp(nome);
+    if (descritor < 0)
+        return;
+    close(descritor);
+    snprintf(nomeDiario, sizeof(nomeDiario), "%s%s", nome, EXTENSAO_DIARIO);
+
+    Dicionario *dicionario = inicializarDicionario();
+    if (dicionario == NULL || !abrirDiarioAlteracoes(dicionario, nome, NULL))
+    {
+        destruirDicionario(dicionario);
+        unlink(nome);
+        return;
+    }
+
+    for (size_t i = 0; i < ALTERACOES_DIARIO; i++)
+    {
+        uint64_t inicio = agoraNs();
+        inserirPalavraDuravel(dicionario, conjunto->desconhecidas.palavras[i % conjunto->desconhecidas.total].inicio);
+        tempos[i] = agoraNs() - inicio;
+        total += tempos[i];
+    }
+    consultarDiarioAlteracoes(dicionario, &estatisticas);
+    escreverOperacao(saida, "insercao_duravel", "op", tempos, ALTERACOES_DIARIO, (double)total / ALTERACOES_DIARIO,
+                     estatisticas.sincronizacoes, 0.0);
+
+    // Com várias threads, o tempo por inserção é o tempo total a dividir por todas as inserções; 'resultados' conta
+    // as sincronizações que elas precisaram.
+    size_t sincronizacoes = estatisticas.sincronizacoes, lancadas = 0;
+    if (ligarModoConcorrente(dicionario))
+    {
+        uint64_t inicio = agoraNs();
+        for (; lancadas < THREADS_DIARIO; lancadas++)
+        {
+            trabalhos[lancadas] = (TrabalhoDiario){dicionario, &conjunto->desconhecidas,
+                                                   (lancadas + 1) * ALTERACOES_DIARIO, 0};
+            if (pthread_create(&threads[lancadas], NULL, inserirDuraveis, &trabalhos[lancadas]) != 0)
+                break;
+        }
+        for (size_t i = 0; i < lancadas; i++)
+        {
+            pthread_join(threads[i], NULL);
+            tempos[i] = trabalhos[i].duracao / ALTERACOES_DIARIO;
+        }
+        uint64_t duracao = agoraNs() - inicio;
+        consultarDiarioAlteracoes(dicionario, &estatisticas);
+        if (lancadas > 0)
+            escreverOperacao(saida, "insercao_duravel_concorrente", "op", tempos, lancadas,
+                             (double)duracao / (double)(lancadas * ALTERACOES_DIARIO),
+                             estatisticas.sincronizacoes - sincronizacoes, 0.0);
+    }
+
+    destruirDicionario(dicionario);
+    unlink(nomeDiario);
+    unlink(nome);
+}
+
+// Gera as palavras desconhecidas de um conjunto: palavras sintéticas que o dicionário não contém.
+static void gerarDesconhecidas(ConjuntoBenchmark *conjunto, size_t total)
+{
+    char palavra[MAX_TAMANHO_PALAVRA];
+
+    for (size_t tentativas = 0; conjunto->desconhecidas.total < total && tentativas < 20 * total; tentativas++)
+    {
+        int comprimento = gerarPalavra(palavra);
+        if (!contemPalavra(conjunto->dicionario, palavra))
+            acrescentarPalavra(&conjunto->desconhecidas, palavra, (size_t)comprimento);
+    }
+    fixarFatias(&conjunto->desconhecidas);
+}
+
+// Bytes por palavra dos nós (e pesos) de um layout compacto.
+static double bytesPorPalavraCompacta(const TSTCompacta *compacta, const ConjuntoBenchmark *conjunto)
+{
+    return (double)(compacta->totalNos * (sizeof(NoCompacto) + (compacta->pesos != NULL ? sizeof(uint32_t) : 0))) /
+           (double)(conjunto->palavras ? conjunto->palavras : 1);
+}
+
+// Mede todas as operações de um conjunto e escreve-o no JSON.
+static void medirConjunto(FILE *saida, ConjuntoBenchmark *conjunto, bool primeiro)
+{
+    Dicionario *dicionario = conjunto->dicionario;
+
+    size_t amostras = conjunto->palavras < MAX_AMOSTRAS_BENCHMARK ? conjunto->palavras : MAX_AMOSTRAS_BENCHMARK;
+    gerarDesconhecidas(conjunto, amostras);
+
+    fprintf(saida, "%s\n    {\"conjunto\": ", primeiro ? "" : ",");
+    escreverTextoJson(saida, conjunto->nome);
+    fprintf(saida, ", \"palavras\": %zu, \"ns_construcao_por_palavra\": %.1f,\n", conjunto->palavras,
+            conjunto->nsConstrucao);
+    fprintf(saida, "      \"nos\": %zu, \"bytes_por_no\": %zu, \"bytes_por_palavra\": %.1f, \"bytes_arena\": %zu, "
+                   "\"bytes_filtro\": %zu,\n",
+            dicionario->arena.nosEmUso, sizeof(NoTST),
+            (double)(dicionario->arena.nosEmUso * sizeof(NoTST)) / (double)(conjunto->palavras ? conjunto->palavras : 1),
+            dicionario->arena.totalBlocos * sizeof(BlocoArena),
+            dicionario->filtro != NULL ? (size_t)dicionario->filtro->totalBlocos * PALAVRAS_POR_BLOCO_FILTRO * sizeof(uint64_t) : 0);
+    fprintf(saida, "      \"operacoes\": [");
+    primeiraOperacao = true;
+
+    medirOperacao(saida, "consulta_existente", conjunto, &conjunto->existentes, operacaoConsultar, 0, false);
+    medirOperacao(saida, "consulta_inexistente", conjunto, &conjunto->desconhecidas, operacaoConsultar, 0, false);
+    medirOperacao(saida, "consulta_existente_raiz", conjunto, &conjunto->existentes, operacaoConsultarRaiz, 0, false);
+    medirOperacao(saida, "consulta_existente_tabela", conjunto, &conjunto->existentes, operacaoConsultarTabela, 0, false);
+    medirOperacao(saida, "consulta_inexistente_raiz", conjunto, &conjunto->desconhecidas, operacaoConsultarRaiz, 0,
+                  false);
+    medirOperacao(saida, "consulta_inexistente_tabela", conjunto, &conjunto->desconhecidas, operacaoConsultarTabela, 0,
+                  false);
+
+    // O índice dobrado só é medido nas consultas: é desligado antes das inserções, que também o atualizariam.
+    size_t formasDobradas = 0;
+    uint64_t inicioDobrado = agoraNs();
+    bool dobrado = construirIndiceDobrado(dicionario);
+    double nsDobrado = (double)(agoraNs() - inicioDobrado) / (double)(conjunto->palavras ? conjunto->palavras : 1);
+    if (dobrado)
+    {
+        formasDobradas = dicionario->dobrado->totalFormas;
+        medirOperacao(saida, "consulta_existente_dobrada", conjunto, &conjunto->existentes, operacaoConsultarDobrada, 0,
+                      false);
+        medirOperacao(saida, "consulta_inexistente_dobrada", conjunto, &conjunto->desconhecidas,
+                      operacaoConsultarDobrada, 0, false);
+        desligarIndiceDobrado(dicionario);
+    }
+
+    // As palavras inseridas são removidas a seguir, para que as operações seguintes vejam o dicionário original.
+    size_t inseridas = medirOperacao(saida, "insercao", conjunto, &conjunto->desconhecidas, operacaoInserir,
+                                     conjunto->desconhecidas.total, false);
+    medirOperacao(saida, "remocao", conjunto, &conjunto->desconhecidas, operacaoRemover, inseridas, true);
+
+    // As remoções deixam os bits das palavras no filtro de Bloom, que passaria a deixar passar as mesmas palavras
+    // desconhecidas usadas a seguir.
+    if (dicionario->filtro != NULL)
+        construirFiltroDicionario(dicionario);
+
+    medirOperacao(saida, "prefixo", conjunto, &conjunto->existentes, operacaoPrefixo, 0, false);
+    medirOperacao(saida, "autocompletar_1", conjunto, &conjunto->existentes, operacaoAutocompletar1, 0, false);
+    medirOperacao(saida, "autocompletar_3", conjunto, &conjunto->existentes, operacaoAutocompletar3, 0, false);
+    medirOperacao(saida, "prefixo_mais_longo", conjunto, &conjunto->desconhecidas, operacaoPrefixoMaisLongo, 0, false);
+    medirOperacao(saida, "distancia_1", conjunto, &conjunto->desconhecidas, operacaoDistancia1, 0, false);
+    medirOperacao(saida, "distancia_2", conjunto, &conjunto->desconhecidas, operacaoDistancia2, 0, false);
+    medirOperacao(saida, "distancia_3", conjunto, &conjunto->desconhecidas, operacaoDistancia3, 0, false);
+    medirDistanciaLote(saida, conjunto);
+    medirFicheiro(saida, conjunto);
+    medirRecarga(saida, conjunto);
+    medirDiario(saida, conjunto);
+    ResultadoCompactacao compactacao;
+    bool compactada = medirCompactacao(saida, conjunto, &compactacao);
+
+    // O layout compacto (só de leitura) é medido no fim, com as consultas outra vez.
+    bool congelado = congelarDicionario(dicionario);
+    uint32_t nosCompactos = 0;
+    double bytesCompactos = 0.0;
+    bool minimizado = false;
+    if (congelado)
+    {
+        medirOperacao(saida, "consulta_existente_compacta", conjunto, &conjunto->existentes, operacaoConsultar, 0, false);
+        medirOperacao(saida, "consulta_inexistente_compacta", conjunto, &conjunto->desconhecidas, operacaoConsultar, 0,
+                      false);
+        medirOperacao(saida, "autocompletar_1_compacta", conjunto, &conjunto->existentes, operacaoAutocompletar1, 0,
+                      false);
+        nosCompactos = dicionario->compacta->totalNos - 1;
+        bytesCompactos = bytesPorPalavraCompacta(dicionario->compacta, conjunto);
+
+        // O layout minimizado (sufixos iguais partilhados) é medido com as mesmas operações e a procura aproximada.
+        minimizado = congelarDicionarioMinimizado(dicionario);
+        if (minimizado)
+        {
+            medirOperacao(saida, "consulta_existente_minimizada", conjunto, &conjunto->existentes, operacaoConsultar, 0,
+                          false);
+            medirOperacao(saida, "consulta_inexistente_minimizada", conjunto, &conjunto->desconhecidas, operacaoConsultar,
+                          0, false);
+            medirOperacao(saida, "autocompletar_1_minimizada", conjunto, &conjunto->existentes, operacaoAutocompletar1, 0,
+                          false);
+            medirOperacao(saida, "distancia_1_minimizada", conjunto, &conjunto->desconhecidas, operacaoDistancia1, 0,
+                          false);
+        }
+    }
+
+    fprintf(saida, "\n      ]");
+    if (dobrado)
+        fprintf(saida, ",\n      \"formas_dobradas\": %zu, \"ns_indice_dobrado_por_palavra\": %.1f", formasDobradas,
+                nsDobrado);
+    if (compactada)
+        fprintf(saida, ",\n      \"compactacao\": {\"nos_antes\": %zu, \"nos_depois\": %zu, \"nos_podados\": %zu, "
+                       "\"niveis_reequilibrados\": %zu, \"bytes_recuperados\": %zu, \"profundidade_antes\": %.2f, "
+                       "\"profundidade_depois\": %.2f, \"profundidade_maxima_antes\": %u, "
+                       "\"profundidade_maxima_depois\": %u}",
+                compactacao.nosAntes, compactacao.nosDepois, compactacao.nosPodados, compactacao.niveisReequilibrados,
+                compactacao.bytesAntes > compactacao.bytesDepois ? compactacao.bytesAntes - compactacao.bytesDepois : 0,
+                compactacao.profundidadeAntes, compactacao.profundidadeDepois, compactacao.profundidadeMaximaAntes,
+                compactacao.profundidadeMaximaDepois);
+    if (congelado)
+        fprintf(saida, ",\n      \"nos_compactos\": %u, \"bytes_por_no_compacto\": %zu, "
+                       "\"bytes_por_palavra_compacto\": %.1f",
+                nosCompactos, sizeof(NoCompacto), bytesCompactos);
+    if (minimizado)
+        fprintf(saida, ",\n      \"nos_minimizados\": %u, \"bytes_por_palavra_minimizado\": %.1f",
+                dicionario->compacta->totalNos - 1, bytesPorPalavraCompacta(dicionario->compacta, conjunto));
+    fprintf(saida, "}");
+    fflush(saida);
+}
+
+// Constrói um dicionário sintético com 'total' palavras geradas (podem repetir-se; contam só as distintas).
+static bool prepararSintetico(ConjuntoBenchmark *conjunto, size_t total)
+{
+    char palavra[MAX_TAMANHO_PALAVRA];
+
+    snprintf(conjunto->nome, sizeof(conjunto->nome), "sintetico-%zu", total);
+    estadoAleatorio = 0x9E3779B97F4A7C15ULL ^ total;
+
+    for (size_t i = 0; i < total; i++)
+    {
+        int comprimento = gerarPalavra(palavra);
+        if (!acrescentarPalavra(&conjunto->existentes, palavra, (size_t)comprimento))
+            return false;
+    }
+    fixarFatias(&conjunto->existentes);
+
+    // inserirPalavrasEmLote ordena as fatias que recebe; as da lista ficam pela ordem aleatória para as consultas.
+    FatiaPalavra *fatias = (FatiaPalavra *)malloc(total * sizeof(FatiaPalavra));
+    if (fatias == NULL)
+        return false;
+    memcpy(fatias, conjunto->existentes.palavras, total * sizeof(FatiaPalavra));
+
+    // Pesos com distribuição log-uniforme (como as frequências de um texto: poucas palavras muito frequentes).
+    for (size_t i = 0; i < total; i++)
+        fatias[i].peso = (uint32_t)(proximoAleatorio() >> 32) >> (proximoAleatorio() % 32);
+
+    uint64_t inicio = agoraNs();
+    if (!inserirPalavrasEmLote(conjunto->dicionario, fatias, total))
+    {
+        free(fatias);
+        return false;
+    }
+    construirFiltroDicionario(conjunto->dicionario);
+    conjunto->nsConstrucao = (double)(agoraNs() - inicio) / (double)total;
+    free(fatias);
+
+    procurarPorPrefixo(conjunto->dicionario, "", contarPalavra, &conjunto->palavras);
+    return true;
+}
+
+// Carrega um dicionário real (uma palavra por linha) como a aplicação o carrega.
+static bool prepararFicheiro(ConjuntoBenchmark *conjunto, const char *nomeFicheiro)
+{
+    snprintf(conjunto->nome, sizeof(conjunto->nome), "%s", nomeFicheiro);
+    estadoAleatorio = 0x9E3779B97F4A7C15ULL;
+
+    uint64_t inicio = agoraNs();
+    if (!carregarFicheiroMapeado(conjunto->dicionario, nomeFicheiro, NULL))
+        return false;
+    construirFiltroDicionario(conjunto->dicionario);
+    uint64_t fim = agoraNs();
+
+    procurarPorPrefixo(conjunto->dicionario, "", guardarPalavraEnumerada, &conjunto->existentes);
+    fixarFatias(&conjunto->existentes);
+    conjunto->palavras = conjunto->existentes.total;
+    conjunto->nsConstrucao = (double)(fim - inicio) / (double)(conjunto->palavras ? conjunto->palavras : 1);
+
+    // Baralhar as palavras, para que as consultas não sigam a ordem alfabética da Trie.
+    for (size_t i = conjunto->existentes.total; i > 1; i--)
+    {
+        size_t j = proximoAleatorio() % i;
+        FatiaPalavra troca = conjunto->existentes.palavras[i - 1];
+        conjunto->existentes.palavras[i - 1] = conjunto->existentes.palavras[j];
+        conjunto->existentes.palavras[j] = troca;
+    }
+    return true;
+}
+
+// Prepara, mede e liberta um conjunto (sintético se 'nomeFicheiro' for NULL).
+static bool executarConjunto(FILE *saida, size_t total, const char *nomeFicheiro, bool primeiro)
+{
+    ConjuntoBenchmark conjunto;
+    memset(&conjunto, 0, sizeof(conjunto));
+
+    conjunto.dicionario = inicializarDicionario();
+    if (conjunto.dicionario == NULL)
+        return false;
+
+    fprintf(stderr, "A medir %s...\n", nomeFicheiro != NULL ? nomeFicheiro : "dicionário sintético");
+    bool preparado = nomeFicheiro != NULL ? prepararFicheiro(&conjunto, nomeFicheiro) : prepararSintetico(&conjunto, total);
+    if (preparado && conjunto.palavras > 0)
+        medirConjunto(saida, &conjunto, primeiro);
+    else
+        fprintf(stderr, "Não foi possível preparar %s.\n", conjunto.nome);
+
+    destruirDicionario(conjunto.dicionario);
+    libertarLista(&conjunto.existentes);
+    libertarLista(&conjunto.desconhecidas);
+    return preparado && conjunto.palavras > 0;
+}
+
+// Mede o custo de uma leitura do relógio, incluído em cada amostra.
+static double medirCustoRelogio(void)
+{
+    uint64_t inicio = agoraNs(), ultimo = inicio;
+    for (int i = 0; i < 100000; i++)
+        ultimo = agoraNs();
+    return (double)(ultimo - inicio) / 100000.0;
+}
+
+// ================================ MAIN ============================================
+
+// Uso: benchmarkDoDicionario [-n tamanhos] [-s segundos] [-o resultados.json] [dicionario.txt ...]
+// Mede cada operação pública do dicionário em dicionários sintéticos (10k a 5M palavras por omissão) e nos ficheiros
+// dados, e escreve os resultados em JSON (no stdout, se -o não for dado).
+int main(int argc, char **argv)
+{
+    const char *tamanhos = TAMANHOS_BENCHMARK;
+    const char *nomeSaida = NULL;
+    int opcao;
+
+    while ((opcao = getopt(argc, argv, "n:s:o:h")) != -1)
+    {
+        switch (opcao)
+        {
+        case 'n':
+            tamanhos = optarg;
+            break;
+        case 's':
+            segundosPorOperacao = atof(optarg);
+            break;
+        case 'o':
+            nomeSaida = optarg;
+            break;
+        default:
+            fprintf(stderr, "Uso: %s [-n tamanhos] [-s segundos] [-o resultados.json] [dicionario.txt ...]\n", argv[0]);
+            return opcao == 'h' ? 0 : 2;
+        }
+    }
+
+    // A biblioteca escreve mensagens no stdout; com o JSON no stdout, elas passam para o stderr.
+    FILE *saida;
+    fflush(stdout);
+    if (nomeSaida != NULL)
+        saida = fopen(nomeSaida, "w");
+    else
+    {
+        saida = fdopen(dup(STDOUT_FILENO), "w");
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+    }
+    if (saida == NULL)
+    {
+        perror("Erro ao abrir a saída do benchmark");
+        return 1;
+    }
+
+    char data[32];
+    time_t agora = time(NULL);
+    strftime(data, sizeof(data), "%Y-%m-%dT%H:%M:%SZ", gmtime(&agora));
+    fprintf(saida, "{\"formato\": %d, \"data\": \"%s\", \"compilador\": ", FORMATO_BENCHMARK, data);
+    escreverTextoJson(saida, __VERSION__);
+    fprintf(saida, ", \"processadores\": %ld, \"segundos_por_operacao\": %.2f, \"custo_relogio_ns\": %.1f,\n"
+                   "  \"conjuntos\": [",
+            sysconf(_SC_NPROCESSORS_ONLN), segundosPorOperacao, medirCustoRelogio());
+
+    bool primeiro = true, sucesso = true;
+    for (const char *tamanho = tamanhos; *tamanho != '\0';)
+    {
+        char *fim;
+        unsigned long long total = strtoull(tamanho, &fim, 10);
+        if (fim == tamanho)
+            break;
+        if (total > 0)
+        {
+            bool medido = executarConjunto(saida, (size_t)total, NULL, primeiro);
+            sucesso &= medido;
+            primeiro = primeiro && !medido;
+        }
+        tamanho = *fim == ',' ? fim + 1 : fim;
+    }
+    for (int i = optind; i < argc; i++)
+    {
+        bool medido = executarConjunto(saida, 0, argv[i], primeiro);
+        sucesso &= medido;
+        primeiro = primeiro && !medido;
+    }
+
+    fprintf(saida, "\n  ]}\n");
+    fclose(saida);
+    return sucesso ? 0 : 1;
+}
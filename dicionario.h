@@ -1,139 +1,1256 @@
-// ================================ GUARDA DE INCLUSÃO ================================
-// A guarda de inclusão evita problemas de inclusões múltiplas de um mesmo arquivo.
-#ifndef DICIONARIO_H
-#define DICIONARIO_H
-
-// ================================ CONSTANTES ============================
-
-// Essa constante representa o tamanho máximo que uma palavra do dicionário pode ter.
-#define MAX_TAMANHO_PALAVRA 100
-
-// ================================ BIBLIOTECAS INCLUÍDAS ============================
-
-// Biblioteca para o uso do tipo bool.
-#include <stdbool.h>
-
-// Biblioteca padrão do C para entrada e saída de dados.
-#include <stdio.h>
-
-// ================================== ESTRUTURAS =====================================
-
-// Struct que define um nó na árvore Ternary Search Trie (TST).
-typedef struct no_tst
-{
-    char caractere;                             // Caractere armazenado no nó.
-    bool fim_palavra;                           // Flag para marcar o fim de uma palavra.
-    struct no_tst *esquerda, *centro, *direito; // Ponteiros para os nós filhos esquerdo, central e direito.
-} NoTST;
-
-// Struct que define o dicionário completo.
-typedef struct
-{
-    NoTST *raiz;         // Ponteiro para a raiz da Trie.
-    char *hash_ficheiro; // Hash do ficheiro carregado na Trie.
-} Dicionario;
-
-// ================================ FUNÇÕES DO DICIONÁRIO ============================
-// As funções são declaradas aqui, mas suas implementações ocorrerão no arquivo 'manipuladorDoDicionario.c'.
-
-// Inicializa o dicionário.
-Dicionario *inicializarDicionario();
-
-// Inicializa um novo nó da Trie com o caractere fornecido.
-NoTST *inicializarNo(char caractere);
-
-// Insere uma palavra no dicionário.
-void inserirPalavra(Dicionario *dicionario, const char *palavra);
-
-// Consulta se uma palavra existe no dicionário.
-bool consultarPalavra(Dicionario *dicionario, const char *palavra);
-
-// Remove uma palavra do dicionário.
-void removerPalavra(Dicionario *dicionario, const char *palavra);
-
-// Atualiza uma palavra existente no dicionário.
-void atualizarPalavra(Dicionario *dicionario, const char *palavraAntiga, const char *palavraNova);
-
-// Imprime todas as palavras com o prefixo fornecido.
-void palavrasComPrefixo(Dicionario *dicionario, const char *prefixo);
-
-// Retorna o prefixo mais longo de uma palavra que existe no dicionário.
-char *prefixoMaisLongo(Dicionario *dicionario, const char *palavra);
-
-// Imprime todas as palavras que estão a uma certa distância de edição de uma palavra base.
-void palavrasPorDistanciaMinima(Dicionario *dicionario, const char *palavraBase, int distancia);
-
-// Verifica a ortografia de um ficheiro de texto usando o dicionário.
-void verificarOrtografia(Dicionario *dicionario, const char *ficheiroTexto);
-
-// Imprime todas as palavras no dicionário em ordem.
-void imprimirIndice(Dicionario *dicionario);
-
-// Verifica a integridade do ficheiro com o hash armazenado no dicionário.
-bool verificarIntegridadeFicheiro(Dicionario *dicionario, const char *nomeFicheiro);
-
-// ================================ FUNÇÕES DE HASH ==================================
-// As funções relacionadas ao hash do ficheiro são declaradas aqui.
-
-// Gera o hash de um ficheiro.
-char *gerarHashFicheiro(const char *nomeFicheiro);
-
-// Compara o hash armazenado no dicionário com um hash fornecido.
-bool compararHashFicheiro(Dicionario *dicionario, const char *hashComparacao);
-
-// ================================ FUNÇÕES AUXILIARES ==================================
-// Estas funções são usadas como auxiliares para evitar a sobrecarga das funções principais.
-
-// Função auxiliar para inserir um nó na árvore.
-NoTST *inserirNo(NoTST *raiz, const char *palavra, int indice);
-
-// Função auxiliar para consultar uma palavra na árvore.
-bool consultarPalavraRecursivo(NoTST *raiz, const char *palavra, int indice);
-
-// Função auxiliar para verificar se um nó está vazio (ou seja, não tem filhos).
-bool noEstaVazio(NoTST *no);
-
-// Função auxiliar para remover uma palavra na árvore.
-NoTST *removerPalavraRecursivo(NoTST *raiz, const char *palavra, int indice);
-
-// Função auxiliar para imprimir todas as palavras na TST que começam com o prefixo fornecido.
-void palavrasComPrefixoAuxiliar(NoTST *no, char *buffer, int profundidade);
-
-// Função auxiliar que encontra todas as palavras que estão a uma certa distância de edição de uma palavra base.
-void palavrasPorDistanciaMinimaAux(NoTST *no, char *buffer, int profundidade, const char *palavraBase, int distancia);
-
-// Função que retorna o menor de três números.
-int min(int a, int b, int c);
-
-// Função que calcula a distância de edição entre duas palavras.
-int distanciaEdicao(const char *palavra1, int comprimento1, const char *palavra2, int comprimento2);
-
-// Função para tratar palavra não encontrada no dicionário
-void tratarPalavraNaoEncontrada(Dicionario *dicionario, FILE *fileOutput, const char *palavra);
-
-// Função auxiliar para percurso em ordem na TST
-void percursoEmOrdem(NoTST *no, char *buffer, int profundidade);
-
-// ================================ FUNÇÕES PARA O MENU ==================================
-// Estas funções são usadas para ajudar nas funcionalidades do menu.
-
-// Função para carregar as palavras do ficheiro e preenchê-las na TRIE TST
-void carregarPalavrasDoFicheiro(Dicionario *dicionario, const char *nomeFicheiro);
-
-// Função para executar a opção escolhida no Menu Principal
-void executarOpcao(Dicionario *dicionario, int opcao, const char *nomeFicheiro);
-
-// Função para exibir as opções disponíveis ao usuário
-void menu(int opcao_selecionada);
-
-// Função para carregar e controlar o Menu Principal
-void menuPrincipal(Dicionario *dicionario, const char *nomeFicheiro);
-
-// ================================ FUNÇÕES DO MAIN ==================================
-// Estas funções são usadas para inicializar o programa ou parte dele.
-
-// Função que dá início ao programa
-void iniciarPrograma();
-
-// ================================ FIM DA GUARDA DE INCLUSÃO ========================
-#endif // DICIONARIO_H
+// ================================ GUARDA DE INCLUSÃO ================================
+// A guarda de inclusão evita problemas de inclusões múltiplas de um mesmo arquivo.
+#ifndef DICIONARIO_H
+#define DICIONARIO_H
+
+// ================================ CONSTANTES ============================
+
+// Essa constante representa o tamanho máximo que uma palavra do dicionário pode ter.
+#define MAX_TAMANHO_PALAVRA 100
+
+// Essa constante representa quantos nós cabem em cada bloco contíguo da arena de nós.
+#define NOS_POR_BLOCO_ARENA 4096
+
+// Essa constante representa o maior padrão aceite pelo cálculo bit-paralelo da distância de edição (um bit por caractere).
+#define MAX_PADRAO_BIT_PARALELO 64
+
+// Essa constante representa o tamanho, em bytes, de cada leitura da verificação ortográfica em lote.
+#define TAMANHO_BLOCO_VERIFICACAO (1 << 20)
+
+// Essa constante representa o bit que marca o fim de uma palavra num nó compacto.
+#define FLAG_FIM_PALAVRA 0x01
+
+// Essa constante representa as entradas da tabela da raiz, indexada pelo primeiro caractere (um byte) das palavras.
+#define TAMANHO_TABELA_RAIZ 256
+
+// Essas constantes identificam o formato do instantâneo binário da Trie (ficheiro com extensão EXTENSAO_INSTANTANEO).
+#define ASSINATURA_INSTANTANEO "TSTDICT"
+#define VERSAO_INSTANTANEO 6
+#define EXTENSAO_INSTANTANEO ".tst"
+
+// Essa constante representa o espaço reservado para o hash do ficheiro de origem no instantâneo.
+#define TAMANHO_HASH_INSTANTANEO 64
+
+// Essas constantes definem o manifesto de integridade: tamanho dos blocos com hash próprio e quantos intervalos
+// alterados o menu mostra.
+#define TAMANHO_BLOCO_MANIFESTO (64 * 1024)
+#define MAX_INTERVALOS_ALTERADOS 16
+
+// Essas constantes definem a recarga incremental: quantas linhas à frente se procura o ponto em que o ficheiro antigo
+// e o novo voltam a coincidir, e quanto tempo a vigia espera por mais eventos antes de recarregar.
+#define JANELA_RESSINCRONIZACAO 256
+#define ESPERA_VIGIA_MS 50
+
+// Essas constantes identificam o formato do diário de alterações (ficheiro com extensão EXTENSAO_DIARIO ao lado do
+// ficheiro de texto) e definem o tamanho a partir do qual ele é compactado num instantâneo (e voltará a ser quando
+// tiver pelo menos o dobro do tamanho que ficou da compactação anterior).
+#define ASSINATURA_DIARIO "TSTWAL"
+#define VERSAO_DIARIO 1
+#define EXTENSAO_DIARIO ".wal"
+#define LIMITE_COMPACTACAO_DIARIO (4 << 20)
+
+// Essa constante é a sequência devolvida por uma alteração aplicada em memória que o diário (aberto) não registou,
+// porque uma escrita anterior falhou: nunca fica durável, ao contrário do 0 de quando não há diário.
+#define SEQUENCIA_DIARIO_FALHADA UINT64_MAX
+
+// Essas constantes definem as sugestões de correção: distância de edição máxima, quantidade e espaço para o texto.
+#define DISTANCIA_SUGESTOES 2
+#define MAX_SUGESTOES 8
+#define TAMANHO_SUGESTOES 256
+
+// Essas constantes definem o filtro de Bloom: bits por palavra na capacidade do filtro (cerca de 0,1% de falsos
+// positivos quando ele está cheio, com os 8 bits de cada palavra num só bloco de 64 bytes; é construído com folga
+// para o dobro das palavras), palavras de 64 bits por bloco e a fração de remoções a partir da qual é reconstruído.
+#define BITS_POR_PALAVRA_FILTRO 16
+#define PALAVRAS_POR_BLOCO_FILTRO 8
+#define FRACAO_REMOVIDAS_FILTRO 8
+
+// Essa constante representa quantas threads podem ler ao mesmo tempo sem trinco no modo concorrente (as restantes
+// leem com o trinco dos escritores).
+#define MAX_LEITORES_CONCORRENTES 256
+
+// Essas constantes definem a cache de sugestões: entradas por conjunto (vias), conjuntos por omissão e quantos
+// trincos partilham os conjuntos entre si.
+#define VIAS_CACHE_SUGESTOES 8
+#define CONJUNTOS_CACHE_SUGESTOES 512
+#define TRINCOS_CACHE_SUGESTOES 64
+
+// Essa constante representa quantas das últimas palavras alteradas a cache de sugestões recorda: uma entrada antiga
+// continua válida se nenhuma delas estiver a DISTANCIA_SUGESTOES ou menos da sua palavra.
+#define ALTERACOES_CACHE_SUGESTOES 64
+
+// Essas constantes definem o servidor local: cabeçalho de cada trama (u32 comprimento, u8 operação ou estado e
+// u32 identificador), maior pedido aceite, saída pendente por ligação a partir da qual deixa de se ler dessa
+// ligação, eventos tratados por iteração e resultados devolvidos por omissão numa procura.
+#define TAMANHO_CABECALHO_TRAMA 9
+#define MAX_PEDIDO_SERVIDOR (1 << 20)
+#define MAX_SAIDA_PENDENTE_SERVIDOR (8 << 20)
+#define MAX_EVENTOS_SERVIDOR 64
+#define MAX_RESULTADOS_SERVIDOR 1000
+
+// Essas constantes definem as estatísticas das operações: uma em cada AMOSTRAGEM_LATENCIA operações de cada thread é
+// cronometrada, e o histograma de latências tem um intervalo por potência de 2 de nanossegundos.
+#define AMOSTRAGEM_LATENCIA 64
+#define INTERVALOS_HISTOGRAMA 32
+
+// Essas constantes definem o autocompletar: quantas sugestões são devolvidas por omissão e quantos bits de mantissa
+// tem o limite do peso guardado em 16 bits em cada nó (os pesos menores do que 2^BITS_MANTISSA_PESO ficam exatos).
+#define SUGESTOES_AUTOCOMPLETAR 10
+#define BITS_MANTISSA_PESO 11
+
+// Essas constantes definem o cursor: tarefas que cabem na pilha guardada no próprio cursor (só um caminho mais fundo
+// do que isso a faz passar para memória alocada) e palavras mostradas por página no menu.
+#define PILHA_INICIAL_CURSOR 128
+#define PALAVRAS_POR_PAGINA 20
+
+// Essas constantes definem a compactação incremental da Trie: nós tratados por fatia (cada fatia demora um tempo
+// limitado) e a fração das remoções, em relação aos nós em uso, a partir da qual o servidor a começa sozinho.
+#define NOS_POR_FATIA_COMPACTACAO 4096
+#define FRACAO_REMOCOES_COMPACTACAO 8
+
+// ================================ BIBLIOTECAS INCLUÍDAS ============================
+
+// Biblioteca para o uso do tipo bool.
+#include <stdbool.h>
+
+// Biblioteca padrão do C para entrada e saída de dados.
+#include <stdio.h>
+
+// Biblioteca padrão do C que define o tipo size_t.
+#include <stddef.h>
+
+// Biblioteca padrão do C para tipos inteiros de tamanho fixo.
+#include <stdint.h>
+
+// Biblioteca POSIX de threads (trincos da cache de sugestões e do modo concorrente, lugares dos leitores, thread da
+// vigia do ficheiro e threads de escrita e de compactação do diário).
+#include <pthread.h>
+
+// ================================ PONTOS DE RASTREIO ===============================
+// O rastreio passo a passo dos percursos só é compilado com -DDICIONARIO_RASTREIO (make RASTREIO=1); sem essa
+// definição, RASTREAR não gera código nenhum e os argumentos não são avaliados.
+#ifdef DICIONARIO_RASTREIO
+#define RASTREAR(...) fprintf(stderr, __VA_ARGS__)
+#else
+#define RASTREAR(...) ((void)0)
+#endif
+
+// ================================== ESTRUTURAS =====================================
+
+// Struct que define um nó na árvore Ternary Search Trie (TST). O peso e o limite ocupam o espaço que o alinhamento
+// dos ponteiros deixava livre, portanto o nó continua a ter 32 bytes.
+typedef struct no_tst
+{
+    char caractere;                             // Caractere armazenado no nó.
+    bool fim_palavra;                           // Flag para marcar o fim de uma palavra.
+    uint16_t pesoMaximo;                        // Limite (arredondado por excesso) do maior peso na subárvore do nó.
+    uint32_t peso;                              // Peso (frequência) da palavra que termina neste nó.
+    struct no_tst *esquerda, *centro, *direito; // Ponteiros para os nós filhos esquerdo, central e direito.
+} NoTST;
+
+// Struct que define um bloco contíguo de nós entregue pela arena.
+typedef struct bloco_arena
+{
+    struct bloco_arena *proximo;    // Próximo bloco da arena (lista ligada de blocos).
+    size_t usados;                  // Quantidade de nós já entregues deste bloco.
+    NoTST nos[NOS_POR_BLOCO_ARENA]; // Nós armazenados de forma contígua.
+} BlocoArena;
+
+// Struct que define a arena de nós da Trie (alocador por blocos com lista de nós livres).
+typedef struct
+{
+    BlocoArena *blocos; // Lista de blocos alocados (o mais recente primeiro).
+    NoTST *livres;      // Lista de nós libertados para reutilização (encadeados pelo ponteiro central).
+    size_t nosEmUso;    // Quantidade de nós atualmente em uso na Trie.
+    size_t totalBlocos; // Quantidade de blocos alocados.
+} ArenaNos;
+
+// Struct que define um ficheiro mapeado em memória (só leitura).
+typedef struct
+{
+    const unsigned char *dados; // Conteúdo do ficheiro (NULL se o ficheiro estiver vazio).
+    size_t tamanho;             // Tamanho do ficheiro em bytes.
+} FicheiroMapeado;
+
+// Struct que define um nó da representação compacta da Trie (16 bytes em vez de 32).
+// Os filhos são índices de 32 bits no vetor de nós; o índice 0 representa a ausência de filho.
+typedef struct
+{
+    uint32_t esquerda, centro, direito; // Índices dos nós filhos esquerdo, central e direito.
+    char caractere;                     // Caractere armazenado no nó.
+    uint8_t flags;                      // Bits do nó (FLAG_FIM_PALAVRA marca o fim de uma palavra).
+    uint16_t pesoMaximo;                // Limite do maior peso na subárvore (como em NoTST).
+} NoCompacto;
+
+// Struct que define a Trie na representação compacta (vetor de nós em ordem de percurso).
+typedef struct
+{
+    NoCompacto *nos;      // Vetor de nós; a posição 0 é reservada para representar "nenhum nó".
+    uint32_t *pesos;      // Peso da palavra de cada nó, paralelo a 'nos' (NULL se todos os pesos forem 0).
+    uint32_t totalNos;    // Quantidade de posições usadas no vetor (incluindo a posição 0).
+    uint32_t raiz;        // Índice da raiz (0 se a Trie estiver vazia).
+    size_t totalPalavras; // Quantidade de palavras armazenadas.
+    bool minimizada;      // Se as subárvores iguais são partilhadas (grafo acíclico, ver construirTSTMinimizada).
+    uint32_t tabelaRaiz[TAMANHO_TABELA_RAIZ]; // Índice do nó do primeiro nível com cada caractere (0 se não houver).
+    FicheiroMapeado instantaneo; // Instantâneo binário de onde os nós são lidos (dados NULL se os nós foram alocados).
+} TSTCompacta;
+
+// Struct que define uma palavra como uma fatia de um texto maior (sem terminador '\0').
+typedef struct
+{
+    const char *inicio; // Primeiro caractere da palavra.
+    int comprimento;    // Quantidade de caracteres da palavra.
+    uint32_t peso;      // Peso da palavra (0 se não foi indicado).
+} FatiaPalavra;
+
+// Struct que define o manifesto de integridade de um ficheiro: o hash (XXH64) de cada bloco de 'tamanhoBloco' bytes
+// e a raiz, o hash da lista de hashes, que identifica o ficheiro inteiro. Comparando os hashes dos blocos de dois
+// manifestos sabe-se que intervalos de bytes mudaram.
+typedef struct
+{
+    uint64_t *hashes;         // Hash de cada bloco (NULL se o ficheiro estiver vazio).
+    size_t totalBlocos;       // Quantidade de blocos (o último pode ser mais curto).
+    uint64_t tamanhoFicheiro; // Tamanho do ficheiro em bytes.
+    uint32_t tamanhoBloco;    // TAMANHO_BLOCO_MANIFESTO quando o manifesto foi gerado.
+    uint64_t raiz;            // Hash da lista de hashes dos blocos.
+} ManifestoFicheiro;
+
+// Struct que define um intervalo de bytes [inicio, fim) de um ficheiro.
+typedef struct
+{
+    uint64_t inicio, fim;
+} IntervaloFicheiro;
+
+// Struct que define o cabeçalho do instantâneo binário. Os nós compactos seguem-se imediatamente ao cabeçalho, os
+// pesos (se existirem) aos nós e os hashes do manifesto da origem aos pesos; como os filhos são índices e não
+// ponteiros, o instantâneo pode ser consultado no endereço em que for mapeado.
+typedef struct
+{
+    char assinatura[8];                           // ASSINATURA_INSTANTANEO, terminada em '\0'.
+    uint32_t versao;                              // VERSAO_INSTANTANEO.
+    uint32_t tamanhoNo;                           // sizeof(NoCompacto), para rejeitar instantâneos de outra plataforma.
+    uint32_t totalNos;                            // Quantidade de nós (incluindo a posição 0).
+    uint32_t raiz;                                // Índice da raiz.
+    uint32_t totalPesos;                          // 0 (todos os pesos são 0) ou totalNos.
+    uint32_t tamanhoBlocoManifesto;               // Tamanho dos blocos do manifesto (0 se não houver manifesto).
+    uint32_t minimizado;                          // 1 se os nós formam o grafo minimizado (subárvores partilhadas).
+    uint32_t reservado;                           // Sempre 0.
+    uint64_t totalPalavras;                       // Quantidade de palavras.
+    uint64_t tamanhoOrigem;                       // Tamanho do ficheiro de texto de origem.
+    int64_t modificacaoOrigem;                    // Instante da última modificação da origem (em nanossegundos).
+    uint64_t totalBlocosManifesto;                // Quantidade de hashes do manifesto.
+    uint64_t tamanhoManifesto;                    // Tamanho do ficheiro descrito pelo manifesto.
+    uint64_t sequenciaDiario;                     // Última entrada do diário de alterações incluída nas palavras.
+    uint64_t hashNos;                             // XXH64 dos nós e dos pesos (rejeita nós truncados ou corrompidos).
+    char hashFicheiro[TAMANHO_HASH_INSTANTANEO];  // Hash do ficheiro de texto de origem.
+} CabecalhoInstantaneo;
+
+// Enumeração que define como a distância de edição pedida é interpretada na procura de palavras semelhantes.
+typedef enum
+{
+    DISTANCIA_EXATA,  // Apenas as palavras exatamente à distância pedida.
+    DISTANCIA_MAXIMA  // Todas as palavras até à distância pedida (inclusive).
+} ModoDistancia;
+
+// Tipo das funções chamadas para cada palavra encontrada numa procura por distância de edição.
+typedef void (*VisitanteDistancia)(const char *palavra, int distancia, void *contexto);
+
+// Tipo das funções chamadas para cada palavra de uma enumeração; devolvem falso para a interromper.
+typedef bool (*VisitantePalavra)(const char *palavra, void *contexto);
+
+// Tipo das funções chamadas para cada sugestão do autocompletar, por ordem decrescente de peso.
+typedef void (*VisitantePeso)(const char *palavra, uint32_t peso, void *contexto);
+
+// Enumeração das operações do protocolo do servidor (byte 'operação' do cabeçalho do pedido).
+typedef enum
+{
+    OPERACAO_CONSULTAR = 1,      // palavra -> u8 existe
+    OPERACAO_PREFIXO,            // u16 limite | prefixo -> u32 total | (u8 comprimento | palavra)*
+    OPERACAO_PREFIXO_MAIS_LONGO, // palavra -> prefixo mais longo que é palavra do dicionário
+    OPERACAO_DISTANCIA,          // u8 distância | u8 modo | u16 limite | palavra -> u32 total | (u8 d | u8 c | palavra)*
+    OPERACAO_INSERIR,            // palavra -> u8 inserida
+    OPERACAO_REMOVER,            // palavra -> u8 removida
+    OPERACAO_CONSULTAR_LOTE,     // u32 total | (u8 comprimento | palavra)* -> u32 encontradas | mapa de bits
+    OPERACAO_ENCERRAR,           // termina o servidor depois de responder
+    OPERACAO_ESTATISTICAS,       // -> texto de imprimirEstatisticasDicionario
+    OPERACAO_AUTOCOMPLETAR,      // u16 k | prefixo -> u32 total | (u32 peso | u8 comprimento | palavra)*
+    OPERACAO_INSERIR_COM_PESO    // u32 peso | palavra -> u8 inserida (1) ou peso atualizado (0)
+} OperacaoServidor;
+
+// Enumeração dos estados de uma resposta do servidor (byte 'estado' do cabeçalho da resposta).
+typedef enum
+{
+    RESPOSTA_OK = 0,
+    RESPOSTA_PEDIDO_INVALIDO,
+    RESPOSTA_OPERACAO_DESCONHECIDA,
+    RESPOSTA_FALHA
+} EstadoResposta;
+
+// Enumeração das operações com latência medida nas estatísticas.
+typedef enum
+{
+    ESTATISTICA_CONSULTA,
+    ESTATISTICA_INSERCAO,
+    ESTATISTICA_REMOCAO,
+    ESTATISTICA_PREFIXO,
+    ESTATISTICA_DISTANCIA,
+    ESTATISTICA_AUTOCOMPLETAR,
+    TOTAL_ESTATISTICAS
+} OperacaoEstatistica;
+
+// Struct que define as latências de um tipo de operação.
+typedef struct
+{
+    uint64_t operacoes;                         // Operações executadas.
+    uint64_t amostras;                          // Operações cronometradas (uma em cada AMOSTRAGEM_LATENCIA).
+    uint64_t nanossegundos;                     // Soma das latências cronometradas.
+    uint64_t histograma[INTERVALOS_HISTOGRAMA]; // Intervalo i: latências em [2^i, 2^(i+1)) ns (o último sem limite).
+} LatenciaOperacao;
+
+// Struct que define as estatísticas do dicionário, somadas sobre todas as threads.
+typedef struct
+{
+    uint64_t nosVisitados;       // Nós visitados pelas consultas, pelas procuras por distância e pelo autocompletar.
+    uint64_t passosLaterais;     // Passos das consultas para a esquerda ou para a direita.
+    uint64_t passosCentrais;     // Passos das consultas para o centro (um por caractere reconhecido).
+    uint64_t profundidadeMaxima; // Maior quantidade de caracteres reconhecidos por uma consulta.
+    uint64_t nosAlocados;        // Nós entregues pela arena.
+    uint64_t nosLibertados;      // Nós devolvidos à arena.
+    uint64_t blocosAlocados;     // Blocos da arena alocados com malloc.
+    LatenciaOperacao latencias[TOTAL_ESTATISTICAS];
+} EstatisticasDicionario;
+
+// Struct que guarda o estado de uma procura por distância de edição ao longo da Trie.
+// A linha i da matriz é a linha da programação dinâmica para o prefixo de i caracteres atualmente no buffer.
+typedef struct
+{
+    const char *palavraBase;                                     // Palavra de referência.
+    int comprimentoBase;                                         // Comprimento da palavra de referência.
+    int distancia;                                               // Distância de edição pedida.
+    ModoDistancia modo;                                          // Distância exata ou máxima.
+    VisitanteDistancia visitar;                                  // Função chamada para cada palavra encontrada.
+    void *contexto;                                              // Contexto passado à função 'visitar'.
+    size_t encontradas;                                          // Quantidade de palavras encontradas.
+    size_t nosVisitados;                                         // Nós visitados (para as estatísticas).
+    char buffer[MAX_TAMANHO_PALAVRA];                            // Prefixo do caminho atual na Trie.
+    int linhas[MAX_TAMANHO_PALAVRA + 1][MAX_TAMANHO_PALAVRA + 1]; // Uma linha da programação dinâmica por profundidade.
+} ProcuraDistancia;
+
+// Struct que define um padrão pré-processado para o cálculo bit-paralelo (Myers/Hyyrö) da distância de edição.
+typedef struct
+{
+    uint64_t mascaras[256]; // Para cada byte, os bits das posições do padrão onde ele ocorre.
+    int comprimento;        // Comprimento do padrão (no máximo MAX_PADRAO_BIT_PARALELO).
+} PadraoBitParalelo;
+
+// Struct que define as opções da verificação ortográfica em lote (não interativa).
+typedef struct
+{
+    const char *ficheiroSaida;     // Texto original com as palavras erradas entre colchetes (NULL para não gerar).
+    const char *ficheiroRelatorio; // Relatório "linha:coluna<TAB>palavra[<TAB>sugestões]" das palavras erradas (ou NULL).
+    size_t tamanhoBloco;           // Bytes lidos de cada vez (0 para usar TAMANHO_BLOCO_VERIFICACAO).
+    int totalThreads;              // Threads que verificam partes do texto em paralelo (0 ou 1 para ler sequencialmente).
+    bool sugerir;                  // Acrescentar ao relatório as sugestões de correção de cada palavra errada.
+    bool ignorarAcentos;           // Aceitar as palavras que só diferem de uma do dicionário em maiúsculas e acentos.
+} OpcoesVerificacao;
+
+// Struct que define o resultado de uma verificação ortográfica em lote.
+typedef struct
+{
+    size_t bytes;     // Bytes lidos do ficheiro de texto.
+    size_t palavras;  // Palavras verificadas.
+    size_t erradas;   // Palavras que não estão no dicionário.
+    size_t linhas;    // Linhas do ficheiro de texto.
+    double segundos;  // Duração da verificação.
+} ResultadoVerificacao;
+
+// Struct que define um filtro de Bloom por blocos: cada palavra escolhe um bloco de 64 bytes (uma linha de cache) e
+// marca um bit em cada uma das suas 8 palavras de 64 bits. Não tem falsos negativos, portanto uma resposta "não está"
+// dispensa o percurso da Trie. As remoções não apagam bits; só deixam o filtro menos seletivo até ser reconstruído.
+// No modo concorrente, os leitores consultam-no sem trinco: os bits são marcados com operações atómicas e um filtro
+// reconstruído é publicado no lugar do antigo, que é retirado até nenhum leitor o poder estar a usar.
+typedef struct
+{
+    uint64_t *blocos;     // totalBlocos * PALAVRAS_POR_BLOCO_FILTRO palavras de 64 bits, alinhadas a 64 bytes.
+    uint32_t totalBlocos; // Quantidade de blocos.
+    size_t capacidade;    // Palavras para as quais o filtro foi dimensionado.
+    size_t inseridas;     // Palavras adicionadas desde a construção.
+    size_t removidas;     // Palavras removidas do dicionário desde a construção (os seus bits ficaram no filtro).
+} FiltroBloom;
+
+// Struct que define uma grafia do dicionário no índice dobrado. As grafias com a mesma forma dobrada formam uma lista.
+typedef struct
+{
+    uint32_t posicao;  // Posição da grafia (terminada em '\0') no texto do índice.
+    uint32_t proxima;  // Índice + 1 da próxima grafia com a mesma forma dobrada (0 no fim da lista).
+} GrafiaDobrada;
+
+// Struct que define o índice dobrado: uma Trie das formas dobradas das palavras (sem maiúsculas nem acentos, ver
+// dobrarPalavra) em que o peso do nó final de cada forma é o índice + 1 da primeira das suas grafias canónicas. Uma
+// consulta que ignora maiúsculas e acentos dobra a palavra e percorre esta Trie uma só vez.
+typedef struct
+{
+    ArenaNos arena;             // Arena dos nós da Trie das formas dobradas.
+    NoTST *raiz;
+    char *texto;                // Grafias canónicas, cada uma terminada em '\0'.
+    size_t tamanhoTexto, capacidadeTexto;
+    GrafiaDobrada *grafias;
+    size_t totalGrafias, capacidadeGrafias;
+    size_t retiradas;           // Grafias removidas das listas (o seu espaço é recuperado quando passam das ligadas).
+    size_t totalFormas;         // Formas dobradas distintas.
+    pthread_rwlock_t trinco;    // No modo concorrente, separa as consultas das alterações.
+} IndiceDobrado;
+
+// Struct que define uma tarefa pendente na pilha de um cursor.
+typedef struct
+{
+    uintptr_t no;         // Nó: ponteiro (layout de ponteiros) ou índice (layout compacto).
+    uint8_t profundidade; // Posição do caractere do nó nas palavras.
+    uint8_t tarefa;       // Subárvore inteira ou só o resto do nó (ver o cursor em manipuladorDoDicionario.c).
+} TarefaCursor;
+
+// Struct que define o lugar de uma thread leitora no modo concorrente. Cada lugar ocupa a sua própria linha de cache,
+// para que as entradas e saídas de leitura de threads diferentes não disputem a mesma linha.
+typedef struct
+{
+    uint64_t epoca;        // Época global lida ao entrar na leitura (0 se a thread não estiver a ler).
+    uint32_t profundidade; // Leituras encaixadas em curso (só a mais exterior publica a época).
+    bool ocupado;          // Se o lugar pertence a uma thread.
+} __attribute__((aligned(64))) LeitorEpoca;
+
+// Declaração antecipada do dicionário, usado pelas funções que libertam os objetos retirados.
+struct Dicionario;
+
+// Struct que define um objeto retirado da estrutura publicada, à espera de que nenhum leitor o possa estar a usar.
+typedef struct
+{
+    void *objeto;                                                  // Nó ou filtro substituído.
+    void (*libertar)(struct Dicionario *dicionario, void *objeto); // Função que o liberta.
+    uint64_t epoca;                                                // Época global no momento em que foi retirado.
+} ObjetoRetirado;
+
+// Struct que define o controlo do modo concorrente: os escritores são serializados por um trinco e copiam o caminho
+// que alteram (copy-on-write), publicando a nova raiz de forma atómica; os leitores nunca tomam trincos e apenas
+// anunciam a época em que entraram. Um objeto retirado na época E só é libertado quando todos os leitores ativos
+// entraram depois de E (reclamação baseada em épocas).
+typedef struct
+{
+    LeitorEpoca leitores[MAX_LEITORES_CONCORRENTES]; // Lugares das threads leitoras.
+    pthread_mutex_t trincoEscrita;                   // Serializa os escritores.
+    pthread_key_t chaveLeitor;                       // Lugar da thread atual (libertado quando a thread termina).
+    uint64_t epocaGlobal;                            // Época atual (começa em 1).
+    ObjetoRetirado *retirados;                       // Objetos à espera de serem libertados.
+    size_t totalRetirados, capacidadeRetirados;
+} ControloConcorrencia;
+
+// Struct que define uma entrada da cache de sugestões.
+typedef struct
+{
+    uint64_t hash;                      // Hash da palavra, para rejeitar depressa as entradas diferentes.
+    uint64_t versao;                    // Versão do dicionário em que as sugestões foram calculadas.
+    bool referenciada;                  // Bit de referência do algoritmo CLOCK (usada desde a última passagem).
+    uint8_t totalSugestoes;             // Quantidade de sugestões guardadas.
+    char palavra[MAX_TAMANHO_PALAVRA];  // Palavra desconhecida ("" se a entrada estiver livre).
+    char sugestoes[TAMANHO_SUGESTOES];  // Sugestões separadas por ", " ("" se não houver nenhuma).
+} EntradaCacheSugestoes;
+
+// Struct que define os contadores da cache de sugestões.
+typedef struct
+{
+    size_t acertos;     // Consultas respondidas pela cache.
+    size_t falhas;      // Consultas que tiveram de calcular as sugestões (inclui as invalidadas).
+    size_t invalidadas; // Entradas encontradas mas calculadas numa versão anterior do dicionário.
+    size_t revalidadas; // Entradas antigas que nenhuma palavra alterada entretanto afetava (contam como acertos).
+    size_t substituidas; // Entradas ocupadas que foram substituídas por outras.
+} EstatisticasCacheSugestoes;
+
+// Struct que define um trinco da cache e os contadores dos conjuntos que ele protege.
+typedef struct
+{
+    pthread_mutex_t trinco;
+    EstatisticasCacheSugestoes estatisticas;
+} FragmentoCacheSugestoes;
+
+// Struct que define a cache de sugestões: associativa por conjuntos, com substituição CLOCK dentro de cada conjunto.
+// O conjunto i é protegido pelo fragmento i % TRINCOS_CACHE_SUGESTOES, o que permite consultas em paralelo.
+typedef struct
+{
+    FragmentoCacheSugestoes fragmentos[TRINCOS_CACHE_SUGESTOES];
+    EntradaCacheSugestoes *entradas; // totalConjuntos * VIAS_CACHE_SUGESTOES entradas.
+    uint8_t *ponteiros;              // Ponteiro do relógio de cada conjunto.
+    size_t totalConjuntos;
+    pthread_mutex_t trincoAlteradas;                                 // Protege as palavras alteradas e a versão.
+    uint64_t versaoBaseAlteradas;                                    // Menor versão a partir da qual todas são conhecidas.
+    int comprimentosAlteradas[ALTERACOES_CACHE_SUGESTOES];           // Comprimento de cada palavra alterada.
+    char alteradas[ALTERACOES_CACHE_SUGESTOES][MAX_TAMANHO_PALAVRA]; // Palavra que levou a cada versão (anel).
+} CacheSugestoes;
+
+// Struct que define uma palavra que aparece mais de uma vez no ficheiro de origem (hash 0 marca um lugar livre).
+typedef struct
+{
+    uint64_t hash;        // Hash (XXH64) da palavra.
+    uint32_t ocorrencias; // Quantas vezes aparece no ficheiro (pode descer para 1 ou 0 depois de uma recarga).
+    uint32_t posicao;     // Posição da palavra no texto das repetidas (para distinguir palavras com o mesmo hash).
+    int comprimento;
+} RepeticaoPalavra;
+
+// Struct que define a base da recarga incremental: o conteúdo do ficheiro na última recarga, com que o conteúdo novo
+// é comparado, e as palavras repetidas (uma palavra só sai do dicionário quando desaparece de todas as linhas).
+typedef struct
+{
+    unsigned char *dados;       // Cópia do ficheiro.
+    size_t tamanho, capacidade; // Tamanho da cópia e memória reservada para ela, em bytes.
+    unsigned char *reserva;     // Memória da cópia anterior, reutilizada na próxima leitura (já tem as páginas).
+    size_t capacidadeReserva;
+    uint64_t raizManifesto;     // Raiz do manifesto da cópia (a base só vale enquanto for a do manifesto guardado).
+    RepeticaoPalavra *repetidas; // Tabela de endereçamento aberto com 'capacidadeRepetidas' lugares (potência de 2).
+    size_t totalRepetidas, capacidadeRepetidas;
+    char *textoRepetidas;        // Palavras da tabela, seguidas (as entradas nunca saem, portanto só cresce).
+    size_t tamanhoTextoRepetidas, capacidadeTextoRepetidas;
+} BaseRecarga;
+
+// Struct que define o resultado de uma recarga do ficheiro.
+typedef struct
+{
+    bool alterado;          // Se o ficheiro tinha mudado desde a última recarga (ou carregamento).
+    bool incremental;       // Se só as linhas alteradas foram comparadas (falso: o ficheiro inteiro foi comparado).
+    size_t inseridas;       // Palavras novas.
+    size_t removidas;       // Palavras que deixaram de existir no ficheiro.
+    size_t pesosAlterados;  // Palavras que já existiam mas mudaram de peso.
+    uint64_t bytesComparados; // Bytes das linhas alteradas (antigas e novas) que foram separados em palavras.
+    double segundos;        // Duração da recarga.
+} ResultadoRecarga;
+
+// Struct que define a vigia de um ficheiro: uma thread espera pelos eventos inotify da pasta do ficheiro e recarrega-o
+// quando ele é escrito ou substituído (os editores costumam gravar num ficheiro novo e mudar-lhe o nome).
+typedef struct
+{
+    pthread_t thread;
+    int inotify;                       // Descritor inotify.
+    int paragem[2];                    // Canal usado para acordar a thread quando a vigia é desligada.
+    char nomeFicheiro[FILENAME_MAX];   // Caminho do ficheiro vigiado.
+    const char *nomeBase;              // Nome do ficheiro dentro da pasta (aponta para dentro de nomeFicheiro).
+    pthread_mutex_t trinco;            // Protege a última recarga e o contador.
+    ResultadoRecarga ultima;           // Resultado da última recarga feita pela vigia.
+    size_t recargas;                   // Quantas recargas a vigia fez.
+    size_t falhas;                     // Quantas recargas falharam (ficheiro ilegível ou memória insuficiente).
+} VigiaFicheiro;
+
+// Enumeração que define os tipos das entradas do diário de alterações.
+typedef enum
+{
+    DIARIO_INSERIR = 1,      // inserirPalavra (uma palavra que já existia mantém o seu peso).
+    DIARIO_INSERIR_COM_PESO, // inserirPalavraComPeso.
+    DIARIO_REMOVER,          // removerPalavra.
+    DIARIO_ATUALIZAR         // atualizarPalavra (remove a primeira palavra e insere a segunda).
+} TipoEntradaDiario;
+
+// Struct que define o cabeçalho de cada entrada do diário; as palavras (sem '\0') seguem-se-lhe no ficheiro.
+typedef struct
+{
+    uint64_t sequencia;      // Número da entrada (crescente, a partir de 1).
+    uint32_t peso;           // Peso da palavra (só em DIARIO_INSERIR_COM_PESO).
+    uint32_t verificacao;    // 32 bits do XXH64 da entrada com este campo a 0 (rejeita entradas meio escritas).
+    uint8_t tipo;            // TipoEntradaDiario.
+    uint8_t comprimento;     // Comprimento da palavra.
+    uint8_t comprimentoNovo; // Comprimento da palavra nova (só em DIARIO_ATUALIZAR; 0 nos outros tipos).
+    uint8_t reservado[5];
+} EntradaDiario;
+
+// Struct que define o cabeçalho do ficheiro do diário (as entradas seguem-se-lhe).
+typedef struct
+{
+    char assinatura[8]; // ASSINATURA_DIARIO, terminada em '\0'.
+    uint32_t versao;    // VERSAO_DIARIO.
+    uint32_t reservado;
+} CabecalhoDiario;
+
+// Struct que define os contadores do diário de alterações.
+typedef struct
+{
+    uint64_t ultimaSequencia;  // Última entrada aplicada ao dicionário.
+    uint64_t sequenciaDuravel; // Última entrada que já está no disco.
+    uint64_t tamanhoFicheiro;  // Tamanho atual do ficheiro do diário.
+    size_t repostas;           // Entradas aplicadas ao abrir o diário.
+    size_t entradas;           // Entradas acrescentadas desde que o diário foi aberto.
+    size_t sincronizacoes;     // Escritas seguidas de fdatasync (cada uma torna duráveis todas as entradas pendentes).
+    size_t compactacoes;       // Compactações concluídas.
+    size_t instantaneos;       // Compactações que também gravaram um instantâneo.
+    bool falhou;               // Uma escrita falhou: as alterações seguintes ficam só em memória.
+} EstatisticasDiario;
+
+// Struct que define o diário de alterações (write-ahead log) do ficheiro de texto. As alterações são acrescentadas a
+// um buffer e aplicadas em memória pela ordem das sequências; uma thread escritora grava o buffer inteiro com um só
+// fdatasync, enquanto as alterações seguintes se juntam no outro buffer (group commit). A compactação grava um
+// instantâneo com uma cópia das palavras e reescreve o diário com uma só entrada por palavra.
+typedef struct
+{
+    char nomeDiario[FILENAME_MAX];      // Ficheiro do diário (origem + EXTENSAO_DIARIO).
+    char nomeInstantaneo[FILENAME_MAX]; // Instantâneo gravado pela compactação (origem + EXTENSAO_INSTANTANEO).
+    char nomeOrigem[FILENAME_MAX];      // Ficheiro de texto a que as alterações se aplicam.
+    int descritor;                      // Descritor do diário (aberto com O_APPEND).
+    uint64_t tamanhoFicheiro;           // Tamanho do diário (protegido por 'trincoFicheiro').
+    uint64_t tamanhoCompactado;         // Tamanho do diário depois da última compactação (idem).
+    pthread_mutex_t trinco;             // Ordena as alterações e protege os buffers, os estados e os contadores.
+    pthread_mutex_t trincoFicheiro;     // Serializa as escritas no diário com a sua substituição pela compactação.
+    pthread_cond_t pendente;            // Acorda a thread escritora (entradas novas ou paragem).
+    pthread_cond_t duravel;             // Acorda quem espera que as suas entradas fiquem no disco.
+    int aviso;                          // eventfd assinalado depois de cada escrita (-1 se não puder ser criado).
+    pthread_t escritor, compactador;
+    unsigned char *buffer;              // Entradas à espera da próxima escrita.
+    size_t usado, capacidade;
+    unsigned char *lote;                // Entradas a ser escritas (trocado com 'buffer' a cada escrita).
+    size_t capacidadeLote;
+    TSTCompacta *copia;                 // Palavras depois da entrada 'sequenciaCopia' (durante a compactação).
+    ManifestoFicheiro *copiaManifesto;  // Manifesto e hash da origem nesse momento (NULL se não houver).
+    char *copiaHash;
+    uint64_t sequenciaCopia;
+    bool compactacaoPedida;             // O diário cresceu o suficiente para ser compactado.
+    bool compactando;                   // A thread da compactação está a trabalhar.
+    bool compactadorPorJuntar;          // A thread da compactação foi lançada e ainda não foi juntada.
+    bool parar;                         // Pede à thread escritora que grave o que falta e termine.
+    EstatisticasDiario estatisticas;    // Contadores (a última sequência aplicada fica no dicionário).
+} DiarioAlteracoes;
+
+// Struct que define o dicionário completo.
+typedef struct Dicionario
+{
+    NoTST *raiz;           // Ponteiro para a raiz da Trie (no modo concorrente, cada escrita publica uma raiz nova).
+    // Nó do primeiro nível da Trie com cada caractere (NULL se nenhuma palavra começar por ele). As consultas começam
+    // no nó do primeiro caractere da palavra, sem as comparações laterais da raiz; no modo concorrente, em que os
+    // escritores copiam os nós do caminho, a tabela não é usada (e é reconstruída quando o modo é desligado).
+    NoTST *tabelaRaiz[TAMANHO_TABELA_RAIZ];
+    char *hash_ficheiro;   // Hash do ficheiro carregado na Trie (a raiz do manifesto, em hexadecimal).
+    ManifestoFicheiro *manifesto; // Manifesto por blocos do ficheiro carregado (NULL se não houver).
+    BaseRecarga *base;     // Conteúdo do ficheiro na última recarga (NULL até à primeira recarga).
+    VigiaFicheiro *vigia;  // Vigia do ficheiro (NULL se estiver desligada).
+    DiarioAlteracoes *diario; // Diário das alterações feitas ao ficheiro (NULL se não estiver aberto).
+    uint64_t sequenciaDiario; // Última entrada do diário incluída nas palavras (do instantâneo ou já aplicada).
+    ArenaNos arena;        // Arena que fornece e recicla os nós da Trie (no modo concorrente, só depois da época).
+    TSTCompacta *compacta; // Representação compacta (só leitura) quando o dicionário está congelado.
+    bool rastrearConsultas; // Se verdadeiro, consultarPalavra imprime cada passo do percurso (desligado por omissão).
+    uint64_t versao;        // Incrementada a cada alteração das palavras (invalida as entradas da cache de sugestões).
+    CacheSugestoes *sugestoes; // Cache das sugestões das palavras desconhecidas (NULL se não foi possível criá-la).
+    FiltroBloom *filtro;       // Filtro que rejeita as palavras ausentes antes da Trie (NULL se estiver desligado;
+                               // publicado e retirado como a raiz no modo concorrente).
+    ControloConcorrencia *concorrencia; // Controlo do modo concorrente (NULL se estiver desligado).
+    IndiceDobrado *dobrado; // Índice das palavras sem maiúsculas nem acentos (NULL se estiver desligado).
+    bool dobrarAoCarregar;  // Construir o índice dobrado em carregarPalavrasDoFicheiro (desligado por omissão).
+    size_t remocoesDesdeCompactacao; // Remoções desde a última compactação da Trie (ver trieDeveSerCompactada).
+} Dicionario;
+
+// Struct que define um cursor sobre as palavras com um prefixo, por ordem. O percurso é iterativo, com uma pilha
+// explícita de tarefas, e pode ser retomado a qualquer momento; avançar não aloca memória (só um caminho mais fundo
+// do que PILHA_INICIAL_CURSOR tarefas faz a pilha crescer, uma vez). O cursor é preenchido por abrirCursor no
+// espaço do chamador e tem de ser fechado com fecharCursor.
+typedef struct
+{
+    const Dicionario *dicionario;
+    const TSTCompacta *compacta;      // Layout percorrido (NULL para a Trie de ponteiros).
+    uintptr_t inicio;                 // Subárvore com as palavras mais longas do que o prefixo (0 se não houver).
+    bool prefixoEhPalavra;            // Se o próprio prefixo é uma palavra (a primeira do intervalo).
+    LeitorEpoca *leitor;              // Leitura concorrente mantida enquanto o cursor está aberto (NULL fora desse modo).
+    TarefaCursor *pilha;              // Pilha alocada quando a inicial não chega (NULL enquanto se usa 'pilhaInicial').
+    size_t totalPilha, capacidadePilha;
+    int comprimentoPrefixo;
+    int comprimento;                  // Comprimento da palavra atual.
+    bool pendente;                    // 'palavra' tem uma palavra ainda não entregue.
+    bool falhou;                      // A pilha não pôde crescer: a enumeração termina aí.
+    char palavra[MAX_TAMANHO_PALAVRA]; // Palavra atual, terminada em '\0' (durante o percurso, o caminho atual).
+    TarefaCursor pilhaInicial[PILHA_INICIAL_CURSOR];
+} CursorDicionario;
+
+// Fases da compactação incremental da Trie de ponteiros.
+typedef enum
+{
+    COMPACTACAO_MEDIR,     // Medir a profundidade das palavras antes de alterar a Trie.
+    COMPACTACAO_PODAR,     // Podar os ramos sem palavras e reequilibrar cada nível (no próprio sítio).
+    COMPACTACAO_COPIAR,    // Copiar os nós, em pré-ordem, para uma arena nova onde ficam contíguos.
+    COMPACTACAO_CONCLUIDA
+} FaseCompactacao;
+
+// Struct que define uma tarefa pendente na pilha da compactação.
+typedef struct
+{
+    NoTST *no;             // Nó a medir ou a copiar (na poda, NULL).
+    NoTST **destino;       // Na poda, o ponteiro para o nível; na cópia, onde fica o endereço da cópia.
+    uint32_t profundidade; // Nós comparados até chegar a este, inclusive (para medir a profundidade das consultas).
+    bool expandido;        // Na poda, se os níveis de baixo já foram empilhados (o nível é refeito depois deles).
+} TarefaCompactacao;
+
+// Struct que define o resultado de uma compactação da Trie (parcial, enquanto decorre).
+typedef struct
+{
+    size_t nosAntes, nosDepois;         // Nós em uso na Trie antes e depois.
+    size_t nosPodados;                  // Nós sem palavras por baixo (ramos mortos) libertados.
+    size_t niveisReequilibrados;        // Níveis (cadeias de irmãos) que ficaram menos altos.
+    size_t bytesAntes, bytesDepois;     // Memória dos blocos da arena antes e depois.
+    double profundidadeAntes, profundidadeDepois; // Nós comparados, em média, para encontrar uma palavra.
+    uint32_t profundidadeMaximaAntes, profundidadeMaximaDepois;
+    size_t fatias;                      // Fatias executadas.
+    size_t recomecos;                   // Fases recomeçadas porque o dicionário foi alterado entre duas fatias.
+    bool falhou;                        // A compactação foi abandonada (falta de memória ou dicionário congelado).
+} ResultadoCompactacao;
+
+// Struct que define uma compactação incremental da Trie de ponteiros. É preenchida por iniciarCompactacaoTrie no
+// espaço do chamador e avança por fatias; entre duas fatias, o dicionário pode ser consultado e alterado (uma
+// alteração só faz recomeçar a fase em curso).
+typedef struct
+{
+    FaseCompactacao fase;
+    uint64_t versao;                  // Versão do dicionário quando a fase em curso começou.
+    TarefaCompactacao *pilha;
+    size_t totalPilha, capacidadePilha;
+    uint64_t palavras, somaProfundidades; // Medição em curso.
+    uint32_t profundidadeMaxima;
+    ArenaNos arena;                   // Arena nova (na fase da cópia).
+    NoTST *raiz;                      // Raiz da cópia.
+    ResultadoCompactacao resultado;
+} CompactacaoTrie;
+
+// ================================ FUNÇÕES DO DICIONÁRIO ============================
+// As funções são declaradas aqui, mas suas implementações ocorrerão no arquivo 'manipuladorDoDicionario.c'.
+
+// Inicializa o dicionário.
+Dicionario *inicializarDicionario();
+
+// Inicializa um novo nó da Trie com o caractere fornecido, obtido da arena.
+NoTST *inicializarNo(ArenaNos *arena, char caractere);
+
+// Liberta o dicionário e todos os seus nós (descartando os blocos da arena).
+void destruirDicionario(Dicionario *dicionario);
+
+// Insere uma palavra no dicionário (com peso 0 se for nova; se já existir, mantém o seu peso). Palavras vazias ou
+// com MAX_TAMANHO_PALAVRA ou mais caracteres são rejeitadas, aqui e em todas as outras formas de inserir.
+void inserirPalavra(Dicionario *dicionario, const char *palavra);
+
+// Insere uma palavra com o peso dado, ou substitui o peso se ela já existir.
+void inserirPalavraComPeso(Dicionario *dicionario, const char *palavra, uint32_t peso);
+
+// Devolve verdadeiro se a palavra existir, guardando o seu peso em 'peso' (opcional).
+bool pesoPalavra(const Dicionario *dicionario, const char *palavra, uint32_t *peso);
+
+// Consulta se uma palavra existe no dicionário (com rastreio opcional, para uso interativo).
+bool consultarPalavra(Dicionario *dicionario, const char *palavra);
+
+// Verifica se uma palavra existe no dicionário, sem recursão e sem imprimir nada.
+bool contemPalavra(const Dicionario *dicionario, const char *palavra);
+
+// Verifica um lote de palavras; o bit i de 'resultado' fica a 1 se palavras[i] existir. Devolve quantas existem.
+// O vetor 'resultado' deve ter pelo menos (total + 63) / 64 posições.
+size_t consultarPalavrasEmLote(const Dicionario *dicionario, const char *const *palavras, size_t total, uint64_t *resultado);
+
+// Remove uma palavra do dicionário.
+void removerPalavra(Dicionario *dicionario, const char *palavra);
+
+// Atualiza uma palavra existente no dicionário.
+void atualizarPalavra(Dicionario *dicionario, const char *palavraAntiga, const char *palavraNova);
+
+// Imprime todas as palavras com o prefixo fornecido.
+void palavrasComPrefixo(Dicionario *dicionario, const char *prefixo);
+
+// Chama 'visitar' para cada palavra com o prefixo fornecido, por ordem, até ela devolver falso. Devolve quantas visitou.
+size_t procurarPorPrefixo(const Dicionario *dicionario, const char *prefixo, VisitantePalavra visitar, void *contexto);
+
+// Chama 'visitar' para as (no máximo) k palavras de maior peso com o prefixo fornecido, por ordem decrescente de peso
+// (os empates ficam numa ordem qualquer). Só visita os nós cujo limite de peso ainda pode entrar nas k melhores,
+// portanto o custo não depende de quantas palavras partilham o prefixo. Devolve quantas visitou.
+size_t melhoresComPrefixo(const Dicionario *dicionario, const char *prefixo, size_t k, VisitantePeso visitar, void *contexto);
+
+// Imprime as k palavras de maior peso com o prefixo fornecido.
+void autocompletarPrefixo(Dicionario *dicionario, const char *prefixo, size_t k);
+
+// Retorna o prefixo mais longo de uma palavra que existe no dicionário.
+char *prefixoMaisLongo(Dicionario *dicionario, const char *palavra);
+
+// Imprime todas as palavras que estão a uma certa distância (exata ou máxima) de edição de uma palavra base.
+void palavrasPorDistanciaMinima(Dicionario *dicionario, const char *palavraBase, int distancia, ModoDistancia modo);
+
+// Chama 'visitar' para cada palavra à distância de edição pedida (exata ou máxima), por ordem. Devolve quantas encontrou.
+size_t procurarPorDistancia(const Dicionario *dicionario, const char *palavraBase, int distancia, ModoDistancia modo,
+                            VisitanteDistancia visitar, void *contexto);
+
+// Verifica a ortografia de um ficheiro de texto usando o dicionário.
+void verificarOrtografia(Dicionario *dicionario, const char *ficheiroTexto);
+
+// Verifica a ortografia de um ficheiro sem interação, lendo-o em blocos grandes e preservando o texto original.
+bool verificarOrtografiaEmLote(const Dicionario *dicionario, const char *ficheiroTexto, const OpcoesVerificacao *opcoes,
+                               ResultadoVerificacao *resultado);
+
+// Imprime todas as palavras no dicionário em ordem.
+void imprimirIndice(Dicionario *dicionario);
+
+// ================================ FUNÇÕES DO CURSOR ================================
+// O cursor enumera as palavras por ordem sem recursão e sem imprimir: o chamador decide quantas quer de cada vez, pode
+// parar a meio e pode saltar para uma chave. Fora do modo concorrente, o dicionário não pode ser alterado enquanto um
+// cursor está aberto; no modo concorrente, o cursor vê a versão publicada quando foi aberto e tem de ser usado e
+// fechado pela thread que o abriu (os nós retirados entretanto só são libertados depois de ele ser fechado).
+
+// Abre um cursor antes da primeira palavra com o prefixo (todas, se for vazio). Devolve falso se o prefixo for longo
+// demais (o cursor fica fechado).
+bool abrirCursor(CursorDicionario *cursor, const Dicionario *dicionario, const char *prefixo);
+
+// Reposiciona o cursor antes da primeira palavra com o prefixo que não é menor do que a chave.
+void posicionarCursor(CursorDicionario *cursor, const char *chave);
+
+// Avança para a próxima palavra, que fica em cursor->palavra. Devolve falso quando não houver mais.
+bool avancarCursor(CursorDicionario *cursor);
+
+// Copia para 'destino' até 'maximo' palavras seguintes, cada uma terminada em '\0', sem passar de 'tamanho' bytes
+// (a palavra que não couber fica para a chamada seguinte). Devolve quantas copiou.
+size_t proximasPalavras(CursorDicionario *cursor, char *destino, size_t tamanho, size_t maximo);
+
+// Fecha o cursor (termina a leitura concorrente e liberta a pilha, se tiver crescido).
+void fecharCursor(CursorDicionario *cursor);
+
+// ================================ FUNÇÕES DA CACHE DE SUGESTÕES ====================
+// As sugestões de correção de uma palavra desconhecida são calculadas uma vez e guardadas na cache; qualquer
+// alteração do dicionário incrementa a sua versão. Uma entrada antiga só é recalculada se uma das palavras alteradas
+// desde então estiver perto da sua (verificadas em lote pela distância vetorizada) ou se já não as conhecer todas.
+
+// Cria uma cache de sugestões com 'totalConjuntos' conjuntos de VIAS_CACHE_SUGESTOES entradas.
+CacheSugestoes *criarCacheSugestoes(size_t totalConjuntos);
+
+// Liberta a cache de sugestões.
+void destruirCacheSugestoes(CacheSugestoes *cache);
+
+// Escreve em 'sugestoes' as palavras mais próximas (até DISTANCIA_SUGESTOES), separadas por ", ", usando a cache.
+// Pode ser chamada por várias threads ao mesmo tempo. Devolve quantas sugestões foram escritas.
+size_t sugerirCorrecoes(const Dicionario *dicionario, const char *palavra, char *sugestoes, size_t tamanho);
+
+// Soma os contadores de acertos e falhas de todos os fragmentos da cache.
+void estatisticasCacheSugestoes(const Dicionario *dicionario, EstatisticasCacheSugestoes *estatisticas);
+
+// Verifica a integridade do ficheiro com o hash armazenado no dicionário.
+bool verificarIntegridadeFicheiro(Dicionario *dicionario, const char *nomeFicheiro);
+
+// Compara o ficheiro com o manifesto guardado no dicionário. 'totalIntervalos' recebe quantos intervalos de bytes
+// mudaram (blocos alterados seguidos formam um só intervalo; sem manifesto, o ficheiro inteiro conta como alterado)
+// e 'intervalos' os primeiros 'maximo' deles. Devolve falso se o ficheiro não puder ser lido.
+bool verificarAlteracoesFicheiro(Dicionario *dicionario, const char *nomeFicheiro, IntervaloFicheiro *intervalos,
+                                 size_t maximo, size_t *totalIntervalos);
+
+// ================================ FUNÇÕES DA RECARGA INCREMENTAL ===================
+// A recarga compara o ficheiro com a cópia guardada na recarga anterior e só separa em palavras as linhas que mudaram;
+// as palavras que entraram, saíram ou mudaram de peso são aplicadas com inserirPalavra/removerPalavra. Sem cópia
+// (primeira recarga), o ficheiro inteiro é comparado com as palavras do dicionário. Com o diário de alterações aberto,
+// as diferenças também são registadas nele, para que a sua repetição no arranque seguinte chegue às mesmas palavras.
+
+// Recarrega o ficheiro no dicionário, aplicando só as diferenças. No modo concorrente, as consultas continuam a ser
+// servidas durante a recarga. Devolve falso se o ficheiro não puder ser lido ou faltar memória.
+bool recarregarFicheiro(Dicionario *dicionario, const char *nomeFicheiro, ResultadoRecarga *resultado);
+
+// Liberta a base da recarga incremental.
+void libertarBaseRecarga(BaseRecarga *base);
+
+// Liga o modo concorrente e começa a vigiar o ficheiro, recarregando-o sempre que for gravado. Devolve falso se não
+// for possível.
+bool ligarVigiaFicheiro(Dicionario *dicionario, const char *nomeFicheiro);
+
+// Para a vigia do ficheiro (espera que uma recarga em curso termine).
+void desligarVigiaFicheiro(Dicionario *dicionario);
+
+// Copia o resultado da última recarga da vigia e quantas recargas ela fez. Devolve falso se a vigia estiver desligada.
+bool consultarVigiaFicheiro(const Dicionario *dicionario, ResultadoRecarga *ultima, size_t *recargas, size_t *falhas);
+
+// ================================ FUNÇÕES DO DIÁRIO DE ALTERAÇÕES ==================
+// As funções "Duravel" aplicam a alteração e só voltam depois de ela estar no diário do ficheiro de texto, de onde é
+// reposta no próximo arranque. Várias threads (no modo concorrente) partilham a mesma escrita e o mesmo fdatasync.
+// Quando o diário passa de LIMITE_COMPACTACAO_DIARIO, é compactado em segundo plano: o instantâneo passa a incluir as
+// alterações e o diário fica com uma só entrada por palavra alterada.
+
+// Abre (ou cria) o diário de 'nomeOrigem' e aplica as entradas posteriores a dicionario->sequenciaDiario; uma entrada
+// meio escrita no fim (o programa terminou a meio de uma escrita) é descartada. 'repostas' (opcional) recebe quantas
+// entradas foram aplicadas. Devolve falso se o diário não puder ser aberto ou não for um diário válido.
+bool abrirDiarioAlteracoes(Dicionario *dicionario, const char *nomeOrigem, size_t *repostas);
+
+// Grava as entradas pendentes, espera pela compactação em curso e fecha o diário.
+void fecharDiarioAlteracoes(Dicionario *dicionario);
+
+// Aplica uma alteração e acrescenta-a ao diário, sem esperar que fique no disco ('palavraNova' só é usada em
+// DIARIO_ATUALIZAR e 'peso' em DIARIO_INSERIR_COM_PESO). Devolve a sequência da entrada, a passar a esperarDiario;
+// SEQUENCIA_DIARIO_FALHADA se a alteração ficou só em memória porque o diário falhou (esperarDiario devolve falso);
+// ou 0 se não há diário aberto (a alteração fica só em memória) ou foi rejeitada (palavra vazia ou com
+// MAX_TAMANHO_PALAVRA ou mais caracteres, que não é aplicada).
+uint64_t aplicarAlteracaoRegistada(Dicionario *dicionario, TipoEntradaDiario tipo, const char *palavra,
+                                   const char *palavraNova, uint32_t peso);
+
+// Como aplicarAlteracaoRegistada, para quem já tem o trinco do diário (se ele estiver aberto). A recarga do ficheiro
+// toma-o antes do trinco dos escritores, pela mesma ordem das alterações registadas, e regista todas as diferenças.
+// A compactação que as entradas pedirem só é lançada por compactarDiarioSePedido, depois de largar o trinco.
+uint64_t aplicarAlteracaoRegistadaComTrinco(Dicionario *dicionario, TipoEntradaDiario tipo, const char *palavra,
+                                            const char *palavraNova, uint32_t peso);
+
+// Espera que a entrada 'sequencia' (e todas as anteriores) esteja no disco. Devolve falso se a escrita falhou.
+bool esperarDiario(Dicionario *dicionario, uint64_t sequencia);
+
+// Indica, sem esperar, se a entrada 'sequencia' já está no disco; 'falhou' (opcional) recebe verdadeiro se uma
+// escrita falhou e ela nunca vai estar.
+bool consultarDiarioDuravel(Dicionario *dicionario, uint64_t sequencia, bool *falhou);
+
+// Devolve um descritor (eventfd) que fica legível depois de cada escrita do diário, para esperar pelas entradas com
+// epoll/poll em vez de esperarDiario, ou -1 se o diário não estiver aberto ou não tiver aviso. Quem o lê deve
+// consultar consultarDiarioDuravel: uma leitura pode juntar várias escritas.
+int descritorAvisoDiario(const Dicionario *dicionario);
+
+// Versões duráveis de inserirPalavra, inserirPalavraComPeso, removerPalavra e atualizarPalavra. Devolvem falso se a
+// alteração ficou só em memória.
+bool inserirPalavraDuravel(Dicionario *dicionario, const char *palavra);
+bool inserirPalavraComPesoDuravel(Dicionario *dicionario, const char *palavra, uint32_t peso);
+bool removerPalavraDuravel(Dicionario *dicionario, const char *palavra);
+bool atualizarPalavraDuravel(Dicionario *dicionario, const char *palavraAntiga, const char *palavraNova);
+
+// Lança a compactação do diário em segundo plano. Devolve falso se já houver uma em curso ou faltar memória.
+bool compactarDiarioAlteracoes(Dicionario *dicionario);
+
+// Lança a compactação se uma escrita do diário a pediu (o diário cresceu o suficiente). Chamada sem o trinco do
+// diário, por quem o largou depois de aplicarAlteracaoRegistadaComTrinco.
+bool compactarDiarioSePedido(Dicionario *dicionario);
+
+// Espera que a compactação em curso (se houver) termine; no modo concorrente, ela lê a Trie como as outras leituras.
+void esperarCompactacaoDiario(Dicionario *dicionario);
+
+// Copia os contadores do diário. Devolve falso se o diário não estiver aberto.
+bool consultarDiarioAlteracoes(const Dicionario *dicionario, EstatisticasDiario *estatisticas);
+
+// ================================ FUNÇÕES DE CARREGAMENTO EM LOTE ==================
+// O carregamento em lote ordena as palavras e constrói a Trie equilibrada, independentemente da ordem do ficheiro.
+
+// Ordena as palavras (na mesma ordem de caracteres usada pela Trie) e remove as repetidas, atualizando o total.
+void ordenarPalavrasSemRepeticao(FatiaPalavra *palavras, size_t *total);
+
+// Constrói diretamente uma Trie equilibrada com as palavras ordenadas e sem repetições do intervalo [inicio, fim).
+// Todas as palavras do intervalo partilham os primeiros 'profundidade' caracteres e são mais longas do que isso.
+// Marca 'falhou' (que deve entrar a falso) se faltar memória; nesse caso a Trie devolvida está incompleta.
+NoTST *construirTSTBalanceada(ArenaNos *arena, const FatiaPalavra *palavras, size_t inicio, size_t fim, int profundidade,
+                              bool *falhou);
+
+// Insere um lote de palavras no dicionário de forma equilibrada (ordena e remove repetidas no próprio vetor).
+// Devolve falso se faltar memória ao construir a Trie vazia (que fica vazia, sem nenhuma das palavras).
+bool inserirPalavrasEmLote(Dicionario *dicionario, FatiaPalavra *palavras, size_t total);
+
+// ================================ FUNÇÕES DA ARENA DE NÓS ==========================
+// A arena entrega os nós da Trie em blocos contíguos e recicla os nós removidos.
+
+// Inicializa uma arena vazia.
+void inicializarArena(ArenaNos *arena);
+
+// Obtém um nó da arena (da lista de livres ou do bloco atual).
+NoTST *alocarNoArena(ArenaNos *arena);
+
+// Devolve um nó à lista de livres da arena para ser reutilizado.
+void libertarNoArena(ArenaNos *arena, NoTST *no);
+
+// Liberta todos os blocos da arena de uma só vez.
+void destruirArena(ArenaNos *arena);
+
+// ================================ FUNÇÕES DA COMPACTAÇÃO DA TRIE ===================
+// As remoções só libertam os nós sem filhos: um nó que deixou de ter palavras por baixo mas ainda tem irmãos fica na
+// Trie, e as cadeias de irmãos desequilibram-se com as inserções. A compactação poda esses ramos, reequilibra cada
+// nível e copia os nós para uma arena nova, em pré-ordem, sem a lista de livres. Corre por fatias de tempo limitado
+// (por exemplo, entre os pedidos do servidor); durante a cópia, a Trie ocupa temporariamente o dobro dos nós. Só
+// trabalha sobre a Trie de ponteiros, fora do modo concorrente, e, como uma alteração, não pode decorrer com um
+// cursor aberto.
+
+// Começa uma compactação. Devolve falso se o dicionário estiver congelado ou no modo concorrente.
+bool iniciarCompactacaoTrie(Dicionario *dicionario, CompactacaoTrie *compactacao);
+
+// Trata no máximo cerca de 'orcamento' nós (o dobro por cada recomeço) e devolve verdadeiro quando a compactação
+// terminou (ou foi abandonada; ver compactacao->resultado.falhou). Ao terminar, a Trie nova substitui a antiga e os
+// recursos são libertados.
+bool avancarCompactacaoTrie(Dicionario *dicionario, CompactacaoTrie *compactacao, size_t orcamento);
+
+// Abandona uma compactação antes do fim (a Trie fica podada e reequilibrada até onde a poda chegou).
+void cancelarCompactacaoTrie(CompactacaoTrie *compactacao);
+
+// Compacta a Trie de uma só vez, por fatias de NOS_POR_FATIA_COMPACTACAO nós. Devolve falso se não foi possível.
+bool compactarTrie(Dicionario *dicionario, ResultadoCompactacao *resultado);
+
+// Indica se as remoções desde a última compactação passam de 1/FRACAO_REMOCOES_COMPACTACAO dos nós em uso.
+bool trieDeveSerCompactada(const Dicionario *dicionario);
+
+// ================================ FUNÇÕES DO LAYOUT COMPACTO =======================
+// O layout compacto guarda a Trie num vetor de nós com filhos indexados por 32 bits.
+// Enquanto o dicionário está congelado, as consultas usam este layout; qualquer alteração descongela-o.
+
+// Constrói a representação compacta de uma Trie de ponteiros (nós dispostos em pré-ordem, centro primeiro).
+TSTCompacta *construirTSTCompacta(const NoTST *raiz);
+
+// Liberta a representação compacta.
+void destruirTSTCompacta(TSTCompacta *compacta);
+
+// Converte o dicionário para o layout compacto, libertando os nós da Trie de ponteiros.
+bool congelarDicionario(Dicionario *dicionario);
+
+// Constrói o layout compacto minimizado: cada nível da Trie é refeito como uma árvore binária equilibrada (a forma
+// passa a depender só das palavras) e os nós com o mesmo caractere, peso e filhos são guardados uma única vez, pelo
+// que os sufixos comuns (-ção, -mente, -ando) deixam de se repetir. O resultado é um grafo acíclico que as consultas
+// do layout compacto percorrem sem alterações.
+TSTCompacta *construirTSTMinimizada(const NoTST *raiz);
+
+// Converte o dicionário para o layout compacto minimizado (só leitura; qualquer alteração descongela-o).
+bool congelarDicionarioMinimizado(Dicionario *dicionario);
+
+// Reconstrói a Trie de ponteiros a partir do layout compacto, para permitir alterações.
+bool descongelarDicionario(Dicionario *dicionario);
+
+// Consulta se uma palavra existe na representação compacta.
+bool consultarPalavraCompacta(const TSTCompacta *compacta, const char *palavra);
+
+// Imprime a memória por palavra e o tempo de consulta (ns/op) dos layouts de ponteiros, compacto e minimizado.
+void relatorioLayouts(Dicionario *dicionario);
+
+// ================================ FUNÇÕES DO INSTANTÂNEO BINÁRIO ===================
+// O instantâneo guarda o layout compacto num ficheiro que é carregado com um único mmap e consultado sem conversão.
+
+// Guarda o dicionário (no layout compacto) num instantâneo binário associado ao ficheiro de texto de origem.
+bool guardarInstantaneo(Dicionario *dicionario, const char *nomeInstantaneo, const char *nomeOrigem);
+
+// Mapeia um instantâneo binário num dicionário vazio, que fica congelado e a consultar diretamente o mapeamento.
+// Se 'nomeOrigem' não for NULL, o instantâneo só é aceite se a origem não tiver mudado desde que foi gerado.
+bool carregarInstantaneo(Dicionario *dicionario, const char *nomeInstantaneo, const char *nomeOrigem);
+
+// ================================ FUNÇÕES DO FILTRO DE BLOOM ======================
+// O filtro é opcional: é construído ao carregar o dicionário, atualizado nas inserções e reconstruído quando as
+// remoções (que não se podem desfazer num filtro de Bloom simples) passam de 1/FRACAO_REMOVIDAS_FILTRO das palavras
+// ou as inserções passam da capacidade. A reconstrução publica um filtro novo, como a raiz no modo concorrente.
+
+// Cria um filtro vazio dimensionado para 'capacidade' palavras.
+FiltroBloom *criarFiltroBloom(size_t capacidade);
+
+// Liberta o filtro.
+void destruirFiltroBloom(FiltroBloom *filtro);
+
+// Adiciona uma palavra (com o comprimento dado) ao filtro.
+void adicionarFiltroBloom(FiltroBloom *filtro, const char *palavra, size_t comprimento);
+
+// Devolve falso se a palavra de certeza não foi adicionada; verdadeiro se talvez tenha sido.
+bool talvezContenhaFiltroBloom(const FiltroBloom *filtro, const char *palavra, size_t comprimento);
+
+// (Re)constrói o filtro do dicionário com as palavras atuais. Devolve falso se não houver memória.
+bool construirFiltroDicionario(Dicionario *dicionario);
+
+// Desliga e liberta o filtro do dicionário.
+void desligarFiltroDicionario(Dicionario *dicionario);
+
+// Reconstrói o filtro do dicionário depois de uma alteração, se ele passou da capacidade ou tem remoções a mais.
+void manterFiltroDicionario(Dicionario *dicionario);
+
+// ================================ FUNÇÕES DO ÍNDICE DOBRADO =======================
+// O índice é opcional: é construído ao carregar o dicionário (se 'dobrarAoCarregar' estiver ligado) e mantido pelas
+// inserções e remoções. Dobrar uma palavra passa as letras ASCII a minúsculas e as letras latinas acentuadas (U+00C0
+// a U+00FF, em UTF-8) à letra base minúscula: "Ação", "ação" e "acao" têm todas a forma "acao".
+
+// Escreve em 'destino' a forma dobrada da palavra com o comprimento dado, numa só passagem e sem alocar memória, e
+// devolve o seu comprimento. A forma nunca é mais longa do que a palavra: 'destino' precisa de comprimento + 1 bytes.
+size_t dobrarPalavra(const char *palavra, size_t comprimento, char *destino);
+
+// (Re)constrói o índice dobrado com as palavras atuais. Devolve falso se não houver memória. Não pode ser chamada
+// enquanto outras threads consultam o índice.
+bool construirIndiceDobrado(Dicionario *dicionario);
+
+// Desliga e liberta o índice dobrado do dicionário.
+void desligarIndiceDobrado(Dicionario *dicionario);
+
+// Acrescenta uma palavra ao índice dobrado, se ele estiver ligado e ainda não a tiver (chamada pelas inserções).
+void acrescentarGrafiaDobrada(Dicionario *dicionario, const char *palavra, size_t comprimento);
+
+// Retira uma palavra do índice dobrado, se ele estiver ligado e a tiver (chamada pelas remoções).
+void retirarGrafiaDobrada(Dicionario *dicionario, const char *palavra);
+
+// Verifica se a fatia do texto é, ignorando maiúsculas e acentos, uma palavra do dicionário (exige o índice).
+bool contemPalavraDobrada(const Dicionario *dicionario, const char *palavra, size_t comprimento);
+
+// Chama 'visitar' para cada grafia do dicionário com a mesma forma dobrada que a palavra, até ela devolver falso.
+// Devolve quantas visitou (0 se o índice estiver desligado). No modo concorrente, o índice fica trancado para leitura
+// durante as visitas: 'visitar' não pode alterar o dicionário.
+size_t procurarPalavraDobrada(const Dicionario *dicionario, const char *palavra, VisitantePalavra visitar, void *contexto);
+
+// ================================ FUNÇÕES DO MODO CONCORRENTE ====================
+// No modo concorrente, inserirPalavra e removerPalavra podem ser chamadas enquanto outras threads consultam o
+// dicionário (contemPalavra, consultarPalavrasEmLote, procurarPorDistancia e sugerirCorrecoes) sem trincos.
+// As restantes operações (impressões, congelar, instantâneos) devem correr com os leitores parados.
+
+// Liga o modo concorrente (descongelando o dicionário, se preciso). Devolve falso se não for possível.
+bool ligarModoConcorrente(Dicionario *dicionario);
+
+// Desliga o modo concorrente e liberta os objetos retirados. Nenhuma thread pode estar a ler.
+void desligarModoConcorrente(Dicionario *dicionario);
+
+// Marca o início de uma leitura da thread atual. Devolve o lugar a passar a terminarLeituraConcorrente.
+LeitorEpoca *iniciarLeituraConcorrente(const Dicionario *dicionario);
+
+// Marca o fim de uma leitura iniciada com iniciarLeituraConcorrente.
+void terminarLeituraConcorrente(const Dicionario *dicionario, LeitorEpoca *leitor);
+
+// Insere uma palavra copiando o caminho alterado e publicando a nova raiz (chamada por inserirPalavra).
+// Se 'substituirPeso' for falso, uma palavra que já existia mantém o seu peso.
+void inserirPalavraConcorrente(Dicionario *dicionario, const char *palavra, uint32_t peso, bool substituirPeso);
+
+// Remove uma palavra copiando o caminho alterado e publicando a nova raiz (chamada por removerPalavra).
+void removerPalavraConcorrente(Dicionario *dicionario, const char *palavra);
+
+// Retira um objeto da estrutura publicada; será libertado quando nenhum leitor o puder estar a usar.
+void retirarObjeto(Dicionario *dicionario, void *objeto, void (*libertar)(Dicionario *dicionario, void *objeto));
+
+// ================================ FUNÇÕES DAS ESTATÍSTICAS =========================
+// Cada thread conta no seu próprio bloco (sem trincos nem linhas de cache partilhadas); os blocos são somados só
+// quando as estatísticas são pedidas. As estatísticas são do processo, não de um dicionário em particular.
+
+// Soma as estatísticas de todas as threads (incluindo as que já terminaram).
+void obterEstatisticasDicionario(EstatisticasDicionario *estatisticas);
+
+// Põe todos os contadores a zero.
+void reiniciarEstatisticasDicionario(void);
+
+// Estima um percentil (entre 0 e 1) de um histograma de latências: devolve o limite superior do intervalo, em ns.
+uint64_t percentilLatencia(const LatenciaOperacao *latencia, double percentil);
+
+// Escreve as estatísticas num ficheiro, em texto: contadores, latências e histogramas de cada operação.
+void imprimirEstatisticasDicionario(FILE *saida);
+
+// ================================ FUNÇÕES DO SERVIDOR ==============================
+// O servidor (servidorDoDicionario.c) atende pedidos binários num socket Unix; ver OperacaoServidor. As alterações
+// são registadas no diário (se estiver aberto) e só são respondidas depois de estarem no disco.
+
+// Serve o dicionário no socket indicado até receber SIGINT/SIGTERM ou OPERACAO_ENCERRAR. Devolve falso se o socket
+// não puder ser criado.
+bool servirDicionario(Dicionario *dicionario, const char *caminhoSocket);
+
+// ================================ FUNÇÕES DE HASH ==================================
+// As funções relacionadas ao hash do ficheiro são declaradas aqui.
+
+// Gera o hash de um ficheiro (a raiz do seu manifesto, em hexadecimal).
+char *gerarHashFicheiro(const char *nomeFicheiro);
+
+// Acumula o hash djb2 de um bloco de bytes, continuando a partir do valor 'hash' (5381 no início). Usado para as
+// palavras curtas (a cache de sugestões); os ficheiros usam hashXXH64.
+unsigned long acumularHash(unsigned long hash, const unsigned char *dados, size_t tamanho);
+
+// Calcula o hash XXH64 de um bloco de bytes (quatro acumuladores independentes, 32 bytes por volta).
+uint64_t hashXXH64(const void *dados, size_t tamanho, uint64_t semente);
+
+// Converte o valor do hash para a string guardada no dicionário.
+char *formatarHash(uint64_t hash);
+
+// Prepara um manifesto vazio para um ficheiro com 'tamanho' bytes. Devolve falso se faltar memória.
+bool iniciarManifesto(ManifestoFicheiro *manifesto, uint64_t tamanho);
+
+// Calcula o hash do bloco 'bloco' do manifesto; 'dados' é o conteúdo do ficheiro inteiro.
+void hashBlocoManifesto(ManifestoFicheiro *manifesto, const unsigned char *dados, size_t bloco);
+
+// Calcula a raiz do manifesto depois de todos os blocos terem hash.
+void concluirManifesto(ManifestoFicheiro *manifesto);
+
+// Gera o manifesto completo de um conteúdo em memória. Devolve falso se faltar memória.
+bool gerarManifesto(ManifestoFicheiro *manifesto, const unsigned char *dados, size_t tamanho);
+
+// Liberta os hashes de um manifesto.
+void libertarManifesto(ManifestoFicheiro *manifesto);
+
+// Passa a guardar no dicionário o manifesto (alocado com malloc, ou NULL) e a sua raiz como hash do ficheiro.
+void substituirManifesto(Dicionario *dicionario, ManifestoFicheiro *manifesto);
+
+// Compara dois manifestos: devolve quantos intervalos de bytes diferem e preenche os primeiros 'maximo'.
+size_t compararManifestos(const ManifestoFicheiro *antigo, const ManifestoFicheiro *atual,
+                          IntervaloFicheiro *intervalos, size_t maximo);
+
+// ================================ FUNÇÕES DE FICHEIROS MAPEADOS ====================
+// Os ficheiros grandes são lidos com mmap, sem cópias para buffers intermédios.
+
+// Mapeia um ficheiro inteiro em memória, só para leitura. Devolve falso se não for possível.
+bool mapearFicheiro(const char *nomeFicheiro, FicheiroMapeado *ficheiro);
+
+// Desfaz o mapeamento de um ficheiro.
+void desmapearFicheiro(FicheiroMapeado *ficheiro);
+
+// Compara o hash armazenado no dicionário com um hash fornecido.
+bool compararHashFicheiro(Dicionario *dicionario, const char *hashComparacao);
+
+// ================================ FUNÇÕES AUXILIARES ==================================
+// Estas funções são usadas como auxiliares para evitar a sobrecarga das funções principais.
+
+// Função auxiliar para inserir um nó na árvore. Uma palavra nova recebe 'peso'; uma que já existia só o recebe se
+// 'substituirPeso' for verdadeiro.
+NoTST *inserirNo(ArenaNos *arena, NoTST *raiz, const char *palavra, int indice, uint32_t peso, bool substituirPeso);
+
+// Recalcula o limite do maior peso da subárvore de um nó a partir do seu peso e dos limites dos filhos.
+void atualizarPesoMaximo(NoTST *no);
+
+// Função auxiliar para consultar uma palavra na árvore, imprimindo cada passo (rastreio).
+bool consultarPalavraRecursivo(NoTST *raiz, const char *palavra, int indice);
+
+// Função auxiliar para consultar uma palavra na árvore num único percurso iterativo, sem efeitos secundários.
+bool consultarPalavraIterativo(const NoTST *raiz, const char *palavra);
+
+// Função auxiliar para verificar se um nó está vazio (ou seja, não tem filhos).
+bool noEstaVazio(NoTST *no);
+
+// Função auxiliar para remover uma palavra na árvore.
+NoTST *removerPalavraRecursivo(ArenaNos *arena, NoTST *raiz, const char *palavra, int indice);
+
+// Função auxiliar que percorre a Trie calculando uma linha de distâncias por profundidade e podando as subárvores sem candidatas.
+void palavrasPorDistanciaMinimaAux(const NoTST *no, int profundidade, ProcuraDistancia *procura);
+
+// Versão da função auxiliar anterior para o layout compacto.
+void palavrasPorDistanciaMinimaCompacta(const TSTCompacta *compacta, uint32_t indice, int profundidade, ProcuraDistancia *procura);
+
+// Função que retorna o menor de três números.
+int min(int a, int b, int c);
+
+// Função que calcula a distância de edição entre duas palavras.
+int distanciaEdicao(const char *palavra1, int comprimento1, const char *palavra2, int comprimento2);
+
+// ================================ FUNÇÕES DA DISTÂNCIA BIT-PARALELA ================
+// Distância de edição pelo algoritmo bit-paralelo de Myers/Hyyrö: uma coluna inteira da matriz cabe num inteiro de 64 bits.
+
+// Prepara um padrão (até MAX_PADRAO_BIT_PARALELO caracteres). Devolve falso se o padrão for longo demais.
+bool prepararPadraoBitParalelo(PadraoBitParalelo *padrao, const char *palavra, int comprimento);
+
+// Calcula a distância de edição entre o padrão e um texto.
+int distanciaEdicaoBitParalela(const PadraoBitParalelo *padrao, const char *texto, int comprimento);
+
+// Calcula a distância de edição, parando assim que ela for garantidamente maior do que o limite (devolve limite + 1).
+int distanciaEdicaoLimitada(const PadraoBitParalelo *padrao, const char *texto, int comprimento, int limite);
+
+// Calcula a distância do padrão a um lote de candidatas, várias de cada vez (vetorizado com AVX2 ou SSE2 quando disponível).
+// Se o limite for negativo, as distâncias são exatas; caso contrário, as que excedem o limite valem limite + 1.
+void distanciaEdicaoLote(const PadraoBitParalelo *padrao, const char *const *candidatas, const int *comprimentos,
+                         size_t total, int limite, int *resultados);
+
+// Função para tratar palavra não encontrada no dicionário
+void tratarPalavraNaoEncontrada(Dicionario *dicionario, FILE *fileOutput, const char *palavra);
+
+// ================================ FUNÇÕES PARA O MENU ==================================
+// Estas funções são usadas para ajudar nas funcionalidades do menu.
+
+// Função para carregar as palavras do ficheiro e preenchê-las na TRIE TST
+void carregarPalavrasDoFicheiro(Dicionario *dicionario, const char *nomeFicheiro);
+
+// Carrega o ficheiro mapeado em memória numa única passagem (palavras e hash), sem imprimir nada. Um número logo a
+// seguir à primeira palavra de uma linha ("palavra 123") é o peso dessa palavra.
+// Devolve falso se o ficheiro não puder ser lido ou faltar memória; 'rejeitadas' (opcional) recebe as palavras
+// longas demais.
+bool carregarFicheiroMapeado(Dicionario *dicionario, const char *nomeFicheiro, size_t *rejeitadas);
+
+// Mostra as palavras com o prefixo por páginas de PALAVRAS_POR_PAGINA, a partir da primeira que não é menor do que
+// 'inicio' (NULL para começar no princípio).
+void paginarPalavrasComPrefixo(Dicionario *dicionario, const char *prefixo, const char *inicio);
+
+// Função para executar a opção escolhida no Menu Principal
+void executarOpcao(Dicionario *dicionario, int opcao, const char *nomeFicheiro);
+
+// Função para exibir as opções disponíveis ao usuário
+void menu(int opcao_selecionada);
+
+// Função para carregar e controlar o Menu Principal
+void menuPrincipal(Dicionario *dicionario, const char *nomeFicheiro);
+
+// ================================ FUNÇÕES DO MAIN ==================================
+// Estas funções são usadas para inicializar o programa ou parte dele.
+
+// Função que dá início ao programa
+void iniciarPrograma();
+
+// ================================ FIM DA GUARDA DE INCLUSÃO ========================
+#endif // DICIONARIO_H
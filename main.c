@@ -0,0 +1,13 @@
+// ================================ BIBLIOTECAS INCLUÍDAS ============================
+
+// Biblioteca personalizada para operações específicas do dicionário.
+#include "dicionario.h"
+
+// ================================ MAIN ============================================
+
+// Ponto de entrada do programa interativo; toda a lógica está na biblioteca do dicionário.
+int main(void)
+{
+    iniciarPrograma();
+    return 0;
+}
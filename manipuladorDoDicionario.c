@@ -1,3 +1,8 @@
+// ================================ DEFINIÇÕES DO SISTEMA ============================
+
+// Ativa as extensões POSIX/GNU (mmap, madvise, strdup, st_mtim) antes de incluir qualquer biblioteca.
+#define _GNU_SOURCE
+
 // ================================ BIBLIOTECAS INCLUÍDAS ============================
 
 // Biblioteca personalizada para operações específicas do dicionário.
@@ -15,6 +20,34 @@
 // Biblioteca para configurar as definições locais/regional do sistema.
 #include <locale.h>
 
+// Biblioteca padrão do C para medir o tempo (usada nos relatórios de desempenho).
+#include <time.h>
+
+// Biblioteca padrão do C para classificar caracteres (espaços em branco, dígitos, etc.).
+#include <ctype.h>
+
+// Intrínsecas SSE2/AVX2 para o cálculo vetorizado da distância de edição (apenas em x86).
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Bibliotecas POSIX para mapear ficheiros em memória (open, fstat, mmap).
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Biblioteca POSIX de threads (verificação ortográfica em paralelo).
+#include <pthread.h>
+
+// Bibliotecas Linux para vigiar o ficheiro do dicionário (inotify) e esperar pelos seus eventos.
+#include <errno.h>
+#include <poll.h>
+#include <sys/inotify.h>
+
+// Biblioteca Linux para avisar, sem bloquear, que as entradas do diário estão no disco (eventfd).
+#include <sys/eventfd.h>
+
 // ================================ FUNÇÕES DO DICIONÁRIO ============================
 // As implementações das funções declaradas no arquivo 'dicionario.h' ocorrem aqui.
 
@@ -35,24 +68,289 @@ void printTST(NoTST *no) {
 }
 
 
-void destruirNo(NoTST *no) {
-    if (no == NULL) {
+// Liberta o dicionário. Os nós vivem nos blocos da arena, portanto não é preciso percorrer a Trie:
+// basta descartar os blocos, um free por bloco em vez de um free por nó.
+void destruirDicionario(Dicionario *dicionario) {
+    if (dicionario == NULL) {
         return;
     }
 
-    destruirNo(no->esquerda);
-    destruirNo(no->centro);
-    destruirNo(no->direito);
+    fecharDiarioAlteracoes(dicionario);
+    desligarModoConcorrente(dicionario);
+    destruirArena(&dicionario->arena);
+    destruirTSTCompacta(dicionario->compacta);
+    destruirCacheSugestoes(dicionario->sugestoes);
+    destruirFiltroBloom(dicionario->filtro);
+    substituirManifesto(dicionario, NULL);
+    libertarBaseRecarga(dicionario->base);
+    desligarIndiceDobrado(dicionario);
+    free(dicionario);
+}
+
+//!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+// *********************************** ESTATÍSTICAS ***********************************
 
-    free(no);
+// Struct auxiliar com os contadores de uma thread, alinhada a uma linha de cache para que as threads não partilhem
+// linhas ao contar. Só a própria thread escreve no seu bloco; as leituras das outras threads são relaxadas.
+typedef struct BlocoEstatisticas
+{
+    EstatisticasDicionario valores;
+    uint32_t ateAmostra; // Operações até à próxima cronometrada.
+    struct BlocoEstatisticas *anterior, *proximo;
+} __attribute__((aligned(64))) BlocoEstatisticas;
+
+// Blocos das threads vivas, soma dos blocos das threads que já terminaram e o trinco que protege ambos.
+static pthread_mutex_t trincoEstatisticas = PTHREAD_MUTEX_INITIALIZER;
+static BlocoEstatisticas *blocosEstatisticas = NULL;
+static EstatisticasDicionario estatisticasTerminadas;
+
+// Bloco usado pelas threads para as quais não foi possível alocar um bloco próprio (os contadores são partilhados).
+static BlocoEstatisticas blocoEstatisticasReserva = {.ateAmostra = 1};
+
+// Chave cujo destrutor junta o bloco de uma thread que termina às estatísticas das threads terminadas.
+static pthread_key_t chaveEstatisticas;
+static pthread_once_t chaveEstatisticasCriada = PTHREAD_ONCE_INIT;
+
+// Bloco da thread atual (NULL até à primeira operação da thread).
+static __thread BlocoEstatisticas *estatisticasThread = NULL;
+
+// Soma um valor a um contador do bloco da thread atual. Só a thread dona escreve, portanto não é preciso uma
+// instrução atómica de leitura-modificação-escrita; a leitura e a escrita relaxadas só evitam que o compilador
+// junte ou rasgue os acessos que as outras threads leem.
+static inline void somarContador(uint64_t *contador, uint64_t valor)
+{
+    __atomic_store_n(contador, __atomic_load_n(contador, __ATOMIC_RELAXED) + valor, __ATOMIC_RELAXED);
 }
 
-void destruirDicionario(Dicionario *dicionario) {
-    destruirNo(dicionario->raiz);
-    free(dicionario);
+// Guarda o maior valor visto num contador (só escrito pela thread dona).
+static inline void maximoContador(uint64_t *contador, uint64_t valor)
+{
+    if (valor > __atomic_load_n(contador, __ATOMIC_RELAXED))
+        __atomic_store_n(contador, valor, __ATOMIC_RELAXED);
 }
 
-//!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+// Acumula as estatísticas de 'origem' em 'destino', lendo a origem com leituras relaxadas.
+static void acumularEstatisticas(EstatisticasDicionario *destino, EstatisticasDicionario *origem)
+{
+    destino->nosVisitados += __atomic_load_n(&origem->nosVisitados, __ATOMIC_RELAXED);
+    destino->passosLaterais += __atomic_load_n(&origem->passosLaterais, __ATOMIC_RELAXED);
+    destino->passosCentrais += __atomic_load_n(&origem->passosCentrais, __ATOMIC_RELAXED);
+    if (__atomic_load_n(&origem->profundidadeMaxima, __ATOMIC_RELAXED) > destino->profundidadeMaxima)
+        destino->profundidadeMaxima = __atomic_load_n(&origem->profundidadeMaxima, __ATOMIC_RELAXED);
+    destino->nosAlocados += __atomic_load_n(&origem->nosAlocados, __ATOMIC_RELAXED);
+    destino->nosLibertados += __atomic_load_n(&origem->nosLibertados, __ATOMIC_RELAXED);
+    destino->blocosAlocados += __atomic_load_n(&origem->blocosAlocados, __ATOMIC_RELAXED);
+
+    for (int i = 0; i < TOTAL_ESTATISTICAS; i++)
+    {
+        LatenciaOperacao *latencia = &origem->latencias[i];
+        destino->latencias[i].operacoes += __atomic_load_n(&latencia->operacoes, __ATOMIC_RELAXED);
+        destino->latencias[i].amostras += __atomic_load_n(&latencia->amostras, __ATOMIC_RELAXED);
+        destino->latencias[i].nanossegundos += __atomic_load_n(&latencia->nanossegundos, __ATOMIC_RELAXED);
+        for (int j = 0; j < INTERVALOS_HISTOGRAMA; j++)
+            destino->latencias[i].histograma[j] += __atomic_load_n(&latencia->histograma[j], __ATOMIC_RELAXED);
+    }
+}
+
+// Põe a zero os contadores de um bloco (com escritas relaxadas, porque a thread dona pode estar a contar).
+static void zerarEstatisticas(EstatisticasDicionario *estatisticas)
+{
+    uint64_t *contadores = (uint64_t *)estatisticas;
+    for (size_t i = 0; i < sizeof(EstatisticasDicionario) / sizeof(uint64_t); i++)
+        __atomic_store_n(&contadores[i], 0, __ATOMIC_RELAXED);
+}
+
+// Junta o bloco de uma thread que terminou às estatísticas das threads terminadas e liberta-o.
+static void terminarThreadEstatisticas(void *argumento)
+{
+    BlocoEstatisticas *bloco = (BlocoEstatisticas *)argumento;
+
+    pthread_mutex_lock(&trincoEstatisticas);
+    acumularEstatisticas(&estatisticasTerminadas, &bloco->valores);
+    if (bloco->anterior != NULL)
+        bloco->anterior->proximo = bloco->proximo;
+    else
+        blocosEstatisticas = bloco->proximo;
+    if (bloco->proximo != NULL)
+        bloco->proximo->anterior = bloco->anterior;
+    pthread_mutex_unlock(&trincoEstatisticas);
+
+    free(bloco);
+}
+
+// Cria a chave das estatísticas (uma vez por processo).
+static void criarChaveEstatisticas(void)
+{
+    pthread_key_create(&chaveEstatisticas, terminarThreadEstatisticas);
+}
+
+// Cria e regista o bloco da thread atual, na sua primeira operação.
+static BlocoEstatisticas *registarBlocoEstatisticas(void)
+{
+    BlocoEstatisticas *bloco = NULL;
+
+    pthread_once(&chaveEstatisticasCriada, criarChaveEstatisticas);
+    if (posix_memalign((void **)&bloco, 64, sizeof(BlocoEstatisticas)) != 0)
+        return estatisticasThread = &blocoEstatisticasReserva;
+
+    // A primeira operação de cada thread é sempre cronometrada (útil quando há poucas, como no menu).
+    memset(bloco, 0, sizeof(BlocoEstatisticas));
+    bloco->ateAmostra = 1;
+
+    pthread_mutex_lock(&trincoEstatisticas);
+    bloco->proximo = blocosEstatisticas;
+    if (blocosEstatisticas != NULL)
+        blocosEstatisticas->anterior = bloco;
+    blocosEstatisticas = bloco;
+    pthread_mutex_unlock(&trincoEstatisticas);
+
+    pthread_setspecific(chaveEstatisticas, bloco);
+    return estatisticasThread = bloco;
+}
+
+// Devolve o bloco de estatísticas da thread atual.
+static inline BlocoEstatisticas *blocoEstatisticas(void)
+{
+    BlocoEstatisticas *bloco = estatisticasThread;
+    return __builtin_expect(bloco != NULL, 1) ? bloco : registarBlocoEstatisticas();
+}
+
+// Devolve o instante atual em nanossegundos (para as latências).
+static inline uint64_t instanteEstatisticas(void)
+{
+    struct timespec instante;
+    clock_gettime(CLOCK_MONOTONIC, &instante);
+    return (uint64_t)instante.tv_sec * 1000000000u + (uint64_t)instante.tv_nsec;
+}
+
+// Marca o início de uma operação. Só uma em cada AMOSTRAGEM_LATENCIA é cronometrada (ler o relógio custaria tanto
+// como uma consulta): devolve o instante inicial dessas, ou 0 para as restantes.
+static inline uint64_t iniciarOperacaoEstatistica(BlocoEstatisticas *bloco)
+{
+    if (--bloco->ateAmostra > 0)
+        return 0;
+
+    bloco->ateAmostra = AMOSTRAGEM_LATENCIA;
+    return instanteEstatisticas();
+}
+
+// Marca o fim de uma operação iniciada com iniciarOperacaoEstatistica.
+static inline void terminarOperacaoEstatistica(BlocoEstatisticas *bloco, OperacaoEstatistica operacao, uint64_t inicio)
+{
+    LatenciaOperacao *latencia = &bloco->valores.latencias[operacao];
+
+    somarContador(&latencia->operacoes, 1);
+    if (inicio == 0)
+        return;
+
+    uint64_t nanossegundos = instanteEstatisticas() - inicio;
+    int intervalo = nanossegundos > 0 ? 63 - __builtin_clzll(nanossegundos) : 0;
+    if (intervalo >= INTERVALOS_HISTOGRAMA)
+        intervalo = INTERVALOS_HISTOGRAMA - 1;
+
+    somarContador(&latencia->amostras, 1);
+    somarContador(&latencia->nanossegundos, nanossegundos);
+    somarContador(&latencia->histograma[intervalo], 1);
+}
+
+// Regista o percurso de uma consulta: nós visitados, passos laterais e centrais e caracteres reconhecidos.
+static inline void registarPercurso(uint64_t visitados, uint64_t laterais, uint64_t centrais, uint64_t profundidade)
+{
+    BlocoEstatisticas *bloco = blocoEstatisticas();
+
+    somarContador(&bloco->valores.nosVisitados, visitados);
+    somarContador(&bloco->valores.passosLaterais, laterais);
+    somarContador(&bloco->valores.passosCentrais, centrais);
+    maximoContador(&bloco->valores.profundidadeMaxima, profundidade);
+}
+
+// Soma as estatísticas de todas as threads (incluindo as que já terminaram).
+void obterEstatisticasDicionario(EstatisticasDicionario *estatisticas)
+{
+    pthread_mutex_lock(&trincoEstatisticas);
+    *estatisticas = estatisticasTerminadas;
+    for (BlocoEstatisticas *bloco = blocosEstatisticas; bloco != NULL; bloco = bloco->proximo)
+        acumularEstatisticas(estatisticas, &bloco->valores);
+    acumularEstatisticas(estatisticas, &blocoEstatisticasReserva.valores);
+    pthread_mutex_unlock(&trincoEstatisticas);
+}
+
+// Põe todos os contadores a zero. Uma operação que esteja a terminar noutra thread pode ainda contar.
+void reiniciarEstatisticasDicionario(void)
+{
+    pthread_mutex_lock(&trincoEstatisticas);
+    memset(&estatisticasTerminadas, 0, sizeof(estatisticasTerminadas));
+    for (BlocoEstatisticas *bloco = blocosEstatisticas; bloco != NULL; bloco = bloco->proximo)
+        zerarEstatisticas(&bloco->valores);
+    zerarEstatisticas(&blocoEstatisticasReserva.valores);
+    pthread_mutex_unlock(&trincoEstatisticas);
+}
+
+// Estima um percentil de um histograma de latências: o limite superior do intervalo onde ele cai, em ns.
+uint64_t percentilLatencia(const LatenciaOperacao *latencia, double percentil)
+{
+    uint64_t acumuladas = 0;
+    uint64_t alvo = (uint64_t)(percentil * (double)latencia->amostras);
+
+    if (latencia->amostras == 0)
+        return 0;
+
+    for (int i = 0; i < INTERVALOS_HISTOGRAMA; i++)
+    {
+        acumuladas += latencia->histograma[i];
+        if (acumuladas > alvo || acumuladas == latencia->amostras)
+            return (uint64_t)1 << (i + 1);
+    }
+    return (uint64_t)1 << INTERVALOS_HISTOGRAMA;
+}
+
+// Escreve as estatísticas num ficheiro, em texto: contadores, latências e histogramas de cada operação.
+void imprimirEstatisticasDicionario(FILE *saida)
+{
+    static const char *nomes[TOTAL_ESTATISTICAS] = {"consulta", "inserção", "remoção", "prefixo", "distância",
+                                                     "autocompletar"};
+    EstatisticasDicionario estatisticas;
+    obterEstatisticasDicionario(&estatisticas);
+
+    uint64_t consultas = estatisticas.latencias[ESTATISTICA_CONSULTA].operacoes;
+    fprintf(saida, "Nós visitados: %llu (laterais: %llu, centrais: %llu), profundidade máxima: %llu\n",
+            (unsigned long long)estatisticas.nosVisitados, (unsigned long long)estatisticas.passosLaterais,
+            (unsigned long long)estatisticas.passosCentrais, (unsigned long long)estatisticas.profundidadeMaxima);
+    if (consultas > 0)
+        fprintf(saida, "Por consulta: %.1f passos laterais, %.1f centrais\n",
+                (double)estatisticas.passosLaterais / (double)consultas,
+                (double)estatisticas.passosCentrais / (double)consultas);
+    fprintf(saida, "Arena: %llu nós alocados, %llu libertados, %llu blocos\n\n",
+            (unsigned long long)estatisticas.nosAlocados, (unsigned long long)estatisticas.nosLibertados,
+            (unsigned long long)estatisticas.blocosAlocados);
+
+    fprintf(saida, "%-13s %12s %10s %12s %10s %10s %10s\n", "Operação", "Total", "Amostras", "Média ns", "p50 <=",
+            "p99 <=", "p99.9 <=");
+    for (int i = 0; i < TOTAL_ESTATISTICAS; i++)
+    {
+        const LatenciaOperacao *latencia = &estatisticas.latencias[i];
+        fprintf(saida, "%-13s %12llu %10llu %12.1f %10llu %10llu %10llu\n", nomes[i],
+                (unsigned long long)latencia->operacoes, (unsigned long long)latencia->amostras,
+                latencia->amostras > 0 ? (double)latencia->nanossegundos / (double)latencia->amostras : 0.0,
+                (unsigned long long)percentilLatencia(latencia, 0.5), (unsigned long long)percentilLatencia(latencia, 0.99),
+                (unsigned long long)percentilLatencia(latencia, 0.999));
+    }
+
+    // Histogramas: uma linha por operação com os intervalos não vazios ("<2^(i+1) ns: amostras").
+    for (int i = 0; i < TOTAL_ESTATISTICAS; i++)
+    {
+        const LatenciaOperacao *latencia = &estatisticas.latencias[i];
+        if (latencia->amostras == 0)
+            continue;
+
+        fprintf(saida, "\n%s:", nomes[i]);
+        for (int j = 0; j < INTERVALOS_HISTOGRAMA; j++)
+            if (latencia->histograma[j] > 0)
+                fprintf(saida, " <%lluns:%llu", (unsigned long long)1 << (j + 1), (unsigned long long)latencia->histograma[j]);
+    }
+    fprintf(saida, "\n");
+}
 
 // ********************************* INICIALIZAÇÃO ***********************************
 
@@ -68,7 +366,25 @@ Dicionario *inicializarDicionario() {
 
     // Inicialização dos membros do novo objeto Dicionario
     novoDicionario->raiz = NULL;
+    memset(novoDicionario->tabelaRaiz, 0, sizeof(novoDicionario->tabelaRaiz));
     novoDicionario->hash_ficheiro = NULL;
+    novoDicionario->manifesto = NULL;
+    novoDicionario->base = NULL;
+    novoDicionario->vigia = NULL;
+    novoDicionario->diario = NULL;
+    novoDicionario->sequenciaDiario = 0;
+    novoDicionario->compacta = NULL;
+    novoDicionario->rastrearConsultas = false;
+    novoDicionario->versao = 0;
+    novoDicionario->filtro = NULL;
+    novoDicionario->concorrencia = NULL;
+    novoDicionario->dobrado = NULL;
+    novoDicionario->dobrarAoCarregar = false;
+    novoDicionario->remocoesDesdeCompactacao = 0;
+    inicializarArena(&novoDicionario->arena);
+
+    // Sem a cache as sugestões continuam a funcionar, apenas são sempre recalculadas.
+    novoDicionario->sugestoes = criarCacheSugestoes(CONJUNTOS_CACHE_SUGESTOES);
 
     // Retorno do novo objeto Dicionario
     printf("[Alocação de memória feita com sucesso!\nDicionário inicializado com sucesso!]\n");
@@ -76,10 +392,10 @@ Dicionario *inicializarDicionario() {
 }
 
 // Implementação da função inicializarNo
-NoTST *inicializarNo(char caractere)
+NoTST *inicializarNo(ArenaNos *arena, char caractere)
 {
-    // Alocar memória para o novo nó
-    NoTST *novoNo = (NoTST *)malloc(sizeof(NoTST));
+    // Obter o novo nó da arena
+    NoTST *novoNo = alocarNoArena(arena);
 
     // Verificar se a alocação de memória foi bem-sucedida
     if (novoNo == NULL)
@@ -88,9 +404,11 @@ NoTST *inicializarNo(char caractere)
         return NULL;
     }
 
-    // Inicializar o caractere do nó e a flag de fim de palavra
+    // Inicializar o caractere do nó, a flag de fim de palavra e os pesos
     novoNo->caractere = caractere;
     novoNo->fim_palavra = false;
+    novoNo->peso = 0;
+    novoNo->pesoMaximo = 0;
 
     // Inicializar todos os ponteiros dos nós filhos com NULL
     novoNo->esquerda = NULL;
@@ -101,647 +419,7743 @@ NoTST *inicializarNo(char caractere)
     return novoNo;
 }
 
+// *********************************** ARENA DE NÓS ***********************************
+
+// Inicializa uma arena vazia. Os blocos só são alocados quando o primeiro nó for pedido.
+void inicializarArena(ArenaNos *arena)
+{
+    arena->blocos = NULL;
+    arena->livres = NULL;
+    arena->nosEmUso = 0;
+    arena->totalBlocos = 0;
+}
+
+// Obtém um nó da arena, reutilizando primeiro os nós que foram libertados.
+NoTST *alocarNoArena(ArenaNos *arena)
+{
+    NoTST *no;
+
+    // Reutilizar um nó da lista de livres, se existir.
+    if (arena->livres != NULL)
+    {
+        no = arena->livres;
+        arena->livres = no->centro;
+        arena->nosEmUso++;
+        somarContador(&blocoEstatisticas()->valores.nosAlocados, 1);
+        return no;
+    }
+
+    // Se o bloco atual está cheio (ou ainda não existe), alocar um novo bloco.
+    if (arena->blocos == NULL || arena->blocos->usados == NOS_POR_BLOCO_ARENA)
+    {
+        BlocoArena *novoBloco = (BlocoArena *)malloc(sizeof(BlocoArena));
+        if (novoBloco == NULL)
+        {
+            return NULL;
+        }
+
+        novoBloco->usados = 0;
+        novoBloco->proximo = arena->blocos;
+        arena->blocos = novoBloco;
+        arena->totalBlocos++;
+        somarContador(&blocoEstatisticas()->valores.blocosAlocados, 1);
+    }
+
+    // Entregar o próximo nó contíguo do bloco atual.
+    no = &arena->blocos->nos[arena->blocos->usados++];
+    arena->nosEmUso++;
+    somarContador(&blocoEstatisticas()->valores.nosAlocados, 1);
+    return no;
+}
+
+// Devolve um nó à lista de livres. O ponteiro central do nó serve de ligação da lista.
+void libertarNoArena(ArenaNos *arena, NoTST *no)
+{
+    if (no == NULL)
+    {
+        return;
+    }
+
+    no->centro = arena->livres;
+    arena->livres = no;
+    arena->nosEmUso--;
+    somarContador(&blocoEstatisticas()->valores.nosLibertados, 1);
+}
+
+// Liberta todos os blocos da arena. O custo depende do número de blocos e não do número de nós.
+void destruirArena(ArenaNos *arena)
+{
+    BlocoArena *bloco = arena->blocos;
+
+    while (bloco != NULL)
+    {
+        BlocoArena *proximo = bloco->proximo;
+        free(bloco);
+        bloco = proximo;
+    }
+
+    inicializarArena(arena);
+}
+
+// *********************************** PESOS DAS PALAVRAS ***********************************
+
+// Converte um peso no limite de 16 bits guardado nos nós, arredondando por excesso. Os pesos menores do que
+// 2^BITS_MANTISSA_PESO ficam exatos; os restantes passam a um expoente e BITS_MANTISSA_PESO bits de mantissa (erro
+// relativo abaixo de 2^-BITS_MANTISSA_PESO). A conversão é monótona: o limite do maior peso é o maior dos limites.
+static inline uint16_t limitePeso(uint32_t peso)
+{
+    if (peso < (1u << BITS_MANTISSA_PESO))
+        return (uint16_t)peso;
+
+    int deslocamento = 31 - __builtin_clz(peso) - BITS_MANTISSA_PESO;
+    uint32_t mantissa = peso >> deslocamento;
+    if ((mantissa << deslocamento) != peso)
+        mantissa++; // Se chegar a 2^(BITS_MANTISSA_PESO + 1), a codificação passa naturalmente ao expoente seguinte.
+
+    return (uint16_t)(((uint32_t)(deslocamento + 1) << BITS_MANTISSA_PESO) + mantissa - (1u << BITS_MANTISSA_PESO));
+}
+
+// Devolve o valor representado por um limite de 16 bits (nunca menor do que os pesos que ele limita).
+static inline uint64_t valorLimitePeso(uint16_t limite)
+{
+    if (limite < (1u << BITS_MANTISSA_PESO))
+        return limite;
+
+    int deslocamento = (limite >> BITS_MANTISSA_PESO) - 1;
+    uint64_t mantissa = (limite & ((1u << BITS_MANTISSA_PESO) - 1)) + (1u << BITS_MANTISSA_PESO);
+    return mantissa << deslocamento;
+}
+
+// Recalcula o limite do maior peso da subárvore de um nó (o próprio nó, os irmãos e o centro). Só depende do nó e
+// dos filhos, portanto as alterações só o recalculam nos nós do caminho, ao subir.
+void atualizarPesoMaximo(NoTST *no)
+{
+    uint16_t maximo = no->fim_palavra ? limitePeso(no->peso) : 0;
+
+    if (no->esquerda != NULL && no->esquerda->pesoMaximo > maximo)
+        maximo = no->esquerda->pesoMaximo;
+    if (no->centro != NULL && no->centro->pesoMaximo > maximo)
+        maximo = no->centro->pesoMaximo;
+    if (no->direito != NULL && no->direito->pesoMaximo > maximo)
+        maximo = no->direito->pesoMaximo;
+
+    no->pesoMaximo = maximo;
+}
+
+// *********************************** TABELA DA RAIZ ***********************************
+
+// Preenche a tabela com os nós de um nível da Trie de ponteiros (o nó e os irmãos à esquerda e à direita).
+static void preencherTabelaRaiz(NoTST **tabela, NoTST *no)
+{
+    if (no == NULL)
+        return;
+
+    tabela[(unsigned char)no->caractere] = no;
+    preencherTabelaRaiz(tabela, no->esquerda);
+    preencherTabelaRaiz(tabela, no->direito);
+}
+
+// Reconstrói a tabela da raiz depois de a Trie de ponteiros ter sido substituída por inteiro.
+static void reconstruirTabelaRaiz(Dicionario *dicionario)
+{
+    memset(dicionario->tabelaRaiz, 0, sizeof(dicionario->tabelaRaiz));
+    preencherTabelaRaiz(dicionario->tabelaRaiz, dicionario->raiz);
+}
+
+// Atualiza a entrada de um caractere na tabela da raiz, descendo pelo primeiro nível até ao seu nó. Depois de uma
+// inserção basta a entrada do primeiro caractere da palavra: os nós existentes mantêm o endereço.
+static void atualizarTabelaRaiz(Dicionario *dicionario, char caractere)
+{
+    NoTST *no = dicionario->raiz;
+
+    while (no != NULL && no->caractere != caractere)
+        no = caractere < no->caractere ? no->esquerda : no->direito;
+    dicionario->tabelaRaiz[(unsigned char)caractere] = no;
+}
+
+// Guarda os caracteres dos nós do primeiro nível no caminho até 'caractere' e devolve quantos são. Uma remoção só
+// liberta nós deste caminho (os que ficam sem filhos), portanto são as entradas a atualizar depois dela.
+static size_t caminhoTabelaRaiz(const NoTST *no, char caractere, char *caracteres)
+{
+    size_t total = 0;
+
+    for (; no != NULL && total < TAMANHO_TABELA_RAIZ; no = caractere < no->caractere ? no->esquerda : no->direito)
+    {
+        caracteres[total++] = no->caractere;
+        if (no->caractere == caractere)
+            break;
+    }
+    return total;
+}
+
+// Preenche a tabela da raiz do layout compacto com os nós do primeiro nível.
+static void preencherTabelaRaizCompacta(TSTCompacta *compacta, uint32_t indice)
+{
+    if (indice == 0)
+        return;
+
+    compacta->tabelaRaiz[(unsigned char)compacta->nos[indice].caractere] = indice;
+    preencherTabelaRaizCompacta(compacta, compacta->nos[indice].esquerda);
+    preencherTabelaRaizCompacta(compacta, compacta->nos[indice].direito);
+}
+
 // *********************************** INSERÇÃO ***********************************
 
 // Função auxiliar para inserir um nó na árvore.
-NoTST *inserirNo(NoTST *raiz, const char *palavra, int indice) {
+NoTST *inserirNo(ArenaNos *arena, NoTST *raiz, const char *palavra, int indice, uint32_t peso, bool substituirPeso) {
     // Se a raiz é NULL, cria um novo nó.
     if (raiz == NULL) {
-        raiz = inicializarNo(palavra[indice]);
+        raiz = inicializarNo(arena, palavra[indice]);
+        if (raiz == NULL) {
+            return NULL;
+        }
     }
 
     // Se o caractere da palavra é menor que o caractere do nó,
     // então a nova palavra deve ser inserida no nó à esquerda.
     if (palavra[indice] < raiz->caractere) {
-        raiz->esquerda = inserirNo(raiz->esquerda, palavra, indice);
+        raiz->esquerda = inserirNo(arena, raiz->esquerda, palavra, indice, peso, substituirPeso);
     }
     // Se o caractere da palavra é maior que o caractere do nó,
     // então a nova palavra deve ser inserida no nó à direita.
     else if (palavra[indice] > raiz->caractere) {
-        raiz->direito = inserirNo(raiz->direito, palavra, indice);
+        raiz->direito = inserirNo(arena, raiz->direito, palavra, indice, peso, substituirPeso);
     }
     // Se o caractere da palavra é igual ao caractere do nó,
     // então a nova palavra deve ser inserida no nó do centro.
     else {
         // Se o fim da palavra ainda não foi alcançado, continue para o próximo caractere.
         if (indice + 1 < (int)strlen(palavra)) {
-            raiz->centro = inserirNo(raiz->centro, palavra, indice + 1);
+            raiz->centro = inserirNo(arena, raiz->centro, palavra, indice + 1, peso, substituirPeso);
         }
-        // Se o fim da palavra foi alcançado, marque o fim da palavra como verdadeiro.
+        // Se o fim da palavra foi alcançado, marque o fim da palavra como verdadeiro (e guarde o peso).
         else {
+            if (!raiz->fim_palavra || substituirPeso) {
+                raiz->peso = peso;
+            }
             raiz->fim_palavra = true;
         }
     }
+
+    // O peso pode ter mudado abaixo deste nó: recalcular o limite ao subir.
+    atualizarPesoMaximo(raiz);
     return raiz;
 }
 
-// Insere uma palavra no dicionário.
-void inserirPalavra(Dicionario *dicionario, const char *palavra) {
-    // Verifica se o dicionário é válido.
-    if (dicionario == NULL) {
-        printf("Dicionario invalido.\n");
+// Regista uma alteração das palavras do dicionário, que torna antigas as sugestões calculadas até aqui. A palavra
+// alterada fica na cache de sugestões, que a usa para revalidar as entradas longe dela; NULL (alteração de muitas
+// palavras de uma vez) invalida todas. A palavra é guardada antes de a versão nova ficar visível.
+static void registarAlteracao(Dicionario *dicionario, const char *palavra) {
+    CacheSugestoes *cache = dicionario->sugestoes;
+
+    if (cache == NULL)
+    {
+        __atomic_add_fetch(&dicionario->versao, 1, __ATOMIC_RELEASE);
         return;
     }
 
-    // Chama a função auxiliar para inserir a palavra.
-    dicionario->raiz = inserirNo(dicionario->raiz, palavra, 0);
+    pthread_mutex_lock(&cache->trincoAlteradas);
+    uint64_t versao = __atomic_load_n(&dicionario->versao, __ATOMIC_RELAXED) + 1;
+    size_t comprimento = palavra != NULL ? strlen(palavra) : 0;
+    if (palavra == NULL || comprimento >= MAX_TAMANHO_PALAVRA)
+        cache->versaoBaseAlteradas = versao;
+    else
+    {
+        memcpy(cache->alteradas[versao % ALTERACOES_CACHE_SUGESTOES], palavra, comprimento + 1);
+        cache->comprimentosAlteradas[versao % ALTERACOES_CACHE_SUGESTOES] = (int)comprimento;
+        if (versao - cache->versaoBaseAlteradas > ALTERACOES_CACHE_SUGESTOES)
+            cache->versaoBaseAlteradas = versao - ALTERACOES_CACHE_SUGESTOES;
+    }
+    __atomic_store_n(&dicionario->versao, versao, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&cache->trincoAlteradas);
 }
 
-// *********************************** CONSULTA ***********************************
-
-// Função auxiliar para consultar uma palavra na árvore.
-bool consultarPalavraRecursivo(NoTST *raiz, const char *palavra, int indice)
-{
-    if (raiz == NULL)
-    {
-        printf("Chegamos a um nó NULL, interrompendo a busca.\n");
-        return false; // A palavra não foi encontrada.
+// Insere uma palavra no dicionário, com o peso dado se for nova (ou sempre, se 'substituirPeso' for verdadeiro).
+static void inserirPalavraPesada(Dicionario *dicionario, const char *palavra, uint32_t peso, bool substituirPeso) {
+    // Verifica se o dicionário é válido.
+    if (dicionario == NULL) {
+        printf("Dicionario invalido.\n");
+        return;
     }
 
-    // Se o caractere atual é menor que o caractere do nó, vá para a esquerda.
-    if (palavra[indice] < raiz->caractere)
-    {
-        printf("Vamos para a esquerda, caractere = %c, nó = %c\n", palavra[indice], raiz->caractere);
-        return consultarPalavraRecursivo(raiz->esquerda, palavra, indice);
+    // Todos os percursos da Trie montam as palavras em buffers de MAX_TAMANHO_PALAVRA caracteres: uma palavra que
+    // não caiba neles nunca chega à Trie.
+    size_t comprimento = palavra != NULL ? strlen(palavra) : 0;
+    if (comprimento == 0 || comprimento >= MAX_TAMANHO_PALAVRA) {
+        printf("Palavra inválida.\n");
+        return;
     }
-    // Se o caractere atual é maior que o caractere do nó, vá para a direita.
-    else if (palavra[indice] > raiz->caractere)
-    {
-        printf("Vamos para a direita, caractere = %c, nó = %c\n", palavra[indice], raiz->caractere);
-        return consultarPalavraRecursivo(raiz->direito, palavra, indice);
+
+    BlocoEstatisticas *estatisticas = blocoEstatisticas();
+    uint64_t inicio = iniciarOperacaoEstatistica(estatisticas);
+
+    // No modo concorrente, o caminho alterado é copiado para não mexer nos nós que os leitores podem estar a ver.
+    if (dicionario->concorrencia != NULL) {
+        inserirPalavraConcorrente(dicionario, palavra, peso, substituirPeso);
+        acrescentarGrafiaDobrada(dicionario, palavra, comprimento);
     }
-    // Se o caractere atual é igual ao caractere do nó:
-    else
-    {
-        if (indice < (int)strlen(palavra) - 1)
-        {
-            printf("Vamos para o centro, caractere = %c, nó = %c\n", palavra[indice], raiz->caractere);
-            return consultarPalavraRecursivo(raiz->centro, palavra, indice + 1); // Vá para o próximo caractere.
-        }
-        else
-        {
-            printf("Chegamos ao final da palavra, fim_palavra = %d, caractere = %c, nó = %c\n", raiz->fim_palavra, palavra[indice], raiz->caractere);
-            return raiz->fim_palavra; // Se estamos no fim da palavra, retorne o valor da flag fim_palavra.
+    else {
+        // Como no modo concorrente, uma palavra que já existe (com o mesmo peso, ou sem peso novo) não altera nada:
+        // não descongela o dicionário, não conta para o filtro e não invalida as sugestões.
+        uint32_t pesoAtual = 0;
+        bool existe = pesoPalavra(dicionario, palavra, &pesoAtual);
+        bool alterada = !existe || (substituirPeso && pesoAtual != peso);
+
+        // Um dicionário congelado é só de leitura: reconstruir a Trie de ponteiros antes de alterar.
+        if (alterada && (dicionario->compacta == NULL || descongelarDicionario(dicionario))) {
+            // Chama a função auxiliar para inserir a palavra.
+            dicionario->raiz = inserirNo(&dicionario->arena, dicionario->raiz, palavra, 0, peso, substituirPeso);
+            atualizarTabelaRaiz(dicionario, palavra[0]);
+            registarAlteracao(dicionario, palavra);
+
+            if (!existe && dicionario->filtro != NULL) {
+                adicionarFiltroBloom(dicionario->filtro, palavra, comprimento);
+                manterFiltroDicionario(dicionario);
+            }
+            if (!existe)
+                acrescentarGrafiaDobrada(dicionario, palavra, comprimento);
         }
     }
+
+    terminarOperacaoEstatistica(estatisticas, ESTATISTICA_INSERCAO, inicio);
+}
+
+// Insere uma palavra no dicionário (uma palavra que já existia mantém o seu peso).
+void inserirPalavra(Dicionario *dicionario, const char *palavra) {
+    inserirPalavraPesada(dicionario, palavra, 0, false);
 }
 
+// Insere uma palavra com o peso dado, ou substitui o peso se ela já existir.
+void inserirPalavraComPeso(Dicionario *dicionario, const char *palavra, uint32_t peso) {
+    inserirPalavraPesada(dicionario, palavra, peso, true);
+}
 
-// Função para consultar uma palavra no dicionário.
-bool consultarPalavra(Dicionario *dicionario, const char *palavra)
+// Liberta um nó retirado da Trie, devolvendo-o à arena.
+static void libertarNoRetirado(Dicionario *dicionario, void *no)
 {
-    // Verificar se a palavra é válida.
-    if (palavra == NULL || strlen(palavra) == 0)
+    libertarNoArena(&dicionario->arena, (NoTST *)no);
+}
+
+// *********************************** INSERÇÃO EM LOTE (EQUILIBRADA) ***********************************
+
+// Compara duas palavras caractere a caractere com a mesma ordem (char com sinal) usada nos nós da Trie.
+static int compararFatias(const void *a, const void *b)
+{
+    const FatiaPalavra *palavra1 = (const FatiaPalavra *)a;
+    const FatiaPalavra *palavra2 = (const FatiaPalavra *)b;
+    int comprimento = palavra1->comprimento < palavra2->comprimento ? palavra1->comprimento : palavra2->comprimento;
+
+    for (int i = 0; i < comprimento; i++)
     {
-        printf("Palavra inválida.\n");
-        return false;
+        if (palavra1->inicio[i] != palavra2->inicio[i])
+            return palavra1->inicio[i] < palavra2->inicio[i] ? -1 : 1;
     }
 
-    // Chamar a função auxiliar consultarPalavraRecursivo para consultar a palavra na árvore.
-    if(consultarPalavraRecursivo(dicionario->raiz, palavra, 0)){
-        printf("Encontrado!!");
-        system("pause");
-    }else{
-        printf("Não encontrado!!");
-        system("pause");
-    }
-    return consultarPalavraRecursivo(dicionario->raiz, palavra, 0);
+    return palavra1->comprimento - palavra2->comprimento;
 }
 
-// *********************************** REMOÇÃO ***********************************
-
-// Função auxiliar para verificar se um nó está vazio (ou seja, não tem filhos).
-bool noEstaVazio(NoTST *no)
+// Ordena as palavras e remove as repetidas, atualizando o total.
+void ordenarPalavrasSemRepeticao(FatiaPalavra *palavras, size_t *total)
 {
-    return no->esquerda == NULL && no->centro == NULL && no->direito == NULL;
+    size_t unicas = 0;
+
+    if (*total == 0)
+        return;
+
+    qsort(palavras, *total, sizeof(FatiaPalavra), compararFatias);
+
+    // Depois de ordenadas, as repetidas ficam lado a lado.
+    for (size_t i = 1; i < *total; i++)
+    {
+        if (compararFatias(&palavras[unicas], &palavras[i]) != 0)
+            palavras[++unicas] = palavras[i];
+        else if (palavras[i].peso > palavras[unicas].peso)
+            palavras[unicas].peso = palavras[i].peso; // Das repetidas, fica o maior peso.
+    }
+
+    *total = unicas + 1;
 }
 
-// Função auxiliar para remover uma palavra na árvore.
-NoTST *removerPalavraRecursivo(NoTST *raiz, const char *palavra, int indice)
+// Constrói diretamente uma Trie equilibrada com as palavras ordenadas do intervalo [inicio, fim).
+// O nó de cada nível é o caractere da palavra do meio do intervalo; as palavras com caracteres menores
+// vão para a esquerda e as maiores para a direita, o que mantém as cadeias de irmãos com profundidade logarítmica.
+// Se faltar memória para um nó, marca 'falhou' e não constrói mais nada (a Trie devolvida fica incompleta).
+NoTST *construirTSTBalanceada(ArenaNos *arena, const FatiaPalavra *palavras, size_t inicio, size_t fim, int profundidade,
+                              bool *falhou)
 {
-    if (raiz == NULL)
+    if (inicio >= fim || *falhou)
+        return NULL;
+
+    // Caractere da palavra do meio, que será o caractere deste nó.
+    size_t meio = inicio + (fim - inicio) / 2;
+    char caractere = palavras[meio].inicio[profundidade];
+
+    // Procurar (por pesquisa binária) o grupo [inicioGrupo, fimGrupo) das palavras que têm esse caractere nesta profundidade.
+    size_t inicioGrupo, fimGrupo;
+    size_t baixo = inicio, alto = meio;
+    while (baixo < alto)
     {
-        return NULL; // A palavra não foi encontrada.
+        size_t m = baixo + (alto - baixo) / 2;
+        if (palavras[m].inicio[profundidade] < caractere)
+            baixo = m + 1;
+        else
+            alto = m;
     }
+    inicioGrupo = baixo;
 
-    // Se o caractere atual é menor que o caractere do nó, vá para a esquerda.
-    if (palavra[indice] < raiz->caractere)
+    baixo = meio + 1;
+    alto = fim;
+    while (baixo < alto)
     {
-        raiz->esquerda = removerPalavraRecursivo(raiz->esquerda, palavra, indice);
+        size_t m = baixo + (alto - baixo) / 2;
+        if (palavras[m].inicio[profundidade] > caractere)
+            alto = m;
+        else
+            baixo = m + 1;
     }
-    // Se o caractere atual é maior que o caractere do nó, vá para a direita.
-    else if (palavra[indice] > raiz->caractere)
+    fimGrupo = baixo;
+
+    NoTST *no = inicializarNo(arena, caractere);
+    if (no == NULL)
     {
-        raiz->direito = removerPalavraRecursivo(raiz->direito, palavra, indice);
+        *falhou = true;
+        return NULL;
     }
-    // Se o caractere atual é igual ao caractere do nó:
-    else
+
+    // A palavra que termina neste caractere (se existir) é a mais curta do grupo, logo a primeira.
+    size_t inicioCentro = inicioGrupo;
+    if (palavras[inicioGrupo].comprimento == profundidade + 1)
     {
-        if (indice < (int)strlen(palavra) - 1)
+        no->fim_palavra = true;
+        no->peso = palavras[inicioGrupo].peso;
+        inicioCentro++;
+    }
+
+    no->esquerda = construirTSTBalanceada(arena, palavras, inicio, inicioGrupo, profundidade, falhou);
+    no->centro = construirTSTBalanceada(arena, palavras, inicioCentro, fimGrupo, profundidade + 1, falhou);
+    no->direito = construirTSTBalanceada(arena, palavras, fimGrupo, fim, profundidade, falhou);
+    atualizarPesoMaximo(no);
+    return no;
+}
+
+// Insere as palavras do intervalo [inicio, fim) começando pela do meio, para equilibrar a Trie existente.
+static void inserirPalavrasPeloMeio(Dicionario *dicionario, const FatiaPalavra *palavras, size_t inicio, size_t fim)
+{
+    char palavra[MAX_TAMANHO_PALAVRA];
+
+    if (inicio >= fim)
+        return;
+
+    size_t meio = inicio + (fim - inicio) / 2;
+    memcpy(palavra, palavras[meio].inicio, palavras[meio].comprimento);
+    palavra[palavras[meio].comprimento] = '\0';
+
+    // Uma palavra sem peso (0) não apaga o peso que ela já tinha no dicionário.
+    if (palavras[meio].peso != 0)
+        inserirPalavraComPeso(dicionario, palavra, palavras[meio].peso);
+    else
+        inserirPalavra(dicionario, palavra);
+
+    inserirPalavrasPeloMeio(dicionario, palavras, inicio, meio);
+    inserirPalavrasPeloMeio(dicionario, palavras, meio + 1, fim);
+}
+
+// Insere um lote de palavras no dicionário de forma equilibrada.
+bool inserirPalavrasEmLote(Dicionario *dicionario, FatiaPalavra *palavras, size_t total)
+{
+    // Tal como em inserirPalavra, as palavras vazias ou que não cabem nos buffers dos percursos ficam de fora.
+    size_t validas = 0;
+    for (size_t i = 0; i < total; i++)
+    {
+        if (palavras[i].comprimento > 0 && palavras[i].comprimento < MAX_TAMANHO_PALAVRA)
+            palavras[validas++] = palavras[i];
+    }
+    total = validas;
+
+    ordenarPalavrasSemRepeticao(palavras, &total);
+
+    // No modo concorrente, cada palavra é publicada separadamente (sempre pela cópia do caminho).
+    if (dicionario->concorrencia != NULL)
+    {
+        char palavra[MAX_TAMANHO_PALAVRA];
+        for (size_t i = 0; i < total; i++)
+        {
+            memcpy(palavra, palavras[i].inicio, (size_t)palavras[i].comprimento);
+            palavra[palavras[i].comprimento] = '\0';
+            inserirPalavraConcorrente(dicionario, palavra, palavras[i].peso, palavras[i].peso != 0);
+            acrescentarGrafiaDobrada(dicionario, palavra, (size_t)palavras[i].comprimento);
+        }
+        return true;
+    }
+
+    // Com a Trie vazia, construí-la diretamente a partir do vetor ordenado (sem percursos da raiz às folhas). Todas
+    // as palavras são novas: entram no filtro aqui, de uma vez.
+    if (dicionario->raiz == NULL && dicionario->compacta == NULL)
+    {
+        bool falhou = false;
+
+        registarAlteracao(dicionario, NULL);
+        dicionario->raiz = construirTSTBalanceada(&dicionario->arena, palavras, 0, total, 0, &falhou);
+        if (falhou)
+        {
+            // A arena só tem os nós desta construção (a Trie estava vazia): descartar a Trie incompleta.
+            printf("[Falha na alocação de memória ao construir a Trie].\n");
+            destruirArena(&dicionario->arena);
+            dicionario->raiz = NULL;
+            reconstruirTabelaRaiz(dicionario);
+            return false;
+        }
+        reconstruirTabelaRaiz(dicionario);
+
+        if (dicionario->filtro != NULL)
+        {
+            for (size_t i = 0; i < total; i++)
+                adicionarFiltroBloom(dicionario->filtro, palavras[i].inicio, (size_t)palavras[i].comprimento);
+            manterFiltroDicionario(dicionario);
+        }
+        for (size_t i = 0; dicionario->dobrado != NULL && i < total; i++)
+            acrescentarGrafiaDobrada(dicionario, palavras[i].inicio, (size_t)palavras[i].comprimento);
+        return true;
+    }
+
+    // Caso contrário, inserir as palavras começando pelas medianas de cada intervalo. Cada inserção regista a sua
+    // alteração e põe no filtro só as palavras que eram mesmo novas.
+    inserirPalavrasPeloMeio(dicionario, palavras, 0, total);
+    return true;
+}
+
+// *********************************** CONSULTA ***********************************
+
+// Função auxiliar para consultar uma palavra na árvore, descrevendo cada passo (só com -DDICIONARIO_RASTREIO).
+bool consultarPalavraRecursivo(NoTST *raiz, const char *palavra, int indice)
+{
+    if (raiz == NULL)
+    {
+        RASTREAR("Chegamos a um nó NULL, interrompendo a busca.\n");
+        return false; // A palavra não foi encontrada.
+    }
+
+    // Se o caractere atual é menor que o caractere do nó, vá para a esquerda.
+    if (palavra[indice] < raiz->caractere)
+    {
+        RASTREAR("Vamos para a esquerda, caractere = %c, nó = %c\n", palavra[indice], raiz->caractere);
+        return consultarPalavraRecursivo(raiz->esquerda, palavra, indice);
+    }
+    // Se o caractere atual é maior que o caractere do nó, vá para a direita.
+    else if (palavra[indice] > raiz->caractere)
+    {
+        RASTREAR("Vamos para a direita, caractere = %c, nó = %c\n", palavra[indice], raiz->caractere);
+        return consultarPalavraRecursivo(raiz->direito, palavra, indice);
+    }
+    // Se o caractere atual é igual ao caractere do nó:
+    else
+    {
+        if (indice < (int)strlen(palavra) - 1)
+        {
+            RASTREAR("Vamos para o centro, caractere = %c, nó = %c\n", palavra[indice], raiz->caractere);
+            return consultarPalavraRecursivo(raiz->centro, palavra, indice + 1); // Vá para o próximo caractere.
+        }
+        else
+        {
+            RASTREAR("Chegamos ao final da palavra, fim_palavra = %d, caractere = %c, nó = %c\n", raiz->fim_palavra, palavra[indice], raiz->caractere);
+            return raiz->fim_palavra; // Se estamos no fim da palavra, retorne o valor da flag fim_palavra.
+        }
+    }
+}
+
+
+// Função auxiliar para consultar uma palavra na árvore num único percurso iterativo.
+// O fim da palavra é detetado pelo '\0', sem calcular o comprimento em cada nível.
+bool consultarPalavraIterativo(const NoTST *raiz, const char *palavra)
+{
+    const char *inicio = palavra;
+    uint64_t visitados = 0, laterais = 0;
+    bool encontrada = false;
+
+    if (*palavra == '\0')
+        return false;
+
+    while (raiz != NULL)
+    {
+        visitados++;
+        if (*palavra < raiz->caractere)
+        {
+            raiz = raiz->esquerda;
+            laterais++;
+        }
+        else if (*palavra > raiz->caractere)
+        {
+            raiz = raiz->direito;
+            laterais++;
+        }
+        else if (*++palavra == '\0')
+        {
+            encontrada = raiz->fim_palavra;
+            break;
+        }
+        else
+            raiz = raiz->centro;
+    }
+
+    // Os passos centrais são os caracteres reconhecidos antes do último nó.
+    uint64_t profundidade = (uint64_t)(palavra - inicio);
+    registarPercurso(visitados, laterais, visitados - laterais - (raiz != NULL), profundidade);
+    RASTREAR("consulta '%s': %llu nós (%llu laterais), %llu caracteres reconhecidos -> %s\n", inicio,
+             (unsigned long long)visitados, (unsigned long long)laterais, (unsigned long long)profundidade,
+             encontrada ? "encontrada" : "ausente");
+    return encontrada;
+}
+
+// Verifica se uma palavra existe no dicionário, sem imprimir nada. Com o filtro de Bloom ligado, a maioria das
+// palavras ausentes é rejeitada com a leitura de uma só linha de cache, sem percorrer a Trie.
+bool contemPalavra(const Dicionario *dicionario, const char *palavra)
+{
+    bool existe;
+
+    if (dicionario == NULL || palavra == NULL)
+        return false;
+
+    BlocoEstatisticas *estatisticas = blocoEstatisticas();
+    uint64_t inicio = iniciarOperacaoEstatistica(estatisticas);
+
+    // No modo concorrente, o filtro e a raiz são lidos uma só vez, dentro de uma leitura protegida pela época:
+    // os nós alcançados a partir dessa raiz não mudam nem são libertados até a leitura terminar.
+    if (dicionario->concorrencia != NULL)
+    {
+        LeitorEpoca *leitor = iniciarLeituraConcorrente(dicionario);
+        const FiltroBloom *filtro = __atomic_load_n(&dicionario->filtro, __ATOMIC_SEQ_CST);
+        existe = (filtro == NULL || talvezContenhaFiltroBloom(filtro, palavra, strlen(palavra))) &&
+                 consultarPalavraIterativo(__atomic_load_n(&dicionario->raiz, __ATOMIC_SEQ_CST), palavra);
+        terminarLeituraConcorrente(dicionario, leitor);
+    }
+    else if (dicionario->filtro != NULL && !talvezContenhaFiltroBloom(dicionario->filtro, palavra, strlen(palavra)))
+        existe = false;
+    else if (dicionario->compacta != NULL)
+        existe = consultarPalavraCompacta(dicionario->compacta, palavra);
+    else
+        existe = consultarPalavraIterativo(dicionario->tabelaRaiz[(unsigned char)palavra[0]], palavra);
+
+    terminarOperacaoEstatistica(estatisticas, ESTATISTICA_CONSULTA, inicio);
+    return existe;
+}
+
+// Verifica um lote de palavras e devolve o resultado num mapa de bits.
+size_t consultarPalavrasEmLote(const Dicionario *dicionario, const char *const *palavras, size_t total, uint64_t *resultado)
+{
+    size_t encontradas = 0;
+
+    memset(resultado, 0, ((total + 63) / 64) * sizeof(uint64_t));
+
+    for (size_t i = 0; i < total; i++)
+    {
+        if (contemPalavra(dicionario, palavras[i]))
+        {
+            resultado[i / 64] |= (uint64_t)1 << (i % 64);
+            encontradas++;
+        }
+    }
+
+    return encontradas;
+}
+
+// Devolve o nó onde a palavra termina na Trie de ponteiros, ou NULL se ela não existir.
+static const NoTST *procurarNoPalavra(const NoTST *no, const char *palavra)
+{
+    if (*palavra == '\0')
+        return NULL;
+
+    while (no != NULL)
+    {
+        if (*palavra < no->caractere)
+            no = no->esquerda;
+        else if (*palavra > no->caractere)
+            no = no->direito;
+        else if (*++palavra == '\0')
+            return no->fim_palavra ? no : NULL;
+        else
+            no = no->centro;
+    }
+
+    return NULL;
+}
+
+// Devolve o índice do nó onde a palavra termina no layout compacto, ou 0 se ela não existir.
+static uint32_t procurarNoPalavraCompacta(const TSTCompacta *compacta, const char *palavra)
+{
+    const NoCompacto *nos = compacta->nos;
+    uint32_t indice = compacta->tabelaRaiz[(unsigned char)palavra[0]];
+
+    if (*palavra == '\0')
+        return 0;
+
+    while (indice != 0)
+    {
+        if (*palavra < nos[indice].caractere)
+            indice = nos[indice].esquerda;
+        else if (*palavra > nos[indice].caractere)
+            indice = nos[indice].direito;
+        else if (*++palavra == '\0')
+            return (nos[indice].flags & FLAG_FIM_PALAVRA) ? indice : 0;
+        else
+            indice = nos[indice].centro;
+    }
+
+    return 0;
+}
+
+// Devolve verdadeiro se a palavra existir, guardando o seu peso em 'peso' (opcional).
+bool pesoPalavra(const Dicionario *dicionario, const char *palavra, uint32_t *peso)
+{
+    uint32_t encontrado = 0;
+    bool existe;
+
+    if (dicionario == NULL || palavra == NULL)
+        return false;
+
+    if (dicionario->compacta != NULL)
+    {
+        uint32_t indice = procurarNoPalavraCompacta(dicionario->compacta, palavra);
+        existe = indice != 0;
+        if (existe && dicionario->compacta->pesos != NULL)
+            encontrado = dicionario->compacta->pesos[indice];
+    }
+    else
+    {
+        LeitorEpoca *leitor = NULL;
+        const NoTST *raiz = dicionario->tabelaRaiz[(unsigned char)palavra[0]];
+        if (dicionario->concorrencia != NULL)
+        {
+            leitor = iniciarLeituraConcorrente(dicionario);
+            raiz = __atomic_load_n(&dicionario->raiz, __ATOMIC_SEQ_CST);
+        }
+
+        const NoTST *no = procurarNoPalavra(raiz, palavra);
+        existe = no != NULL;
+        if (existe)
+            encontrado = no->peso;
+
+        if (dicionario->concorrencia != NULL)
+            terminarLeituraConcorrente(dicionario, leitor);
+    }
+
+    if (existe && peso != NULL)
+        *peso = encontrado;
+    return existe;
+}
+
+// Função para consultar uma palavra no dicionário.
+bool consultarPalavra(Dicionario *dicionario, const char *palavra)
+{
+    // Verificar se a palavra é válida.
+    if (palavra == NULL || strlen(palavra) == 0)
+    {
+        printf("Palavra inválida.\n");
+        return false;
+    }
+
+    // Só percorrer a versão com rastreio se ele tiver sido pedido (e a Trie de ponteiros estiver ativa).
+    if (dicionario->rastrearConsultas && dicionario->compacta == NULL && dicionario->concorrencia == NULL)
+    {
+        if (dicionario->filtro != NULL && !talvezContenhaFiltroBloom(dicionario->filtro, palavra, strlen(palavra)))
+        {
+            RASTREAR("O filtro de Bloom rejeitou a palavra, sem percorrer a Trie.\n");
+            return false;
+        }
+        return consultarPalavraRecursivo(dicionario->raiz, palavra, 0);
+    }
+
+    return contemPalavra(dicionario, palavra);
+}
+
+// *********************************** REMOÇÃO ***********************************
+
+// Função auxiliar para verificar se um nó está vazio (ou seja, não tem filhos).
+bool noEstaVazio(NoTST *no)
+{
+    return no->esquerda == NULL && no->centro == NULL && no->direito == NULL;
+}
+
+// Função auxiliar para remover uma palavra na árvore.
+NoTST *removerPalavraRecursivo(ArenaNos *arena, NoTST *raiz, const char *palavra, int indice)
+{
+    if (raiz == NULL)
+    {
+        return NULL; // A palavra não foi encontrada.
+    }
+
+    // Se o caractere atual é menor que o caractere do nó, vá para a esquerda.
+    if (palavra[indice] < raiz->caractere)
+    {
+        raiz->esquerda = removerPalavraRecursivo(arena, raiz->esquerda, palavra, indice);
+    }
+    // Se o caractere atual é maior que o caractere do nó, vá para a direita.
+    else if (palavra[indice] > raiz->caractere)
+    {
+        raiz->direito = removerPalavraRecursivo(arena, raiz->direito, palavra, indice);
+    }
+    // Se o caractere atual é igual ao caractere do nó:
+    else
+    {
+        if (indice < (int)strlen(palavra) - 1)
+        {
+            raiz->centro = removerPalavraRecursivo(arena, raiz->centro, palavra, indice + 1); // Vá para o próximo caractere.
+        }
+        else
+        {
+            // Chegamos ao fim da palavra. Marcar o fim da palavra como false.
+            raiz->fim_palavra = false;
+            raiz->peso = 0;
+        }
+    }
+
+    // Se o nó atual está vazio e não é o fim de uma palavra, podemos removê-lo.
+    if (noEstaVazio(raiz) && !raiz->fim_palavra)
+    {
+        RASTREAR("Nó '%c' libertado ao remover '%s'.\n", raiz->caractere, palavra);
+        libertarNoArena(arena, raiz);
+        return NULL;
+    }
+
+    atualizarPesoMaximo(raiz);
+    return raiz;
+}
+
+// Função para remover uma palavra do dicionário.
+void removerPalavra(Dicionario *dicionario, const char *palavra)
+{
+    // Verificar se a palavra é válida.
+    if (palavra == NULL || strlen(palavra) == 0)
+    {
+        printf("Palavra inválida.\n");
+        return;
+    }
+
+    BlocoEstatisticas *estatisticas = blocoEstatisticas();
+    uint64_t inicio = iniciarOperacaoEstatistica(estatisticas);
+
+    // No modo concorrente, o caminho alterado é copiado para não mexer nos nós que os leitores podem estar a ver.
+    if (dicionario->concorrencia != NULL)
+    {
+        removerPalavraConcorrente(dicionario, palavra);
+        retirarGrafiaDobrada(dicionario, palavra);
+    }
+    // Uma palavra que não existe não altera nada: não descongela o dicionário nem conta para o filtro, para as
+    // sugestões ou para a compactação. Um dicionário congelado é só de leitura: reconstruir a Trie de ponteiros antes
+    // de alterar.
+    else if (pesoPalavra(dicionario, palavra, NULL) &&
+             (dicionario->compacta == NULL || descongelarDicionario(dicionario)))
+    {
+        char caminho[TAMANHO_TABELA_RAIZ];
+        size_t totalCaminho = caminhoTabelaRaiz(dicionario->raiz, palavra[0], caminho);
+
+        // Chamar a função auxiliar removerPalavraRecursivo para remover a palavra da árvore.
+        dicionario->raiz = removerPalavraRecursivo(&dicionario->arena, dicionario->raiz, palavra, 0);
+        for (size_t i = 0; i < totalCaminho; i++)
+            atualizarTabelaRaiz(dicionario, caminho[i]);
+        registarAlteracao(dicionario, palavra);
+
+        // Os bits da palavra removida ficam no filtro; só contam para decidir quando reconstruí-lo.
+        if (dicionario->filtro != NULL)
+        {
+            dicionario->filtro->removidas++;
+            manterFiltroDicionario(dicionario);
+        }
+        retirarGrafiaDobrada(dicionario, palavra);
+        dicionario->remocoesDesdeCompactacao++;
+    }
+
+    terminarOperacaoEstatistica(estatisticas, ESTATISTICA_REMOCAO, inicio);
+}
+
+// *********************************** ACTUALIZAÇÃO ***********************************
+
+// Função para atualizar uma palavra existente no dicionário.
+void atualizarPalavra(Dicionario *dicionario, const char *palavraAntiga, const char *palavraNova)
+{
+    // Verificar se as palavras são válidas.
+    if (palavraAntiga == NULL || strlen(palavraAntiga) == 0 || palavraNova == NULL || strlen(palavraNova) == 0 ||
+        strlen(palavraNova) >= MAX_TAMANHO_PALAVRA)
+    {
+        printf("Palavra inválida.\n");
+        return;
+    }
+
+    // Remover a palavra antiga do dicionário.
+    removerPalavra(dicionario, palavraAntiga);
+
+    // Inserir a nova palavra no dicionário.
+    inserirPalavra(dicionario, palavraNova);
+}
+
+// *********************************** COMPACTAÇÃO INCREMENTAL DA TRIE ***********************************
+
+// Empilha uma tarefa da compactação. Devolve falso se a pilha não puder crescer.
+static bool empilharCompactacao(CompactacaoTrie *compactacao, NoTST *no, NoTST **destino, uint32_t profundidade)
+{
+    if (compactacao->totalPilha == compactacao->capacidadePilha)
+    {
+        size_t capacidade = compactacao->capacidadePilha > 0 ? compactacao->capacidadePilha * 2 : 256;
+        TarefaCompactacao *pilha = (TarefaCompactacao *)realloc(compactacao->pilha, capacidade * sizeof(TarefaCompactacao));
+        if (pilha == NULL)
+            return false;
+        compactacao->pilha = pilha;
+        compactacao->capacidadePilha = capacidade;
+    }
+
+    TarefaCompactacao *tarefa = &compactacao->pilha[compactacao->totalPilha++];
+    tarefa->no = no;
+    tarefa->destino = destino;
+    tarefa->profundidade = profundidade;
+    tarefa->expandido = false;
+    return true;
+}
+
+// Empilha os filhos de um nó com o centro no topo, para que a ordem seja a pré-ordem com o centro primeiro (a mesma
+// do layout compacto). Na cópia, os filhos copiados ficam ligados à cópia 'copia' do nó.
+static bool empilharFilhosCompactacao(CompactacaoTrie *compactacao, const NoTST *no, NoTST *copia, uint32_t profundidade)
+{
+    return (no->direito == NULL ||
+            empilharCompactacao(compactacao, no->direito, copia != NULL ? &copia->direito : NULL, profundidade + 1)) &&
+           (no->esquerda == NULL ||
+            empilharCompactacao(compactacao, no->esquerda, copia != NULL ? &copia->esquerda : NULL, profundidade + 1)) &&
+           (no->centro == NULL ||
+            empilharCompactacao(compactacao, no->centro, copia != NULL ? &copia->centro : NULL, profundidade + 1));
+}
+
+// Conta a profundidade de um nó, se ele terminar uma palavra.
+static void medirNoCompactacao(CompactacaoTrie *compactacao, const NoTST *no, uint32_t profundidade)
+{
+    if (!no->fim_palavra)
+        return;
+
+    compactacao->palavras++;
+    compactacao->somaProfundidades += profundidade;
+    if (profundidade > compactacao->profundidadeMaxima)
+        compactacao->profundidadeMaxima = profundidade;
+}
+
+// Recolhe os nós de um nível por ordem (cada caractere aparece no máximo uma vez por nível, portanto cabem em
+// TAMANHO_TABELA_RAIZ lugares) e devolve a altura do nível.
+static uint32_t recolherNivelCompactacao(NoTST *no, NoTST **nos, size_t *total)
+{
+    if (no == NULL)
+        return 0;
+
+    uint32_t esquerda = recolherNivelCompactacao(no->esquerda, nos, total);
+    nos[(*total)++] = no;
+    uint32_t direita = recolherNivelCompactacao(no->direito, nos, total);
+    return 1 + (esquerda > direita ? esquerda : direita);
+}
+
+// Liga os nós [inicio, fim) de um nível como uma árvore binária equilibrada e devolve a raiz.
+static NoTST *montarNivelCompactacao(NoTST **nos, size_t inicio, size_t fim)
+{
+    if (inicio == fim)
+        return NULL;
+
+    size_t meio = inicio + (fim - inicio) / 2;
+    NoTST *no = nos[meio];
+    no->esquerda = montarNivelCompactacao(nos, inicio, meio);
+    no->direito = montarNivelCompactacao(nos, meio + 1, fim);
+    atualizarPesoMaximo(no);
+    return no;
+}
+
+// Poda e reequilibra um nível cujos níveis de baixo já foram tratados: um nó sem centro que não termina uma palavra
+// já não leva a nenhuma (as remoções deixam-no ficar enquanto tiver irmãos). Devolve quantos nós tratou.
+static size_t refazerNivelCompactacao(Dicionario *dicionario, CompactacaoTrie *compactacao, NoTST **nivel)
+{
+    NoTST *nos[TAMANHO_TABELA_RAIZ];
+    size_t total = 0, vivos = 0;
+    uint32_t altura = recolherNivelCompactacao(*nivel, nos, &total), alturaNova = 0;
+
+    for (size_t i = 0; i < total; i++)
+    {
+        if (nos[i]->centro == NULL && !nos[i]->fim_palavra)
+        {
+            libertarNoArena(&dicionario->arena, nos[i]);
+            compactacao->resultado.nosPodados++;
+        }
+        else
+        {
+            nos[vivos++] = nos[i];
+        }
+    }
+
+    *nivel = montarNivelCompactacao(nos, 0, vivos);
+    for (size_t n = vivos; n > 0; n /= 2)
+        alturaNova++;
+    if (alturaNova < altura)
+        compactacao->resultado.niveisReequilibrados++;
+
+    // Os nós do primeiro nível podem ter sido libertados ou mudado de lugar no nível.
+    if (nivel == &dicionario->raiz)
+        reconstruirTabelaRaiz(dicionario);
+    return total;
+}
+
+// Começa (ou recomeça) uma fase, com a pilha só com a tarefa da raiz.
+static bool comecarFaseCompactacao(Dicionario *dicionario, CompactacaoTrie *compactacao, FaseCompactacao fase)
+{
+    compactacao->fase = fase;
+    compactacao->versao = __atomic_load_n(&dicionario->versao, __ATOMIC_ACQUIRE);
+    compactacao->totalPilha = 0;
+    compactacao->palavras = 0;
+    compactacao->somaProfundidades = 0;
+    compactacao->profundidadeMaxima = 0;
+    destruirArena(&compactacao->arena);
+    compactacao->raiz = NULL;
+
+    if (fase == COMPACTACAO_PODAR)
+        return empilharCompactacao(compactacao, NULL, &dicionario->raiz, 0);
+    if (fase == COMPACTACAO_CONCLUIDA || dicionario->raiz == NULL)
+        return true;
+    return empilharCompactacao(compactacao, dicionario->raiz, fase == COMPACTACAO_COPIAR ? &compactacao->raiz : NULL, 1);
+}
+
+// Fecha a fase cuja pilha esvaziou e começa a seguinte. No fim da cópia, a Trie nova substitui a antiga: os blocos
+// da arena antiga (com os nós livres) são libertados de uma só vez.
+static bool terminarFaseCompactacao(Dicionario *dicionario, CompactacaoTrie *compactacao)
+{
+    ResultadoCompactacao *resultado = &compactacao->resultado;
+    double profundidade = compactacao->palavras > 0 ? (double)compactacao->somaProfundidades / (double)compactacao->palavras : 0.0;
+
+    switch (compactacao->fase)
+    {
+    case COMPACTACAO_MEDIR:
+        resultado->nosAntes = dicionario->arena.nosEmUso;
+        resultado->bytesAntes = dicionario->arena.totalBlocos * sizeof(BlocoArena);
+        resultado->profundidadeAntes = profundidade;
+        resultado->profundidadeMaximaAntes = compactacao->profundidadeMaxima;
+        return comecarFaseCompactacao(dicionario, compactacao, COMPACTACAO_PODAR);
+
+    case COMPACTACAO_PODAR:
+        return comecarFaseCompactacao(dicionario, compactacao, COMPACTACAO_COPIAR);
+
+    default:
+        resultado->profundidadeDepois = profundidade;
+        resultado->profundidadeMaximaDepois = compactacao->profundidadeMaxima;
+
+        destruirArena(&dicionario->arena);
+        dicionario->arena = compactacao->arena;
+        dicionario->raiz = compactacao->raiz;
+        reconstruirTabelaRaiz(dicionario);
+        dicionario->remocoesDesdeCompactacao = 0;
+        inicializarArena(&compactacao->arena);
+
+        resultado->nosDepois = dicionario->arena.nosEmUso;
+        resultado->bytesDepois = dicionario->arena.totalBlocos * sizeof(BlocoArena);
+        cancelarCompactacaoTrie(compactacao);
+        return true;
+    }
+}
+
+// Começa uma compactação da Trie de ponteiros pela medição da profundidade.
+bool iniciarCompactacaoTrie(Dicionario *dicionario, CompactacaoTrie *compactacao)
+{
+    memset(compactacao, 0, sizeof(*compactacao));
+    inicializarArena(&compactacao->arena);
+    compactacao->fase = COMPACTACAO_CONCLUIDA;
+
+    if (dicionario == NULL || dicionario->compacta != NULL || dicionario->concorrencia != NULL)
+        return false;
+
+    if (!comecarFaseCompactacao(dicionario, compactacao, COMPACTACAO_MEDIR))
+    {
+        cancelarCompactacaoTrie(compactacao);
+        return false;
+    }
+    return true;
+}
+
+// Executa uma fatia: cada nó medido ou copiado conta um, e cada nível podado conta os seus nós duas vezes (ao empilhar
+// os níveis de baixo e ao refazê-lo). Entre duas fatias a Trie está sempre completa e consultável. Cada recomeço
+// duplica o orçamento das fatias seguintes, para que uma sequência contínua de alterações não impeça o fim.
+bool avancarCompactacaoTrie(Dicionario *dicionario, CompactacaoTrie *compactacao, size_t orcamento)
+{
+    size_t tratados = 0;
+
+    if (compactacao->fase == COMPACTACAO_CONCLUIDA)
+        return true;
+
+    // Congelar o dicionário ou ligar o modo concorrente tira a Trie de ponteiros do lugar: a compactação é abandonada.
+    // Uma alteração pode ter libertado nós guardados na pilha: a fase em curso recomeça.
+    bool valida = dicionario->compacta == NULL && dicionario->concorrencia == NULL;
+    if (valida && __atomic_load_n(&dicionario->versao, __ATOMIC_ACQUIRE) != compactacao->versao)
+    {
+        compactacao->resultado.recomecos++;
+        valida = comecarFaseCompactacao(dicionario, compactacao, compactacao->fase);
+    }
+    if (!valida)
+    {
+        compactacao->resultado.falhou = true;
+        cancelarCompactacaoTrie(compactacao);
+        return true;
+    }
+
+    compactacao->resultado.fatias++;
+    if (compactacao->resultado.recomecos > 0)
+        orcamento <<= compactacao->resultado.recomecos < 20 ? compactacao->resultado.recomecos : 20;
+    while (tratados < orcamento)
+    {
+        if (compactacao->totalPilha == 0)
+        {
+            if (!terminarFaseCompactacao(dicionario, compactacao))
+            {
+                compactacao->resultado.falhou = true;
+                cancelarCompactacaoTrie(compactacao);
+            }
+            if (compactacao->fase == COMPACTACAO_CONCLUIDA)
+                return true;
+            continue;
+        }
+
+        TarefaCompactacao *topo = &compactacao->pilha[compactacao->totalPilha - 1];
+        TarefaCompactacao tarefa = *topo;
+        bool sucesso = true;
+
+        if (compactacao->fase == COMPACTACAO_PODAR && !tarefa.expandido)
+        {
+            // Empilhar os níveis de baixo por cima deste, que só é refeito quando eles já estiverem tratados.
+            NoTST *nos[TAMANHO_TABELA_RAIZ];
+            size_t total = 0;
+
+            topo->expandido = true;
+            recolherNivelCompactacao(*tarefa.destino, nos, &total);
+            for (size_t i = 0; sucesso && i < total; i++)
+                if (nos[i]->centro != NULL)
+                    sucesso = empilharCompactacao(compactacao, NULL, &nos[i]->centro, 0);
+            tratados += total;
+        }
+        else if (compactacao->fase == COMPACTACAO_PODAR)
+        {
+            compactacao->totalPilha--;
+            tratados += refazerNivelCompactacao(dicionario, compactacao, tarefa.destino);
+        }
+        else
+        {
+            NoTST *copia = NULL;
+
+            compactacao->totalPilha--;
+            if (compactacao->fase == COMPACTACAO_COPIAR)
+            {
+                copia = alocarNoArena(&compactacao->arena);
+                if (copia == NULL)
+                {
+                    sucesso = false;
+                }
+                else
+                {
+                    *copia = *tarefa.no;
+                    copia->esquerda = copia->centro = copia->direito = NULL;
+                    *tarefa.destino = copia;
+                }
+            }
+
+            if (sucesso)
+            {
+                medirNoCompactacao(compactacao, tarefa.no, tarefa.profundidade);
+                sucesso = empilharFilhosCompactacao(compactacao, tarefa.no, copia, tarefa.profundidade);
+            }
+            tratados++;
+        }
+
+        if (!sucesso)
+        {
+            compactacao->resultado.falhou = true;
+            cancelarCompactacaoTrie(compactacao);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Liberta a pilha e a cópia em curso.
+void cancelarCompactacaoTrie(CompactacaoTrie *compactacao)
+{
+    destruirArena(&compactacao->arena);
+    free(compactacao->pilha);
+    compactacao->pilha = NULL;
+    compactacao->totalPilha = 0;
+    compactacao->capacidadePilha = 0;
+    compactacao->raiz = NULL;
+    compactacao->fase = COMPACTACAO_CONCLUIDA;
+}
+
+// Compacta a Trie até ao fim, fatia a fatia.
+bool compactarTrie(Dicionario *dicionario, ResultadoCompactacao *resultado)
+{
+    CompactacaoTrie compactacao;
+
+    if (!iniciarCompactacaoTrie(dicionario, &compactacao))
+        return false;
+
+    while (!avancarCompactacaoTrie(dicionario, &compactacao, NOS_POR_FATIA_COMPACTACAO))
+        ;
+
+    if (resultado != NULL)
+        *resultado = compactacao.resultado;
+    return !compactacao.resultado.falhou;
+}
+
+// As remoções são comparadas com os nós em uso (cada palavra removida deixa, no máximo, alguns nós para trás).
+bool trieDeveSerCompactada(const Dicionario *dicionario)
+{
+    return dicionario->compacta == NULL && dicionario->concorrencia == NULL && dicionario->remocoesDesdeCompactacao > 0 &&
+           dicionario->remocoesDesdeCompactacao * FRACAO_REMOCOES_COMPACTACAO >= dicionario->arena.nosEmUso;
+}
+
+// *********************************** ÍNDICE DOBRADO (MAIÚSCULAS E ACENTOS) ***********************************
+
+// Letra base de cada caractere de U+00C0 a U+00FF (o segundo byte UTF-8 depois de 0xC3, menos 0x80). Um '.' marca os
+// caracteres sem letra base (Æ, Ð, ×, Þ, ß e as minúsculas destas letras), que ficam com os dois bytes.
+static const char letrasBaseLatin1[64 + 1] = "aaaaaa.ceeeeiiii.nooooo.ouuuuy.."
+                                             "aaaaaa.ceeeeiiii.nooooo.ouuuuy.y";
+
+// Dobra a palavra numa só passagem, byte a byte; os bytes que não são letras ASCII nem de U+00C0 a U+00FF ficam iguais.
+size_t dobrarPalavra(const char *palavra, size_t comprimento, char *destino)
+{
+    size_t escritos = 0;
+
+    for (size_t i = 0; i < comprimento; i++)
+    {
+        unsigned char c = (unsigned char)palavra[i];
+
+        if (c >= 'A' && c <= 'Z')
+        {
+            destino[escritos++] = (char)(c - 'A' + 'a');
+        }
+        else if (c == 0xC3 && i + 1 < comprimento && ((unsigned char)palavra[i + 1] & 0xC0) == 0x80)
+        {
+            unsigned char segundo = (unsigned char)palavra[++i];
+            char base = letrasBaseLatin1[segundo - 0x80];
+
+            if (base != '.')
+            {
+                destino[escritos++] = base;
+            }
+            else
+            {
+                // As maiúsculas sem letra base (até U+00DE, menos o ×) passam à minúscula, 32 pontos de código acima.
+                destino[escritos++] = (char)c;
+                destino[escritos++] = (char)(segundo < 0x9F && segundo != 0x97 ? segundo + 0x20 : segundo);
+            }
+        }
+        else
+        {
+            destino[escritos++] = (char)c;
+        }
+    }
+
+    destino[escritos] = '\0';
+    return escritos;
+}
+
+// Liberta um índice dobrado.
+static void destruirIndiceDobrado(IndiceDobrado *indice)
+{
+    if (indice == NULL)
+        return;
+
+    destruirArena(&indice->arena);
+    free(indice->texto);
+    free(indice->grafias);
+    pthread_rwlock_destroy(&indice->trinco);
+    free(indice);
+}
+
+// Guarda mais uma grafia no texto do índice, ainda fora de qualquer lista, e devolve o seu índice + 1 (0 se não houver
+// memória).
+static uint32_t guardarGrafiaDobrada(IndiceDobrado *indice, const char *palavra, size_t comprimento)
+{
+    if (indice->tamanhoTexto + comprimento + 1 > UINT32_MAX || indice->totalGrafias >= UINT32_MAX - 1)
+        return 0;
+
+    if (indice->tamanhoTexto + comprimento + 1 > indice->capacidadeTexto)
+    {
+        size_t capacidade = indice->capacidadeTexto > 0 ? indice->capacidadeTexto * 2 : 4096;
+        while (capacidade < indice->tamanhoTexto + comprimento + 1)
+            capacidade *= 2;
+
+        char *texto = (char *)realloc(indice->texto, capacidade);
+        if (texto == NULL)
+            return 0;
+        indice->texto = texto;
+        indice->capacidadeTexto = capacidade;
+    }
+
+    if (indice->totalGrafias == indice->capacidadeGrafias)
+    {
+        size_t capacidade = indice->capacidadeGrafias > 0 ? indice->capacidadeGrafias * 2 : 1024;
+        GrafiaDobrada *grafias = (GrafiaDobrada *)realloc(indice->grafias, capacidade * sizeof(GrafiaDobrada));
+        if (grafias == NULL)
+            return 0;
+        indice->grafias = grafias;
+        indice->capacidadeGrafias = capacidade;
+    }
+
+    GrafiaDobrada *grafia = &indice->grafias[indice->totalGrafias];
+    grafia->posicao = (uint32_t)indice->tamanhoTexto;
+    grafia->proxima = 0;
+    memcpy(indice->texto + indice->tamanhoTexto, palavra, comprimento);
+    indice->texto[indice->tamanhoTexto + comprimento] = '\0';
+    indice->tamanhoTexto += comprimento + 1;
+    return (uint32_t)++indice->totalGrafias;
+}
+
+// Compara duas formas dobradas pela ordem da Trie; as formas iguais ficam pela ordem das suas grafias (no peso).
+static int compararFormasDobradas(const void *a, const void *b)
+{
+    int comparacao = compararFatias(a, b);
+
+    if (comparacao != 0)
+        return comparacao;
+    return ((const FatiaPalavra *)a)->peso < ((const FatiaPalavra *)b)->peso ? -1 : 1;
+}
+
+// Monta a Trie das formas dobradas das grafias já guardadas. A forma de cada grafia é escrita na mesma posição de um
+// texto paralelo (nunca é mais longa); ordenadas as formas, as grafias de cada forma são ligadas numa lista e a Trie é
+// construída equilibrada a partir das formas distintas, como na inserção em lote.
+static bool montarIndiceDobrado(IndiceDobrado *indice)
+{
+    size_t total = indice->totalGrafias, unicas = 0;
+
+    if (total == 0)
+        return true;
+
+    char *formas = (char *)malloc(indice->tamanhoTexto);
+    FatiaPalavra *fatias = (FatiaPalavra *)malloc(total * sizeof(FatiaPalavra));
+    if (formas == NULL || fatias == NULL)
+    {
+        free(formas);
+        free(fatias);
+        return false;
+    }
+
+    for (size_t i = 0; i < total; i++)
+    {
+        const char *grafia = indice->texto + indice->grafias[i].posicao;
+
+        fatias[i].inicio = formas + indice->grafias[i].posicao;
+        fatias[i].comprimento = (int)dobrarPalavra(grafia, strlen(grafia), formas + indice->grafias[i].posicao);
+        fatias[i].peso = (uint32_t)(i + 1);
+    }
+    qsort(fatias, total, sizeof(FatiaPalavra), compararFormasDobradas);
+
+    // Cada forma distinta fica com o peso da primeira grafia; as seguintes são ligadas à anterior.
+    uint32_t anterior = fatias[0].peso;
+    for (size_t i = 1; i < total; i++)
+    {
+        uint32_t grafia = fatias[i].peso;
+
+        if (compararFatias(&fatias[unicas], &fatias[i]) != 0)
+            fatias[++unicas] = fatias[i];
+        else
+            indice->grafias[anterior - 1].proxima = grafia;
+        anterior = grafia;
+    }
+    indice->totalFormas = unicas + 1;
+
+    bool falhou = false;
+    indice->raiz = construirTSTBalanceada(&indice->arena, fatias, 0, indice->totalFormas, 0, &falhou);
+
+    free(formas);
+    free(fatias);
+    return !falhou;
+}
+
+// Devolve o nó da forma dobrada da palavra na Trie do índice (NULL se não houver), deixando a forma em 'forma'.
+static NoTST *procurarFormaDobrada(const IndiceDobrado *indice, const char *palavra, size_t comprimento, char *forma)
+{
+    if (comprimento == 0 || comprimento >= MAX_TAMANHO_PALAVRA)
+        return NULL;
+
+    dobrarPalavra(palavra, comprimento, forma);
+    return (NoTST *)procurarNoPalavra(indice->raiz, forma);
+}
+
+// Liga uma grafia no fim da lista da sua forma dobrada, criando a forma se for nova (nada muda se já estiver ligada).
+static void ligarGrafiaDobrada(IndiceDobrado *indice, const char *palavra, size_t comprimento)
+{
+    char forma[MAX_TAMANHO_PALAVRA];
+    uint32_t ultima = 0;
+
+    if (comprimento == 0 || comprimento >= MAX_TAMANHO_PALAVRA)
+        return;
+
+    NoTST *no = procurarFormaDobrada(indice, palavra, comprimento, forma);
+    if (no != NULL)
+    {
+        for (uint32_t g = no->peso; g != 0; g = indice->grafias[g - 1].proxima)
+        {
+            const char *grafia = indice->texto + indice->grafias[g - 1].posicao;
+            if (strncmp(grafia, palavra, comprimento) == 0 && grafia[comprimento] == '\0')
+                return;
+            ultima = g;
+        }
+    }
+
+    uint32_t nova = guardarGrafiaDobrada(indice, palavra, comprimento);
+    if (nova == 0)
+        return;
+
+    if (no != NULL)
+    {
+        indice->grafias[ultima - 1].proxima = nova;
+    }
+    else
+    {
+        indice->raiz = inserirNo(&indice->arena, indice->raiz, forma, 0, nova, true);
+        indice->totalFormas++;
+    }
+}
+
+// Copia as listas de grafias das formas de uma subárvore para os vetores de 'novo', pela ordem de cada lista, e
+// aponta o peso de cada forma para a nova cabeça da sua lista.
+static void copiarGrafiasDobradas(const IndiceDobrado *indice, NoTST *no, IndiceDobrado *novo)
+{
+    if (no == NULL)
+        return;
+
+    copiarGrafiasDobradas(indice, no->esquerda, novo);
+
+    if (no->fim_palavra)
+    {
+        uint32_t anterior = 0;
+        for (uint32_t g = no->peso; g != 0; g = indice->grafias[g - 1].proxima)
+        {
+            const char *grafia = indice->texto + indice->grafias[g - 1].posicao;
+            uint32_t nova = guardarGrafiaDobrada(novo, grafia, strlen(grafia));
+
+            if (anterior == 0)
+                no->peso = nova;
+            else
+                novo->grafias[anterior - 1].proxima = nova;
+            anterior = nova;
+        }
+    }
+
+    copiarGrafiasDobradas(indice, no->centro, novo);
+    copiarGrafiasDobradas(indice, no->direito, novo);
+}
+
+// Recupera o espaço das grafias retiradas, copiando as ligadas para vetores novos. Os vetores novos são reservados
+// com o tamanho final antes da cópia, que assim não pode falhar a meio; sem memória, o índice fica como estava.
+static void compactarGrafiasDobradas(IndiceDobrado *indice)
+{
+    IndiceDobrado novo;
+
+    memset(&novo, 0, sizeof(novo));
+    novo.capacidadeTexto = indice->tamanhoTexto;
+    novo.capacidadeGrafias = indice->totalGrafias - indice->retiradas;
+    novo.texto = (char *)malloc(novo.capacidadeTexto > 0 ? novo.capacidadeTexto : 1);
+    novo.grafias = (GrafiaDobrada *)malloc(novo.capacidadeGrafias > 0 ? novo.capacidadeGrafias * sizeof(GrafiaDobrada) : 1);
+    if (novo.texto == NULL || novo.grafias == NULL)
+    {
+        free(novo.texto);
+        free(novo.grafias);
+        return;
+    }
+
+    copiarGrafiasDobradas(indice, indice->raiz, &novo);
+
+    free(indice->texto);
+    free(indice->grafias);
+    indice->texto = novo.texto;
+    indice->tamanhoTexto = novo.tamanhoTexto;
+    indice->capacidadeTexto = novo.capacidadeTexto;
+    indice->grafias = novo.grafias;
+    indice->totalGrafias = novo.totalGrafias;
+    indice->capacidadeGrafias = novo.capacidadeGrafias;
+    indice->retiradas = 0;
+}
+
+// Retira uma grafia da lista da sua forma dobrada; a forma sai da Trie quando fica sem grafias.
+static void desligarGrafiaDobrada(IndiceDobrado *indice, const char *palavra)
+{
+    char forma[MAX_TAMANHO_PALAVRA];
+    NoTST *no = procurarFormaDobrada(indice, palavra, strlen(palavra), forma);
+    uint32_t anterior = 0;
+
+    if (no == NULL)
+        return;
+
+    for (uint32_t g = no->peso; g != 0; anterior = g, g = indice->grafias[g - 1].proxima)
+    {
+        if (strcmp(indice->texto + indice->grafias[g - 1].posicao, palavra) != 0)
+            continue;
+
+        if (anterior == 0)
+            no->peso = indice->grafias[g - 1].proxima;
+        else
+            indice->grafias[anterior - 1].proxima = indice->grafias[g - 1].proxima;
+        indice->retiradas++;
+
+        if (no->peso == 0)
+        {
+            indice->raiz = removerPalavraRecursivo(&indice->arena, indice->raiz, forma, 0);
+            indice->totalFormas--;
+        }
+        break;
+    }
+
+    // Compactar só quando as retiradas passam das ligadas: o custo fica amortizado pelas remoções que o provocaram.
+    if (indice->retiradas > 1024 && indice->retiradas > indice->totalGrafias - indice->retiradas)
+        compactarGrafiasDobradas(indice);
+}
+
+// No modo concorrente, as consultas trancam o índice para leitura (as alterações trancam-no sempre para escrita).
+static bool trancarLeituraDobrada(const Dicionario *dicionario, IndiceDobrado *indice)
+{
+    if (dicionario->concorrencia == NULL)
+        return false;
+
+    pthread_rwlock_rdlock(&indice->trinco);
+    return true;
+}
+
+// Constrói o índice com as grafias enumeradas pelo cursor (já por ordem, que passa a ser a ordem de cada lista).
+bool construirIndiceDobrado(Dicionario *dicionario)
+{
+    CursorDicionario cursor;
+    bool sucesso = true;
+
+    if (dicionario == NULL)
+        return false;
+
+    IndiceDobrado *indice = (IndiceDobrado *)calloc(1, sizeof(IndiceDobrado));
+    if (indice == NULL)
+        return false;
+    inicializarArena(&indice->arena);
+    pthread_rwlock_init(&indice->trinco, NULL);
+
+    if (abrirCursor(&cursor, dicionario, ""))
+    {
+        while (sucesso && avancarCursor(&cursor))
+            sucesso = guardarGrafiaDobrada(indice, cursor.palavra, (size_t)cursor.comprimento) != 0;
+        sucesso = sucesso && !cursor.falhou;
+        fecharCursor(&cursor);
+    }
+
+    if (!sucesso || !montarIndiceDobrado(indice))
+    {
+        destruirIndiceDobrado(indice);
+        return false;
+    }
+
+    desligarIndiceDobrado(dicionario);
+    dicionario->dobrado = indice;
+    return true;
+}
+
+// Desliga e liberta o índice dobrado do dicionário.
+void desligarIndiceDobrado(Dicionario *dicionario)
+{
+    destruirIndiceDobrado(dicionario->dobrado);
+    dicionario->dobrado = NULL;
+}
+
+// Acrescenta uma palavra inserida no dicionário ao índice dobrado.
+void acrescentarGrafiaDobrada(Dicionario *dicionario, const char *palavra, size_t comprimento)
+{
+    IndiceDobrado *indice = dicionario->dobrado;
+
+    if (indice == NULL)
+        return;
+
+    pthread_rwlock_wrlock(&indice->trinco);
+    ligarGrafiaDobrada(indice, palavra, comprimento);
+    pthread_rwlock_unlock(&indice->trinco);
+}
+
+// Retira uma palavra removida do dicionário do índice dobrado.
+void retirarGrafiaDobrada(Dicionario *dicionario, const char *palavra)
+{
+    IndiceDobrado *indice = dicionario->dobrado;
+
+    if (indice == NULL)
+        return;
+
+    pthread_rwlock_wrlock(&indice->trinco);
+    desligarGrafiaDobrada(indice, palavra);
+    pthread_rwlock_unlock(&indice->trinco);
+}
+
+// Dobra a fatia para um buffer na pilha e percorre a Trie das formas uma só vez.
+bool contemPalavraDobrada(const Dicionario *dicionario, const char *palavra, size_t comprimento)
+{
+    char forma[MAX_TAMANHO_PALAVRA];
+    IndiceDobrado *indice = dicionario != NULL ? dicionario->dobrado : NULL;
+
+    if (indice == NULL || palavra == NULL)
+        return false;
+
+    bool trancado = trancarLeituraDobrada(dicionario, indice);
+    bool existe = procurarFormaDobrada(indice, palavra, comprimento, forma) != NULL;
+    if (trancado)
+        pthread_rwlock_unlock(&indice->trinco);
+    return existe;
+}
+
+// Visita as grafias da lista da forma dobrada da palavra (por ordem alfabética, exceto as inseridas depois de o índice
+// ser construído, que ficam no fim da lista).
+size_t procurarPalavraDobrada(const Dicionario *dicionario, const char *palavra, VisitantePalavra visitar, void *contexto)
+{
+    char forma[MAX_TAMANHO_PALAVRA];
+    IndiceDobrado *indice = dicionario != NULL ? dicionario->dobrado : NULL;
+    size_t visitadas = 0;
+
+    if (indice == NULL || palavra == NULL)
+        return 0;
+
+    bool trancado = trancarLeituraDobrada(dicionario, indice);
+    const NoTST *no = procurarFormaDobrada(indice, palavra, strlen(palavra), forma);
+    for (uint32_t g = no != NULL ? no->peso : 0; g != 0; g = indice->grafias[g - 1].proxima)
+    {
+        visitadas++;
+        if (!visitar(indice->texto + indice->grafias[g - 1].posicao, contexto))
+            break;
+    }
+    if (trancado)
+        pthread_rwlock_unlock(&indice->trinco);
+    return visitadas;
+}
+
+// *********************************** CURSOR (ENUMERAÇÃO POR ORDEM SEM RECURSÃO) ***********************************
+
+// Tarefas da pilha do cursor. A ordem das palavras de uma subárvore é: esquerda, o próprio nó, centro, direita. Uma
+// tarefa de subárvore desce pela esquerda deixando na pilha o resto de cada nó do caminho; o resto de um nó escreve o
+// seu caractere, empilha a direita e depois o centro (que sai primeiro) e entrega a palavra, se o nó a terminar.
+enum
+{
+    TAREFA_SUBARVORE,
+    TAREFA_RESTO
+};
+
+// Struct auxiliar com os campos de um nó, lidos de qualquer um dos layouts.
+typedef struct
+{
+    uintptr_t esquerda, centro, direito;
+    char caractere;
+    bool fimPalavra;
+} NoCursor;
+
+// Lê o nó 'no' do layout compacto (se 'nos' não for NULL) ou do layout de ponteiros. Nos percursos, 'nos' é uma
+// constante em cada chamada, e o compilador gera uma versão sem o teste para cada layout.
+static inline void lerNoCursor(const NoCompacto *nos, uintptr_t no, NoCursor *lido)
+{
+    if (nos != NULL)
+    {
+        const NoCompacto *compacto = &nos[no];
+        lido->esquerda = compacto->esquerda;
+        lido->centro = compacto->centro;
+        lido->direito = compacto->direito;
+        lido->caractere = compacto->caractere;
+        lido->fimPalavra = (compacto->flags & FLAG_FIM_PALAVRA) != 0;
+    }
+    else
+    {
+        const NoTST *ponteiro = (const NoTST *)no;
+        lido->esquerda = (uintptr_t)ponteiro->esquerda;
+        lido->centro = (uintptr_t)ponteiro->centro;
+        lido->direito = (uintptr_t)ponteiro->direito;
+        lido->caractere = ponteiro->caractere;
+        lido->fimPalavra = ponteiro->fim_palavra;
+    }
+}
+
+// Devolve os nós do layout que o cursor percorre (NULL para a Trie de ponteiros).
+static inline const NoCompacto *nosCursor(const CursorDicionario *cursor)
+{
+    return cursor->compacta != NULL ? cursor->compacta->nos : NULL;
+}
+
+// Faz a pilha crescer para o dobro (só num caminho mais fundo do que a pilha inicial). Se não houver memória, o
+// cursor falha e a enumeração termina.
+static bool crescerPilhaCursor(CursorDicionario *cursor)
+{
+    TarefaCursor *nova = malloc(2 * cursor->capacidadePilha * sizeof(TarefaCursor));
+    if (nova == NULL)
+    {
+        cursor->falhou = true;
+        return false;
+    }
+
+    memcpy(nova, cursor->pilha != NULL ? cursor->pilha : cursor->pilhaInicial, cursor->totalPilha * sizeof(TarefaCursor));
+    free(cursor->pilha);
+    cursor->pilha = nova;
+    cursor->capacidadePilha *= 2;
+    return true;
+}
+
+// Empilha uma tarefa (nada, se o nó for vazio).
+static inline bool empilharCursor(CursorDicionario *cursor, uintptr_t no, int profundidade, uint8_t tarefa)
+{
+    if (no == 0)
+        return true;
+    if (cursor->totalPilha == cursor->capacidadePilha && !crescerPilhaCursor(cursor))
+        return false;
+
+    TarefaCursor *pilha = cursor->pilha != NULL ? cursor->pilha : cursor->pilhaInicial;
+    pilha[cursor->totalPilha].no = no;
+    pilha[cursor->totalPilha].profundidade = (uint8_t)profundidade;
+    pilha[cursor->totalPilha].tarefa = tarefa;
+    cursor->totalPilha++;
+    return true;
+}
+
+// Reposiciona o cursor antes da primeira palavra do intervalo do prefixo.
+static void reiniciarCursor(CursorDicionario *cursor)
+{
+    cursor->totalPilha = 0;
+    cursor->pendente = cursor->prefixoEhPalavra;
+    if (cursor->pendente)
+    {
+        cursor->comprimento = cursor->comprimentoPrefixo;
+        cursor->palavra[cursor->comprimento] = '\0';
+    }
+    empilharCursor(cursor, cursor->inicio, cursor->comprimentoPrefixo, TAREFA_SUBARVORE);
+}
+
+// Executa tarefas até encontrar a próxima palavra, que fica em cursor->palavra. Só vai para a pilha o que fica para
+// depois: o centro de um nó é percorrido logo a seguir (e só é empilhado quando o nó entrega uma palavra) e o nó
+// mais à esquerda de uma subárvore é tratado sem passar pela pilha.
+static inline bool percorrerCursor(CursorDicionario *cursor, const NoCompacto *nos)
+{
+    NoCursor lido;
+
+    while (cursor->totalPilha > 0 && !cursor->falhou)
+    {
+        const TarefaCursor *pilha = cursor->pilha != NULL ? cursor->pilha : cursor->pilhaInicial;
+        TarefaCursor tarefa = pilha[--cursor->totalPilha];
+        uintptr_t no = tarefa.no;
+        int profundidade = tarefa.profundidade;
+        bool descer = tarefa.tarefa == TAREFA_SUBARVORE;
+
+        for (;;)
+        {
+            lerNoCursor(nos, no, &lido);
+            if (descer)
+            {
+                // Descer pela esquerda, deixando na pilha o resto de cada nó do caminho.
+                for (; lido.esquerda != 0; lerNoCursor(nos, no, &lido))
+                {
+                    if (!empilharCursor(cursor, no, profundidade, TAREFA_RESTO))
+                        return false;
+                    no = lido.esquerda;
+                }
+            }
+
+            // A direita vem depois de todo o centro.
+            if (!empilharCursor(cursor, lido.direito, profundidade, TAREFA_SUBARVORE))
+                return false;
+            cursor->palavra[profundidade] = lido.caractere;
+            if (lido.fimPalavra)
+            {
+                if (!empilharCursor(cursor, lido.centro, profundidade + 1, TAREFA_SUBARVORE))
+                    return false;
+                cursor->comprimento = profundidade + 1;
+                cursor->palavra[cursor->comprimento] = '\0';
+                return true;
+            }
+            if (lido.centro == 0)
+                break;
+
+            no = lido.centro;
+            profundidade++;
+            descer = true;
+        }
+    }
+    return false;
+}
+
+// Encontra a próxima palavra no layout que o cursor percorre.
+static bool produzirPalavraCursor(CursorDicionario *cursor)
+{
+    if (cursor->compacta != NULL)
+        return percorrerCursor(cursor, cursor->compacta->nos);
+    return percorrerCursor(cursor, NULL);
+}
+
+// Função para abrir um cursor antes da primeira palavra com o prefixo fornecido.
+bool abrirCursor(CursorDicionario *cursor, const Dicionario *dicionario, const char *prefixo)
+{
+    int comprimento = (int)strlen(prefixo);
+    NoCursor lido;
+
+    if (comprimento >= MAX_TAMANHO_PALAVRA)
+        return false;
+
+    cursor->dicionario = dicionario;
+    cursor->compacta = NULL;
+    cursor->leitor = NULL;
+    cursor->pilha = NULL;
+    cursor->totalPilha = 0;
+    cursor->capacidadePilha = PILHA_INICIAL_CURSOR;
+    cursor->comprimentoPrefixo = comprimento;
+    cursor->pendente = false;
+    cursor->falhou = false;
+    memcpy(cursor->palavra, prefixo, (size_t)comprimento);
+
+    // No modo concorrente, o cursor percorre do princípio ao fim a versão da Trie publicada quando foi aberto.
+    uintptr_t no;
+    if (dicionario->compacta != NULL)
+    {
+        cursor->compacta = dicionario->compacta;
+        no = dicionario->compacta->raiz;
+    }
+    else if (dicionario->concorrencia != NULL)
+    {
+        cursor->leitor = iniciarLeituraConcorrente(dicionario);
+        no = (uintptr_t)__atomic_load_n(&dicionario->raiz, __ATOMIC_SEQ_CST);
+    }
+    else
+        no = (uintptr_t)dicionario->raiz;
+
+    // Com um prefixo, a descida começa no nó do primeiro caractere dado pela tabela da raiz.
+    if (comprimento > 0 && cursor->leitor == NULL)
+        no = cursor->compacta != NULL ? cursor->compacta->tabelaRaiz[(unsigned char)prefixo[0]]
+                                      : (uintptr_t)dicionario->tabelaRaiz[(unsigned char)prefixo[0]];
+
+    // Descer até ao nó do último caractere do prefixo; as palavras mais longas estão no seu filho central.
+    cursor->prefixoEhPalavra = false;
+    for (int i = 0; i < comprimento && no != 0;)
+    {
+        lerNoCursor(nosCursor(cursor), no, &lido);
+        if (prefixo[i] < lido.caractere)
+            no = lido.esquerda;
+        else if (prefixo[i] > lido.caractere)
+            no = lido.direito;
+        else
+        {
+            if (++i == comprimento)
+                cursor->prefixoEhPalavra = lido.fimPalavra;
+            no = lido.centro;
+        }
+    }
+    cursor->inicio = no;
+
+    reiniciarCursor(cursor);
+    return true;
+}
+
+// Função para reposicionar o cursor antes da primeira palavra do intervalo que não é menor do que a chave.
+void posicionarCursor(CursorDicionario *cursor, const char *chave)
+{
+    int comprimentoPrefixo = cursor->comprimentoPrefixo;
+    NoCursor lido;
+    int i;
+
+    // Uma chave fora do intervalo do prefixo deixa o cursor no início (se for menor) ou no fim (se for maior).
+    for (i = 0; i < comprimentoPrefixo; i++)
+    {
+        if (chave[i] == cursor->palavra[i])
+            continue;
+        if (chave[i] == '\0' || chave[i] < cursor->palavra[i])
+            reiniciarCursor(cursor);
+        else
+        {
+            cursor->totalPilha = 0;
+            cursor->pendente = false;
+        }
+        return;
+    }
+
+    cursor->totalPilha = 0;
+    cursor->pendente = false;
+    if (chave[i] == '\0' || cursor->falhou)
+    {
+        reiniciarCursor(cursor);
+        return;
+    }
+
+    // Descer pela chave deixando na pilha, por ordem, tudo o que vem depois dela: o resto dos nós com um caractere
+    // maior (quando se vai para a esquerda) e a direita dos nós do caminho.
+    uintptr_t no = cursor->inicio;
+    while (no != 0)
+    {
+        lerNoCursor(nosCursor(cursor), no, &lido);
+        if (chave[i] < lido.caractere)
+        {
+            if (!empilharCursor(cursor, no, i, TAREFA_RESTO))
+                return;
+            no = lido.esquerda;
+        }
+        else if (chave[i] > lido.caractere)
+            no = lido.direito;
+        else
+        {
+            if (!empilharCursor(cursor, lido.direito, i, TAREFA_SUBARVORE))
+                return;
+            cursor->palavra[i] = lido.caractere;
+            if (chave[++i] == '\0')
+            {
+                // A chave termina neste nó: ela própria é a primeira palavra, se existir, e depois vem o centro.
+                empilharCursor(cursor, lido.centro, i, TAREFA_SUBARVORE);
+                if (lido.fimPalavra)
+                {
+                    cursor->comprimento = i;
+                    cursor->palavra[i] = '\0';
+                    cursor->pendente = true;
+                }
+                return;
+            }
+            no = lido.centro;
+        }
+    }
+}
+
+// Função para avançar o cursor para a próxima palavra.
+bool avancarCursor(CursorDicionario *cursor)
+{
+    if (cursor->pendente)
+    {
+        cursor->pendente = false;
+        return true;
+    }
+    return produzirPalavraCursor(cursor);
+}
+
+// Função para copiar as próximas palavras do cursor para o buffer do chamador.
+size_t proximasPalavras(CursorDicionario *cursor, char *destino, size_t tamanho, size_t maximo)
+{
+    size_t usados = 0, copiadas = 0;
+
+    while (copiadas < maximo)
+    {
+        if (!cursor->pendente)
+        {
+            if (!produzirPalavraCursor(cursor))
+                break;
+            cursor->pendente = true;
+        }
+
+        // A palavra que não cabe fica pendente para a próxima chamada.
+        size_t bytes = (size_t)cursor->comprimento + 1;
+        if (bytes > tamanho - usados)
+            break;
+        memcpy(destino + usados, cursor->palavra, bytes);
+        usados += bytes;
+        copiadas++;
+        cursor->pendente = false;
+    }
+    return copiadas;
+}
+
+// Função para fechar o cursor.
+void fecharCursor(CursorDicionario *cursor)
+{
+    if (cursor->leitor != NULL)
+        terminarLeituraConcorrente(cursor->dicionario, cursor->leitor);
+    free(cursor->pilha);
+    cursor->leitor = NULL;
+    cursor->pilha = NULL;
+    cursor->totalPilha = 0;
+    cursor->pendente = false;
+}
+
+// *********************************** IMPRESSÃO DE TODAS AS PALAVRAS COM O MESMO PREFIXO DE ENTRADA ***********************************
+
+// Função para imprimir todas as palavras no dicionário que começam com o prefixo fornecido.
+void palavrasComPrefixo(Dicionario *dicionario, const char *prefixo)
+{
+    CursorDicionario cursor;
+
+    // Verificar se o prefixo é válido.
+    if (prefixo == NULL || strlen(prefixo) == 0 || !abrirCursor(&cursor, dicionario, prefixo))
+    {
+        printf("Prefixo inválido.\n");
+        return;
+    }
+
+    while (avancarCursor(&cursor))
+        printf("%s\n", cursor.palavra);
+    fecharCursor(&cursor);
+}
+
+// Chama 'visitar' para cada palavra com o prefixo fornecido (todas, se o prefixo for vazio), sem imprimir nada.
+size_t procurarPorPrefixo(const Dicionario *dicionario, const char *prefixo, VisitantePalavra visitar, void *contexto)
+{
+    CursorDicionario cursor;
+    size_t visitadas = 0;
+
+    BlocoEstatisticas *estatisticas = blocoEstatisticas();
+    uint64_t inicio = iniciarOperacaoEstatistica(estatisticas);
+
+    if (abrirCursor(&cursor, dicionario, prefixo))
+    {
+        while (avancarCursor(&cursor))
+        {
+            visitadas++;
+            if (!visitar(cursor.palavra, contexto))
+                break;
+        }
+        fecharCursor(&cursor);
+    }
+
+    terminarOperacaoEstatistica(estatisticas, ESTATISTICA_PREFIXO, inicio);
+    return visitadas;
+}
+
+// *********************************** AUTOCOMPLETAR (AS K PALAVRAS DE MAIOR PESO) ***********************************
+
+// Struct auxiliar com um elemento da fila de prioridade do autocompletar: uma subárvore inteira (o nó, os irmãos e
+// os descendentes), cujo valor é o limite do seu maior peso, ou uma palavra já encontrada, cujo valor é o seu peso.
+typedef struct
+{
+    uint64_t chave;   // valor << 9 | palavra << 8 | comprimento do caminho (ver chaveAutocompletar).
+    uintptr_t no;     // Nó da subárvore: ponteiro (layout de ponteiros) ou índice (layout compacto).
+    uint32_t caminho; // Passo com o último caractere antes da subárvore (ou o último da palavra).
+} EntradaAutocompletar;
+
+// Struct auxiliar com um caractere do caminho a partir do prefixo; os passos partilham os caminhos comuns.
+typedef struct
+{
+    uint32_t anterior;   // Passo anterior (o passo 0 é o próprio prefixo).
+    uint8_t comprimento; // Caracteres do caminho até este passo, inclusive.
+    char caractere;      // Caractere do nó central que este passo atravessa.
+} PassoAutocompletar;
+
+// Struct auxiliar com o estado de uma procura das k melhores palavras.
+typedef struct
+{
+    const TSTCompacta *compacta;      // Layout percorrido (NULL para a Trie de ponteiros).
+    EntradaAutocompletar *fila;       // Monte binário com o maior valor na posição 0.
+    size_t totalFila, capacidadeFila;
+    PassoAutocompletar *passos;
+    size_t totalPassos, capacidadePassos;
+    size_t nosVisitados;
+    bool falhou;                      // Sem memória: a procura termina com as palavras que já entregou.
+} ProcuraAutocompletar;
+
+// Chave de um elemento da fila. Com valores iguais, uma palavra sai antes de qualquer subárvore (nenhuma palavra
+// lá dentro a pode ultrapassar) e, entre subárvores, a de caminho mais longo sai primeiro: sem pesos, a procura
+// desce logo pelo centro até às palavras em vez de abrir todos os irmãos de cada nível.
+static inline uint64_t chaveAutocompletar(uint64_t valor, bool palavra, uint8_t comprimento)
+{
+    return valor << 9 | (uint64_t)palavra << 8 | comprimento;
+}
+
+// Junta um elemento à fila de prioridade.
+static void juntarAutocompletar(ProcuraAutocompletar *procura, uint64_t chave, uintptr_t no, uint32_t caminho)
+{
+    if (procura->totalFila == procura->capacidadeFila)
+    {
+        size_t capacidade = procura->capacidadeFila * 2;
+        EntradaAutocompletar *fila = (EntradaAutocompletar *)realloc(procura->fila, capacidade * sizeof(EntradaAutocompletar));
+        if (fila == NULL)
+        {
+            procura->falhou = true;
+            return;
+        }
+        procura->fila = fila;
+        procura->capacidadeFila = capacidade;
+    }
+
+    // Subir o novo elemento enquanto for maior do que o pai.
+    size_t posicao = procura->totalFila++;
+    while (posicao > 0)
+    {
+        size_t pai = (posicao - 1) / 2;
+        if (procura->fila[pai].chave >= chave)
+            break;
+        procura->fila[posicao] = procura->fila[pai];
+        posicao = pai;
+    }
+
+    procura->fila[posicao].chave = chave;
+    procura->fila[posicao].no = no;
+    procura->fila[posicao].caminho = caminho;
+}
+
+// Retira da fila o elemento de maior chave.
+static EntradaAutocompletar retirarAutocompletar(ProcuraAutocompletar *procura)
+{
+    EntradaAutocompletar maior = procura->fila[0];
+    EntradaAutocompletar ultimo = procura->fila[--procura->totalFila];
+    size_t posicao = 0;
+
+    // Descer o último elemento a partir da raiz, trocando-o com o maior dos filhos.
+    for (;;)
+    {
+        size_t filho = 2 * posicao + 1;
+        if (filho >= procura->totalFila)
+            break;
+        if (filho + 1 < procura->totalFila && procura->fila[filho + 1].chave > procura->fila[filho].chave)
+            filho++;
+        if (procura->fila[filho].chave <= ultimo.chave)
+            break;
+        procura->fila[posicao] = procura->fila[filho];
+        posicao = filho;
+    }
+
+    if (procura->totalFila > 0)
+        procura->fila[posicao] = ultimo;
+    return maior;
+}
+
+// Acrescenta um passo ao caminho e devolve o seu índice (0 se não houver memória).
+static uint32_t acrescentarPassoAutocompletar(ProcuraAutocompletar *procura, uint32_t anterior, char caractere)
+{
+    if (procura->totalPassos == procura->capacidadePassos)
+    {
+        size_t capacidade = procura->capacidadePassos * 2;
+        PassoAutocompletar *passos = (PassoAutocompletar *)realloc(procura->passos, capacidade * sizeof(PassoAutocompletar));
+        if (passos == NULL)
+        {
+            procura->falhou = true;
+            return 0;
+        }
+        procura->passos = passos;
+        procura->capacidadePassos = capacidade;
+    }
+
+    PassoAutocompletar *passo = &procura->passos[procura->totalPassos];
+    passo->anterior = anterior;
+    passo->comprimento = (uint8_t)(procura->passos[anterior].comprimento + 1);
+    passo->caractere = caractere;
+    return (uint32_t)procura->totalPassos++;
+}
+
+// Junta à fila a subárvore de um nó (ponteiro ou índice; 0 representa a ausência de nó).
+static void juntarSubarvoreAutocompletar(ProcuraAutocompletar *procura, uintptr_t no, uint32_t caminho)
+{
+    if (no == 0)
+        return;
+
+    uint16_t limite = procura->compacta != NULL ? procura->compacta->nos[no].pesoMaximo : ((const NoTST *)no)->pesoMaximo;
+    juntarAutocompletar(procura, chaveAutocompletar(valorLimitePeso(limite), false, procura->passos[caminho].comprimento),
+                        no, caminho);
+}
+
+// Abre a subárvore de um nó: os irmãos ficam com o mesmo caminho, e a palavra do nó e o centro ganham o caractere.
+static void expandirAutocompletar(ProcuraAutocompletar *procura, uintptr_t no, uint32_t caminho)
+{
+    uintptr_t esquerda, centro, direito;
+    bool fimPalavra;
+    uint32_t peso;
+    char caractere;
+
+    if (procura->compacta != NULL)
+    {
+        const NoCompacto *compacto = &procura->compacta->nos[no];
+        esquerda = compacto->esquerda;
+        centro = compacto->centro;
+        direito = compacto->direito;
+        fimPalavra = (compacto->flags & FLAG_FIM_PALAVRA) != 0;
+        peso = procura->compacta->pesos != NULL ? procura->compacta->pesos[no] : 0;
+        caractere = compacto->caractere;
+    }
+    else
+    {
+        const NoTST *ponteiro = (const NoTST *)no;
+        esquerda = (uintptr_t)ponteiro->esquerda;
+        centro = (uintptr_t)ponteiro->centro;
+        direito = (uintptr_t)ponteiro->direito;
+        fimPalavra = ponteiro->fim_palavra;
+        peso = ponteiro->peso;
+        caractere = ponteiro->caractere;
+    }
+
+    procura->nosVisitados++;
+    juntarSubarvoreAutocompletar(procura, esquerda, caminho);
+    juntarSubarvoreAutocompletar(procura, direito, caminho);
+
+    uint32_t passo = acrescentarPassoAutocompletar(procura, caminho, caractere);
+    if (passo == 0)
+        return;
+
+    if (fimPalavra)
+        juntarAutocompletar(procura, chaveAutocompletar(peso, true, procura->passos[passo].comprimento), 0, passo);
+    juntarSubarvoreAutocompletar(procura, centro, passo);
+}
+
+// Chama 'visitar' para as k palavras de maior peso com o prefixo fornecido (todas as palavras, se for vazio).
+// Procura pela melhor primeiro: a fila começa com a subárvore do prefixo e, de cada vez, abre a subárvore com o
+// maior limite; uma palavra sai da fila quando nenhuma subárvore por abrir a pode ultrapassar. As subárvores cujo
+// limite nunca chega ao topo da fila antes de se completarem as k palavras não são visitadas.
+size_t melhoresComPrefixo(const Dicionario *dicionario, const char *prefixo, size_t k, VisitantePeso visitar, void *contexto)
+{
+    ProcuraAutocompletar procura;
+    char buffer[MAX_TAMANHO_PALAVRA];
+    size_t entregues = 0;
+
+    if (dicionario == NULL || prefixo == NULL || k == 0)
+        return 0;
+
+    int comprimento = (int)strlen(prefixo);
+    if (comprimento >= MAX_TAMANHO_PALAVRA)
+        return 0;
+    memcpy(buffer, prefixo, (size_t)comprimento);
+
+    // As capacidades iniciais chegam para as procuras habituais (k pequeno) sem realocações.
+    procura.compacta = dicionario->compacta;
+    procura.capacidadeFila = 64 + 4 * k;
+    procura.capacidadePassos = 64 + 2 * k;
+    procura.fila = (EntradaAutocompletar *)malloc(procura.capacidadeFila * sizeof(EntradaAutocompletar));
+    procura.passos = (PassoAutocompletar *)malloc(procura.capacidadePassos * sizeof(PassoAutocompletar));
+    procura.totalFila = 0;
+    procura.totalPassos = 1;
+    procura.nosVisitados = 0;
+    procura.falhou = false;
+    if (procura.fila == NULL || procura.passos == NULL)
+    {
+        free(procura.fila);
+        free(procura.passos);
+        return 0;
+    }
+
+    // O passo 0 representa o prefixo pedido.
+    procura.passos[0].anterior = 0;
+    procura.passos[0].comprimento = 0;
+    procura.passos[0].caractere = '\0';
+
+    BlocoEstatisticas *estatisticas = blocoEstatisticas();
+    uint64_t inicio = iniciarOperacaoEstatistica(estatisticas);
+
+    // No modo concorrente, a procura inteira percorre a versão da Trie publicada quando começou.
+    LeitorEpoca *leitor = NULL;
+    uintptr_t no;
+    if (dicionario->compacta != NULL)
+        no = dicionario->compacta->raiz;
+    else if (dicionario->concorrencia != NULL)
+    {
+        leitor = iniciarLeituraConcorrente(dicionario);
+        no = (uintptr_t)__atomic_load_n(&dicionario->raiz, __ATOMIC_SEQ_CST);
+    }
+    else
+        no = (uintptr_t)dicionario->raiz;
+
+    if (comprimento > 0 && leitor == NULL)
+        no = procura.compacta != NULL ? procura.compacta->tabelaRaiz[(unsigned char)prefixo[0]]
+                                      : (uintptr_t)dicionario->tabelaRaiz[(unsigned char)prefixo[0]];
+
+    // Descer até ao nó do último caractere do prefixo: o próprio prefixo pode ser uma palavra, e as restantes
+    // palavras estão na subárvore do seu filho central.
+    for (int i = 0; i < comprimento && no != 0;)
+    {
+        const NoCompacto *compacto = procura.compacta != NULL ? &procura.compacta->nos[no] : NULL;
+        const NoTST *ponteiro = (const NoTST *)no;
+        char caractere = compacto != NULL ? compacto->caractere : ponteiro->caractere;
+
+        procura.nosVisitados++;
+        if (prefixo[i] < caractere)
+            no = compacto != NULL ? compacto->esquerda : (uintptr_t)ponteiro->esquerda;
+        else if (prefixo[i] > caractere)
+            no = compacto != NULL ? compacto->direito : (uintptr_t)ponteiro->direito;
+        else
+        {
+            if (++i == comprimento)
+            {
+                bool fimPalavra = compacto != NULL ? (compacto->flags & FLAG_FIM_PALAVRA) != 0 : ponteiro->fim_palavra;
+                uint32_t peso = compacto == NULL ? ponteiro->peso : procura.compacta->pesos != NULL ? procura.compacta->pesos[no] : 0;
+                if (fimPalavra)
+                    juntarAutocompletar(&procura, chaveAutocompletar(peso, true, 0), 0, 0);
+            }
+            no = compacto != NULL ? compacto->centro : (uintptr_t)ponteiro->centro;
+        }
+    }
+    juntarSubarvoreAutocompletar(&procura, no, 0);
+
+    while (entregues < k && procura.totalFila > 0 && !procura.falhou)
+    {
+        EntradaAutocompletar melhor = retirarAutocompletar(&procura);
+
+        // Uma subárvore é aberta; uma palavra é reconstruída a partir dos passos e entregue.
+        if (!(melhor.chave & (1u << 8)))
+        {
+            expandirAutocompletar(&procura, melhor.no, melhor.caminho);
+            continue;
+        }
+
+        int tamanho = comprimento + procura.passos[melhor.caminho].comprimento;
+        buffer[tamanho] = '\0';
+        for (uint32_t passo = melhor.caminho; passo != 0; passo = procura.passos[passo].anterior)
+            buffer[comprimento + procura.passos[passo].comprimento - 1] = procura.passos[passo].caractere;
+
+        visitar(buffer, (uint32_t)(melhor.chave >> 9), contexto);
+        entregues++;
+    }
+
+    if (leitor != NULL)
+        terminarLeituraConcorrente(dicionario, leitor);
+
+    somarContador(&estatisticas->valores.nosVisitados, procura.nosVisitados);
+    terminarOperacaoEstatistica(estatisticas, ESTATISTICA_AUTOCOMPLETAR, inicio);
+    RASTREAR("autocompletar '%s' (k = %zu): %zu nós visitados, %zu passos, %zu palavras\n", prefixo, k,
+             procura.nosVisitados, procura.totalPassos, entregues);
+
+    free(procura.fila);
+    free(procura.passos);
+    return entregues;
+}
+
+// Imprime uma sugestão do autocompletar, com o seu peso.
+static void imprimirPalavraPeso(const char *palavra, uint32_t peso, void *contexto)
+{
+    (void)contexto;
+    printf("%10u  %s\n", peso, palavra);
+}
+
+// Imprime as k palavras de maior peso com o prefixo fornecido.
+void autocompletarPrefixo(Dicionario *dicionario, const char *prefixo, size_t k)
+{
+    if (prefixo == NULL || strlen(prefixo) >= MAX_TAMANHO_PALAVRA)
+    {
+        printf("Prefixo inválido.\n");
+        return;
+    }
+
+    if (melhoresComPrefixo(dicionario, prefixo, k, imprimirPalavraPeso, NULL) == 0)
+        printf("Nenhuma palavra começa com '%s'.\n", prefixo);
+}
+
+// *********************************** IMPRESSÃO DA PALAVRA COM O PREFIXO MAIS LONGO ***********************************
+
+// Função para retornar o prefixo mais longo de uma palavra que existe no dicionário.
+char *prefixoMaisLongo(Dicionario *dicionario, const char *palavra)
+{
+
+    int i;
+
+    if (palavra == NULL || strlen(palavra) == 0)
+    {
+        printf("Palavra inválida.\n");
+        return NULL;
+    }
+
+    // Comprimento do maior prefixo da palavra que termina uma palavra do dicionário.
+    int comprimento = 0;
+    int tamanhoPalavra = (int)strlen(palavra);
+
+    if (dicionario->compacta != NULL)
+    {
+        // Mesmo percurso, mas sobre o layout compacto.
+        const NoCompacto *nos = dicionario->compacta->nos;
+        uint32_t indice = dicionario->compacta->tabelaRaiz[(unsigned char)palavra[0]];
+
+        for (i = 0; i < tamanhoPalavra && indice != 0;)
+        {
+            if (palavra[i] < nos[indice].caractere)
+                indice = nos[indice].esquerda;
+            else if (palavra[i] > nos[indice].caractere)
+                indice = nos[indice].direito;
+            else
+            {
+                if (nos[indice].flags & FLAG_FIM_PALAVRA)
+                    comprimento = i + 1;
+                indice = nos[indice].centro;
+                i++;
+            }
+        }
+    }
+    else
+    {
+        // Nó atual para percorrer a trie (o do primeiro caractere, pela tabela da raiz, fora do modo concorrente). No modo
+        // concorrente, o percurso inteiro é uma leitura protegida pela época, sobre a raiz publicada quando começou.
+        LeitorEpoca *leitor = NULL;
+        const NoTST *noAtual;
+        if (dicionario->concorrencia != NULL)
+        {
+            leitor = iniciarLeituraConcorrente(dicionario);
+            noAtual = __atomic_load_n(&dicionario->raiz, __ATOMIC_SEQ_CST);
+        }
+        else
+            noAtual = dicionario->tabelaRaiz[(unsigned char)palavra[0]];
+
+        // Procurar o nó que corresponde ao último caractere da palavra.
+        for (i = 0; i < tamanhoPalavra && noAtual != NULL;)
+        {
+            if (palavra[i] < noAtual->caractere)
+                noAtual = noAtual->esquerda;
+            else if (palavra[i] > noAtual->caractere)
+                noAtual = noAtual->direito;
+            else
+            {
+                if (noAtual->fim_palavra)
+                    comprimento = i + 1;
+                noAtual = noAtual->centro;
+                i++;
+            }
+        }
+
+        if (leitor != NULL)
+            terminarLeituraConcorrente(dicionario, leitor);
+    }
+
+    char *prefixo = (char *)malloc(sizeof(char) * (comprimento + 1));
+    if (prefixo == NULL)
+    {
+        return NULL;
+    }
+    memcpy(prefixo, palavra, comprimento);
+    prefixo[comprimento] = '\0';
+    return prefixo;
+}
+
+// *********************************** IMPRESSÃO DE TODAS AS PALAVRAS COM A MESMA DISTÂNCIA DE EDIÇÃO ***********************************
+
+// Função que retorna o menor de três números.
+int min(int a, int b, int c) {
+    if (a < b) return (a < c)? a : c;
+    else return (b < c)? b : c;
+}
+
+// Função que calcula a distância de edição entre duas palavras.
+// Se uma delas couber em 64 bits usa o algoritmo bit-paralelo; caso contrário, a programação dinâmica com duas linhas.
+int distanciaEdicao(const char *palavra1, int comprimento1, const char *palavra2, int comprimento2) {
+    PadraoBitParalelo padrao;
+
+    // O padrão é a palavra mais curta; a distância é simétrica.
+    if (comprimento1 > comprimento2) {
+        const char *palavra = palavra1;
+        int comprimento = comprimento1;
+        palavra1 = palavra2;
+        comprimento1 = comprimento2;
+        palavra2 = palavra;
+        comprimento2 = comprimento;
+    }
+
+    if (prepararPadraoBitParalelo(&padrao, palavra1, comprimento1))
+        return distanciaEdicaoBitParalela(&padrao, palavra2, comprimento2);
+
+    // Apenas duas linhas da matriz são necessárias de cada vez.
+    int *anterior = (int *)malloc((comprimento2 + 1) * sizeof(int));
+    int *atual = (int *)malloc((comprimento2 + 1) * sizeof(int));
+    if (anterior == NULL || atual == NULL) {
+        free(anterior);
+        free(atual);
+        return -1;
+    }
+
+    for (int j = 0; j <= comprimento2; j++)
+        anterior[j] = j;
+
+    for (int i = 1; i <= comprimento1; i++) {
+        atual[0] = i;
+        for (int j = 1; j <= comprimento2; j++) {
+            if (palavra1[i-1] == palavra2[j-1])
+                atual[j] = anterior[j-1];
+            else
+                atual[j] = 1 + min(atual[j-1],     // Inserção
+                                   anterior[j],    // Remoção
+                                   anterior[j-1]   // Substituição
+                                  );
+        }
+        int *troca = anterior;
+        anterior = atual;
+        atual = troca;
+    }
+
+    int distancia = anterior[comprimento2];
+    free(anterior);
+    free(atual);
+    return distancia;
+}
+
+// *********************************** DISTÂNCIA DE EDIÇÃO BIT-PARALELA ***********************************
+
+// Prepara as máscaras do padrão: o bit i da máscara de um byte indica que o padrão tem esse byte na posição i.
+bool prepararPadraoBitParalelo(PadraoBitParalelo *padrao, const char *palavra, int comprimento)
+{
+    if (comprimento < 0 || comprimento > MAX_PADRAO_BIT_PARALELO)
+        return false;
+
+    memset(padrao->mascaras, 0, sizeof(padrao->mascaras));
+    for (int i = 0; i < comprimento; i++)
+        padrao->mascaras[(unsigned char)palavra[i]] |= (uint64_t)1 << i;
+
+    padrao->comprimento = comprimento;
+    return true;
+}
+
+// Núcleo escalar do algoritmo de Myers/Hyyrö. Os vetores Pv/Mv guardam as diferenças verticais (+1/-1) de uma coluna
+// da matriz; cada caractere do texto atualiza a coluna inteira com meia dúzia de operações sobre 64 bits.
+// Com limite >= 0, pára logo que a distância final não possa voltar a ficar dentro do limite.
+static int distanciaBitParalelaNucleo(const PadraoBitParalelo *padrao, const char *texto, int comprimento, int limite)
+{
+    int m = padrao->comprimento;
+
+    if (m == 0)
+        return (limite >= 0 && comprimento > limite) ? limite + 1 : comprimento;
+
+    uint64_t pv = ~(uint64_t)0, mv = 0;
+    uint64_t ultimo = (uint64_t)1 << (m - 1);
+    int distancia = m;
+
+    for (int j = 0; j < comprimento; j++)
+    {
+        uint64_t eq = padrao->mascaras[(unsigned char)texto[j]];
+        uint64_t xv = eq | mv;
+        uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+
+        if (ph & ultimo)
+            distancia++;
+        else if (mh & ultimo)
+            distancia--;
+
+        // A primeira linha da matriz cresce uma unidade por coluna, daí o bit 1 que entra em ph.
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+
+        // Cada caractere restante do texto só pode baixar a distância em uma unidade.
+        if (limite >= 0 && distancia - (comprimento - j - 1) > limite)
+            return limite + 1;
+    }
+
+    return distancia;
+}
+
+// Calcula a distância de edição entre o padrão e um texto.
+int distanciaEdicaoBitParalela(const PadraoBitParalelo *padrao, const char *texto, int comprimento)
+{
+    return distanciaBitParalelaNucleo(padrao, texto, comprimento, -1);
+}
+
+// Calcula a distância de edição com paragem antecipada quando o limite é ultrapassado.
+int distanciaEdicaoLimitada(const PadraoBitParalelo *padrao, const char *texto, int comprimento, int limite)
+{
+    // A diferença de comprimentos já é um mínimo para a distância.
+    int diferenca = comprimento - padrao->comprimento;
+    if (diferenca < 0)
+        diferenca = -diferenca;
+    if (limite >= 0 && diferenca > limite)
+        return limite + 1;
+
+    return distanciaBitParalelaNucleo(padrao, texto, comprimento, limite);
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+// Versão AVX2: quatro candidatas por vetor de 256 bits, uma por cada faixa de 64 bits.
+// As faixas cujas candidatas já terminaram mantêm o estado anterior (mistura com a máscara de faixas ativas).
+__attribute__((target("avx2")))
+static void distanciaLoteAVX2(const PadraoBitParalelo *padrao, const char *const *candidatas, const int *comprimentos,
+                              int limite, int *resultados)
+{
+    const __m256i um = _mm256_set1_epi64x(1);
+    const int deslocamento = padrao->comprimento - 1;
+    __m256i pv = _mm256_set1_epi64x(-1), mv = _mm256_setzero_si256();
+    __m256i distancia = _mm256_set1_epi64x(padrao->comprimento);
+    __m256i comprimento = _mm256_set_epi64x(comprimentos[3], comprimentos[2], comprimentos[1], comprimentos[0]);
+    int maior = 0, processados = 0;
+
+    for (int faixa = 0; faixa < 4; faixa++)
+        if (comprimentos[faixa] > maior)
+            maior = comprimentos[faixa];
+
+    for (int j = 0; j < maior; j++)
+    {
+        processados = j + 1;
+
+        // Faixas ativas: candidatas com mais de j caracteres.
+        __m256i ativa = _mm256_cmpgt_epi64(comprimento, _mm256_set1_epi64x(j));
+        // As candidatas que já terminaram leem o seu '\0', cuja máscara é vazia (o padrão não tem '\0'), em vez de
+        // um salto por faixa. O vetor é montado nos registos: uma carga de 256 bits logo depois de quatro escritas
+        // de 64 bits não aproveitaria o reencaminhamento das escritas.
+        long long eqs[4];
+        for (int faixa = 0; faixa < 4; faixa++)
+            eqs[faixa] = (long long)padrao->mascaras[(unsigned char)candidatas[faixa][j < comprimentos[faixa] ? j : comprimentos[faixa]]];
+        __m128i baixo = _mm_insert_epi64(_mm_cvtsi64_si128(eqs[0]), eqs[1], 1);
+        __m128i alto = _mm_insert_epi64(_mm_cvtsi64_si128(eqs[2]), eqs[3], 1);
+        __m256i eq = _mm256_inserti128_si256(_mm256_castsi128_si256(baixo), alto, 1);
+        __m256i xv = _mm256_or_si256(eq, mv);
+        __m256i xh = _mm256_or_si256(_mm256_xor_si256(_mm256_add_epi64(_mm256_and_si256(eq, pv), pv), pv), eq);
+        __m256i ph = _mm256_or_si256(mv, _mm256_xor_si256(_mm256_or_si256(xh, pv), _mm256_set1_epi64x(-1)));
+        __m256i mh = _mm256_and_si256(pv, xh);
+
+        // distância += bit mais alto de ph - bit mais alto de mh (apenas nas faixas ativas).
+        __m256i soma = _mm256_and_si256(_mm256_srli_epi64(ph, deslocamento), um);
+        __m256i subtrai = _mm256_and_si256(_mm256_srli_epi64(mh, deslocamento), um);
+        distancia = _mm256_add_epi64(distancia, _mm256_and_si256(_mm256_sub_epi64(soma, subtrai), ativa));
+
+        ph = _mm256_or_si256(_mm256_slli_epi64(ph, 1), um);
+        mh = _mm256_slli_epi64(mh, 1);
+        __m256i novoPv = _mm256_or_si256(mh, _mm256_xor_si256(_mm256_or_si256(xv, ph), _mm256_set1_epi64x(-1)));
+        __m256i novoMv = _mm256_and_si256(ph, xv);
+        pv = _mm256_blendv_epi8(pv, novoPv, ativa);
+        mv = _mm256_blendv_epi8(mv, novoMv, ativa);
+
+        // Paragem antecipada quando nenhuma das quatro candidatas pode voltar a ficar dentro do limite.
+        if (limite >= 0 && (j & 7) == 7)
+        {
+            uint64_t valores[4];
+            bool todasAcima = true;
+            _mm256_storeu_si256((__m256i *)valores, distancia);
+            for (int faixa = 0; faixa < 4 && todasAcima; faixa++)
+            {
+                int restantes = comprimentos[faixa] - j - 1;
+                todasAcima = (int)valores[faixa] - (restantes > 0 ? restantes : 0) > limite;
+            }
+            if (todasAcima)
+                break;
+        }
+    }
+
+    uint64_t valores[4];
+    _mm256_storeu_si256((__m256i *)valores, distancia);
+    for (int faixa = 0; faixa < 4; faixa++)
+    {
+        // Uma candidata interrompida não tem a distância final, mas só se interrompe quando ela excede o limite.
+        int valor = (int)valores[faixa];
+        if (limite >= 0 && (comprimentos[faixa] > processados || valor > limite))
+            valor = limite + 1;
+        resultados[faixa] = valor;
+    }
+}
+
+// Versão SSE2: duas candidatas por vetor de 128 bits. O SSE2 não tem mistura por máscara nem comparação de 64 bits,
+// portanto as faixas inativas são preservadas com and/andnot e a máscara é montada a partir dos comprimentos.
+__attribute__((target("sse2")))
+static void distanciaLoteSSE2(const PadraoBitParalelo *padrao, const char *const *candidatas, const int *comprimentos,
+                              int limite, int *resultados)
+{
+    const __m128i um = _mm_set1_epi64x(1);
+    const __m128i todos = _mm_set1_epi64x(-1);
+    const int deslocamento = padrao->comprimento - 1;
+    __m128i pv = todos, mv = _mm_setzero_si128();
+    __m128i distancia = _mm_set1_epi64x(padrao->comprimento);
+    int maior = comprimentos[0] > comprimentos[1] ? comprimentos[0] : comprimentos[1], processados = 0;
+
+    for (int j = 0; j < maior; j++)
+    {
+        processados = j + 1;
+
+        __m128i ativa = _mm_set_epi64x(j < comprimentos[1] ? -1 : 0, j < comprimentos[0] ? -1 : 0);
+        __m128i eq = _mm_set_epi64x(j < comprimentos[1] ? (long long)padrao->mascaras[(unsigned char)candidatas[1][j]] : 0,
+                                    j < comprimentos[0] ? (long long)padrao->mascaras[(unsigned char)candidatas[0][j]] : 0);
+        __m128i xv = _mm_or_si128(eq, mv);
+        __m128i xh = _mm_or_si128(_mm_xor_si128(_mm_add_epi64(_mm_and_si128(eq, pv), pv), pv), eq);
+        __m128i ph = _mm_or_si128(mv, _mm_xor_si128(_mm_or_si128(xh, pv), todos));
+        __m128i mh = _mm_and_si128(pv, xh);
+
+        __m128i soma = _mm_and_si128(_mm_srli_epi64(ph, deslocamento), um);
+        __m128i subtrai = _mm_and_si128(_mm_srli_epi64(mh, deslocamento), um);
+        distancia = _mm_add_epi64(distancia, _mm_and_si128(_mm_sub_epi64(soma, subtrai), ativa));
+
+        ph = _mm_or_si128(_mm_slli_epi64(ph, 1), um);
+        mh = _mm_slli_epi64(mh, 1);
+        __m128i novoPv = _mm_or_si128(mh, _mm_xor_si128(_mm_or_si128(xv, ph), todos));
+        __m128i novoMv = _mm_and_si128(ph, xv);
+        pv = _mm_or_si128(_mm_and_si128(ativa, novoPv), _mm_andnot_si128(ativa, pv));
+        mv = _mm_or_si128(_mm_and_si128(ativa, novoMv), _mm_andnot_si128(ativa, mv));
+
+        // Paragem antecipada, como na versão AVX2.
+        if (limite >= 0 && (j & 7) == 7)
+        {
+            uint64_t valores[2];
+            bool todasAcima = true;
+            _mm_storeu_si128((__m128i *)valores, distancia);
+            for (int faixa = 0; faixa < 2 && todasAcima; faixa++)
+            {
+                int restantes = comprimentos[faixa] - j - 1;
+                todasAcima = (int)valores[faixa] - (restantes > 0 ? restantes : 0) > limite;
+            }
+            if (todasAcima)
+                break;
+        }
+    }
+
+    uint64_t valores[2];
+    _mm_storeu_si128((__m128i *)valores, distancia);
+    for (int faixa = 0; faixa < 2; faixa++)
+    {
+        int valor = (int)valores[faixa];
+        if (limite >= 0 && (comprimentos[faixa] > processados || valor > limite))
+            valor = limite + 1;
+        resultados[faixa] = valor;
+    }
+}
+
+#endif
+
+// Calcula a distância do padrão a um lote de candidatas. As candidatas são processadas em grupos de quatro (AVX2)
+// ou de duas (SSE2), com o mesmo padrão em todas as faixas; as que sobram usam o núcleo escalar. Com limite, as
+// candidatas cuja diferença de comprimento já o excede ficam de fora dos grupos, para não ocuparem uma faixa.
+void distanciaEdicaoLote(const PadraoBitParalelo *padrao, const char *const *candidatas, const int *comprimentos,
+                         size_t total, int limite, int *resultados)
+{
+    const char *grupo[4];
+    int comprimentosGrupo[4], resultadosGrupo[4];
+    size_t indices[4], noGrupo = 0, largura = 1;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    if (padrao->comprimento > 0)
+        largura = __builtin_cpu_supports("avx2") ? 4 : __builtin_cpu_supports("sse2") ? 2 : 1;
+#endif
+
+    for (size_t i = 0; i < total; i++)
+    {
+        if (limite >= 0 && abs(comprimentos[i] - padrao->comprimento) > limite)
+        {
+            resultados[i] = limite + 1;
+            continue;
+        }
+
+        grupo[noGrupo] = candidatas[i];
+        comprimentosGrupo[noGrupo] = comprimentos[i];
+        indices[noGrupo++] = i;
+        if (noGrupo < largura)
+            continue;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        if (largura == 4)
+            distanciaLoteAVX2(padrao, grupo, comprimentosGrupo, limite, resultadosGrupo);
+        else if (largura == 2)
+            distanciaLoteSSE2(padrao, grupo, comprimentosGrupo, limite, resultadosGrupo);
+        else
+#endif
+            resultadosGrupo[0] = distanciaBitParalelaNucleo(padrao, grupo[0], comprimentosGrupo[0], limite);
+
+        for (size_t k = 0; k < noGrupo; k++)
+            resultados[indices[k]] = resultadosGrupo[k];
+        noGrupo = 0;
+    }
+
+    // As candidatas de um grupo incompleto usam o núcleo escalar.
+    for (size_t k = 0; k < noGrupo; k++)
+        resultados[indices[k]] = distanciaBitParalelaNucleo(padrao, grupo[k], comprimentosGrupo[k], limite);
+}
+
+// Calcula a linha da programação dinâmica do prefixo com 'profundidade' + 1 caracteres, a partir da linha do pai
+// (o prefixo sem o último caractere). Devolve o menor valor da linha: se ele exceder a distância pedida,
+// nenhuma palavra que continue este prefixo pode estar suficientemente perto da palavra base.
+static int calcularLinhaDistancia(ProcuraDistancia *procura, int profundidade, char caractere)
+{
+    const int *anterior = procura->linhas[profundidade];
+    int *atual = procura->linhas[profundidade + 1];
+    int menor;
+
+    atual[0] = profundidade + 1;
+    menor = atual[0];
+
+    for (int j = 1; j <= procura->comprimentoBase; j++)
+    {
+        atual[j] = min(atual[j - 1] + 1,                                                // Inserção
+                       anterior[j] + 1,                                                 // Remoção
+                       anterior[j - 1] + (procura->palavraBase[j - 1] != caractere));   // Substituição
+        if (atual[j] < menor)
+            menor = atual[j];
+    }
+
+    return menor;
+}
+
+// Regista a palavra que termina no nó atual se a sua distância satisfizer o modo pedido.
+static void avaliarPalavraDistancia(ProcuraDistancia *procura, int profundidade)
+{
+    int distancia = procura->linhas[profundidade + 1][procura->comprimentoBase];
+
+    if (distancia == procura->distancia || (procura->modo == DISTANCIA_MAXIMA && distancia < procura->distancia))
+    {
+        procura->buffer[profundidade + 1] = '\0';
+        procura->encontradas++;
+        if (procura->visitar != NULL)
+            procura->visitar(procura->buffer, distancia, procura->contexto);
+    }
+}
+
+// Função auxiliar que percorre a Trie calculando uma linha de distâncias por profundidade.
+// Os irmãos esquerdo e direito reutilizam a linha do pai; o filho central parte da linha deste nó.
+void palavrasPorDistanciaMinimaAux(const NoTST *no, int profundidade, ProcuraDistancia *procura) {
+    if (no == NULL || profundidade + 1 >= MAX_TAMANHO_PALAVRA)
+        return;
+
+    // Vai para o nó esquerdo
+    palavrasPorDistanciaMinimaAux(no->esquerda, profundidade, procura);
+
+    // Adiciona o caractere do nó no buffer e calcula a linha do novo prefixo
+    procura->nosVisitados++;
+    procura->buffer[profundidade] = no->caractere;
+    int menor = calcularLinhaDistancia(procura, profundidade, no->caractere);
+
+    if (no->fim_palavra)
+        avaliarPalavraDistancia(procura, profundidade);
+
+    // Vai para o nó do meio, apenas se ainda houver palavras possíveis por baixo dele
+    if (menor <= procura->distancia)
+        palavrasPorDistanciaMinimaAux(no->centro, profundidade + 1, procura);
+
+    // Vai para o nó direito
+    palavrasPorDistanciaMinimaAux(no->direito, profundidade, procura);
+}
+
+// Versão da função auxiliar anterior para o layout compacto.
+void palavrasPorDistanciaMinimaCompacta(const TSTCompacta *compacta, uint32_t indice, int profundidade, ProcuraDistancia *procura) {
+    if (indice == 0 || profundidade + 1 >= MAX_TAMANHO_PALAVRA)
+        return;
+
+    const NoCompacto *no = &compacta->nos[indice];
+
+    palavrasPorDistanciaMinimaCompacta(compacta, no->esquerda, profundidade, procura);
+
+    procura->nosVisitados++;
+    procura->buffer[profundidade] = no->caractere;
+    int menor = calcularLinhaDistancia(procura, profundidade, no->caractere);
+
+    if (no->flags & FLAG_FIM_PALAVRA)
+        avaliarPalavraDistancia(procura, profundidade);
+
+    if (menor <= procura->distancia)
+        palavrasPorDistanciaMinimaCompacta(compacta, no->centro, profundidade + 1, procura);
+
+    palavrasPorDistanciaMinimaCompacta(compacta, no->direito, profundidade, procura);
+}
+
+// Chama 'visitar' para cada palavra à distância de edição pedida, por ordem.
+size_t procurarPorDistancia(const Dicionario *dicionario, const char *palavraBase, int distancia, ModoDistancia modo,
+                            VisitanteDistancia visitar, void *contexto) {
+    if (dicionario == NULL || palavraBase == NULL || distancia < 0)
+        return 0;
+
+    int comprimentoBase = (int)strlen(palavraBase);
+    if (comprimentoBase >= MAX_TAMANHO_PALAVRA)
+        return 0;
+
+    // O estado tem uma linha por profundidade possível; é grande demais para a pilha.
+    ProcuraDistancia *procura = (ProcuraDistancia *)malloc(sizeof(ProcuraDistancia));
+    if (procura == NULL)
+        return 0;
+
+    procura->palavraBase = palavraBase;
+    procura->comprimentoBase = comprimentoBase;
+    procura->distancia = distancia;
+    procura->modo = modo;
+    procura->visitar = visitar;
+    procura->contexto = contexto;
+    procura->encontradas = 0;
+    procura->nosVisitados = 0;
+
+    BlocoEstatisticas *estatisticas = blocoEstatisticas();
+    uint64_t inicio = iniciarOperacaoEstatistica(estatisticas);
+
+    // A linha do prefixo vazio é a distância até cada prefixo da palavra base (só inserções).
+    for (int j = 0; j <= comprimentoBase; j++)
+        procura->linhas[0][j] = j;
+
+    if (dicionario->compacta != NULL)
+    {
+        palavrasPorDistanciaMinimaCompacta(dicionario->compacta, dicionario->compacta->raiz, 0, procura);
+    }
+    else if (dicionario->concorrencia != NULL)
+    {
+        // A procura inteira percorre a versão da Trie publicada quando começou.
+        LeitorEpoca *leitor = iniciarLeituraConcorrente(dicionario);
+        palavrasPorDistanciaMinimaAux(__atomic_load_n(&dicionario->raiz, __ATOMIC_SEQ_CST), 0, procura);
+        terminarLeituraConcorrente(dicionario, leitor);
+    }
+    else
+    {
+        palavrasPorDistanciaMinimaAux(dicionario->raiz, 0, procura);
+    }
+
+    somarContador(&estatisticas->valores.nosVisitados, procura->nosVisitados);
+    terminarOperacaoEstatistica(estatisticas, ESTATISTICA_DISTANCIA, inicio);
+    RASTREAR("distância %d de '%s': %zu nós visitados, %zu palavras\n", distancia, palavraBase, procura->nosVisitados,
+             procura->encontradas);
+
+    size_t encontradas = procura->encontradas;
+    free(procura);
+    return encontradas;
+}
+
+// Imprime uma palavra encontrada na procura por distância.
+static void imprimirPalavraDistancia(const char *palavra, int distancia, void *contexto) {
+    (void)contexto;
+    printf("%s (%d)\n", palavra, distancia);
+}
+
+// Imprime todas as palavras que estão a uma certa distância (exata ou máxima) de edição de uma palavra base.
+void palavrasPorDistanciaMinima(Dicionario *dicionario, const char *palavraBase, int distancia, ModoDistancia modo) {
+    // Verifica se o dicionário é válido
+    if (dicionario == NULL || (dicionario->raiz == NULL && dicionario->compacta == NULL)) {
+        printf("Dicionario vazio ou invalido.\n");
+        return;
+    }
+
+    if (procurarPorDistancia(dicionario, palavraBase, distancia, modo, imprimirPalavraDistancia, NULL) == 0)
+        printf("Nenhuma palavra encontrada.\n");
+}
+
+
+// *********************************** CACHE DE SUGESTÕES ***********************************
+
+// Struct auxiliar que junta as melhores sugestões de uma procura por distância, ordenadas pela distância.
+typedef struct
+{
+    char palavras[MAX_SUGESTOES][MAX_TAMANHO_PALAVRA];
+    int distancias[MAX_SUGESTOES];
+    int total;
+} ColecaoSugestoes;
+
+// Guarda uma palavra encontrada se estiver entre as MAX_SUGESTOES mais próximas. As palavras chegam por ordem
+// alfabética, portanto, em caso de empate, fica a que chegou primeiro.
+static void recolherSugestao(const char *palavra, int distancia, void *contexto)
+{
+    ColecaoSugestoes *colecao = (ColecaoSugestoes *)contexto;
+    int posicao = colecao->total;
+
+    while (posicao > 0 && colecao->distancias[posicao - 1] > distancia)
+        posicao--;
+    if (posicao >= MAX_SUGESTOES)
+        return;
+
+    int ultima = colecao->total < MAX_SUGESTOES ? colecao->total : MAX_SUGESTOES - 1;
+    for (int i = ultima; i > posicao; i--)
+    {
+        memcpy(colecao->palavras[i], colecao->palavras[i - 1], MAX_TAMANHO_PALAVRA);
+        colecao->distancias[i] = colecao->distancias[i - 1];
+    }
+
+    snprintf(colecao->palavras[posicao], MAX_TAMANHO_PALAVRA, "%s", palavra);
+    colecao->distancias[posicao] = distancia;
+    if (colecao->total < MAX_SUGESTOES)
+        colecao->total++;
+}
+
+// Calcula as sugestões de uma palavra sem a cache, escrevendo-as em 'sugestoes' separadas por ", ".
+// Uma sugestão que já não caiba no espaço disponível é descartada inteira.
+static int calcularSugestoes(const Dicionario *dicionario, const char *palavra, char *sugestoes, size_t tamanho)
+{
+    ColecaoSugestoes colecao;
+    size_t usado = 0;
+    int escritas = 0;
+
+    colecao.total = 0;
+    procurarPorDistancia(dicionario, palavra, DISTANCIA_SUGESTOES, DISTANCIA_MAXIMA, recolherSugestao, &colecao);
+
+    sugestoes[0] = '\0';
+    for (int i = 0; i < colecao.total; i++)
+    {
+        int escrito = snprintf(sugestoes + usado, tamanho - usado, "%s%s", escritas > 0 ? ", " : "", colecao.palavras[i]);
+        if (escrito < 0 || (size_t)escrito >= tamanho - usado)
+        {
+            sugestoes[usado] = '\0';
+            break;
+        }
+        usado += (size_t)escrito;
+        escritas++;
+    }
+
+    return escritas;
+}
+
+// Cria uma cache de sugestões vazia com 'totalConjuntos' conjuntos de VIAS_CACHE_SUGESTOES entradas.
+CacheSugestoes *criarCacheSugestoes(size_t totalConjuntos)
+{
+    CacheSugestoes *cache = (CacheSugestoes *)calloc(1, sizeof(CacheSugestoes));
+    if (cache == NULL || totalConjuntos == 0)
+    {
+        free(cache);
+        return NULL;
+    }
+
+    // As entradas livres têm a palavra vazia, portanto a memória zerada já representa uma cache vazia.
+    cache->entradas = (EntradaCacheSugestoes *)calloc(totalConjuntos * VIAS_CACHE_SUGESTOES, sizeof(EntradaCacheSugestoes));
+    cache->ponteiros = (uint8_t *)calloc(totalConjuntos, sizeof(uint8_t));
+    if (cache->entradas == NULL || cache->ponteiros == NULL)
+    {
+        free(cache->entradas);
+        free(cache->ponteiros);
+        free(cache);
+        return NULL;
+    }
+
+    cache->totalConjuntos = totalConjuntos;
+    for (int i = 0; i < TRINCOS_CACHE_SUGESTOES; i++)
+        pthread_mutex_init(&cache->fragmentos[i].trinco, NULL);
+    pthread_mutex_init(&cache->trincoAlteradas, NULL);
+    return cache;
+}
+
+// Liberta a cache de sugestões.
+void destruirCacheSugestoes(CacheSugestoes *cache)
+{
+    if (cache == NULL)
+        return;
+
+    for (int i = 0; i < TRINCOS_CACHE_SUGESTOES; i++)
+        pthread_mutex_destroy(&cache->fragmentos[i].trinco);
+    pthread_mutex_destroy(&cache->trincoAlteradas);
+    free(cache->entradas);
+    free(cache->ponteiros);
+    free(cache);
+}
+
+// Procura uma palavra nas vias de um conjunto. Devolve NULL se não estiver lá.
+static EntradaCacheSugestoes *procurarNoConjunto(EntradaCacheSugestoes *conjunto, uint64_t hash, const char *palavra)
+{
+    for (int via = 0; via < VIAS_CACHE_SUGESTOES; via++)
+    {
+        if (conjunto[via].hash == hash && strcmp(conjunto[via].palavra, palavra) == 0)
+            return &conjunto[via];
+    }
+    return NULL;
+}
+
+// Escolhe a entrada do conjunto a substituir com o algoritmo CLOCK: o ponteiro avança pelas vias, dando uma segunda
+// oportunidade às que foram usadas desde a última passagem, até encontrar uma livre ou não referenciada.
+static EntradaCacheSugestoes *escolherVitima(EntradaCacheSugestoes *conjunto, uint8_t *ponteiro)
+{
+    for (;;)
+    {
+        EntradaCacheSugestoes *entrada = &conjunto[*ponteiro];
+        *ponteiro = (uint8_t)((*ponteiro + 1) % VIAS_CACHE_SUGESTOES);
+
+        if (entrada->palavra[0] == '\0' || !entrada->referenciada)
+            return entrada;
+        entrada->referenciada = false;
+    }
+}
+
+// Verifica se as sugestões de uma entrada calculada numa versão anterior continuam certas na versão 'versao': só
+// mudam se uma das palavras alteradas entretanto estiver a DISTANCIA_SUGESTOES ou menos da palavra da entrada. As
+// palavras alteradas são comparadas de uma vez com a distância em lote; se a cache já não as conhecer todas (mais de
+// ALTERACOES_CACHE_SUGESTOES alterações ou uma alteração em massa), a entrada tem de ser recalculada.
+static bool revalidarEntradaSugestoes(CacheSugestoes *cache, const EntradaCacheSugestoes *entrada, uint64_t versao)
+{
+    const char *alteradas[ALTERACOES_CACHE_SUGESTOES] = {NULL};
+    int comprimentos[ALTERACOES_CACHE_SUGESTOES] = {0}, distancias[ALTERACOES_CACHE_SUGESTOES];
+    PadraoBitParalelo padrao;
+    bool valida = false;
+
+    if (versao <= entrada->versao || !prepararPadraoBitParalelo(&padrao, entrada->palavra, (int)strlen(entrada->palavra)))
+        return false;
+
+    pthread_mutex_lock(&cache->trincoAlteradas);
+    if (entrada->versao >= cache->versaoBaseAlteradas && versao - entrada->versao <= ALTERACOES_CACHE_SUGESTOES)
+    {
+        size_t total = (size_t)(versao - entrada->versao);
+        for (size_t i = 0; i < total; i++)
+        {
+            size_t posicao = (size_t)((entrada->versao + 1 + i) % ALTERACOES_CACHE_SUGESTOES);
+            alteradas[i] = cache->alteradas[posicao];
+            comprimentos[i] = cache->comprimentosAlteradas[posicao];
+        }
+        distanciaEdicaoLote(&padrao, alteradas, comprimentos, total, DISTANCIA_SUGESTOES, distancias);
+
+        valida = true;
+        for (size_t i = 0; i < total && valida; i++)
+            valida = distancias[i] > DISTANCIA_SUGESTOES;
+    }
+    pthread_mutex_unlock(&cache->trincoAlteradas);
+
+    return valida;
+}
+
+// Escreve as sugestões de uma palavra desconhecida, consultando primeiro a cache. As sugestões são calculadas fora
+// do trinco (a procura por distância é a parte cara), e só a cópia para a cache é feita com o trinco.
+size_t sugerirCorrecoes(const Dicionario *dicionario, const char *palavra, char *sugestoes, size_t tamanho)
+{
+    CacheSugestoes *cache = dicionario->sugestoes;
+    size_t comprimento = strlen(palavra);
+
+    if (tamanho == 0)
+        return 0;
+    if (cache == NULL || comprimento == 0 || comprimento >= MAX_TAMANHO_PALAVRA)
+        return (size_t)calcularSugestoes(dicionario, palavra, sugestoes, tamanho);
+
+    uint64_t hash = acumularHash(5381, (const unsigned char *)palavra, comprimento);
+    size_t indiceConjunto = (size_t)(hash % cache->totalConjuntos);
+    EntradaCacheSugestoes *conjunto = &cache->entradas[indiceConjunto * VIAS_CACHE_SUGESTOES];
+    FragmentoCacheSugestoes *fragmento = &cache->fragmentos[indiceConjunto % TRINCOS_CACHE_SUGESTOES];
+    uint64_t versao = __atomic_load_n(&dicionario->versao, __ATOMIC_ACQUIRE);
+
+    pthread_mutex_lock(&fragmento->trinco);
+    EntradaCacheSugestoes *entrada = procurarNoConjunto(conjunto, hash, palavra);
+    if (entrada != NULL && entrada->versao != versao && revalidarEntradaSugestoes(cache, entrada, versao))
+    {
+        entrada->versao = versao;
+        fragmento->estatisticas.revalidadas++;
+    }
+    if (entrada != NULL && entrada->versao == versao)
+    {
+        entrada->referenciada = true;
+        snprintf(sugestoes, tamanho, "%s", entrada->sugestoes);
+        size_t total = entrada->totalSugestoes;
+        fragmento->estatisticas.acertos++;
+        pthread_mutex_unlock(&fragmento->trinco);
+        return total;
+    }
+    if (entrada != NULL)
+        fragmento->estatisticas.invalidadas++;
+    fragmento->estatisticas.falhas++;
+    pthread_mutex_unlock(&fragmento->trinco);
+
+    char calculadas[TAMANHO_SUGESTOES];
+    int total = calcularSugestoes(dicionario, palavra, calculadas, sizeof(calculadas));
+
+    // Outra thread pode ter guardado a mesma palavra entretanto: nesse caso reutiliza-se a sua entrada.
+    pthread_mutex_lock(&fragmento->trinco);
+    entrada = procurarNoConjunto(conjunto, hash, palavra);
+    if (entrada == NULL)
+    {
+        entrada = escolherVitima(conjunto, &cache->ponteiros[indiceConjunto]);
+        if (entrada->palavra[0] != '\0')
+            fragmento->estatisticas.substituidas++;
+        entrada->hash = hash;
+        memcpy(entrada->palavra, palavra, comprimento + 1);
+    }
+    entrada->versao = versao;
+    entrada->referenciada = true;
+    entrada->totalSugestoes = (uint8_t)total;
+    memcpy(entrada->sugestoes, calculadas, sizeof(calculadas));
+    pthread_mutex_unlock(&fragmento->trinco);
+
+    snprintf(sugestoes, tamanho, "%s", calculadas);
+    return (size_t)total;
+}
+
+// Soma os contadores de todos os fragmentos da cache.
+void estatisticasCacheSugestoes(const Dicionario *dicionario, EstatisticasCacheSugestoes *estatisticas)
+{
+    memset(estatisticas, 0, sizeof(*estatisticas));
+    if (dicionario->sugestoes == NULL)
+        return;
+
+    for (int i = 0; i < TRINCOS_CACHE_SUGESTOES; i++)
+    {
+        FragmentoCacheSugestoes *fragmento = &dicionario->sugestoes->fragmentos[i];
+
+        pthread_mutex_lock(&fragmento->trinco);
+        estatisticas->acertos += fragmento->estatisticas.acertos;
+        estatisticas->falhas += fragmento->estatisticas.falhas;
+        estatisticas->invalidadas += fragmento->estatisticas.invalidadas;
+        estatisticas->revalidadas += fragmento->estatisticas.revalidadas;
+        estatisticas->substituidas += fragmento->estatisticas.substituidas;
+        pthread_mutex_unlock(&fragmento->trinco);
+    }
+}
+
+// *********************************** VERIFICAÇÃO ORTOGRÁFICA DO FICHEIRO DE TEXTO ***********************************
+
+// Imprime uma grafia do dicionário, precedida do título na primeira.
+static bool imprimirGrafiaDobrada(const char *grafia, void *contexto)
+{
+    bool *primeira = (bool *)contexto;
+
+    printf("%s%s", *primeira ? "Grafias no dicionário: " : ", ", grafia);
+    *primeira = false;
+    return true;
+}
+
+// Função para tratar palavra não encontrada no dicionário
+void tratarPalavraNaoEncontrada(Dicionario *dicionario, FILE *fileOutput, const char *palavra)
+{
+    char sugestoes[TAMANHO_SUGESTOES];
+    bool primeira = true;
+
+    // Imprimir a palavra, as suas grafias no dicionário (se só diferir delas em maiúsculas ou acentos) e as sugestões
+    // de correção (as palavras repetidas são respondidas pela cache)
+    printf("A palavra '%s' não foi encontrada no dicionário.\n", palavra);
+    if (procurarPalavraDobrada(dicionario, palavra, imprimirGrafiaDobrada, &primeira) > 0)
+        printf("\n");
+    if (sugerirCorrecoes(dicionario, palavra, sugestoes, sizeof(sugestoes)) > 0)
+        printf("Sugestões: %s\n", sugestoes);
+    // Perguntar ao usuário se ele deseja adicionar a palavra ao dicionário
+    char opcao;
+    printf("Deseja adicionar '%s' ao dicionario? (s/n): ", palavra);
+    scanf(" %c", &opcao);
+    // Se o usuário responder afirmativamente
+    if (opcao == 's' || opcao == 'S')
+    {
+        // Adicionar a palavra ao dicionário (e ao diário, para que continue lá no próximo arranque)
+        if (!inserirPalavraDuravel(dicionario, palavra))
+            printf("A palavra '%s' não ficou guardada no diário de alterações.\n", palavra);
+        // Imprimir uma mensagem indicando que a palavra foi adicionada
+        printf("A palavra '%s' foi adicionada ao dicionário.\n", palavra);
+        // Escrever a palavra no ficheiro de saída
+        fprintf(fileOutput, "%s ", palavra);
+    }
+    else
+    {
+        // Se o usuário responder negativamente, imprimir uma mensagem indicando que a palavra foi marcada como errada
+        printf("A palavra '%s' foi marcada como errada.\n", palavra);
+        // Escrever a palavra no ficheiro de saída entre colchetes para indicar que está errada
+        fprintf(fileOutput, "[%s] ", palavra);
+    }
+}
+
+// Função para verificar a ortografia de um ficheiro de texto usando o dicionário
+void verificarOrtografia(Dicionario *dicionario, const char *ficheiroTexto)
+{
+    // Abrir o ficheiro para leitura
+    FILE *file = fopen(ficheiroTexto, "r");
+    // Se o ficheiro não puder ser aberto, imprimir uma mensagem de erro e retornar
+    if (file == NULL)
+    {
+        printf("Não foi possível abrir o ficheiro %s.\n", ficheiroTexto);
+        return;
+    }
+
+    // Criar um novo ficheiro para a saída
+    FILE *fileOutput = fopen("ficheiroTexto_atualizado.txt", "w");
+    // Se o ficheiro de saída não puder ser criado, imprimir uma mensagem de erro, fechar o ficheiro de entrada e retornar
+    if (fileOutput == NULL)
+    {
+        printf("Não foi possível criar o ficheiro de saída.\n");
+        fclose(file);
+        return;
+    }
+
+    // Criar um buffer para armazenar cada palavra
+    char palavra[MAX_TAMANHO_PALAVRA];
+    // Ler palavras do ficheiro uma de cada vez
+    while (fscanf(file, "%s", palavra) == 1)
+    {
+        // Se a palavra não estiver no dicionário
+        if (!contemPalavra(dicionario, palavra))
+        {
+            tratarPalavraNaoEncontrada(dicionario, fileOutput, palavra);
+        }
+        else
+        {
+            // Se a palavra estiver no dicionário, escrevê-la no ficheiro de saída
+            fprintf(fileOutput, "%s ", palavra);
+        }
+    }
+
+    // Fechar os ficheiros
+    fclose(file);
+    fclose(fileOutput);
+    // Imprimir uma mensagem indicando que a verificação de ortografia foi concluída e o nome do ficheiro de saída
+    printf("Verificação de ortografia concluída. O ficheiro atualizado foi salvo como 'ficheiroTexto_atualizado.txt'.\n");
+}
+
+// *********************************** VERIFICAÇÃO ORTOGRÁFICA EM LOTE ***********************************
+
+// Devolve o instante atual em nanossegundos.
+static double agoraNanossegundos(void)
+{
+    struct timespec instante;
+    clock_gettime(CLOCK_MONOTONIC, &instante);
+    return (double)instante.tv_sec * 1e9 + (double)instante.tv_nsec;
+}
+
+
+// Struct auxiliar que acumula a saída em memória e a despeja no ficheiro (se houver) quando fica grande.
+typedef struct
+{
+    char *dados;
+    size_t tamanho, capacidade;
+    FILE *ficheiro;
+    bool falhou;
+} BufferSaida;
+
+// Struct auxiliar com a posição atual no texto e os contadores da verificação.
+typedef struct
+{
+    size_t linha, coluna; // Posição (a contar de 1) do próximo byte a processar.
+    size_t palavras, erradas;
+} EstadoVerificacao;
+
+// Acrescenta bytes ao buffer de saída (despejando-o no ficheiro quando passa do tamanho de um bloco).
+static void escreverSaida(BufferSaida *saida, const char *dados, size_t tamanho)
+{
+    if (saida == NULL || tamanho == 0 || saida->falhou)
+        return;
+
+    if (saida->tamanho + tamanho > saida->capacidade)
+    {
+        size_t capacidade = saida->capacidade ? saida->capacidade : 1 << 16;
+        while (capacidade < saida->tamanho + tamanho)
+            capacidade *= 2;
+        char *maior = (char *)realloc(saida->dados, capacidade);
+        if (maior == NULL)
+        {
+            saida->falhou = true;
+            return;
+        }
+        saida->dados = maior;
+        saida->capacidade = capacidade;
+    }
+
+    memcpy(saida->dados + saida->tamanho, dados, tamanho);
+    saida->tamanho += tamanho;
+
+    if (saida->ficheiro != NULL && saida->tamanho >= TAMANHO_BLOCO_VERIFICACAO)
+    {
+        if (fwrite(saida->dados, 1, saida->tamanho, saida->ficheiro) != saida->tamanho)
+            saida->falhou = true;
+        saida->tamanho = 0;
+    }
+}
+
+// Despeja o que resta no buffer no ficheiro.
+static void despejarSaida(BufferSaida *saida)
+{
+    if (saida->ficheiro != NULL && saida->tamanho > 0 && !saida->falhou)
+    {
+        if (fwrite(saida->dados, 1, saida->tamanho, saida->ficheiro) != saida->tamanho)
+            saida->falhou = true;
+    }
+    saida->tamanho = 0;
+}
+
+// Indica se um byte faz parte de uma palavra: letras e dígitos ASCII e todos os bytes de caracteres UTF-8 não ASCII.
+static bool ehByteDePalavra(unsigned char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c >= 0x80;
+}
+
+// Verifica se uma palavra (fatia do texto) está no dicionário. Uma palavra com maiúscula inicial (início de frase)
+// também é aceite se a versão com minúscula inicial existir. Com 'ignorarAcentos' e o índice dobrado ligado, basta
+// uma consulta ao índice, que já aceita a palavra exata e todas as que só diferem dela em maiúsculas e acentos.
+static bool palavraCorreta(const Dicionario *dicionario, const char *inicio, size_t comprimento, bool ignorarAcentos)
+{
+    char palavra[MAX_TAMANHO_PALAVRA];
+
+    if (comprimento >= MAX_TAMANHO_PALAVRA)
+        return false;
+    if (ignorarAcentos && dicionario->dobrado != NULL)
+        return contemPalavraDobrada(dicionario, inicio, comprimento);
+
+    memcpy(palavra, inicio, comprimento);
+    palavra[comprimento] = '\0';
+    if (contemPalavra(dicionario, palavra))
+        return true;
+
+    if (palavra[0] >= 'A' && palavra[0] <= 'Z')
+    {
+        palavra[0] = (char)(palavra[0] - 'A' + 'a');
+        return contemPalavra(dicionario, palavra);
+    }
+
+    return false;
+}
+
+// Verifica um bloco de texto, copiando-o para a saída e anotando as palavras erradas. Se o bloco não for o fim do texto,
+// a palavra que toca o fim do bloco pode continuar no bloco seguinte, portanto não é processada: a função devolve
+// quantos bytes consumiu e o resto deve ser repetido no início do próximo bloco. Com 'sugerir', cada linha do
+// relatório termina com as sugestões de correção da palavra (vindas da cache de sugestões).
+static size_t verificarBlocoOrtografia(const Dicionario *dicionario, const char *dados, size_t tamanho, bool fimDoTexto,
+                                       bool sugerir, bool ignorarAcentos, EstadoVerificacao *estado, BufferSaida *saida,
+                                       BufferSaida *relatorio)
+{
+    size_t i = 0;
+
+    while (i < tamanho)
+    {
+        // Copiar de uma só vez a sequência de bytes que não pertencem a palavras, contando as linhas.
+        size_t inicio = i;
+        while (i < tamanho && !ehByteDePalavra((unsigned char)dados[i]))
+        {
+            if (dados[i] == '\n')
+            {
+                estado->linha++;
+                estado->coluna = 1;
+            }
+            else
+            {
+                estado->coluna++;
+            }
+            i++;
+        }
+        escreverSaida(saida, dados + inicio, i - inicio);
+
+        if (i == tamanho)
+            break;
+
+        // Delimitar a palavra. Hífenes e apóstrofos entre letras fazem parte dela (ex.: "guarda-chuva").
+        inicio = i;
+        while (i < tamanho)
+        {
+            if (ehByteDePalavra((unsigned char)dados[i]))
+                i++;
+            else if ((dados[i] == '-' || dados[i] == '\'') && i + 1 < tamanho && ehByteDePalavra((unsigned char)dados[i + 1]))
+                i++;
+            else
+                break;
+        }
+
+        // A palavra pode continuar no próximo bloco (inclusive depois de um hífen no último byte): deixá-la para depois.
+        if (!fimDoTexto && (i == tamanho || (i + 1 == tamanho && (dados[i] == '-' || dados[i] == '\''))))
+            return inicio;
+
+        size_t comprimento = i - inicio;
+        estado->palavras++;
+
+        if (palavraCorreta(dicionario, dados + inicio, comprimento, ignorarAcentos))
+        {
+            escreverSaida(saida, dados + inicio, comprimento);
+        }
+        else
+        {
+            estado->erradas++;
+            escreverSaida(saida, "[", 1);
+            escreverSaida(saida, dados + inicio, comprimento);
+            escreverSaida(saida, "]", 1);
+
+            if (relatorio != NULL)
+            {
+                char posicao[48];
+                int tamanhoPosicao = snprintf(posicao, sizeof(posicao), "%zu:%zu\t", estado->linha, estado->coluna);
+                escreverSaida(relatorio, posicao, (size_t)tamanhoPosicao);
+                escreverSaida(relatorio, dados + inicio, comprimento);
+
+                // A palavra errada cabe no buffer: palavraCorreta rejeita as que têm MAX_TAMANHO_PALAVRA ou mais.
+                if (sugerir && comprimento < MAX_TAMANHO_PALAVRA)
+                {
+                    char palavra[MAX_TAMANHO_PALAVRA], sugestoes[TAMANHO_SUGESTOES];
+
+                    memcpy(palavra, dados + inicio, comprimento);
+                    palavra[comprimento] = '\0';
+                    sugerirCorrecoes(dicionario, palavra, sugestoes, sizeof(sugestoes));
+                    escreverSaida(relatorio, "\t", 1);
+                    escreverSaida(relatorio, sugestoes, strlen(sugestoes));
+                }
+                escreverSaida(relatorio, "\n", 1);
+            }
+        }
+
+        estado->coluna += comprimento;
+    }
+
+    return tamanho;
+}
+
+// Abre o ficheiro de uma saída opcional.
+static bool abrirSaida(BufferSaida *saida, const char *nomeFicheiro)
+{
+    memset(saida, 0, sizeof(*saida));
+    if (nomeFicheiro == NULL)
+        return true;
+
+    saida->ficheiro = fopen(nomeFicheiro, "wb");
+    if (saida->ficheiro == NULL)
+    {
+        printf("Não foi possível criar o ficheiro %s.\n", nomeFicheiro);
+        return false;
+    }
+    return true;
+}
+
+// Despeja e fecha uma saída opcional. Devolve falso se alguma escrita falhou.
+static bool fecharSaida(BufferSaida *saida)
+{
+    bool sucesso = true;
+
+    if (saida->ficheiro != NULL)
+    {
+        despejarSaida(saida);
+        sucesso = fclose(saida->ficheiro) == 0;
+    }
+
+    free(saida->dados);
+    return sucesso && !saida->falhou;
+}
+
+// Struct auxiliar com uma parte do texto verificada por uma das threads da verificação paralela.
+typedef struct
+{
+    size_t inicio, fim;               // Fatia [inicio, fim) do texto, cortada entre duas palavras.
+    size_t quebras, bytesUltimaLinha; // Quebras de linha da parte e bytes depois da última (ou da parte toda).
+    EstadoVerificacao estado;         // Posição no texto onde a parte começa e contadores da parte.
+    BufferSaida saida, relatorio;     // Saídas da parte em memória, escritas por ordem pela thread principal.
+    bool concluida;
+} ParteVerificacao;
+
+// Struct auxiliar partilhada pelas threads da verificação paralela.
+typedef struct
+{
+    const Dicionario *dicionario;
+    const char *texto;
+    ParteVerificacao *partes;
+    size_t totalPartes;
+    size_t proximaParte; // Próxima parte por distribuir (incrementada atomicamente pelas threads).
+    bool contarLinhas;   // Primeira fase (contar as quebras de linha) ou segunda (verificar a ortografia).
+    bool gerarSaida, gerarRelatorio, sugerir, ignorarAcentos;
+    pthread_mutex_t trinco;
+    pthread_cond_t parteConcluida;
+} TrabalhoVerificacao;
+
+// Corpo de cada thread: vai buscando a próxima parte por fazer até não haver mais. A Trie só é lida, portanto é
+// partilhada por todas as threads sem trincos; cada parte escreve apenas nas suas próprias saídas.
+static void *trabalharVerificacao(void *argumento)
+{
+    TrabalhoVerificacao *trabalho = (TrabalhoVerificacao *)argumento;
+
+    for (;;)
+    {
+        size_t indice = __atomic_fetch_add(&trabalho->proximaParte, 1, __ATOMIC_RELAXED);
+        if (indice >= trabalho->totalPartes)
+            break;
+
+        ParteVerificacao *parte = &trabalho->partes[indice];
+        const char *dados = trabalho->texto + parte->inicio;
+        size_t tamanho = parte->fim - parte->inicio;
+
+        if (trabalho->contarLinhas)
+        {
+            const char *ultima = NULL;
+            for (const char *p = dados; (p = memchr(p, '\n', (size_t)(dados + tamanho - p))) != NULL; p++)
+            {
+                parte->quebras++;
+                ultima = p;
+            }
+            parte->bytesUltimaLinha = ultima != NULL ? (size_t)(dados + tamanho - ultima - 1) : tamanho;
+            continue;
+        }
+
+        // As partes são cortadas entre palavras, portanto cada uma é verificada como se fosse o fim do texto.
+        verificarBlocoOrtografia(trabalho->dicionario, dados, tamanho, true, trabalho->sugerir,
+                                 trabalho->ignorarAcentos, &parte->estado, trabalho->gerarSaida ? &parte->saida : NULL,
+                                 trabalho->gerarRelatorio ? &parte->relatorio : NULL);
+
+        pthread_mutex_lock(&trabalho->trinco);
+        parte->concluida = true;
+        pthread_cond_signal(&trabalho->parteConcluida);
+        pthread_mutex_unlock(&trabalho->trinco);
+    }
+
+    return NULL;
+}
+
+// Executa uma fase do trabalho em várias threads. Se nenhuma puder ser criada, a thread atual faz o trabalho todo.
+static int lancarThreadsVerificacao(TrabalhoVerificacao *trabalho, pthread_t *threads, int totalThreads)
+{
+    int criadas = 0;
+
+    trabalho->proximaParte = 0;
+    while (criadas < totalThreads && pthread_create(&threads[criadas], NULL, trabalharVerificacao, trabalho) == 0)
+        criadas++;
+
+    if (criadas == 0)
+        trabalharVerificacao(trabalho);
+    return criadas;
+}
+
+// Escreve no ficheiro de uma saída o conteúdo acumulado em memória por uma parte e liberta-o.
+static void anexarSaida(BufferSaida *destino, BufferSaida *origem)
+{
+    if (destino->ficheiro != NULL && !destino->falhou && origem->tamanho > 0 &&
+        fwrite(origem->dados, 1, origem->tamanho, destino->ficheiro) != origem->tamanho)
+        destino->falhou = true;
+
+    destino->falhou = destino->falhou || origem->falhou;
+    free(origem->dados);
+    origem->dados = NULL;
+}
+
+// Verificação em paralelo: o texto é mapeado em memória e cortado entre palavras em partes do tamanho de um bloco,
+// que as threads vão buscando. Numa primeira fase (rápida, com memchr) conta-se as quebras de linha de cada parte,
+// para saber a linha e a coluna onde cada parte começa; na segunda verifica-se a ortografia. A thread principal
+// escreve as saídas de cada parte pela ordem original assim que ficam prontas.
+static bool verificarOrtografiaParalela(const Dicionario *dicionario, const char *ficheiroTexto,
+                                        const OpcoesVerificacao *opcoes, ResultadoVerificacao *resultado)
+{
+    FicheiroMapeado texto;
+    BufferSaida saida, relatorio;
+    size_t tamanhoParte = opcoes->tamanhoBloco ? opcoes->tamanhoBloco : TAMANHO_BLOCO_VERIFICACAO;
+    double inicio = agoraNanossegundos();
+
+    if (!mapearFicheiro(ficheiroTexto, &texto))
+    {
+        printf("Não foi possível abrir o ficheiro %s.\n", ficheiroTexto);
+        return false;
+    }
+
+    // Cada parte tem pelo menos tamanhoParte bytes (exceto a última), portanto este é o número máximo de partes.
+    ParteVerificacao *partes = (ParteVerificacao *)calloc(texto.tamanho / tamanhoParte + 1, sizeof(ParteVerificacao));
+    pthread_t *threads = (pthread_t *)malloc((size_t)opcoes->totalThreads * sizeof(pthread_t));
+    if (partes == NULL || threads == NULL || !abrirSaida(&saida, opcoes->ficheiroSaida))
+    {
+        free(partes);
+        free(threads);
+        desmapearFicheiro(&texto);
+        return false;
+    }
+    if (!abrirSaida(&relatorio, opcoes->ficheiroRelatorio))
+    {
+        fecharSaida(&saida);
+        free(partes);
+        free(threads);
+        desmapearFicheiro(&texto);
+        return false;
+    }
+
+    // Cortar o texto: o fim de cada parte avança até um byte que não pode pertencer a uma palavra (nem ligar duas).
+    const char *dados = (const char *)texto.dados;
+    size_t totalPartes = 0, inicioParte = 0;
+    while (inicioParte < texto.tamanho)
+    {
+        size_t fim = texto.tamanho - inicioParte > tamanhoParte ? inicioParte + tamanhoParte : texto.tamanho;
+        while (fim < texto.tamanho &&
+               (ehByteDePalavra((unsigned char)dados[fim]) || dados[fim] == '-' || dados[fim] == '\''))
+            fim++;
+
+        partes[totalPartes].inicio = inicioParte;
+        partes[totalPartes].fim = fim;
+        totalPartes++;
+        inicioParte = fim;
+    }
+
+    TrabalhoVerificacao trabalho = {dicionario, dados, partes, totalPartes, 0, true,
+                                    opcoes->ficheiroSaida != NULL, opcoes->ficheiroRelatorio != NULL, opcoes->sugerir,
+                                    opcoes->ignorarAcentos, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER};
+    int totalThreads = (size_t)opcoes->totalThreads < totalPartes ? opcoes->totalThreads : (int)totalPartes;
+
+    // Primeira fase: contar as quebras de linha de cada parte.
+    int criadas = lancarThreadsVerificacao(&trabalho, threads, totalThreads);
+    for (int t = 0; t < criadas; t++)
+        pthread_join(threads[t], NULL);
+
+    // Posição de início de cada parte (soma acumulada das anteriores).
+    EstadoVerificacao posicao = {1, 1, 0, 0};
+    for (size_t p = 0; p < totalPartes; p++)
+    {
+        partes[p].estado = posicao;
+        if (partes[p].quebras > 0)
+        {
+            posicao.linha += partes[p].quebras;
+            posicao.coluna = partes[p].bytesUltimaLinha + 1;
+        }
+        else
+        {
+            posicao.coluna += partes[p].bytesUltimaLinha;
+        }
+    }
+
+    // Segunda fase: verificar as partes e escrevê-las por ordem à medida que ficam prontas.
+    trabalho.contarLinhas = false;
+    criadas = lancarThreadsVerificacao(&trabalho, threads, totalThreads);
+
+    for (size_t p = 0; p < totalPartes; p++)
+    {
+        pthread_mutex_lock(&trabalho.trinco);
+        while (!partes[p].concluida)
+            pthread_cond_wait(&trabalho.parteConcluida, &trabalho.trinco);
+        pthread_mutex_unlock(&trabalho.trinco);
+
+        anexarSaida(&saida, &partes[p].saida);
+        anexarSaida(&relatorio, &partes[p].relatorio);
+        resultado->palavras += partes[p].estado.palavras;
+        resultado->erradas += partes[p].estado.erradas;
+    }
+
+    for (int t = 0; t < criadas; t++)
+        pthread_join(threads[t], NULL);
+    pthread_mutex_destroy(&trabalho.trinco);
+    pthread_cond_destroy(&trabalho.parteConcluida);
+
+    bool sucesso = fecharSaida(&saida);
+    sucesso = fecharSaida(&relatorio) && sucesso;
+
+    resultado->bytes = texto.tamanho;
+    resultado->linhas = posicao.linha;
+    resultado->segundos = (agoraNanossegundos() - inicio) / 1e9;
+
+    free(partes);
+    free(threads);
+    desmapearFicheiro(&texto);
+    return sucesso;
+}
+
+// Verifica a ortografia de um ficheiro sem interação. O texto é lido em blocos grandes com fread e copiado para a saída
+// tal como está (espaços, pontuação e quebras de linha), com as palavras erradas entre colchetes. Com mais de uma
+// thread nas opções, a verificação é feita em paralelo e produz exatamente a mesma saída.
+bool verificarOrtografiaEmLote(const Dicionario *dicionario, const char *ficheiroTexto, const OpcoesVerificacao *opcoes,
+                               ResultadoVerificacao *resultado)
+{
+    BufferSaida saida, relatorio;
+    EstadoVerificacao estado = {1, 1, 0, 0};
+    size_t tamanhoBloco = opcoes->tamanhoBloco ? opcoes->tamanhoBloco : TAMANHO_BLOCO_VERIFICACAO;
+    double inicio = agoraNanossegundos();
+
+    memset(resultado, 0, sizeof(*resultado));
+    if (opcoes->totalThreads > 1)
+        return verificarOrtografiaParalela(dicionario, ficheiroTexto, opcoes, resultado);
+
+    FILE *ficheiro = fopen(ficheiroTexto, "rb");
+    if (ficheiro == NULL)
+    {
+        printf("Não foi possível abrir o ficheiro %s.\n", ficheiroTexto);
+        return false;
+    }
+
+    // O buffer tem espaço para um bloco mais a palavra incompleta que ficou do bloco anterior; só cresce se aparecer
+    // uma "palavra" maior do que MAX_TAMANHO_PALAVRA, para que seja sempre anotada inteira.
+    size_t capacidade = tamanhoBloco + MAX_TAMANHO_PALAVRA;
+    char *buffer = (char *)malloc(capacidade);
+    if (buffer == NULL || !abrirSaida(&saida, opcoes->ficheiroSaida))
+    {
+        free(buffer);
+        fclose(ficheiro);
+        return false;
+    }
+    if (!abrirSaida(&relatorio, opcoes->ficheiroRelatorio))
+    {
+        fecharSaida(&saida);
+        free(buffer);
+        fclose(ficheiro);
+        return false;
+    }
+
+    size_t pendentes = 0;
+    bool fimDoTexto = false;
+
+    while (!fimDoTexto)
+    {
+        if (pendentes + tamanhoBloco > capacidade)
+        {
+            char *maior = (char *)realloc(buffer, pendentes + tamanhoBloco);
+            if (maior == NULL)
+            {
+                saida.falhou = true;
+                break;
+            }
+            buffer = maior;
+            capacidade = pendentes + tamanhoBloco;
+        }
+
+        size_t lidos = fread(buffer + pendentes, 1, tamanhoBloco, ficheiro);
+        resultado->bytes += lidos;
+        fimDoTexto = lidos < tamanhoBloco;
+
+        size_t disponiveis = pendentes + lidos;
+        size_t consumidos = verificarBlocoOrtografia(dicionario, buffer, disponiveis, fimDoTexto, opcoes->sugerir,
+                                                     opcoes->ignorarAcentos, &estado,
+                                                     opcoes->ficheiroSaida ? &saida : NULL,
+                                                     opcoes->ficheiroRelatorio ? &relatorio : NULL);
+
+        pendentes = disponiveis - consumidos;
+        memmove(buffer, buffer + consumidos, pendentes);
+    }
+
+    bool sucesso = !ferror(ficheiro);
+    fclose(ficheiro);
+    free(buffer);
+    sucesso = fecharSaida(&saida) && sucesso;
+    sucesso = fecharSaida(&relatorio) && sucesso;
+
+    resultado->palavras = estado.palavras;
+    resultado->erradas = estado.erradas;
+    resultado->linhas = estado.linha;
+    resultado->segundos = (agoraNanossegundos() - inicio) / 1e9;
+    return sucesso;
+}
+
+// *********************************** IMPRESSÃO DE TODAS AS PALAVRAS EM ORDEM ***********************************
+
+// Função para imprimir todas as palavras no dicionário em ordem
+void imprimirIndice(Dicionario *dicionario)
+{
+    CursorDicionario cursor;
+
+    abrirCursor(&cursor, dicionario, "");
+    while (avancarCursor(&cursor))
+        printf("%s\n", cursor.palavra);
+    fecharCursor(&cursor);
+    system("pause");
+}
+
+// *********************************** LAYOUT COMPACTO ***********************************
+
+// Conta os nós de uma Trie de ponteiros.
+static size_t contarNos(const NoTST *no)
+{
+    if (no == NULL)
+        return 0;
+
+    return 1 + contarNos(no->esquerda) + contarNos(no->centro) + contarNos(no->direito);
+}
+
+// Copia um nó e os seus descendentes para o vetor compacto e devolve o índice atribuído.
+// O nó é seguido imediatamente pelo seu filho central, que é o passo mais frequente numa consulta.
+static uint32_t copiarParaCompacta(TSTCompacta *compacta, const NoTST *no)
+{
+    if (no == NULL)
+        return 0;
+
+    uint32_t indice = compacta->totalNos++;
+    compacta->nos[indice].caractere = no->caractere;
+    compacta->nos[indice].flags = no->fim_palavra ? FLAG_FIM_PALAVRA : 0;
+    compacta->nos[indice].pesoMaximo = no->pesoMaximo;
+    if (compacta->pesos != NULL)
+        compacta->pesos[indice] = no->peso;
+    if (no->fim_palavra)
+        compacta->totalPalavras++;
+
+    // As chamadas recursivas não realocam o vetor, portanto o índice continua válido.
+    uint32_t centro = copiarParaCompacta(compacta, no->centro);
+    uint32_t esquerda = copiarParaCompacta(compacta, no->esquerda);
+    uint32_t direito = copiarParaCompacta(compacta, no->direito);
+
+    compacta->nos[indice].centro = centro;
+    compacta->nos[indice].esquerda = esquerda;
+    compacta->nos[indice].direito = direito;
+    return indice;
+}
+
+// Aloca uma representação compacta vazia com espaço para 'totalNos' posições (incluindo a posição 0).
+static TSTCompacta *alocarTSTCompacta(size_t totalNos, bool comPesos)
+{
+    if (totalNos > UINT32_MAX)
+    {
+        printf("[A Trie tem nós demais para o layout compacto].\n");
+        return NULL;
+    }
+
+    TSTCompacta *compacta = (TSTCompacta *)malloc(sizeof(TSTCompacta));
+    if (compacta == NULL)
+    {
+        printf("[Falha na alocação de memória para o layout compacto].\n");
+        return NULL;
+    }
+
+    compacta->nos = (NoCompacto *)malloc(totalNos * sizeof(NoCompacto));
+    compacta->pesos = comPesos ? (uint32_t *)malloc(totalNos * sizeof(uint32_t)) : NULL;
+    if (compacta->nos == NULL || (comPesos && compacta->pesos == NULL))
+    {
+        printf("[Falha na alocação de memória para o layout compacto].\n");
+        free(compacta->nos);
+        free(compacta->pesos);
+        free(compacta);
+        return NULL;
+    }
+
+    // A posição 0 fica preenchida com zeros e nunca é visitada.
+    memset(&compacta->nos[0], 0, sizeof(NoCompacto));
+    if (compacta->pesos != NULL)
+        compacta->pesos[0] = 0;
+    memset(compacta->tabelaRaiz, 0, sizeof(compacta->tabelaRaiz));
+    compacta->totalNos = 1;
+    compacta->raiz = 0;
+    compacta->totalPalavras = 0;
+    compacta->minimizada = false;
+    compacta->instantaneo.dados = NULL;
+    compacta->instantaneo.tamanho = 0;
+    return compacta;
+}
+
+// Constrói a representação compacta de uma Trie de ponteiros.
+TSTCompacta *construirTSTCompacta(const NoTST *raiz)
+{
+    // Os pesos só ocupam memória se alguma palavra tiver peso (o limite da raiz cobre a Trie inteira).
+    TSTCompacta *compacta = alocarTSTCompacta(contarNos(raiz) + 1, raiz != NULL && raiz->pesoMaximo != 0);
+    if (compacta == NULL)
+        return NULL;
+
+    compacta->raiz = copiarParaCompacta(compacta, raiz);
+    preencherTabelaRaizCompacta(compacta, compacta->raiz);
+    return compacta;
+}
+
+// Liberta a representação compacta.
+void destruirTSTCompacta(TSTCompacta *compacta)
+{
+    if (compacta == NULL)
+        return;
+
+    // Os nós e os pesos de um instantâneo pertencem ao mapeamento; os restantes foram alocados.
+    if (compacta->instantaneo.dados != NULL)
+        desmapearFicheiro(&compacta->instantaneo);
+    else
+    {
+        free(compacta->nos);
+        free(compacta->pesos);
+    }
+    free(compacta);
+}
+
+// Converte o dicionário para o layout compacto, libertando os nós da Trie de ponteiros.
+bool congelarDicionario(Dicionario *dicionario)
+{
+    if (dicionario->compacta != NULL)
+        return true;
+
+    // O layout compacto não pode ser alterado por cópia do caminho.
+    if (dicionario->concorrencia != NULL)
+    {
+        printf("Desligue o modo concorrente antes de congelar o dicionário.\n");
+        return false;
+    }
+
+    TSTCompacta *compacta = construirTSTCompacta(dicionario->raiz);
+    if (compacta == NULL)
+        return false;
+
+    destruirArena(&dicionario->arena);
+    dicionario->raiz = NULL;
+    reconstruirTabelaRaiz(dicionario);
+    dicionario->compacta = compacta;
+    return true;
+}
+
+// Copia um nó compacto e os seus descendentes para a Trie de ponteiros.
+static NoTST *copiarDeCompacta(ArenaNos *arena, const TSTCompacta *compacta, uint32_t indice, bool *falhou)
+{
+    if (indice == 0 || *falhou)
+        return NULL;
+
+    const NoCompacto *origem = &compacta->nos[indice];
+    NoTST *no = inicializarNo(arena, origem->caractere);
+    if (no == NULL)
+    {
+        *falhou = true;
+        return NULL;
+    }
+
+    no->fim_palavra = (origem->flags & FLAG_FIM_PALAVRA) != 0;
+    no->peso = compacta->pesos != NULL ? compacta->pesos[indice] : 0;
+    no->pesoMaximo = origem->pesoMaximo;
+    no->esquerda = copiarDeCompacta(arena, compacta, origem->esquerda, falhou);
+    no->centro = copiarDeCompacta(arena, compacta, origem->centro, falhou);
+    no->direito = copiarDeCompacta(arena, compacta, origem->direito, falhou);
+    return no;
+}
+
+// Reconstrói a Trie de ponteiros a partir do layout compacto, para permitir alterações.
+bool descongelarDicionario(Dicionario *dicionario)
+{
+    if (dicionario->compacta == NULL)
+        return true;
+
+    bool falhou = false;
+    NoTST *raiz = copiarDeCompacta(&dicionario->arena, dicionario->compacta, dicionario->compacta->raiz, &falhou);
+    if (falhou)
+    {
+        printf("[Falha na alocação de memória ao descongelar o dicionário].\n");
+        destruirArena(&dicionario->arena);
+        return false;
+    }
+
+    destruirTSTCompacta(dicionario->compacta);
+    dicionario->compacta = NULL;
+    dicionario->raiz = raiz;
+    reconstruirTabelaRaiz(dicionario);
+    return true;
+}
+
+// Struct auxiliar da minimização: a tabela dos nós já guardados (endereçamento aberto; 0 marca uma posição livre) e
+// uma pilha com os nós dos níveis em construção, cada nível pela ordem dos caracteres.
+typedef struct
+{
+    TSTCompacta *grafo;  // Nós minimizados, pela ordem em que foram criados (os filhos antes dos pais).
+    uint32_t *tabela;
+    size_t mascara;
+    const NoTST **nivel; // Nós dos níveis em construção.
+    uint32_t *centros;   // Índice minimizado do filho central de cada nó de 'nivel'.
+    size_t usados;
+} MinimizacaoTST;
+
+// Struct auxiliar com o que distingue dois nós minimizados (o limite do peso deriva destes campos).
+typedef struct
+{
+    uint32_t esquerda, centro, direito;
+    uint32_t peso;
+    char caractere;
+    uint8_t flags;
+} ChaveNoMinimizado;
+
+// Devolve o nó do grafo igual ao pedido, criando-o se ainda não existir.
+static uint32_t guardarNoMinimizado(MinimizacaoTST *minimizacao, const NoTST *no, uint32_t esquerda, uint32_t centro,
+                                    uint32_t direito)
+{
+    TSTCompacta *grafo = minimizacao->grafo;
+    ChaveNoMinimizado chave;
+
+    // Os campos são preenchidos um a um sobre zeros, para que o enchimento não entre no hash.
+    memset(&chave, 0, sizeof(chave));
+    chave.esquerda = esquerda;
+    chave.centro = centro;
+    chave.direito = direito;
+    chave.peso = no->fim_palavra && grafo->pesos != NULL ? no->peso : 0;
+    chave.caractere = no->caractere;
+    chave.flags = no->fim_palavra ? FLAG_FIM_PALAVRA : 0;
+
+    size_t posicao = (size_t)hashXXH64(&chave, sizeof(chave), 0) & minimizacao->mascara;
+    for (; minimizacao->tabela[posicao] != 0; posicao = (posicao + 1) & minimizacao->mascara)
+    {
+        uint32_t indice = minimizacao->tabela[posicao];
+        const NoCompacto *existente = &grafo->nos[indice];
+        if (existente->caractere == chave.caractere && existente->flags == chave.flags &&
+            existente->esquerda == esquerda && existente->centro == centro && existente->direito == direito &&
+            (grafo->pesos == NULL || grafo->pesos[indice] == chave.peso))
+            return indice;
+    }
+
+    // Os filhos já existem no grafo, portanto o limite do peso calcula-se como em atualizarPesoMaximo.
+    uint16_t maximo = chave.flags != 0 ? limitePeso(chave.peso) : 0;
+    if (grafo->nos[esquerda].pesoMaximo > maximo)
+        maximo = grafo->nos[esquerda].pesoMaximo;
+    if (grafo->nos[centro].pesoMaximo > maximo)
+        maximo = grafo->nos[centro].pesoMaximo;
+    if (grafo->nos[direito].pesoMaximo > maximo)
+        maximo = grafo->nos[direito].pesoMaximo;
+
+    uint32_t indice = grafo->totalNos++;
+    NoCompacto *novo = &grafo->nos[indice];
+    novo->esquerda = esquerda;
+    novo->centro = centro;
+    novo->direito = direito;
+    novo->caractere = chave.caractere;
+    novo->flags = chave.flags;
+    novo->pesoMaximo = maximo;
+    if (grafo->pesos != NULL)
+        grafo->pesos[indice] = chave.peso;
+    minimizacao->tabela[posicao] = indice;
+    return indice;
+}
+
+// Empilha os nós de um nível (a árvore binária dos irmãos) pela ordem dos caracteres.
+static void recolherNivel(MinimizacaoTST *minimizacao, const NoTST *no)
+{
+    if (no == NULL)
+        return;
+
+    recolherNivel(minimizacao, no->esquerda);
+    minimizacao->nivel[minimizacao->usados++] = no;
+    if (no->fim_palavra)
+        minimizacao->grafo->totalPalavras++;
+    recolherNivel(minimizacao, no->direito);
+}
+
+// Refaz os nós [inicio, fim) de um nível como uma árvore binária equilibrada e devolve a raiz no grafo.
+static uint32_t montarNivel(MinimizacaoTST *minimizacao, size_t inicio, size_t fim)
+{
+    if (inicio == fim)
+        return 0;
+
+    size_t meio = inicio + (fim - inicio) / 2;
+    uint32_t esquerda = montarNivel(minimizacao, inicio, meio);
+    uint32_t direito = montarNivel(minimizacao, meio + 1, fim);
+    return guardarNoMinimizado(minimizacao, minimizacao->nivel[meio], esquerda, minimizacao->centros[meio], direito);
+}
+
+// Minimiza o nível que começa em 'no' e os níveis abaixo dele. Os centros são minimizados antes do próprio nível,
+// para que dois nós só sejam iguais quando os sufixos que levam também o são.
+static uint32_t minimizarNivel(MinimizacaoTST *minimizacao, const NoTST *no)
+{
+    if (no == NULL)
+        return 0;
+
+    size_t inicio = minimizacao->usados;
+    recolherNivel(minimizacao, no);
+    size_t fim = minimizacao->usados;
+
+    // Os níveis de baixo usam a pilha depois de 'fim' e devolvem-na vazia. Um nó sem palavras por baixo e que não
+    // termina uma palavra fica de fora: ao refazer o nível passaria a ser uma folha morta.
+    size_t vivos = inicio;
+    for (size_t i = inicio; i < fim; i++)
+    {
+        uint32_t centro = minimizarNivel(minimizacao, minimizacao->nivel[i]->centro);
+        if (centro == 0 && !minimizacao->nivel[i]->fim_palavra)
+            continue;
+        minimizacao->nivel[vivos] = minimizacao->nivel[i];
+        minimizacao->centros[vivos++] = centro;
+    }
+    fim = vivos;
+
+    uint32_t raiz = montarNivel(minimizacao, inicio, fim);
+    minimizacao->usados = inicio;
+    return raiz;
+}
+
+// Copia o grafo para o vetor final em pré-ordem (centro primeiro, como copiarParaCompacta), visitando cada nó
+// partilhado uma só vez; 'novos' guarda o índice já atribuído a cada nó do grafo (0 se ainda não foi copiado).
+static uint32_t ordenarMinimizada(const TSTCompacta *grafo, uint32_t indice, TSTCompacta *compacta, uint32_t *novos)
+{
+    if (indice == 0 || novos[indice] != 0)
+        return novos[indice];
+
+    uint32_t novo = compacta->totalNos++;
+    novos[indice] = novo;
+    compacta->nos[novo] = grafo->nos[indice];
+    if (compacta->pesos != NULL)
+        compacta->pesos[novo] = grafo->pesos[indice];
+
+    // As chamadas recursivas não realocam o vetor, portanto o índice continua válido.
+    uint32_t centro = ordenarMinimizada(grafo, grafo->nos[indice].centro, compacta, novos);
+    uint32_t esquerda = ordenarMinimizada(grafo, grafo->nos[indice].esquerda, compacta, novos);
+    uint32_t direito = ordenarMinimizada(grafo, grafo->nos[indice].direito, compacta, novos);
+
+    compacta->nos[novo].centro = centro;
+    compacta->nos[novo].esquerda = esquerda;
+    compacta->nos[novo].direito = direito;
+    return novo;
+}
+
+// Constrói o layout compacto minimizado de uma Trie de ponteiros.
+TSTCompacta *construirTSTMinimizada(const NoTST *raiz)
+{
+    // O grafo nunca tem mais nós do que a Trie: cada nível é refeito com os mesmos nós.
+    size_t totalNos = contarNos(raiz) + 1;
+    bool comPesos = raiz != NULL && raiz->pesoMaximo != 0;
+    TSTCompacta *grafo = alocarTSTCompacta(totalNos, comPesos);
+    if (grafo == NULL)
+        return NULL;
+
+    size_t capacidade = 16;
+    while (capacidade < 2 * totalNos)
+        capacidade *= 2;
+
+    MinimizacaoTST minimizacao;
+    minimizacao.grafo = grafo;
+    minimizacao.tabela = (uint32_t *)calloc(capacidade, sizeof(uint32_t));
+    minimizacao.mascara = capacidade - 1;
+    minimizacao.nivel = (const NoTST **)malloc(totalNos * sizeof(const NoTST *));
+    minimizacao.centros = (uint32_t *)malloc(totalNos * sizeof(uint32_t));
+    minimizacao.usados = 0;
+    if (minimizacao.tabela == NULL || minimizacao.nivel == NULL || minimizacao.centros == NULL)
+    {
+        printf("[Falha na alocação de memória para o layout minimizado].\n");
+        free(minimizacao.tabela);
+        free(minimizacao.nivel);
+        free(minimizacao.centros);
+        destruirTSTCompacta(grafo);
+        return NULL;
+    }
+
+    grafo->raiz = minimizarNivel(&minimizacao, raiz);
+    free(minimizacao.tabela);
+    free(minimizacao.nivel);
+    free(minimizacao.centros);
+
+    // O grafo foi criado das folhas para a raiz; o vetor final fica com o tamanho exato e na ordem das consultas.
+    TSTCompacta *compacta = alocarTSTCompacta(grafo->totalNos, comPesos);
+    uint32_t *novos = compacta != NULL ? (uint32_t *)calloc(grafo->totalNos, sizeof(uint32_t)) : NULL;
+    if (novos == NULL)
+    {
+        if (compacta != NULL)
+            printf("[Falha na alocação de memória para o layout minimizado].\n");
+        destruirTSTCompacta(compacta);
+        destruirTSTCompacta(grafo);
+        return NULL;
+    }
+
+    compacta->raiz = ordenarMinimizada(grafo, grafo->raiz, compacta, novos);
+    preencherTabelaRaizCompacta(compacta, compacta->raiz);
+    compacta->totalPalavras = grafo->totalPalavras;
+    compacta->minimizada = true;
+    free(novos);
+    destruirTSTCompacta(grafo);
+    return compacta;
+}
+
+// Converte o dicionário para o layout compacto minimizado, libertando os nós da Trie de ponteiros.
+bool congelarDicionarioMinimizado(Dicionario *dicionario)
+{
+    if (dicionario->compacta != NULL && dicionario->compacta->minimizada)
+        return true;
+
+    if (dicionario->concorrencia != NULL)
+    {
+        printf("Desligue o modo concorrente antes de congelar o dicionário.\n");
+        return false;
+    }
+
+    // A minimização parte da Trie de ponteiros (um dicionário congelado no layout compacto é descongelado antes).
+    if (!descongelarDicionario(dicionario))
+        return false;
+
+    TSTCompacta *compacta = construirTSTMinimizada(dicionario->raiz);
+    if (compacta == NULL)
+        return false;
+
+    destruirArena(&dicionario->arena);
+    dicionario->raiz = NULL;
+    reconstruirTabelaRaiz(dicionario);
+    dicionario->compacta = compacta;
+    return true;
+}
+
+// Consulta se uma palavra existe na representação compacta.
+bool consultarPalavraCompacta(const TSTCompacta *compacta, const char *palavra)
+{
+    const NoCompacto *nos = compacta->nos;
+    uint32_t indice = compacta->tabelaRaiz[(unsigned char)palavra[0]]; // O percurso começa no nó do primeiro caractere.
+    const char *inicio = palavra;
+    uint64_t visitados = 0, laterais = 0;
+    bool encontrada = false;
+
+    if (*palavra == '\0')
+        return false;
+
+    while (indice != 0)
+    {
+        visitados++;
+        if (*palavra < nos[indice].caractere)
+        {
+            indice = nos[indice].esquerda;
+            laterais++;
+        }
+        else if (*palavra > nos[indice].caractere)
+        {
+            indice = nos[indice].direito;
+            laterais++;
+        }
+        else if (*++palavra == '\0')
+        {
+            encontrada = (nos[indice].flags & FLAG_FIM_PALAVRA) != 0;
+            break;
+        }
+        else
+            indice = nos[indice].centro;
+    }
+
+    uint64_t profundidade = (uint64_t)(palavra - inicio);
+    registarPercurso(visitados, laterais, visitados - laterais - (indice != 0), profundidade);
+    RASTREAR("consulta compacta '%s': %llu nós (%llu laterais), %llu caracteres reconhecidos -> %s\n", inicio,
+             (unsigned long long)visitados, (unsigned long long)laterais, (unsigned long long)profundidade,
+             encontrada ? "encontrada" : "ausente");
+    return encontrada;
+}
+
+// Struct auxiliar com as palavras recolhidas para o relatório (um único bloco de texto com as palavras separadas por '\0').
+typedef struct
+{
+    char *texto;
+    size_t tamanho, capacidade;
+    size_t totalPalavras;
+} PalavrasRecolhidas;
+
+// Recolhe todas as palavras da Trie de ponteiros, em ordem.
+static void recolherPalavras(const NoTST *no, char *buffer, int profundidade, PalavrasRecolhidas *recolha)
+{
+    if (no == NULL)
+        return;
+
+    recolherPalavras(no->esquerda, buffer, profundidade, recolha);
+
+    buffer[profundidade] = no->caractere;
+    if (no->fim_palavra)
+    {
+        size_t comprimento = (size_t)profundidade + 1;
+        if (recolha->tamanho + comprimento + 1 > recolha->capacidade)
+        {
+            size_t capacidade = recolha->capacidade ? recolha->capacidade * 2 : 1 << 16;
+            char *texto = (char *)realloc(recolha->texto, capacidade);
+            if (texto == NULL)
+                return;
+            recolha->texto = texto;
+            recolha->capacidade = capacidade;
+        }
+        memcpy(recolha->texto + recolha->tamanho, buffer, comprimento);
+        recolha->texto[recolha->tamanho + comprimento] = '\0';
+        recolha->tamanho += comprimento + 1;
+        recolha->totalPalavras++;
+    }
+
+    recolherPalavras(no->centro, buffer, profundidade + 1, recolha);
+    recolherPalavras(no->direito, buffer, profundidade, recolha);
+}
+
+// Mede o tempo total (em nanossegundos) de consultar no layout compacto dado todas as palavras recolhidas.
+static double medirConsultasCompacta(const TSTCompacta *compacta, const PalavrasRecolhidas *recolha, size_t *encontradas)
+{
+    double inicio = agoraNanossegundos();
+    for (size_t posicao = 0; posicao < recolha->tamanho; posicao += strlen(recolha->texto + posicao) + 1)
+        *encontradas += consultarPalavraCompacta(compacta, recolha->texto + posicao);
+    return agoraNanossegundos() - inicio;
+}
+
+// Memória ocupada pelos nós (e pesos) de um layout compacto.
+static size_t bytesTSTCompacta(const TSTCompacta *compacta)
+{
+    return (size_t)compacta->totalNos * (sizeof(NoCompacto) + (compacta->pesos != NULL ? sizeof(uint32_t) : 0));
+}
+
+// Volta a congelar o dicionário no layout em que estava antes do relatório.
+static void restaurarLayout(Dicionario *dicionario, bool congelado, bool minimizado)
+{
+    if (minimizado)
+        congelarDicionarioMinimizado(dicionario);
+    else if (congelado)
+        congelarDicionario(dicionario);
+}
+
+// Imprime a memória por palavra e o tempo de consulta (ns/op) dos layouts de ponteiros, compacto e minimizado.
+void relatorioLayouts(Dicionario *dicionario)
+{
+    // O relatório compara os três layouts, portanto precisa da Trie de ponteiros.
+    bool estavaCongelado = dicionario->compacta != NULL;
+    bool estavaMinimizado = estavaCongelado && dicionario->compacta->minimizada;
+    if (estavaCongelado && !descongelarDicionario(dicionario))
+        return;
+
+    char buffer[MAX_TAMANHO_PALAVRA];
+    PalavrasRecolhidas recolha = {NULL, 0, 0, 0};
+    recolherPalavras(dicionario->raiz, buffer, 0, &recolha);
+
+    TSTCompacta *compacta = construirTSTCompacta(dicionario->raiz);
+    TSTCompacta *minimizada = compacta != NULL ? construirTSTMinimizada(dicionario->raiz) : NULL;
+    if (minimizada == NULL || recolha.totalPalavras == 0)
+    {
+        printf("Dicionario vazio ou invalido.\n");
+        destruirTSTCompacta(compacta);
+        destruirTSTCompacta(minimizada);
+        free(recolha.texto);
+        restaurarLayout(dicionario, estavaCongelado, estavaMinimizado);
+        return;
+    }
+
+    // Medir as consultas de todas as palavras em cada layout.
+    size_t encontradasPonteiros = 0, encontradasCompacta = 0, encontradasMinimizada = 0;
+    double inicio = agoraNanossegundos();
+    for (size_t posicao = 0; posicao < recolha.tamanho; posicao += strlen(recolha.texto + posicao) + 1)
+        encontradasPonteiros += consultarPalavraIterativo(dicionario->raiz, recolha.texto + posicao);
+    double tempoPonteiros = agoraNanossegundos() - inicio;
+
+    double tempoCompacta = medirConsultasCompacta(compacta, &recolha, &encontradasCompacta);
+    double tempoMinimizada = medirConsultasCompacta(minimizada, &recolha, &encontradasMinimizada);
+
+    double palavras = (double)recolha.totalPalavras;
+    size_t bytesPonteiros = dicionario->arena.totalBlocos * sizeof(BlocoArena);
+
+    printf("Palavras: %zu\n", recolha.totalPalavras);
+    printf("%-10s %12s %12s %14s %12s %12s\n", "Layout", "Nós", "Bytes/nó", "Bytes/palavra", "ns/consulta", "Encontradas");
+    printf("%-10s %12zu %12zu %14.1f %12.1f %12zu\n", "Ponteiros", dicionario->arena.nosEmUso, sizeof(NoTST),
+           bytesPonteiros / palavras, tempoPonteiros / palavras, encontradasPonteiros);
+    printf("%-10s %12u %12zu %14.1f %12.1f %12zu\n", "Compacto", compacta->totalNos - 1, sizeof(NoCompacto),
+           bytesTSTCompacta(compacta) / palavras, tempoCompacta / palavras, encontradasCompacta);
+    printf("%-10s %12u %12zu %14.1f %12.1f %12zu\n", "Minimizado", minimizada->totalNos - 1, sizeof(NoCompacto),
+           bytesTSTCompacta(minimizada) / palavras, tempoMinimizada / palavras, encontradasMinimizada);
+
+    destruirTSTCompacta(compacta);
+    destruirTSTCompacta(minimizada);
+    free(recolha.texto);
+    restaurarLayout(dicionario, estavaCongelado, estavaMinimizado);
+}
+
+// *********************************** INSTANTÂNEO BINÁRIO ***********************************
+
+// Preenche o tamanho e o instante de modificação de um ficheiro (usados para saber se a origem mudou).
+static bool identificarOrigem(const char *nomeOrigem, uint64_t *tamanho, int64_t *modificacao)
+{
+    struct stat informacao;
+
+    if (stat(nomeOrigem, &informacao) != 0)
+        return false;
+
+    *tamanho = (uint64_t)informacao.st_size;
+    *modificacao = (int64_t)informacao.st_mtim.tv_sec * 1000000000 + informacao.st_mtim.tv_nsec;
+    return true;
+}
+
+// Hash dos nós e dos pesos de um instantâneo (os pesos continuam o hash dos nós, como se estivessem seguidos).
+static uint64_t hashNosInstantaneo(const NoCompacto *nos, const uint32_t *pesos, uint32_t totalNos)
+{
+    uint64_t hash = hashXXH64(nos, (size_t)totalNos * sizeof(NoCompacto), 0);
+    if (pesos != NULL)
+        hash = hashXXH64(pesos, (size_t)totalNos * sizeof(uint32_t), hash);
+    return hash;
+}
+
+// Confirma que os nós de um instantâneo podem ser percorridos: todos os índices dentro do vetor, nenhum ciclo e
+// nenhuma palavra com MAX_TAMANHO_PALAVRA ou mais caracteres (os percursos montam as palavras em buffers desse
+// tamanho). O percurso em profundidade visita cada nó uma vez, mesmo os partilhados do layout minimizado; 'estados'
+// guarda 0 (por visitar), 1 (no caminho atual) ou 2 mais o comprimento da palavra mais longa a partir do nó.
+static bool validarNosInstantaneo(const NoCompacto *nos, uint32_t totalNos, uint32_t raiz)
+{
+    for (uint32_t i = 0; i < totalNos; i++)
+    {
+        if (nos[i].esquerda >= totalNos || nos[i].centro >= totalNos || nos[i].direito >= totalNos)
+            return false;
+    }
+    if (raiz == 0)
+        return true;
+
+    uint8_t *estados = (uint8_t *)calloc(totalNos, sizeof(uint8_t));
+    uint32_t *pilha = (uint32_t *)malloc((3 * (size_t)totalNos + 1) * sizeof(uint32_t));
+    bool valido = estados != NULL && pilha != NULL;
+    size_t topo = 0;
+
+    if (valido)
+        pilha[topo++] = raiz;
+    while (valido && topo > 0)
+    {
+        uint32_t indice = pilha[topo - 1];
+        const NoCompacto *no = &nos[indice];
+        uint32_t filhos[3] = {no->esquerda, no->centro, no->direito};
+
+        // Primeira visita: empilhar os filhos por visitar. Um filho que ainda está no caminho fecha um ciclo.
+        if (estados[indice] == 0)
+        {
+            estados[indice] = 1;
+            for (int i = 0; i < 3 && valido; i++)
+            {
+                if (filhos[i] != 0 && estados[filhos[i]] == 0)
+                    pilha[topo++] = filhos[i];
+                else if (filhos[i] != 0 && estados[filhos[i]] == 1)
+                    valido = false;
+            }
+            continue;
+        }
+
+        // Segunda visita: os filhos estão todos medidos (o centro acrescenta o caractere deste nó).
+        topo--;
+        if (estados[indice] == 1)
+        {
+            int maisLonga = 1 + (no->centro != 0 ? estados[no->centro] - 2 : 0);
+            if (no->esquerda != 0 && estados[no->esquerda] - 2 > maisLonga)
+                maisLonga = estados[no->esquerda] - 2;
+            if (no->direito != 0 && estados[no->direito] - 2 > maisLonga)
+                maisLonga = estados[no->direito] - 2;
+            valido = maisLonga < MAX_TAMANHO_PALAVRA;
+            estados[indice] = (uint8_t)(2 + maisLonga);
+        }
+    }
+
+    free(estados);
+    free(pilha);
+    return valido;
+}
+
+// Escreve um instantâneo com os nós dados, o manifesto e o hash da origem e a identificação da origem (tamanho e
+// instante de modificação). O ficheiro é escrito com outro nome, sincronizado e depois renomeado, para que um
+// processo que esteja a mapear o instantâneo antigo nunca veja um ficheiro incompleto.
+static bool escreverInstantaneo(const TSTCompacta *compacta, const ManifestoFicheiro *manifesto, const char *hash,
+                                const char *nomeInstantaneo, uint64_t tamanhoOrigem, int64_t modificacaoOrigem,
+                                uint64_t sequenciaDiario)
+{
+    CabecalhoInstantaneo cabecalho;
+    char nomeTemporario[FILENAME_MAX];
+
+    memset(&cabecalho, 0, sizeof(cabecalho));
+    memcpy(cabecalho.assinatura, ASSINATURA_INSTANTANEO, sizeof(ASSINATURA_INSTANTANEO));
+    cabecalho.versao = VERSAO_INSTANTANEO;
+    cabecalho.tamanhoNo = sizeof(NoCompacto);
+    cabecalho.totalNos = compacta->totalNos;
+    cabecalho.raiz = compacta->raiz;
+    cabecalho.totalPesos = compacta->pesos != NULL ? compacta->totalNos : 0;
+    cabecalho.totalPalavras = compacta->totalPalavras;
+    cabecalho.minimizado = compacta->minimizada ? 1 : 0;
+    cabecalho.tamanhoOrigem = tamanhoOrigem;
+    cabecalho.modificacaoOrigem = modificacaoOrigem;
+    cabecalho.sequenciaDiario = sequenciaDiario;
+    cabecalho.hashNos = hashNosInstantaneo(compacta->nos, compacta->pesos, compacta->totalNos);
+    if (hash != NULL)
+        snprintf(cabecalho.hashFicheiro, sizeof(cabecalho.hashFicheiro), "%s", hash);
+
+    // O manifesto da origem vai no fim, para que a verificação da integridade continue a indicar os blocos alterados
+    // depois de o dicionário ser carregado do instantâneo.
+    if (manifesto != NULL)
+    {
+        cabecalho.tamanhoBlocoManifesto = manifesto->tamanhoBloco;
+        cabecalho.totalBlocosManifesto = manifesto->totalBlocos;
+        cabecalho.tamanhoManifesto = manifesto->tamanhoFicheiro;
+    }
+
+    snprintf(nomeTemporario, sizeof(nomeTemporario), "%s.tmp", nomeInstantaneo);
+    FILE *ficheiro = fopen(nomeTemporario, "wb");
+    bool sucesso = ficheiro != NULL &&
+                   fwrite(&cabecalho, sizeof(cabecalho), 1, ficheiro) == 1 &&
+                   fwrite(compacta->nos, sizeof(NoCompacto), compacta->totalNos, ficheiro) == compacta->totalNos &&
+                   (cabecalho.totalPesos == 0 ||
+                    fwrite(compacta->pesos, sizeof(uint32_t), cabecalho.totalPesos, ficheiro) == cabecalho.totalPesos) &&
+                   (manifesto == NULL ||
+                    fwrite(manifesto->hashes, sizeof(uint64_t), manifesto->totalBlocos, ficheiro) == manifesto->totalBlocos) &&
+                   fflush(ficheiro) == 0 && fdatasync(fileno(ficheiro)) == 0;
+
+    if (ficheiro != NULL && fclose(ficheiro) != 0)
+        sucesso = false;
+    if (sucesso)
+        sucesso = rename(nomeTemporario, nomeInstantaneo) == 0;
+    if (!sucesso)
+        remove(nomeTemporario);
+    return sucesso;
+}
+
+// Guarda o dicionário num instantâneo binário, com as entradas do diário que já foram aplicadas.
+bool guardarInstantaneo(Dicionario *dicionario, const char *nomeInstantaneo, const char *nomeOrigem)
+{
+    uint64_t tamanhoOrigem = 0;
+    int64_t modificacaoOrigem = 0;
+
+    // Usar o layout compacto do dicionário, ou construir um temporário a partir da Trie de ponteiros.
+    TSTCompacta *compacta = dicionario->compacta;
+    if (compacta == NULL)
+    {
+        compacta = construirTSTCompacta(dicionario->raiz);
+        if (compacta == NULL)
+            return false;
+    }
+
+    if (nomeOrigem != NULL)
+        identificarOrigem(nomeOrigem, &tamanhoOrigem, &modificacaoOrigem);
+    bool sucesso = escreverInstantaneo(compacta, dicionario->manifesto, dicionario->hash_ficheiro, nomeInstantaneo,
+                                       tamanhoOrigem, modificacaoOrigem, dicionario->sequenciaDiario);
+
+    if (compacta != dicionario->compacta)
+        destruirTSTCompacta(compacta);
+    return sucesso;
+}
+
+// Mapeia um instantâneo binário num dicionário vazio. Nenhum nó é copiado: o layout compacto aponta para o
+// mapeamento, e as páginas são partilhadas por todos os processos que mapeiam o mesmo instantâneo.
+bool carregarInstantaneo(Dicionario *dicionario, const char *nomeInstantaneo, const char *nomeOrigem)
+{
+    FicheiroMapeado ficheiro;
+    CabecalhoInstantaneo cabecalho;
+
+    if (dicionario->raiz != NULL || dicionario->compacta != NULL || dicionario->concorrencia != NULL)
+        return false;
+
+    if (!mapearFicheiro(nomeInstantaneo, &ficheiro))
+        return false;
+
+    // Validar o cabeçalho e o tamanho antes de confiar nos índices guardados.
+    bool valido = ficheiro.tamanho >= sizeof(cabecalho);
+    if (valido)
+    {
+        memcpy(&cabecalho, ficheiro.dados, sizeof(cabecalho));
+        valido = memcmp(cabecalho.assinatura, ASSINATURA_INSTANTANEO, sizeof(ASSINATURA_INSTANTANEO)) == 0 &&
+                 cabecalho.versao == VERSAO_INSTANTANEO &&
+                 cabecalho.tamanhoNo == sizeof(NoCompacto) &&
+                 cabecalho.totalNos >= 1 && cabecalho.raiz < cabecalho.totalNos &&
+                 (cabecalho.totalPesos == 0 || cabecalho.totalPesos == cabecalho.totalNos) &&
+                 cabecalho.minimizado <= 1 &&
+                 cabecalho.totalBlocosManifesto <= ficheiro.tamanho / sizeof(uint64_t) &&
+                 (cabecalho.tamanhoBlocoManifesto == 0
+                      ? cabecalho.totalBlocosManifesto == 0
+                      : cabecalho.totalBlocosManifesto == (cabecalho.tamanhoManifesto + cabecalho.tamanhoBlocoManifesto - 1) /
+                                                             cabecalho.tamanhoBlocoManifesto) &&
+                 ficheiro.tamanho == sizeof(cabecalho) + (size_t)cabecalho.totalNos * sizeof(NoCompacto) +
+                                         (size_t)cabecalho.totalPesos * sizeof(uint32_t) +
+                                         (size_t)cabecalho.totalBlocosManifesto * sizeof(uint64_t) &&
+                 memchr(cabecalho.hashFicheiro, '\0', sizeof(cabecalho.hashFicheiro)) != NULL;
+    }
+
+    // Os índices dos nós são seguidos sem verificação em todas as consultas: um instantâneo truncado ou corrompido
+    // é rejeitado aqui, pelo hash e pela forma do grafo (que também recusa um ficheiro forjado com o hash certo).
+    if (valido)
+    {
+        const NoCompacto *nos = (const NoCompacto *)(ficheiro.dados + sizeof(cabecalho));
+        const uint32_t *pesos = cabecalho.totalPesos != 0 ? (const uint32_t *)(nos + cabecalho.totalNos) : NULL;
+        valido = hashNosInstantaneo(nos, pesos, cabecalho.totalNos) == cabecalho.hashNos &&
+                 validarNosInstantaneo(nos, cabecalho.totalNos, cabecalho.raiz);
+    }
+
+    // Copiar o manifesto (é pequeno: 8 bytes por bloco) e confirmar que a sua raiz é o hash guardado.
+    ManifestoFicheiro *manifesto = NULL;
+    if (valido && cabecalho.tamanhoBlocoManifesto != 0)
+    {
+        manifesto = (ManifestoFicheiro *)malloc(sizeof(ManifestoFicheiro));
+        valido = manifesto != NULL;
+        if (valido)
+        {
+            manifesto->tamanhoFicheiro = cabecalho.tamanhoManifesto;
+            manifesto->tamanhoBloco = cabecalho.tamanhoBlocoManifesto;
+            manifesto->totalBlocos = (size_t)cabecalho.totalBlocosManifesto;
+            manifesto->hashes = manifesto->totalBlocos > 0 ? (uint64_t *)malloc(manifesto->totalBlocos * sizeof(uint64_t)) : NULL;
+            valido = manifesto->totalBlocos == 0 || manifesto->hashes != NULL;
+        }
+        if (valido)
+        {
+            memcpy(manifesto->hashes, ficheiro.dados + ficheiro.tamanho - manifesto->totalBlocos * sizeof(uint64_t),
+                   manifesto->totalBlocos * sizeof(uint64_t));
+            concluirManifesto(manifesto);
+            char *raiz = formatarHash(manifesto->raiz);
+            valido = raiz != NULL && strcmp(raiz, cabecalho.hashFicheiro) == 0;
+            free(raiz);
+        }
+        if (!valido && manifesto != NULL)
+        {
+            libertarManifesto(manifesto);
+            free(manifesto);
+            manifesto = NULL;
+        }
+    }
+
+    // Rejeitar o instantâneo se o ficheiro de texto de origem mudou desde que ele foi gerado.
+    if (valido && nomeOrigem != NULL)
+    {
+        uint64_t tamanhoOrigem;
+        int64_t modificacaoOrigem;
+        valido = identificarOrigem(nomeOrigem, &tamanhoOrigem, &modificacaoOrigem) &&
+                 tamanhoOrigem == cabecalho.tamanhoOrigem && modificacaoOrigem == cabecalho.modificacaoOrigem;
+    }
+
+    TSTCompacta *compacta = valido ? (TSTCompacta *)malloc(sizeof(TSTCompacta)) : NULL;
+    if (compacta == NULL)
+    {
+        if (manifesto != NULL)
+        {
+            libertarManifesto(manifesto);
+            free(manifesto);
+        }
+        desmapearFicheiro(&ficheiro);
+        return false;
+    }
+
+    // Os dados do mapeamento só são lidos: o cast apenas acompanha o tipo do layout compacto.
+    compacta->nos = (NoCompacto *)(ficheiro.dados + sizeof(cabecalho));
+    compacta->pesos = cabecalho.totalPesos != 0 ? (uint32_t *)(compacta->nos + cabecalho.totalNos) : NULL;
+    compacta->totalNos = cabecalho.totalNos;
+    compacta->raiz = cabecalho.raiz;
+    compacta->totalPalavras = (size_t)cabecalho.totalPalavras;
+    compacta->minimizada = cabecalho.minimizado != 0;
+    compacta->instantaneo = ficheiro;
+    memset(compacta->tabelaRaiz, 0, sizeof(compacta->tabelaRaiz));
+    preencherTabelaRaizCompacta(compacta, compacta->raiz);
+
+    // Sem manifesto (instantâneo guardado sem ficheiro de origem), fica só o hash guardado, se houver.
+    substituirManifesto(dicionario, manifesto);
+    if (manifesto == NULL && cabecalho.hashFicheiro[0] != '\0')
+        dicionario->hash_ficheiro = strdup(cabecalho.hashFicheiro);
+    dicionario->compacta = compacta;
+    dicionario->sequenciaDiario = cabecalho.sequenciaDiario;
+    registarAlteracao(dicionario, NULL);
+
+    // As palavras foram todas substituídas: o filtro antigo já não serve.
+    if (dicionario->filtro != NULL && !construirFiltroDicionario(dicionario))
+        desligarFiltroDicionario(dicionario);
+    return true;
+}
+
+// *********************************** FILTRO DE BLOOM ***********************************
+
+// Multiplicadores ímpares que tiram 8 posições de bit diferentes do mesmo hash (um por palavra de 64 bits do bloco).
+static const uint32_t SAIS_FILTRO_BLOOM[PALAVRAS_POR_BLOCO_FILTRO] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+// Hash de 64 bits de uma palavra (FNV-1a seguido do finalizador do MurmurHash3, para misturar todos os bits).
+static uint64_t hashFiltroBloom(const char *palavra, size_t comprimento)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < comprimento; i++)
+    {
+        hash ^= (unsigned char)palavra[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// Devolve o bloco de uma palavra: os 32 bits altos do hash escalados para [0, totalBlocos), sem divisão.
+static uint64_t *blocoFiltroBloom(const FiltroBloom *filtro, uint64_t hash)
+{
+    size_t indice = (size_t)(((hash >> 32) * filtro->totalBlocos) >> 32);
+    return &filtro->blocos[indice * PALAVRAS_POR_BLOCO_FILTRO];
+}
+
+// Cria um filtro vazio dimensionado para 'capacidade' palavras.
+FiltroBloom *criarFiltroBloom(size_t capacidade)
+{
+    size_t bitsPorBloco = PALAVRAS_POR_BLOCO_FILTRO * 64;
+    size_t totalBlocos = (capacidade * BITS_POR_PALAVRA_FILTRO + bitsPorBloco - 1) / bitsPorBloco;
+
+    if (totalBlocos == 0)
+        totalBlocos = 1;
+    if (totalBlocos > UINT32_MAX)
+        return NULL;
+
+    FiltroBloom *filtro = (FiltroBloom *)malloc(sizeof(FiltroBloom));
+    if (filtro == NULL)
+        return NULL;
+
+    // Cada bloco ocupa exatamente uma linha de cache, portanto uma consulta lê uma só linha.
+    size_t tamanho = totalBlocos * PALAVRAS_POR_BLOCO_FILTRO * sizeof(uint64_t);
+    filtro->blocos = (uint64_t *)aligned_alloc(64, tamanho);
+    if (filtro->blocos == NULL)
+    {
+        free(filtro);
+        return NULL;
+    }
+
+    memset(filtro->blocos, 0, tamanho);
+    filtro->totalBlocos = (uint32_t)totalBlocos;
+    filtro->capacidade = capacidade;
+    filtro->inseridas = 0;
+    filtro->removidas = 0;
+    return filtro;
+}
+
+// Liberta o filtro.
+void destruirFiltroBloom(FiltroBloom *filtro)
+{
+    if (filtro == NULL)
+        return;
+
+    free(filtro->blocos);
+    free(filtro);
+}
+
+// Adiciona uma palavra ao filtro, marcando um bit em cada palavra de 64 bits do seu bloco.
+// Se o filtro já estiver publicado para leitores concorrentes, os bits são marcados com operações atómicas.
+static void marcarFiltroBloom(FiltroBloom *filtro, const char *palavra, size_t comprimento, bool partilhado)
+{
+    uint64_t hash = hashFiltroBloom(palavra, comprimento);
+    uint64_t *bloco = blocoFiltroBloom(filtro, hash);
+
+    for (int i = 0; i < PALAVRAS_POR_BLOCO_FILTRO; i++)
+    {
+        uint64_t bit = (uint64_t)1 << (((uint32_t)hash * SAIS_FILTRO_BLOOM[i]) >> 26);
+        if (partilhado)
+            __atomic_fetch_or(&bloco[i], bit, __ATOMIC_RELAXED);
+        else
+            bloco[i] |= bit;
+    }
+    filtro->inseridas++;
+}
+
+void adicionarFiltroBloom(FiltroBloom *filtro, const char *palavra, size_t comprimento)
+{
+    marcarFiltroBloom(filtro, palavra, comprimento, false);
+}
+
+// Devolve falso se a palavra de certeza não foi adicionada. Os 8 testes são sobre a mesma linha de cache.
+bool talvezContenhaFiltroBloom(const FiltroBloom *filtro, const char *palavra, size_t comprimento)
+{
+    uint64_t hash = hashFiltroBloom(palavra, comprimento);
+    const uint64_t *bloco = blocoFiltroBloom(filtro, hash);
+    uint64_t ausentes = 0;
+
+    for (int i = 0; i < PALAVRAS_POR_BLOCO_FILTRO; i++)
+        ausentes |= ~__atomic_load_n(&bloco[i], __ATOMIC_RELAXED) & ((uint64_t)1 << (((uint32_t)hash * SAIS_FILTRO_BLOOM[i]) >> 26));
+    return ausentes == 0;
+}
+
+// Conta as palavras da Trie de ponteiros.
+static size_t contarPalavras(const NoTST *no)
+{
+    if (no == NULL)
+        return 0;
+
+    return (no->fim_palavra ? 1 : 0) + contarPalavras(no->esquerda) + contarPalavras(no->centro) +
+           contarPalavras(no->direito);
+}
+
+// Adiciona ao filtro todas as palavras da Trie de ponteiros (o buffer guarda o prefixo do caminho atual).
+static void adicionarPalavrasFiltro(FiltroBloom *filtro, const NoTST *no, char *buffer, int profundidade)
+{
+    if (no == NULL)
+        return;
+
+    adicionarPalavrasFiltro(filtro, no->esquerda, buffer, profundidade);
+
+    buffer[profundidade] = no->caractere;
+    if (no->fim_palavra)
+        adicionarFiltroBloom(filtro, buffer, (size_t)profundidade + 1);
+    adicionarPalavrasFiltro(filtro, no->centro, buffer, profundidade + 1);
+
+    adicionarPalavrasFiltro(filtro, no->direito, buffer, profundidade);
+}
+
+// Adiciona ao filtro todas as palavras da representação compacta.
+static void adicionarPalavrasFiltroCompacta(FiltroBloom *filtro, const TSTCompacta *compacta, uint32_t indice,
+                                            char *buffer, int profundidade)
+{
+    if (indice == 0)
+        return;
+
+    const NoCompacto *no = &compacta->nos[indice];
+    adicionarPalavrasFiltroCompacta(filtro, compacta, no->esquerda, buffer, profundidade);
+
+    buffer[profundidade] = no->caractere;
+    if (no->flags & FLAG_FIM_PALAVRA)
+        adicionarFiltroBloom(filtro, buffer, (size_t)profundidade + 1);
+    adicionarPalavrasFiltroCompacta(filtro, compacta, no->centro, buffer, profundidade + 1);
+
+    adicionarPalavrasFiltroCompacta(filtro, compacta, no->direito, buffer, profundidade);
+}
+
+// Liberta um filtro retirado do dicionário.
+static void libertarFiltroRetirado(Dicionario *dicionario, void *filtro)
+{
+    (void)dicionario;
+    destruirFiltroBloom((FiltroBloom *)filtro);
+}
+
+// Publica um novo filtro (ou nenhum). No modo concorrente, o antigo só é libertado quando nenhum leitor o usar.
+static void substituirFiltroDicionario(Dicionario *dicionario, FiltroBloom *filtro)
+{
+    FiltroBloom *antigo = dicionario->filtro;
+
+    __atomic_store_n(&dicionario->filtro, filtro, __ATOMIC_SEQ_CST);
+    if (antigo != NULL)
+        retirarObjeto(dicionario, antigo, libertarFiltroRetirado);
+}
+
+// (Re)constrói o filtro do dicionário com as palavras atuais, com folga para o dobro das palavras antes de precisar
+// de ser redimensionado.
+bool construirFiltroDicionario(Dicionario *dicionario)
+{
+    char buffer[MAX_TAMANHO_PALAVRA];
+    size_t totalPalavras = dicionario->compacta != NULL ? dicionario->compacta->totalPalavras
+                                                        : contarPalavras(dicionario->raiz);
+
+    FiltroBloom *filtro = criarFiltroBloom(totalPalavras * 2);
+    if (filtro == NULL)
+        return false;
+
+    if (dicionario->compacta != NULL)
+        adicionarPalavrasFiltroCompacta(filtro, dicionario->compacta, dicionario->compacta->raiz, buffer, 0);
+    else
+        adicionarPalavrasFiltro(filtro, dicionario->raiz, buffer, 0);
+
+    substituirFiltroDicionario(dicionario, filtro);
+    return true;
+}
+
+// Desliga e liberta o filtro do dicionário.
+void desligarFiltroDicionario(Dicionario *dicionario)
+{
+    substituirFiltroDicionario(dicionario, NULL);
+}
+
+// Mantém o filtro coerente depois de uma alteração: reconstrói-o se passou da capacidade (mais falsos positivos)
+// ou se demasiadas palavras removidas ainda têm bits marcados. Se a reconstrução falhar, o filtro é desligado,
+// porque um filtro desatualizado podia rejeitar palavras que existem.
+void manterFiltroDicionario(Dicionario *dicionario)
+{
+    FiltroBloom *filtro = dicionario->filtro;
+
+    if (filtro == NULL)
+        return;
+
+    if (filtro->inseridas > filtro->capacidade || filtro->removidas > filtro->inseridas / FRACAO_REMOVIDAS_FILTRO)
+    {
+        if (!construirFiltroDicionario(dicionario))
+            desligarFiltroDicionario(dicionario);
+    }
+}
+
+// *********************************** MODO CONCORRENTE (CÓPIA DO CAMINHO) ***********************************
+
+// Liberta o lugar de uma thread leitora quando ela termina (destrutor da chave do lugar).
+static void libertarLugarLeitor(void *lugar)
+{
+    LeitorEpoca *leitor = (LeitorEpoca *)lugar;
+
+    __atomic_store_n(&leitor->epoca, 0, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&leitor->ocupado, false, __ATOMIC_RELEASE);
+}
+
+// Liga o modo concorrente. O layout compacto não é atualizável, portanto o dicionário é descongelado.
+bool ligarModoConcorrente(Dicionario *dicionario)
+{
+    pthread_mutexattr_t atributos;
+
+    if (dicionario->concorrencia != NULL)
+        return true;
+    if (dicionario->compacta != NULL && !descongelarDicionario(dicionario))
+        return false;
+
+    // Os lugares dos leitores estão alinhados a 64 bytes, portanto o tamanho do controlo também é múltiplo de 64.
+    ControloConcorrencia *controlo = (ControloConcorrencia *)aligned_alloc(64, sizeof(ControloConcorrencia));
+    if (controlo == NULL)
+        return false;
+
+    memset(controlo, 0, sizeof(ControloConcorrencia));
+    if (pthread_key_create(&controlo->chaveLeitor, libertarLugarLeitor) != 0)
+    {
+        free(controlo);
+        return false;
+    }
+
+    // O trinco é recursivo porque também serve de leitura de recurso quando não há lugares livres.
+    pthread_mutexattr_init(&atributos);
+    pthread_mutexattr_settype(&atributos, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&controlo->trincoEscrita, &atributos);
+    pthread_mutexattr_destroy(&atributos);
+
+    controlo->epocaGlobal = 1;
+    dicionario->concorrencia = controlo;
+    return true;
+}
+
+// Liberta os objetos retirados que nenhum leitor ativo pode estar a usar: os que foram retirados numa época anterior
+// à do leitor ativo mais antigo. Com 'todos', liberta tudo (não pode haver leitores).
+static void recolherRetirados(Dicionario *dicionario, bool todos)
+{
+    ControloConcorrencia *controlo = dicionario->concorrencia;
+    uint64_t maisAntiga = UINT64_MAX;
+
+    if (controlo->totalRetirados == 0)
+        return;
+
+    for (int i = 0; i < MAX_LEITORES_CONCORRENTES && !todos; i++)
+    {
+        uint64_t epoca = __atomic_load_n(&controlo->leitores[i].epoca, __ATOMIC_SEQ_CST);
+        if (epoca != 0 && epoca < maisAntiga)
+            maisAntiga = epoca;
+    }
+
+    size_t mantidos = 0;
+    for (size_t i = 0; i < controlo->totalRetirados; i++)
+    {
+        ObjetoRetirado *retirado = &controlo->retirados[i];
+        if (retirado->epoca < maisAntiga)
+            retirado->libertar(dicionario, retirado->objeto);
+        else
+            controlo->retirados[mantidos++] = *retirado;
+    }
+    controlo->totalRetirados = mantidos;
+}
+
+// Desliga o modo concorrente. Sem leitores, todos os objetos retirados podem ser libertados.
+void desligarModoConcorrente(Dicionario *dicionario)
+{
+    ControloConcorrencia *controlo = dicionario->concorrencia;
+
+    if (controlo == NULL)
+        return;
+
+    // A vigia do ficheiro escreve a partir da sua própria thread, e a compactação do diário lê a Trie a partir da sua:
+    // ambas só funcionam no modo concorrente.
+    desligarVigiaFicheiro(dicionario);
+    esperarCompactacaoDiario(dicionario);
+
+    recolherRetirados(dicionario, true);
+    dicionario->concorrencia = NULL;
+
+    // Os escritores copiaram os nós dos caminhos que alteraram: a tabela da raiz aponta para nós antigos.
+    reconstruirTabelaRaiz(dicionario);
+
+    // Depois de apagar a chave, os destrutores já não são chamados quando as threads leitoras terminarem.
+    pthread_key_delete(controlo->chaveLeitor);
+    pthread_mutex_destroy(&controlo->trincoEscrita);
+    free(controlo->retirados);
+    free(controlo);
+}
+
+// Retira um objeto da estrutura publicada. Fora do modo concorrente, ninguém o pode estar a ler: é libertado já.
+void retirarObjeto(Dicionario *dicionario, void *objeto, void (*libertar)(Dicionario *dicionario, void *objeto))
+{
+    ControloConcorrencia *controlo = dicionario->concorrencia;
+
+    if (controlo == NULL)
+    {
+        libertar(dicionario, objeto);
+        return;
+    }
+
+    if (controlo->totalRetirados == controlo->capacidadeRetirados)
+    {
+        size_t capacidade = controlo->capacidadeRetirados ? controlo->capacidadeRetirados * 2 : 256;
+        ObjetoRetirado *maior = (ObjetoRetirado *)realloc(controlo->retirados, capacidade * sizeof(ObjetoRetirado));
+
+        // Sem memória para o registar, o objeto fica por libertar: é melhor perdê-lo do que libertá-lo a um leitor.
+        if (maior == NULL)
+            return;
+        controlo->retirados = maior;
+        controlo->capacidadeRetirados = capacidade;
+    }
+
+    ObjetoRetirado *retirado = &controlo->retirados[controlo->totalRetirados++];
+    retirado->objeto = objeto;
+    retirado->libertar = libertar;
+    retirado->epoca = __atomic_load_n(&controlo->epocaGlobal, __ATOMIC_SEQ_CST);
+}
+
+// Marca o início de uma leitura: a thread anuncia a época atual no seu lugar (obtido na primeira leitura). Tudo o
+// que for retirado a partir desta época fica vivo até ela terminar. Se não houver lugares livres, a leitura
+// é feita com o trinco dos escritores (e o lugar devolvido é NULL).
+LeitorEpoca *iniciarLeituraConcorrente(const Dicionario *dicionario)
+{
+    ControloConcorrencia *controlo = dicionario->concorrencia;
+    LeitorEpoca *leitor = (LeitorEpoca *)pthread_getspecific(controlo->chaveLeitor);
+
+    if (leitor == NULL)
+    {
+        for (int i = 0; i < MAX_LEITORES_CONCORRENTES && leitor == NULL; i++)
+        {
+            bool livre = false;
+            if (__atomic_compare_exchange_n(&controlo->leitores[i].ocupado, &livre, true, false, __ATOMIC_ACQ_REL,
+                                            __ATOMIC_RELAXED))
+            {
+                leitor = &controlo->leitores[i];
+                leitor->profundidade = 0;
+                pthread_setspecific(controlo->chaveLeitor, leitor);
+            }
+        }
+
+        if (leitor == NULL)
+        {
+            pthread_mutex_lock(&controlo->trincoEscrita);
+            return NULL;
+        }
+    }
+
+    if (leitor->profundidade++ == 0)
+        __atomic_store_n(&leitor->epoca, __atomic_load_n(&controlo->epocaGlobal, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+    return leitor;
+}
+
+// Marca o fim de uma leitura.
+void terminarLeituraConcorrente(const Dicionario *dicionario, LeitorEpoca *leitor)
+{
+    if (leitor == NULL)
+    {
+        pthread_mutex_unlock(&dicionario->concorrencia->trincoEscrita);
+        return;
+    }
+
+    if (--leitor->profundidade == 0)
+        __atomic_store_n(&leitor->epoca, 0, __ATOMIC_RELEASE);
+}
+
+// Struct auxiliar com os nós copiados numa alteração: se ela for publicada, os originais são retirados; se falhar
+// a meio, as cópias (que nenhum leitor viu) são devolvidas à arena. Os nós novos entram com o original a NULL.
+typedef struct
+{
+    NoTST **originais, **copias;
+    size_t total, capacidade;
+    bool falhou;
+} CaminhoCopiado;
+
+// Copia um nó do caminho alterado (ou cria um nó vazio, se 'original' for NULL). A cópia só fica visível quando a
+// nova raiz for publicada.
+static NoTST *copiarNoDoCaminho(ArenaNos *arena, NoTST *original, CaminhoCopiado *caminho)
+{
+    if (caminho->total == caminho->capacidade)
+    {
+        size_t capacidade = caminho->capacidade ? caminho->capacidade * 2 : 64;
+        NoTST **originais = (NoTST **)realloc(caminho->originais, capacidade * sizeof(NoTST *));
+        if (originais != NULL)
+            caminho->originais = originais;
+        NoTST **copias = (NoTST **)realloc(caminho->copias, capacidade * sizeof(NoTST *));
+        if (copias != NULL)
+            caminho->copias = copias;
+
+        if (originais == NULL || copias == NULL)
+        {
+            caminho->falhou = true;
+            return NULL;
+        }
+        caminho->capacidade = capacidade;
+    }
+
+    NoTST *copia = alocarNoArena(arena);
+    if (copia == NULL)
+    {
+        caminho->falhou = true;
+        return NULL;
+    }
+
+    if (original != NULL)
+        *copia = *original;
+    else
+        memset(copia, 0, sizeof(NoTST));
+    caminho->originais[caminho->total] = original;
+    caminho->copias[caminho->total] = copia;
+    caminho->total++;
+    return copia;
+}
+
+// Insere uma palavra sem alterar nenhum nó publicado: cada nó do caminho é copiado e os nós novos só são criados
+// abaixo do último nó existente. Também os nós novos ficam no caminho, para serem devolvidos se a alteração falhar.
+static NoTST *inserirNoCopiando(ArenaNos *arena, NoTST *no, const char *palavra, int indice, uint32_t peso,
+                                bool substituirPeso, CaminhoCopiado *caminho)
+{
+    NoTST *copia = copiarNoDoCaminho(arena, no, caminho);
+    if (copia == NULL)
+        return NULL;
+
+    // Um nó novo leva o caractere da palavra e o resto dela desce sempre pelo centro.
+    if (no == NULL)
+    {
+        copia->caractere = palavra[indice];
+        no = copia;
+    }
+
+    if (palavra[indice] < no->caractere)
+        copia->esquerda = inserirNoCopiando(arena, no->esquerda, palavra, indice, peso, substituirPeso, caminho);
+    else if (palavra[indice] > no->caractere)
+        copia->direito = inserirNoCopiando(arena, no->direito, palavra, indice, peso, substituirPeso, caminho);
+    else if (palavra[indice + 1] != '\0')
+        copia->centro = inserirNoCopiando(arena, no->centro, palavra, indice + 1, peso, substituirPeso, caminho);
+    else
+    {
+        if (!copia->fim_palavra || substituirPeso)
+            copia->peso = peso;
+        copia->fim_palavra = true;
+    }
+
+    atualizarPesoMaximo(copia);
+    return copia;
+}
+
+// Remove uma palavra (que existe) sem alterar nenhum nó publicado. As cópias que ficam vazias são libertadas já,
+// porque nunca foram visíveis; isto só acontece a subir, depois de todas as cópias terem sido feitas.
+static NoTST *removerNoCopiando(ArenaNos *arena, NoTST *no, const char *palavra, int indice, CaminhoCopiado *caminho)
+{
+    NoTST *copia = copiarNoDoCaminho(arena, no, caminho);
+    if (copia == NULL)
+        return NULL;
+
+    if (palavra[indice] < no->caractere)
+        copia->esquerda = removerNoCopiando(arena, no->esquerda, palavra, indice, caminho);
+    else if (palavra[indice] > no->caractere)
+        copia->direito = removerNoCopiando(arena, no->direito, palavra, indice, caminho);
+    else if (palavra[indice + 1] != '\0')
+        copia->centro = removerNoCopiando(arena, no->centro, palavra, indice + 1, caminho);
+    else
+    {
+        copia->fim_palavra = false;
+        copia->peso = 0;
+    }
+
+    if (!caminho->falhou && noEstaVazio(copia) && !copia->fim_palavra)
+    {
+        libertarNoArena(arena, copia);
+        return NULL;
+    }
+    atualizarPesoMaximo(copia);
+    return copia;
+}
+
+// Conclui a alteração concorrente de 'palavra' com o trinco dos escritores tomado: publica a nova raiz e retira os nós
+// substituídos, ou desfaz as cópias se a alteração falhou. Depois avança a época e liberta o que já for seguro.
+static void publicarCaminhoCopiado(Dicionario *dicionario, const char *palavra, NoTST *raiz, CaminhoCopiado *caminho)
+{
+    ControloConcorrencia *controlo = dicionario->concorrencia;
+
+    if (caminho->falhou)
+    {
+        printf("[Falha na alocação de memória ao alterar o dicionário].\n");
+        for (size_t i = 0; i < caminho->total; i++)
+            libertarNoArena(&dicionario->arena, caminho->copias[i]);
+    }
+    else
+    {
+        __atomic_store_n(&dicionario->raiz, raiz, __ATOMIC_SEQ_CST);
+        for (size_t i = 0; i < caminho->total; i++)
+            if (caminho->originais[i] != NULL)
+                retirarObjeto(dicionario, caminho->originais[i], libertarNoRetirado);
+        registarAlteracao(dicionario, palavra);
+    }
+
+    __atomic_add_fetch(&controlo->epocaGlobal, 1, __ATOMIC_SEQ_CST);
+    recolherRetirados(dicionario, false);
+
+    free(caminho->originais);
+    free(caminho->copias);
+}
+
+// Insere uma palavra no modo concorrente. Os leitores continuam a ver a raiz antiga até a nova ser publicada.
+void inserirPalavraConcorrente(Dicionario *dicionario, const char *palavra, uint32_t peso, bool substituirPeso)
+{
+    ControloConcorrencia *controlo = dicionario->concorrencia;
+    CaminhoCopiado caminho = {NULL, NULL, 0, 0, false};
+    size_t comprimento = strlen(palavra);
+
+    // As mesmas palavras que inserirPalavra rejeita: não cabem nos buffers dos percursos.
+    if (comprimento == 0 || comprimento >= MAX_TAMANHO_PALAVRA)
+        return;
+
+    pthread_mutex_lock(&controlo->trincoEscrita);
+
+    // Uma palavra que já existe (com o mesmo peso, ou sem peso novo) não altera nada: não vale a pena copiar o caminho.
+    const NoTST *existente = procurarNoPalavra(dicionario->raiz, palavra);
+    if (existente == NULL || (substituirPeso && existente->peso != peso))
+    {
+        NoTST *raiz = inserirNoCopiando(&dicionario->arena, dicionario->raiz, palavra, 0, peso, substituirPeso, &caminho);
+
+        // O filtro tem de conhecer a palavra antes de a nova raiz ficar visível, senão podia rejeitá-la.
+        if (!caminho.falhou && existente == NULL && dicionario->filtro != NULL)
+            marcarFiltroBloom(dicionario->filtro, palavra, comprimento, true);
+
+        publicarCaminhoCopiado(dicionario, palavra, raiz, &caminho);
+        if (!caminho.falhou)
+            manterFiltroDicionario(dicionario);
+    }
+
+    pthread_mutex_unlock(&controlo->trincoEscrita);
+}
+
+// Remove uma palavra no modo concorrente.
+void removerPalavraConcorrente(Dicionario *dicionario, const char *palavra)
+{
+    ControloConcorrencia *controlo = dicionario->concorrencia;
+    CaminhoCopiado caminho = {NULL, NULL, 0, 0, false};
+
+    pthread_mutex_lock(&controlo->trincoEscrita);
+
+    if (consultarPalavraIterativo(dicionario->raiz, palavra))
+    {
+        NoTST *raiz = removerNoCopiando(&dicionario->arena, dicionario->raiz, palavra, 0, &caminho);
+        publicarCaminhoCopiado(dicionario, palavra, raiz, &caminho);
+
+        if (!caminho.falhou && dicionario->filtro != NULL)
+        {
+            dicionario->filtro->removidas++;
+            manterFiltroDicionario(dicionario);
+        }
+    }
+
+    pthread_mutex_unlock(&controlo->trincoEscrita);
+}
+
+// *********************************** VERIFICAÇÃO DA INTEGRIDADE DO FICHEIRO DE TEXTO ***********************************
+
+// Compara o ficheiro, bloco a bloco, com o manifesto guardado no dicionário quando ele foi carregado.
+bool verificarAlteracoesFicheiro(Dicionario *dicionario, const char *nomeFicheiro, IntervaloFicheiro *intervalos,
+                                 size_t maximo, size_t *totalIntervalos)
+{
+    FicheiroMapeado ficheiro;
+    ManifestoFicheiro atual;
+
+    *totalIntervalos = 0;
+    if (!mapearFicheiro(nomeFicheiro, &ficheiro))
+        return false;
+
+    // O manifesto atual é gerado de uma só vez sobre o ficheiro mapeado.
+    bool gerado = gerarManifesto(&atual, ficheiro.dados, ficheiro.tamanho);
+    desmapearFicheiro(&ficheiro);
+    if (!gerado)
+        return false;
+
+    // No modo concorrente, a vigia pode estar a substituir o manifesto guardado.
+    if (dicionario->concorrencia != NULL)
+        pthread_mutex_lock(&dicionario->concorrencia->trincoEscrita);
+
+    // Sem manifesto guardado não há com que comparar: o ficheiro inteiro conta como alterado.
+    if (dicionario->manifesto != NULL)
+        *totalIntervalos = compararManifestos(dicionario->manifesto, &atual, intervalos, maximo);
+    else
+    {
+        *totalIntervalos = 1;
+        if (maximo > 0)
+        {
+            intervalos[0].inicio = 0;
+            intervalos[0].fim = atual.tamanhoFicheiro;
+        }
+    }
+
+    if (dicionario->concorrencia != NULL)
+        pthread_mutex_unlock(&dicionario->concorrencia->trincoEscrita);
+
+    libertarManifesto(&atual);
+    return true;
+}
+
+// Verifica a integridade do ficheiro comparando o manifesto atual do ficheiro com o armazenado no dicionário.
+bool verificarIntegridadeFicheiro(Dicionario *dicionario, const char *nomeFicheiro)
+{
+    size_t alterados;
+
+    // A integridade está preservada se nenhum bloco mudou desde que o ficheiro foi carregado.
+    return verificarAlteracoesFicheiro(dicionario, nomeFicheiro, NULL, 0, &alterados) && alterados == 0;
+}
+
+// ================================ FUNÇÕES DE HASH ==================================
+// As funções relacionadas ao hash do ficheiro são implementadas aqui.
+
+// *********************************** GERANDO O HASH PARA O ARQUIVO DE TEXTO ***********************************
+
+// Acumula o hash djb2 de um bloco de bytes a partir do valor atual do hash.
+unsigned long acumularHash(unsigned long hash, const unsigned char *dados, size_t tamanho)
+{
+    for (size_t i = 0; i < tamanho; i++)
+    {
+        // Calcula o hash usando o algoritmo djb2
+        hash = ((hash << 5) + hash) + dados[i]; // hash * 33 + c
+    }
+
+    return hash;
+}
+
+// Constantes do XXH64 (primos de 64 bits).
+#define PRIMO_XXH64_1 0x9E3779B185EBCA87ULL
+#define PRIMO_XXH64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIMO_XXH64_3 0x165667B19E3779F9ULL
+#define PRIMO_XXH64_4 0x85EBCA77C2B2AE63ULL
+#define PRIMO_XXH64_5 0x27D4EB2F165667C5ULL
+
+// Roda um valor de 64 bits 'bits' posições para a esquerda.
+static inline uint64_t rodarXXH64(uint64_t valor, int bits)
+{
+    return (valor << bits) | (valor >> (64 - bits));
+}
+
+// Lê 8 bytes em little-endian, sem exigir alinhamento.
+static inline uint64_t ler64XXH64(const unsigned char *dados)
+{
+    uint64_t valor;
+    memcpy(&valor, dados, sizeof(valor));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    valor = __builtin_bswap64(valor);
+#endif
+    return valor;
+}
+
+// Lê 4 bytes em little-endian, sem exigir alinhamento.
+static inline uint32_t ler32XXH64(const unsigned char *dados)
+{
+    uint32_t valor;
+    memcpy(&valor, dados, sizeof(valor));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    valor = __builtin_bswap32(valor);
+#endif
+    return valor;
+}
+
+// Mistura 8 bytes de entrada num acumulador.
+static inline uint64_t rondaXXH64(uint64_t acumulador, uint64_t entrada)
+{
+    acumulador += entrada * PRIMO_XXH64_2;
+    acumulador = rodarXXH64(acumulador, 31);
+    return acumulador * PRIMO_XXH64_1;
+}
+
+// Junta um dos quatro acumuladores ao hash.
+static inline uint64_t juntarXXH64(uint64_t hash, uint64_t acumulador)
+{
+    hash ^= rondaXXH64(0, acumulador);
+    return hash * PRIMO_XXH64_1 + PRIMO_XXH64_4;
+}
+
+// Calcula o hash XXH64 de um bloco de bytes. Os quatro acumuladores não dependem uns dos outros, o que deixa o
+// processador tratar 32 bytes por volta em paralelo, em vez de esperar pelo byte anterior como no djb2.
+uint64_t hashXXH64(const void *dados, size_t tamanho, uint64_t semente)
+{
+    const unsigned char *atual = (const unsigned char *)dados;
+    const unsigned char *fim = tamanho > 0 ? atual + tamanho : atual;
+    uint64_t hash;
+
+    if (tamanho >= 32)
+    {
+        const unsigned char *limite = fim - 32;
+        uint64_t acumulador1 = semente + PRIMO_XXH64_1 + PRIMO_XXH64_2;
+        uint64_t acumulador2 = semente + PRIMO_XXH64_2;
+        uint64_t acumulador3 = semente;
+        uint64_t acumulador4 = semente - PRIMO_XXH64_1;
+
+        do
+        {
+            acumulador1 = rondaXXH64(acumulador1, ler64XXH64(atual));
+            acumulador2 = rondaXXH64(acumulador2, ler64XXH64(atual + 8));
+            acumulador3 = rondaXXH64(acumulador3, ler64XXH64(atual + 16));
+            acumulador4 = rondaXXH64(acumulador4, ler64XXH64(atual + 24));
+            atual += 32;
+        } while (atual <= limite);
+
+        hash = rodarXXH64(acumulador1, 1) + rodarXXH64(acumulador2, 7) + rodarXXH64(acumulador3, 12) +
+               rodarXXH64(acumulador4, 18);
+        hash = juntarXXH64(hash, acumulador1);
+        hash = juntarXXH64(hash, acumulador2);
+        hash = juntarXXH64(hash, acumulador3);
+        hash = juntarXXH64(hash, acumulador4);
+    }
+    else
+        hash = semente + PRIMO_XXH64_5;
+
+    hash += (uint64_t)tamanho;
+
+    // Os bytes que sobram: primeiro de 8 em 8, depois 4 e por fim um a um.
+    for (; fim - atual >= 8; atual += 8)
+    {
+        hash ^= rondaXXH64(0, ler64XXH64(atual));
+        hash = rodarXXH64(hash, 27) * PRIMO_XXH64_1 + PRIMO_XXH64_4;
+    }
+    if (fim - atual >= 4)
+    {
+        hash ^= (uint64_t)ler32XXH64(atual) * PRIMO_XXH64_1;
+        hash = rodarXXH64(hash, 23) * PRIMO_XXH64_2 + PRIMO_XXH64_3;
+        atual += 4;
+    }
+    for (; atual < fim; atual++)
+    {
+        hash ^= (uint64_t)*atual * PRIMO_XXH64_5;
+        hash = rodarXXH64(hash, 11) * PRIMO_XXH64_1;
+    }
+
+    // Avalanche final.
+    hash ^= hash >> 33;
+    hash *= PRIMO_XXH64_2;
+    hash ^= hash >> 29;
+    hash *= PRIMO_XXH64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+// Converte o valor do hash para uma string alocada dinamicamente (16 dígitos hexadecimais)
+char *formatarHash(uint64_t hash)
+{
+    // 16 dígitos hexadecimais, mais um para o caractere nulo no final
+    char *hashStr = malloc(17 * sizeof(char));
+    // Se a alocação falhar, imprime um erro e retorna NULL
+    if (hashStr == NULL)
+    {
+        printf("Erro ao alocar memória para o hash.\n");
+        return NULL;
+    }
+
+    // Converte o valor do hash para uma string
+    sprintf(hashStr, "%016llx", (unsigned long long)hash);
+    return hashStr;
+}
+
+// Esta função gera um hash para um arquivo especificado: a raiz do seu manifesto
+char *gerarHashFicheiro(const char *nomeFicheiro)
+{
+    FicheiroMapeado ficheiro;
+    ManifestoFicheiro manifesto;
+
+    // Mapeia o arquivo em memória; se não for possível, imprime um erro e retorna NULL
+    if (!mapearFicheiro(nomeFicheiro, &ficheiro))
+    {
+        printf("Erro ao abrir o ficheiro: %s\n", nomeFicheiro);
+        return NULL;
+    }
+
+    // Calcula o hash de cada bloco do conteúdo mapeado e a raiz da lista de hashes
+    bool gerado = gerarManifesto(&manifesto, ficheiro.dados, ficheiro.tamanho);
+    desmapearFicheiro(&ficheiro);
+    if (!gerado)
+        return NULL;
+
+    // Retorna a string com o hash do arquivo
+    char *hash = formatarHash(manifesto.raiz);
+    libertarManifesto(&manifesto);
+    return hash;
+}
+
+// *********************************** MANIFESTO POR BLOCOS ***********************************
+
+// Prepara um manifesto para um ficheiro com 'tamanho' bytes, ainda sem os hashes dos blocos.
+bool iniciarManifesto(ManifestoFicheiro *manifesto, uint64_t tamanho)
+{
+    manifesto->tamanhoFicheiro = tamanho;
+    manifesto->tamanhoBloco = TAMANHO_BLOCO_MANIFESTO;
+    manifesto->totalBlocos = (size_t)((tamanho + TAMANHO_BLOCO_MANIFESTO - 1) / TAMANHO_BLOCO_MANIFESTO);
+    manifesto->raiz = 0;
+    manifesto->hashes = NULL;
+
+    if (manifesto->totalBlocos == 0)
+        return true;
+
+    manifesto->hashes = (uint64_t *)malloc(manifesto->totalBlocos * sizeof(uint64_t));
+    return manifesto->hashes != NULL;
+}
+
+// Calcula o hash de um bloco; o último bloco só tem os bytes que restam no ficheiro.
+void hashBlocoManifesto(ManifestoFicheiro *manifesto, const unsigned char *dados, size_t bloco)
+{
+    uint64_t inicio = (uint64_t)bloco * manifesto->tamanhoBloco;
+    uint64_t tamanho = manifesto->tamanhoFicheiro - inicio;
+
+    if (tamanho > manifesto->tamanhoBloco)
+        tamanho = manifesto->tamanhoBloco;
+    manifesto->hashes[bloco] = hashXXH64(dados + inicio, (size_t)tamanho, 0);
+}
+
+// Calcula a raiz: o hash da lista de hashes dos blocos, com o tamanho do ficheiro como semente.
+void concluirManifesto(ManifestoFicheiro *manifesto)
+{
+    manifesto->raiz = hashXXH64(manifesto->hashes, manifesto->totalBlocos * sizeof(uint64_t),
+                                manifesto->tamanhoFicheiro);
+}
+
+// Gera o manifesto completo de um conteúdo em memória.
+bool gerarManifesto(ManifestoFicheiro *manifesto, const unsigned char *dados, size_t tamanho)
+{
+    if (!iniciarManifesto(manifesto, tamanho))
+        return false;
+
+    for (size_t bloco = 0; bloco < manifesto->totalBlocos; bloco++)
+        hashBlocoManifesto(manifesto, dados, bloco);
+    concluirManifesto(manifesto);
+    return true;
+}
+
+// Liberta os hashes de um manifesto.
+void libertarManifesto(ManifestoFicheiro *manifesto)
+{
+    free(manifesto->hashes);
+    manifesto->hashes = NULL;
+    manifesto->totalBlocos = 0;
+}
+
+// Passa a guardar no dicionário o manifesto (alocado) do ficheiro carregado, e a sua raiz como hash do ficheiro.
+void substituirManifesto(Dicionario *dicionario, ManifestoFicheiro *manifesto)
+{
+    if (dicionario->manifesto != NULL)
+        libertarManifesto(dicionario->manifesto);
+    free(dicionario->manifesto);
+    free(dicionario->hash_ficheiro);
+
+    dicionario->manifesto = manifesto;
+    dicionario->hash_ficheiro = manifesto != NULL ? formatarHash(manifesto->raiz) : NULL;
+}
+
+// Conta um intervalo alterado, guardando-o se ainda houver espaço.
+static void acrescentarIntervalo(IntervaloFicheiro *intervalos, size_t maximo, size_t *total, uint64_t inicio,
+                                 uint64_t fim)
+{
+    if (*total < maximo)
+    {
+        intervalos[*total].inicio = inicio;
+        intervalos[*total].fim = fim;
+    }
+    (*total)++;
+}
+
+// Compara dois manifestos bloco a bloco, juntando os blocos alterados seguidos num só intervalo. Os blocos que só
+// existem num dos manifestos (o ficheiro cresceu ou encolheu) contam como alterados.
+size_t compararManifestos(const ManifestoFicheiro *antigo, const ManifestoFicheiro *atual,
+                          IntervaloFicheiro *intervalos, size_t maximo)
+{
+    uint64_t tamanho = antigo->tamanhoFicheiro > atual->tamanhoFicheiro ? antigo->tamanhoFicheiro : atual->tamanhoFicheiro;
+    size_t blocos = antigo->totalBlocos > atual->totalBlocos ? antigo->totalBlocos : atual->totalBlocos;
+    size_t total = 0;
+
+    if (tamanho == 0)
+        return 0;
+
+    // Manifestos com blocos de tamanhos diferentes não se podem comparar bloco a bloco.
+    if (antigo->tamanhoBloco != atual->tamanhoBloco)
+    {
+        acrescentarIntervalo(intervalos, maximo, &total, 0, tamanho);
+        return total;
+    }
+
+    uint64_t tamanhoBloco = atual->tamanhoBloco, inicio = 0;
+    bool dentroDeIntervalo = false;
+    for (size_t bloco = 0; bloco < blocos; bloco++)
+    {
+        bool alterado = bloco >= antigo->totalBlocos || bloco >= atual->totalBlocos ||
+                        antigo->hashes[bloco] != atual->hashes[bloco];
+
+        if (alterado && !dentroDeIntervalo)
+        {
+            inicio = bloco * tamanhoBloco;
+            dentroDeIntervalo = true;
+        }
+        else if (!alterado && dentroDeIntervalo)
+        {
+            acrescentarIntervalo(intervalos, maximo, &total, inicio, bloco * tamanhoBloco);
+            dentroDeIntervalo = false;
+        }
+    }
+
+    if (dentroDeIntervalo)
+        acrescentarIntervalo(intervalos, maximo, &total, inicio, tamanho);
+    return total;
+}
+
+// *********************************** FICHEIROS MAPEADOS EM MEMÓRIA ***********************************
+
+// Mapeia um ficheiro inteiro em memória, só para leitura.
+bool mapearFicheiro(const char *nomeFicheiro, FicheiroMapeado *ficheiro)
+{
+    struct stat informacao;
+
+    ficheiro->dados = NULL;
+    ficheiro->tamanho = 0;
+
+    int descritor = open(nomeFicheiro, O_RDONLY);
+    if (descritor < 0)
+        return false;
+
+    if (fstat(descritor, &informacao) != 0)
+    {
+        close(descritor);
+        return false;
+    }
+
+    // Um ficheiro vazio não pode ser mapeado, mas é um ficheiro válido sem conteúdo.
+    if (informacao.st_size > 0)
+    {
+        void *dados = mmap(NULL, (size_t)informacao.st_size, PROT_READ, MAP_PRIVATE, descritor, 0);
+        if (dados == MAP_FAILED)
+        {
+            close(descritor);
+            return false;
+        }
+
+        // O conteúdo é lido do início ao fim, o que permite ao sistema ler antecipadamente.
+        madvise(dados, (size_t)informacao.st_size, MADV_SEQUENTIAL);
+        ficheiro->dados = (const unsigned char *)dados;
+        ficheiro->tamanho = (size_t)informacao.st_size;
+    }
+
+    // O mapeamento continua válido depois de fechar o descritor.
+    close(descritor);
+    return true;
+}
+
+// Desfaz o mapeamento de um ficheiro.
+void desmapearFicheiro(FicheiroMapeado *ficheiro)
+{
+    if (ficheiro->dados != NULL)
+        munmap((void *)ficheiro->dados, ficheiro->tamanho);
+
+    ficheiro->dados = NULL;
+    ficheiro->tamanho = 0;
+}
+
+// *********************************** COMPARANDO O HASH ARMAZENADO DO FICHEIRO DE TEXTO ***********************************
+
+// Esta função compara o hash armazenado no dicionário com um hash fornecido
+bool compararHashFicheiro(Dicionario *dicionario, const char *hashComparacao)
+{
+    // Se ambos os hashes são NULL, eles são considerados iguais
+    if (dicionario->hash_ficheiro == NULL && hashComparacao == NULL)
+    {
+        return true;
+    }
+
+    // Se apenas um dos hashes é NULL, eles são considerados diferentes
+    if (dicionario->hash_ficheiro == NULL || hashComparacao == NULL)
+    {
+        return false;
+    }
+
+    // Compara os dois hashes
+    // Se a função strcmp retorna 0, significa que as strings são iguais
+    if (strcmp(dicionario->hash_ficheiro, hashComparacao) == 0)
+    {
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+// ================================ FUNÇÕES DO MENU ==================================
+// As funções relacionadas ao menu principal são implementadas aqui.
+
+// *********************************** CARREGANDO AS PALAVRAS DO FICHEIRO PARA A TRIE TST (O DICIONÁRIO) ***********************************
+
+// Tipo das funções que recebem as palavras separadas de um texto; devolvem falso para interromper a separação.
+typedef bool (*VisitanteFatia)(const FatiaPalavra *fatia, void *contexto);
+
+// Separa as palavras do texto [inicio, fim), que tem de começar no início de uma linha. Cada linha pode ter uma
+// segunda coluna com o peso da primeira palavra, que por isso só é entregue quando a linha mostra se ela tem peso.
+// Com um manifesto (só para o ficheiro inteiro), o hash de cada bloco é calculado logo que o bloco acaba de ser
+// percorrido, ainda na cache. Devolve falso se o visitante interromper a separação.
+static bool separarPalavrasTexto(const unsigned char *dados, size_t inicio, size_t fim, size_t *rejeitadas,
+                                 ManifestoFicheiro *manifesto, VisitanteFatia visitar, void *contexto)
+{
+    FatiaPalavra primeira;
+    bool primeiraPendente = false, dentroDePalavra = false, soDigitos = false;
+    size_t inicioPalavra = inicio;
+    int palavrasNaLinha = 0;
+
+    // Bloco do manifesto que está a ser percorrido e a posição onde ele acaba.
+    size_t bloco = 0;
+    size_t fimBloco = fim < TAMANHO_BLOCO_MANIFESTO ? fim : TAMANHO_BLOCO_MANIFESTO;
+
+    // O índice vai até ao fim (inclusive) para fechar a última palavra como se houvesse um espaço no fim.
+    for (size_t i = inicio; i <= fim; i++)
+    {
+        if (manifesto != NULL && i == fimBloco && bloco < manifesto->totalBlocos)
+        {
+            hashBlocoManifesto(manifesto, dados, bloco++);
+            fimBloco = fim - fimBloco < TAMANHO_BLOCO_MANIFESTO ? fim : fimBloco + TAMANHO_BLOCO_MANIFESTO;
+        }
+
+        bool espaco = i == fim || isspace(dados[i]);
+        if (!espaco)
+        {
+            if (!dentroDePalavra)
+            {
+                inicioPalavra = i;
+                dentroDePalavra = true;
+                soDigitos = true;
+            }
+            soDigitos = soDigitos && isdigit(dados[i]);
+            continue;
+        }
+
+        if (dentroDePalavra)
+        {
+            dentroDePalavra = false;
+            palavrasNaLinha++;
+
+            // Um número logo a seguir à primeira palavra da linha é o peso dessa palavra (saturado em 32 bits).
+            if (palavrasNaLinha == 2 && soDigitos)
+            {
+                if (primeiraPendente)
+                {
+                    uint64_t peso = 0;
+                    for (size_t j = inicioPalavra; j < i && peso <= UINT32_MAX; j++)
+                        peso = peso * 10 + (uint64_t)(dados[j] - '0');
+                    primeira.peso = peso > UINT32_MAX ? UINT32_MAX : (uint32_t)peso;
+                }
+            }
+            // Palavras que não cabem nos buffers de MAX_TAMANHO_PALAVRA caracteres são rejeitadas
+            else if (i - inicioPalavra >= MAX_TAMANHO_PALAVRA)
+            {
+                if (rejeitadas != NULL)
+                    (*rejeitadas)++;
+            }
+            else
+            {
+                FatiaPalavra fatia = {(const char *)dados + inicioPalavra, (int)(i - inicioPalavra), 0};
+                if (palavrasNaLinha == 1)
+                {
+                    primeira = fatia;
+                    primeiraPendente = true;
+                }
+                else if (!visitar(&fatia, contexto))
+                    return false;
+            }
+
+            // Depois da segunda palavra da linha, a primeira já não pode receber peso.
+            if (palavrasNaLinha >= 2 && primeiraPendente)
+            {
+                primeiraPendente = false;
+                if (!visitar(&primeira, contexto))
+                    return false;
+            }
+        }
+
+        if (i == fim || dados[i] == '\n')
+        {
+            if (primeiraPendente)
+            {
+                primeiraPendente = false;
+                if (!visitar(&primeira, contexto))
+                    return false;
+            }
+            palavrasNaLinha = 0;
+        }
+    }
+    return true;
+}
+
+// Struct auxiliar com um vetor de fatias que cresce para o dobro quando enche.
+typedef struct
+{
+    FatiaPalavra *palavras;
+    size_t total, capacidade;
+} ListaFatias;
+
+// Acrescenta uma fatia à lista (visitante de separarPalavrasTexto). Devolve falso se faltar memória.
+static bool acrescentarFatia(const FatiaPalavra *fatia, void *contexto)
+{
+    ListaFatias *lista = (ListaFatias *)contexto;
+
+    if (lista->total == lista->capacidade)
+    {
+        size_t capacidade = lista->capacidade ? lista->capacidade * 2 : 1024;
+        FatiaPalavra *maior = (FatiaPalavra *)realloc(lista->palavras, capacidade * sizeof(FatiaPalavra));
+        if (maior == NULL)
+            return false;
+        lista->palavras = maior;
+        lista->capacidade = capacidade;
+    }
+
+    lista->palavras[lista->total++] = *fatia;
+    return true;
+}
+
+// Carrega o ficheiro mapeado em memória numa única passagem: as palavras são fatias do próprio mapeamento (sem cópias)
+// e o manifesto de integridade é calculado ao mesmo tempo.
+bool carregarFicheiroMapeado(Dicionario *dicionario, const char *nomeFicheiro, size_t *rejeitadas)
+{
+    FicheiroMapeado ficheiro;
+    ListaFatias lista = {NULL, 0, 0};
+
+    if (rejeitadas != NULL)
+        *rejeitadas = 0;
+
+    if (!mapearFicheiro(nomeFicheiro, &ficheiro))
+        return false;
+
+    ManifestoFicheiro *manifesto = (ManifestoFicheiro *)malloc(sizeof(ManifestoFicheiro));
+    bool sucesso = manifesto != NULL && iniciarManifesto(manifesto, ficheiro.tamanho) &&
+                   separarPalavrasTexto(ficheiro.dados, 0, ficheiro.tamanho, rejeitadas, manifesto, acrescentarFatia, &lista);
+    if (!sucesso)
+    {
+        if (manifesto != NULL)
+            libertarManifesto(manifesto);
+        free(manifesto);
+        free(lista.palavras);
+        desmapearFicheiro(&ficheiro);
+        return false;
+    }
+
+    // Construir a TRIE TST equilibrada com todas as palavras lidas; as fatias deixam de ser usadas depois disto
+    sucesso = inserirPalavrasEmLote(dicionario, lista.palavras, lista.total);
+    free(lista.palavras);
+    desmapearFicheiro(&ficheiro);
+    if (!sucesso)
+    {
+        libertarManifesto(manifesto);
+        free(manifesto);
+        return false;
+    }
+
+    // Armazenar o manifesto do ficheiro, calculado na mesma passagem
+    concluirManifesto(manifesto);
+    substituirManifesto(dicionario, manifesto);
+    return true;
+}
+
+// Função para carregar as palavras do ficheiro e preenchê-las na TRIE TST
+void carregarPalavrasDoFicheiro(Dicionario *dicionario, const char *nomeFicheiro)
+{
+    size_t rejeitadas, repostas;
+    char nomeInstantaneo[FILENAME_MAX];
+    bool doTexto = false;
+
+    // Se existir um instantâneo binário gerado a partir da versão atual do ficheiro, basta mapeá-lo
+    snprintf(nomeInstantaneo, sizeof(nomeInstantaneo), "%s%s", nomeFicheiro, EXTENSAO_INSTANTANEO);
+    if (carregarInstantaneo(dicionario, nomeInstantaneo, nomeFicheiro))
+    {
+        // Construir o filtro de Bloom que rejeita as palavras ausentes antes de percorrer a Trie
+        if (!construirFiltroDicionario(dicionario))
+            printf("Não foi possível construir o filtro de Bloom; as consultas usam só a Trie.\n");
+        printf("As palavras foram carregadas do instantâneo %s (%zu palavras).\n", nomeInstantaneo, dicionario->compacta->totalPalavras);
+    }
+    // Verificar se o ficheiro foi carregado com sucesso
+    else if (!carregarFicheiroMapeado(dicionario, nomeFicheiro, &rejeitadas))
+    {
+        // Imprimir uma mensagem de erro se o ficheiro não puder ser lido (ou faltar memória para a Trie)
+        printf("Não foi possível carregar o ficheiro %s.\n", nomeFicheiro);
+        perror("Erro");
+        system("pause");
+        return;
+    }
+    else
+    {
+        if (rejeitadas > 0)
+            printf("%zu palavra(s) com %d ou mais caracteres foram ignoradas.\n", rejeitadas, MAX_TAMANHO_PALAVRA);
+
+        // Construir o filtro de Bloom que rejeita as palavras ausentes antes de percorrer a Trie
+        if (!construirFiltroDicionario(dicionario))
+            printf("Não foi possível construir o filtro de Bloom; as consultas usam só a Trie.\n");
+
+        // Imprimir uma mensagem de sucesso
+        printf("As palavras foram carregadas com sucesso do ficheiro %s.\n", nomeFicheiro);
+        doTexto = true;
+    }
+
+    // Repor as alterações feitas depois do instantâneo (ou todas, sobre o ficheiro de texto) e continuar a registá-las
+    if (!abrirDiarioAlteracoes(dicionario, nomeFicheiro, &repostas))
+        printf("Não foi possível abrir o diário %s%s; as alterações ficam só em memória.\n", nomeFicheiro, EXTENSAO_DIARIO);
+    else if (repostas > 0)
+        printf("%zu alteração(ões) do diário %s%s foram repostas.\n", repostas, nomeFicheiro, EXTENSAO_DIARIO);
+
+    // Construir o índice das palavras sem maiúsculas nem acentos, uma só vez, já com as palavras finais
+    if (dicionario->dobrarAoCarregar && !construirIndiceDobrado(dicionario))
+        printf("Não foi possível construir o índice dobrado; as consultas distinguem maiúsculas e acentos.\n");
+
+    // Guardar o instantâneo binário (já com as alterações repostas) para que o próximo arranque não precise de
+    // reconstruir a Trie
+    if (doTexto && !guardarInstantaneo(dicionario, nomeInstantaneo, nomeFicheiro))
+        printf("Não foi possível guardar o instantâneo %s.\n", nomeInstantaneo);
+    system("pause");
+}
+
+// *********************************** RECARGA INCREMENTAL ***********************************
+
+// Struct auxiliar com um intervalo de linhas que mudou: [inicioAntigo, fimAntigo) na cópia guardada corresponde a
+// [inicioNovo, fimNovo) no ficheiro novo. Fora destes intervalos, os dois conteúdos são iguais byte a byte.
+typedef struct
+{
+    size_t inicioAntigo, fimAntigo;
+    size_t inicioNovo, fimNovo;
+} RegiaoAlterada;
+
+// Struct auxiliar com a lista das regiões alteradas.
+typedef struct
+{
+    RegiaoAlterada *regioes;
+    size_t total, capacidade;
+} ListaRegioes;
+
+// Struct auxiliar com uma palavra das linhas alteradas: quantas vezes e com que peso máximo aparece nas linhas antigas
+// e nas novas e, se for preciso, nas linhas que não mudaram.
+typedef struct
+{
+    uint64_t hash;             // Hash (XXH64) da palavra (0 marca um lugar livre).
+    const char *palavra;       // Primeira ocorrência da palavra (na cópia antiga ou no conteúdo novo).
+    int comprimento;
+    uint32_t contagemAntiga, contagemNova, contagemFora;
+    uint32_t pesoAntigo, pesoNovo, pesoFora;
+    uint32_t pesoAtual;        // Peso no dicionário antes da recarga.
+    bool existe;               // Se a palavra estava no dicionário antes da recarga.
+    bool precisaFora;          // Se a decisão depende do peso da palavra nas linhas que não mudaram.
+    bool vistaFora;            // Se a palavra foi encontrada nas linhas que não mudaram.
+} EntradaRecarga;
+
+// Struct auxiliar com a tabela (endereçamento aberto) das palavras das linhas alteradas.
+typedef struct
+{
+    EntradaRecarga *entradas;
+    size_t total, capacidade; // A capacidade é uma potência de 2.
+    bool novo;                // Se as palavras que estão a ser separadas são do conteúdo novo.
+} MapaRecarga;
+
+// Hash de uma palavra para as tabelas da recarga; o 0 fica reservado para os lugares livres.
+static inline uint64_t hashPalavraRecarga(const char *palavra, size_t comprimento)
+{
+    uint64_t hash = hashXXH64(palavra, comprimento, 0);
+    return hash != 0 ? hash : 1;
+}
+
+// Liberta a base da recarga incremental (a cópia do ficheiro e a tabela das palavras repetidas).
+void libertarBaseRecarga(BaseRecarga *base)
+{
+    if (base == NULL)
+        return;
+
+    free(base->dados);
+    free(base->reserva);
+    free(base->repetidas);
+    free(base->textoRepetidas);
+    free(base);
+}
+
+// Procura uma palavra na tabela das repetidas; com 'criar', acrescenta-a (com 0 ocorrências) se não existir.
+// Devolve NULL se a palavra não existir (ou faltar memória para a acrescentar). O hash só escolhe o lugar: duas
+// palavras diferentes com o mesmo hash ficam em entradas diferentes.
+static RepeticaoPalavra *procurarRepeticao(BaseRecarga *base, uint64_t hash, const char *palavra, int comprimento,
+                                           bool criar)
+{
+    // A tabela cresce para o dobro antes de passar de metade da capacidade.
+    if (criar && (base->totalRepetidas + 1) * 2 > base->capacidadeRepetidas)
+    {
+        size_t capacidade = base->capacidadeRepetidas ? base->capacidadeRepetidas * 2 : 64;
+        RepeticaoPalavra *tabela = (RepeticaoPalavra *)calloc(capacidade, sizeof(RepeticaoPalavra));
+        if (tabela == NULL)
+            return NULL;
+
+        for (size_t i = 0; i < base->capacidadeRepetidas; i++)
+        {
+            if (base->repetidas[i].hash == 0)
+                continue;
+            size_t lugar = (size_t)base->repetidas[i].hash & (capacidade - 1);
+            while (tabela[lugar].hash != 0)
+                lugar = (lugar + 1) & (capacidade - 1);
+            tabela[lugar] = base->repetidas[i];
+        }
+
+        free(base->repetidas);
+        base->repetidas = tabela;
+        base->capacidadeRepetidas = capacidade;
+    }
+
+    if (base->capacidadeRepetidas == 0)
+        return NULL;
+
+    size_t lugar = (size_t)hash & (base->capacidadeRepetidas - 1);
+    while (base->repetidas[lugar].hash != 0)
+    {
+        RepeticaoPalavra *repeticao = &base->repetidas[lugar];
+        if (repeticao->hash == hash && repeticao->comprimento == comprimento &&
+            memcmp(base->textoRepetidas + repeticao->posicao, palavra, (size_t)comprimento) == 0)
+            return repeticao;
+        lugar = (lugar + 1) & (base->capacidadeRepetidas - 1);
+    }
+
+    if (!criar)
+        return NULL;
+
+    // A palavra é copiada: as fatias apontam para o conteúdo do ficheiro, que é substituído a cada recarga.
+    if (base->capacidadeTextoRepetidas - base->tamanhoTextoRepetidas < (size_t)comprimento)
+    {
+        size_t capacidade = base->capacidadeTextoRepetidas ? base->capacidadeTextoRepetidas * 2 : 4096;
+        while (capacidade - base->tamanhoTextoRepetidas < (size_t)comprimento)
+            capacidade *= 2;
+        if (capacidade > UINT32_MAX)
+            return NULL;
+        char *maior = (char *)realloc(base->textoRepetidas, capacidade);
+        if (maior == NULL)
+            return NULL;
+        base->textoRepetidas = maior;
+        base->capacidadeTextoRepetidas = capacidade;
+    }
+
+    RepeticaoPalavra *repeticao = &base->repetidas[lugar];
+    repeticao->hash = hash;
+    repeticao->ocorrencias = 0;
+    repeticao->posicao = (uint32_t)base->tamanhoTextoRepetidas;
+    repeticao->comprimento = comprimento;
+    memcpy(base->textoRepetidas + base->tamanhoTextoRepetidas, palavra, (size_t)comprimento);
+    base->tamanhoTextoRepetidas += (size_t)comprimento;
+    base->totalRepetidas++;
+    return repeticao;
+}
+
+// Ordena as palavras, regista na base as que aparecem mais de uma vez e remove as repetidas (fica o maior peso).
+// Devolve falso se faltar memória.
+static bool ordenarContandoRepetidas(FatiaPalavra *palavras, size_t *total, BaseRecarga *base)
+{
+    size_t unicas = 0;
+
+    if (*total == 0)
+        return true;
+
+    qsort(palavras, *total, sizeof(FatiaPalavra), compararFatias);
+
+    for (size_t i = 1, inicioGrupo = 0; i <= *total; i++)
+    {
+        if (i < *total && compararFatias(&palavras[unicas], &palavras[i]) == 0)
+        {
+            if (palavras[i].peso > palavras[unicas].peso)
+                palavras[unicas].peso = palavras[i].peso;
+            continue;
+        }
+
+        // O grupo [inicioGrupo, i) tem a mesma palavra.
+        if (i - inicioGrupo > 1)
+        {
+            uint64_t hash = hashPalavraRecarga(palavras[unicas].inicio, (size_t)palavras[unicas].comprimento);
+            RepeticaoPalavra *repeticao = procurarRepeticao(base, hash, palavras[unicas].inicio,
+                                                            palavras[unicas].comprimento, true);
+            if (repeticao == NULL)
+                return false;
+            repeticao->ocorrencias = (uint32_t)(i - inicioGrupo);
+        }
+
+        if (i < *total)
+            palavras[++unicas] = palavras[i];
+        inicioGrupo = i;
+    }
+
+    *total = unicas + 1;
+    return true;
+}
+
+// Lê o ficheiro inteiro para 'buffer', que cresce se a 'capacidade' não chegar (a vigia não mapeia o ficheiro: um
+// editor pode estar a truncá-lo enquanto é lido). Um buffer reutilizado já tem as páginas, o que evita as faltas de
+// página de uma alocação nova do tamanho do ficheiro.
+static bool lerFicheiroCompleto(const char *nomeFicheiro, unsigned char **buffer, size_t *capacidade, size_t *tamanho)
+{
+    struct stat informacao;
+    size_t lidos = 0;
+
+    *tamanho = 0;
+    int descritor = open(nomeFicheiro, O_RDONLY);
+    if (descritor < 0)
+        return false;
+
+    if (fstat(descritor, &informacao) != 0)
+    {
+        close(descritor);
+        return false;
+    }
+
+    // Mais um byte do que o tamanho, para o fim do ficheiro ser visto sem crescer o buffer.
+    size_t necessario = (size_t)informacao.st_size + 1;
+    for (;;)
+    {
+        // O ficheiro pode crescer enquanto é lido: o buffer cresce para o dobro quando enche.
+        if (lidos == *capacidade || necessario > *capacidade)
+        {
+            size_t nova = necessario > *capacidade * 2 ? necessario : *capacidade * 2;
+            unsigned char *maior = (unsigned char *)realloc(*buffer, nova);
+            if (maior == NULL)
+                break;
+            *buffer = maior;
+            *capacidade = nova;
+        }
+
+        ssize_t bytes = read(descritor, *buffer + lidos, *capacidade - lidos);
+        if (bytes < 0 && errno == EINTR)
+            continue;
+        if (bytes <= 0)
+        {
+            close(descritor);
+            *tamanho = lidos;
+            return bytes == 0;
+        }
+        lidos += (size_t)bytes;
+    }
+
+    close(descritor);
+    return false;
+}
+
+// Quantos bytes iguais têm 'a' e 'b' a partir do início (até 'maximo'), comparando primeiro em blocos de 4 KiB.
+static size_t comprimentoComum(const unsigned char *a, const unsigned char *b, size_t maximo)
+{
+    size_t iguais = 0;
+
+    while (maximo - iguais >= 4096 && memcmp(a + iguais, b + iguais, 4096) == 0)
+        iguais += 4096;
+    while (iguais < maximo && a[iguais] == b[iguais])
+        iguais++;
+    return iguais;
+}
+
+// Quantos bytes iguais têm 'a' e 'b' antes de 'fimA' e 'fimB' (até 'maximo'), do fim para o início.
+static size_t comprimentoComumFinal(const unsigned char *fimA, const unsigned char *fimB, size_t maximo)
+{
+    size_t iguais = 0;
+
+    while (maximo - iguais >= 4096 && memcmp(fimA - iguais - 4096, fimB - iguais - 4096, 4096) == 0)
+        iguais += 4096;
+    while (iguais < maximo && fimA[-(ptrdiff_t)iguais - 1] == fimB[-(ptrdiff_t)iguais - 1])
+        iguais++;
+    return iguais;
+}
+
+// Guarda em 'inicios' o início das (até 'maximo') linhas a partir de 'posicao' e, a seguir, o fim da última.
+// Devolve quantas linhas foram guardadas.
+static size_t recolherLinhas(const unsigned char *dados, size_t tamanho, size_t posicao, size_t *inicios, size_t maximo)
+{
+    size_t total = 0;
+
+    while (total < maximo && posicao < tamanho)
+    {
+        inicios[total++] = posicao;
+        const unsigned char *fimLinha = (const unsigned char *)memchr(dados + posicao, '\n', tamanho - posicao);
+        posicao = fimLinha != NULL ? (size_t)(fimLinha - dados) + 1 : tamanho;
+    }
+
+    inicios[total] = posicao;
+    return total;
+}
+
+// Acrescenta uma região alterada à lista (juntando-a à anterior se forem seguidas). Devolve falso se faltar memória.
+static bool acrescentarRegiao(ListaRegioes *lista, size_t inicioAntigo, size_t fimAntigo, size_t inicioNovo, size_t fimNovo)
+{
+    if (lista->total > 0)
+    {
+        RegiaoAlterada *anterior = &lista->regioes[lista->total - 1];
+        if (anterior->fimAntigo == inicioAntigo && anterior->fimNovo == inicioNovo)
+        {
+            anterior->fimAntigo = fimAntigo;
+            anterior->fimNovo = fimNovo;
+            return true;
+        }
+    }
+
+    if (lista->total == lista->capacidade)
+    {
+        size_t capacidade = lista->capacidade ? lista->capacidade * 2 : 16;
+        RegiaoAlterada *maior = (RegiaoAlterada *)realloc(lista->regioes, capacidade * sizeof(RegiaoAlterada));
+        if (maior == NULL)
+            return false;
+        lista->regioes = maior;
+        lista->capacidade = capacidade;
+    }
+
+    lista->regioes[lista->total++] = (RegiaoAlterada){inicioAntigo, fimAntigo, inicioNovo, fimNovo};
+    return true;
+}
+
+// Compara a cópia antiga com o conteúdo novo e guarda as regiões de linhas que mudaram. Os trechos iguais são
+// saltados com memcmp; em cada diferença, procuram-se nas JANELA_RESSINCRONIZACAO linhas seguintes de cada lado as
+// duas linhas iguais mais próximas, onde os conteúdos voltam a coincidir. Se não houver nenhuma, o resto (até ao
+// maior final comum) forma uma só região. Devolve falso se faltar memória.
+static bool separarRegioesAlteradas(const unsigned char *antigo, size_t tamanhoAntigo, const unsigned char *novo,
+                                    size_t tamanhoNovo, ListaRegioes *lista)
+{
+    size_t linhasAntigas[JANELA_RESSINCRONIZACAO + 1], linhasNovas[JANELA_RESSINCRONIZACAO + 1];
+    size_t i = 0, j = 0;
+
+    while (i < tamanhoAntigo || j < tamanhoNovo)
+    {
+        size_t restoAntigo = tamanhoAntigo - i, restoNovo = tamanhoNovo - j;
+        size_t iguais = comprimentoComum(antigo + i, novo + j, restoAntigo < restoNovo ? restoAntigo : restoNovo);
+        i += iguais;
+        j += iguais;
+        if (i == tamanhoAntigo && j == tamanhoNovo)
+            break;
+
+        // Recuar até ao início da linha onde está a diferença (os bytes anteriores são iguais dos dois lados).
+        while (i > 0 && antigo[i - 1] != '\n')
+        {
+            i--;
+            j--;
+        }
+
+        size_t totalAntigas = recolherLinhas(antigo, tamanhoAntigo, i, linhasAntigas, JANELA_RESSINCRONIZACAO);
+        size_t totalNovas = recolherLinhas(novo, tamanhoNovo, j, linhasNovas, JANELA_RESSINCRONIZACAO);
+
+        // Um dos lados acabou: o que resta do outro é a última região.
+        if (totalAntigas == 0 || totalNovas == 0)
+            return acrescentarRegiao(lista, i, tamanhoAntigo, j, tamanhoNovo);
+
+        // Procurar o par de linhas iguais (a, b) com a + b mínimo; a primeira linha de cada lado é a que difere.
+        bool encontrado = false;
+        size_t a = 0, b = 0;
+        for (size_t soma = 1; soma <= totalAntigas + totalNovas - 2 && !encontrado; soma++)
+        {
+            size_t primeiro = soma > totalNovas - 1 ? soma - (totalNovas - 1) : 0;
+            size_t ultimo = soma < totalAntigas - 1 ? soma : totalAntigas - 1;
+            for (a = primeiro; a <= ultimo; a++)
+            {
+                b = soma - a;
+                size_t comprimento = linhasAntigas[a + 1] - linhasAntigas[a];
+                if (comprimento == linhasNovas[b + 1] - linhasNovas[b] &&
+                    memcmp(antigo + linhasAntigas[a], novo + linhasNovas[b], comprimento) == 0)
+                {
+                    encontrado = true;
+                    break;
+                }
+            }
+        }
+
+        if (encontrado)
+        {
+            if (!acrescentarRegiao(lista, i, linhasAntigas[a], j, linhasNovas[b]))
+                return false;
+            i = linhasAntigas[a];
+            j = linhasNovas[b];
+            continue;
+        }
+
+        // Sem ponto de encontro na janela: a região vai até ao maior final comum, acabado num fim de linha.
+        restoAntigo = tamanhoAntigo - i;
+        restoNovo = tamanhoNovo - j;
+        size_t final = comprimentoComumFinal(antigo + tamanhoAntigo, novo + tamanhoNovo,
+                                             restoAntigo < restoNovo ? restoAntigo : restoNovo);
+        size_t fimAntigo = tamanhoAntigo - final, fimNovo = tamanhoNovo - final;
+        if (final > 0 && !((fimAntigo == i || antigo[fimAntigo - 1] == '\n') && (fimNovo == j || novo[fimNovo - 1] == '\n')))
+        {
+            // O final comum começa a meio de uma linha: passa a começar depois do seu primeiro fim de linha.
+            const unsigned char *fimLinha = (const unsigned char *)memchr(antigo + fimAntigo, '\n', final);
+            size_t avanco = fimLinha != NULL ? (size_t)(fimLinha - (antigo + fimAntigo)) + 1 : final;
+            fimAntigo += avanco;
+            fimNovo += avanco;
+        }
+        return acrescentarRegiao(lista, i, fimAntigo, j, fimNovo);
+    }
+
+    return true;
+}
+
+// Procura uma palavra na tabela da recarga; com 'criar', acrescenta-a se não existir (NULL se faltar memória). Como
+// na tabela das repetidas, as palavras são comparadas depois do hash.
+static EntradaRecarga *procurarEntradaRecarga(MapaRecarga *mapa, const char *palavra, int comprimento, bool criar)
+{
+    uint64_t hash = hashPalavraRecarga(palavra, (size_t)comprimento);
+
+    if (criar && (mapa->total + 1) * 2 > mapa->capacidade)
+    {
+        size_t capacidade = mapa->capacidade ? mapa->capacidade * 2 : 256;
+        EntradaRecarga *tabela = (EntradaRecarga *)calloc(capacidade, sizeof(EntradaRecarga));
+        if (tabela == NULL)
+            return NULL;
+
+        for (size_t i = 0; i < mapa->capacidade; i++)
+        {
+            if (mapa->entradas[i].hash == 0)
+                continue;
+            size_t lugar = (size_t)mapa->entradas[i].hash & (capacidade - 1);
+            while (tabela[lugar].hash != 0)
+                lugar = (lugar + 1) & (capacidade - 1);
+            tabela[lugar] = mapa->entradas[i];
+        }
+
+        free(mapa->entradas);
+        mapa->entradas = tabela;
+        mapa->capacidade = capacidade;
+    }
+
+    if (mapa->capacidade == 0)
+        return NULL;
+
+    size_t lugar = (size_t)hash & (mapa->capacidade - 1);
+    while (mapa->entradas[lugar].hash != 0)
+    {
+        EntradaRecarga *entrada = &mapa->entradas[lugar];
+        if (entrada->hash == hash && entrada->comprimento == comprimento &&
+            memcmp(entrada->palavra, palavra, (size_t)comprimento) == 0)
+            return entrada;
+        lugar = (lugar + 1) & (mapa->capacidade - 1);
+    }
+
+    if (!criar)
+        return NULL;
+
+    // A primeira ocorrência (na cópia antiga ou no conteúdo novo) fica a representar a palavra.
+    mapa->entradas[lugar].hash = hash;
+    mapa->entradas[lugar].palavra = palavra;
+    mapa->entradas[lugar].comprimento = comprimento;
+    mapa->total++;
+    return &mapa->entradas[lugar];
+}
+
+// Conta uma palavra das linhas alteradas, do lado antigo ou do novo (visitante de separarPalavrasTexto).
+static bool contarPalavraRecarga(const FatiaPalavra *fatia, void *contexto)
+{
+    MapaRecarga *mapa = (MapaRecarga *)contexto;
+    EntradaRecarga *entrada = procurarEntradaRecarga(mapa, fatia->inicio, fatia->comprimento, true);
+
+    if (entrada == NULL)
+        return false;
+
+    if (mapa->novo)
+    {
+        entrada->contagemNova++;
+        if (fatia->peso > entrada->pesoNovo)
+            entrada->pesoNovo = fatia->peso;
+    }
+    else
+    {
+        entrada->contagemAntiga++;
+        if (fatia->peso > entrada->pesoAntigo)
+            entrada->pesoAntigo = fatia->peso;
+    }
+    return true;
+}
+
+// Regista o peso de uma palavra das linhas que não mudaram, se a decisão sobre ela depender disso.
+static bool procurarPalavraFora(const FatiaPalavra *fatia, void *contexto)
+{
+    MapaRecarga *mapa = (MapaRecarga *)contexto;
+    EntradaRecarga *entrada = procurarEntradaRecarga(mapa, fatia->inicio, fatia->comprimento, false);
+
+    if (entrada != NULL && entrada->precisaFora)
+    {
+        entrada->vistaFora = true;
+        if (fatia->peso > entrada->pesoFora)
+            entrada->pesoFora = fatia->peso;
+    }
+    return true;
+}
+
+// Copia a palavra de uma fatia para 'palavra', terminada em '\0'.
+static inline void copiarFatia(char *palavra, const char *inicio, int comprimento)
+{
+    memcpy(palavra, inicio, (size_t)comprimento);
+    palavra[comprimento] = '\0';
+}
+
+// Aplica ao dicionário só as palavras das linhas que mudaram. Para cada palavra, a quantidade de ocorrências fora
+// das regiões vem da tabela das repetidas (uma palavra sem entrada aparece uma vez, se estiver no dicionário); só
+// quando o peso final depende das linhas que não mudaram é que elas são percorridas. Devolve falso se faltar memória.
+static bool aplicarRegioesAlteradas(Dicionario *dicionario, BaseRecarga *base, const unsigned char *novo,
+                                    size_t tamanhoNovo, const ListaRegioes *lista, ResultadoRecarga *resultado)
+{
+    MapaRecarga mapa = {NULL, 0, 0, false};
+    char palavra[MAX_TAMANHO_PALAVRA];
+    bool precisaFora = false;
+
+    for (size_t r = 0; r < lista->total; r++)
+    {
+        const RegiaoAlterada *regiao = &lista->regioes[r];
+        resultado->bytesComparados += (regiao->fimAntigo - regiao->inicioAntigo) + (regiao->fimNovo - regiao->inicioNovo);
+
+        mapa.novo = false;
+        if (!separarPalavrasTexto(base->dados, regiao->inicioAntigo, regiao->fimAntigo, NULL, NULL, contarPalavraRecarga, &mapa))
+        {
+            free(mapa.entradas);
+            return false;
+        }
+        mapa.novo = true;
+        if (!separarPalavrasTexto(novo, regiao->inicioNovo, regiao->fimNovo, NULL, NULL, contarPalavraRecarga, &mapa))
+        {
+            free(mapa.entradas);
+            return false;
+        }
+    }
+
+    // Primeira passagem: estado de cada palavra no dicionário e quantas vezes aparece nas linhas que não mudaram.
+    for (size_t i = 0; i < mapa.capacidade; i++)
+    {
+        EntradaRecarga *entrada = &mapa.entradas[i];
+        if (entrada->hash == 0)
+            continue;
+
+        copiarFatia(palavra, entrada->palavra, entrada->comprimento);
+        entrada->existe = pesoPalavra(dicionario, palavra, &entrada->pesoAtual);
+
+        RepeticaoPalavra *repeticao = procurarRepeticao(base, entrada->hash, entrada->palavra, entrada->comprimento, false);
+        uint32_t ocorrencias = repeticao != NULL ? repeticao->ocorrencias
+                               : entrada->contagemAntiga > 0 ? entrada->contagemAntiga : entrada->existe ? 1 : 0;
+        entrada->contagemFora = ocorrencias > entrada->contagemAntiga ? ocorrencias - entrada->contagemAntiga : 0;
+
+        // O peso atual é o maior entre o das linhas antigas e o de fora; se as linhas antigas podem ter dado o maior
+        // (e ele não é 0) e o novo peso não o iguala, o peso de fora tem de ser lido.
+        entrada->precisaFora = entrada->contagemFora > 0 &&
+                               (!entrada->existe ||
+                                (entrada->pesoAtual > 0 && entrada->contagemAntiga > 0 &&
+                                 entrada->pesoAntigo >= entrada->pesoAtual &&
+                                 (entrada->contagemNova == 0 || entrada->pesoNovo < entrada->pesoAtual)));
+        precisaFora = precisaFora || entrada->precisaFora;
+    }
+
+    // Só se alguma decisão depender delas é que as linhas que não mudaram são percorridas.
+    if (precisaFora)
+    {
+        size_t inicio = 0;
+        for (size_t r = 0; r <= lista->total; r++)
+        {
+            size_t fim = r < lista->total ? lista->regioes[r].inicioNovo : tamanhoNovo;
+            if (fim > inicio)
+                separarPalavrasTexto(novo, inicio, fim, NULL, NULL, procurarPalavraFora, &mapa);
+            if (r < lista->total)
+                inicio = lista->regioes[r].fimNovo;
+        }
+    }
+
+    // Segunda passagem: aplicar as palavras que entraram, saíram ou mudaram de peso.
+    for (size_t i = 0; i < mapa.capacidade; i++)
+    {
+        EntradaRecarga *entrada = &mapa.entradas[i];
+        if (entrada->hash == 0)
+            continue;
+
+        // A tabela das repetidas pode estar desatualizada (palavras alteradas à mão): quem não foi visto não está fora.
+        if (entrada->precisaFora && !entrada->vistaFora)
         {
-            raiz->centro = removerPalavraRecursivo(raiz->centro, palavra, indice + 1); // Vá para o próximo caractere.
+            entrada->precisaFora = false;
+            entrada->contagemFora = 0;
+        }
+
+        uint32_t ocorrencias = entrada->contagemFora + entrada->contagemNova;
+        copiarFatia(palavra, entrada->palavra, entrada->comprimento);
+
+        if (ocorrencias == 0)
+        {
+            if (entrada->existe)
+            {
+                aplicarAlteracaoRegistadaComTrinco(dicionario, DIARIO_REMOVER, palavra, NULL, 0);
+                resultado->removidas++;
+            }
         }
         else
         {
-            // Chegamos ao fim da palavra. Marcar o fim da palavra como false.
-            raiz->fim_palavra = false;
+            uint32_t peso;
+            if (entrada->precisaFora)
+                peso = entrada->pesoNovo > entrada->pesoFora ? entrada->pesoNovo : entrada->pesoFora;
+            else if (entrada->contagemFora == 0)
+                peso = entrada->pesoNovo;
+            else
+                peso = entrada->pesoNovo > entrada->pesoAtual ? entrada->pesoNovo : entrada->pesoAtual;
+
+            if (!entrada->existe || peso != entrada->pesoAtual)
+            {
+                aplicarAlteracaoRegistadaComTrinco(dicionario, DIARIO_INSERIR_COM_PESO, palavra, NULL, peso);
+                if (entrada->existe)
+                    resultado->pesosAlterados++;
+                else
+                    resultado->inseridas++;
+            }
+        }
+
+        RepeticaoPalavra *repeticao = procurarRepeticao(base, entrada->hash, entrada->palavra, entrada->comprimento,
+                                                        ocorrencias > 1);
+        if (repeticao != NULL)
+            repeticao->ocorrencias = ocorrencias;
+    }
+
+    free(mapa.entradas);
+    return true;
+}
+
+// Compara o ficheiro inteiro (palavras ordenadas e sem repetições) com as palavras do dicionário, percorridas por
+// ordem com um cursor, e aplica as diferenças. Devolve falso se faltar memória.
+static bool aplicarFicheiroCompleto(Dicionario *dicionario, FatiaPalavra *palavras, size_t total,
+                                    ResultadoRecarga *resultado)
+{
+    CursorDicionario cursor;
+    char *removidas = NULL;
+    size_t tamanhoRemovidas = 0, capacidadeRemovidas = 0, i = 0;
+
+    // Marca as palavras do ficheiro que já estão no dicionário (as outras têm de ser inseridas).
+    bool *existentes = (bool *)calloc(total > 0 ? total : 1, sizeof(bool));
+    if (existentes == NULL || !abrirCursor(&cursor, dicionario, ""))
+    {
+        free(existentes);
+        return false;
+    }
+
+    // As alterações só são feitas depois de fechar o cursor; as palavras a remover são copiadas, separadas por '\0'.
+    bool sucesso = true;
+    while (sucesso && avancarCursor(&cursor))
+    {
+        FatiaPalavra atual = {cursor.palavra, (int)strlen(cursor.palavra), 0};
+        int comparacao = 1;
+        while (i < total && (comparacao = compararFatias(&palavras[i], &atual)) < 0)
+            i++;
+
+        if (i < total && comparacao == 0)
+        {
+            existentes[i++] = true;
+            continue;
+        }
+
+        if (tamanhoRemovidas + (size_t)atual.comprimento + 1 > capacidadeRemovidas)
+        {
+            size_t capacidade = capacidadeRemovidas ? capacidadeRemovidas * 2 : 4096;
+            char *maior = (char *)realloc(removidas, capacidade);
+            sucesso = maior != NULL;
+            if (!sucesso)
+                break;
+            removidas = maior;
+            capacidadeRemovidas = capacidade;
+        }
+        memcpy(removidas + tamanhoRemovidas, cursor.palavra, (size_t)atual.comprimento + 1);
+        tamanhoRemovidas += (size_t)atual.comprimento + 1;
+    }
+    sucesso = sucesso && !cursor.falhou;
+    fecharCursor(&cursor);
+
+    if (sucesso)
+    {
+        for (size_t posicao = 0; posicao < tamanhoRemovidas; posicao += strlen(removidas + posicao) + 1)
+        {
+            aplicarAlteracaoRegistadaComTrinco(dicionario, DIARIO_REMOVER, removidas + posicao, NULL, 0);
+            resultado->removidas++;
+        }
+
+        char palavra[MAX_TAMANHO_PALAVRA];
+        for (i = 0; i < total; i++)
+        {
+            uint32_t peso = 0;
+            copiarFatia(palavra, palavras[i].inicio, palavras[i].comprimento);
+            if (existentes[i] && pesoPalavra(dicionario, palavra, &peso) && peso == palavras[i].peso)
+                continue;
+
+            aplicarAlteracaoRegistadaComTrinco(dicionario, DIARIO_INSERIR_COM_PESO, palavra, NULL, palavras[i].peso);
+            if (existentes[i])
+                resultado->pesosAlterados++;
+            else
+                resultado->inseridas++;
+        }
+    }
+
+    free(removidas);
+    free(existentes);
+    return sucesso;
+}
+
+// Cria a base da recarga a partir do conteúdo do ficheiro (que passa a pertencer-lhe) e, com 'aplicar', compara o
+// ficheiro inteiro com o dicionário. Devolve NULL se faltar memória.
+static BaseRecarga *criarBaseRecarga(Dicionario *dicionario, unsigned char *dados, size_t tamanho,
+                                     size_t capacidade, bool aplicar, ResultadoRecarga *resultado)
+{
+    ListaFatias lista = {NULL, 0, 0};
+    BaseRecarga *base = (BaseRecarga *)calloc(1, sizeof(BaseRecarga));
+
+    if (base == NULL)
+        return NULL;
+    base->dados = dados;
+    base->tamanho = tamanho;
+    base->capacidade = capacidade;
+
+    // Todas as palavras são separadas e ordenadas, para contar as repetidas e comparar com o dicionário.
+    bool sucesso = separarPalavrasTexto(dados, 0, tamanho, NULL, NULL, acrescentarFatia, &lista) &&
+                   ordenarContandoRepetidas(lista.palavras, &lista.total, base) &&
+                   (!aplicar || aplicarFicheiroCompleto(dicionario, lista.palavras, lista.total, resultado));
+    free(lista.palavras);
+
+    if (!sucesso)
+    {
+        base->dados = NULL;
+        libertarBaseRecarga(base);
+        return NULL;
+    }
+
+    resultado->bytesComparados = aplicar ? tamanho : 0;
+    return base;
+}
+
+// Recarrega o ficheiro: o manifesto novo é comparado com o guardado (como em verificarIntegridadeFicheiro) e, se
+// mudou, as diferenças são aplicadas a partir da cópia da recarga anterior, ou do ficheiro inteiro se não houver.
+bool recarregarFicheiro(Dicionario *dicionario, const char *nomeFicheiro, ResultadoRecarga *resultado)
+{
+    ControloConcorrencia *controlo = dicionario->concorrencia;
+    unsigned char *dados = NULL;
+    size_t tamanho, capacidade = 0;
+    ManifestoFicheiro *manifesto;
+    double inicio = agoraNanossegundos();
+
+    memset(resultado, 0, sizeof(ResultadoRecarga));
+
+    // O ficheiro é lido para a memória da cópia anterior, se houver (no modo concorrente, com o trinco dos escritores,
+    // porque a base pertence a quem estiver a recarregar).
+    if (controlo != NULL)
+        pthread_mutex_lock(&controlo->trincoEscrita);
+    if (dicionario->base != NULL)
+    {
+        dados = dicionario->base->reserva;
+        capacidade = dicionario->base->capacidadeReserva;
+        dicionario->base->reserva = NULL;
+        dicionario->base->capacidadeReserva = 0;
+    }
+    if (controlo != NULL)
+        pthread_mutex_unlock(&controlo->trincoEscrita);
+
+    manifesto = (ManifestoFicheiro *)malloc(sizeof(ManifestoFicheiro));
+    if (manifesto == NULL || !lerFicheiroCompleto(nomeFicheiro, &dados, &capacidade, &tamanho) ||
+        !gerarManifesto(manifesto, dados, tamanho))
+    {
+        free(manifesto);
+        free(dados);
+        return false;
+    }
+
+    // As diferenças são registadas no diário, se estiver aberto: sem elas, a repetição do diário no próximo arranque
+    // voltaria a pôr as palavras que a recarga removeu. O trinco do diário vem antes do dos escritores, como nas
+    // alterações registadas. No modo concorrente, a recarga é uma sequência de escritas: os outros escritores
+    // esperam, os leitores não.
+    DiarioAlteracoes *diario = dicionario->diario;
+    if (diario != NULL)
+        pthread_mutex_lock(&diario->trinco);
+    if (controlo != NULL)
+        pthread_mutex_lock(&controlo->trincoEscrita);
+
+    BaseRecarga *base = dicionario->base;
+    bool sucesso = true, baseValida = base != NULL && dicionario->manifesto != NULL &&
+                                      base->raizManifesto == dicionario->manifesto->raiz;
+    resultado->alterado = dicionario->manifesto == NULL ||
+                          compararManifestos(dicionario->manifesto, manifesto, NULL, 0) > 0;
+
+    if (!resultado->alterado && baseValida)
+    {
+        // Nada mudou: a memória lida volta a ser a reserva.
+        libertarManifesto(manifesto);
+        free(manifesto);
+        manifesto = NULL;
+        free(base->reserva);
+        base->reserva = dados;
+        base->capacidadeReserva = capacidade;
+    }
+    else if (resultado->alterado && baseValida)
+    {
+        ListaRegioes lista = {NULL, 0, 0};
+
+        resultado->incremental = true;
+        sucesso = separarRegioesAlteradas(base->dados, base->tamanho, dados, tamanho, &lista) &&
+                  aplicarRegioesAlteradas(dicionario, base, dados, tamanho, &lista, resultado);
+        free(lista.regioes);
+
+        // O conteúdo novo passa a ser a cópia com que a próxima recarga é comparada; a antiga fica de reserva.
+        if (sucesso)
+        {
+            free(base->reserva);
+            base->reserva = base->dados;
+            base->capacidadeReserva = base->capacidade;
+            base->dados = dados;
+            base->tamanho = tamanho;
+            base->capacidade = capacidade;
+        }
+    }
+    else
+    {
+        // Sem cópia (ou com uma cópia de outro conteúdo), o ficheiro inteiro é comparado se tiver mudado.
+        BaseRecarga *nova = criarBaseRecarga(dicionario, dados, tamanho, capacidade, resultado->alterado, resultado);
+        sucesso = nova != NULL;
+        if (sucesso)
+        {
+            libertarBaseRecarga(dicionario->base);
+            dicionario->base = nova;
         }
     }
 
-    // Se o nó atual está vazio e não é o fim de uma palavra, podemos removê-lo.
-    if (noEstaVazio(raiz) && !raiz->fim_palavra)
+    if (!sucesso)
+    {
+        // Uma recarga interrompida pode ter aplicado parte das diferenças: a próxima compara o ficheiro inteiro.
+        libertarBaseRecarga(dicionario->base);
+        dicionario->base = NULL;
+        libertarManifesto(manifesto);
+        free(manifesto);
+        free(dados);
+    }
+    else if (manifesto != NULL)
     {
-        free(raiz);
-        printf("[Palavra removida com sucesso!].\n");
-        printf("[Como a palavra já foi removida, portanto, ela já não está na TRIE TST criada!].");
-        raiz = NULL;
+        dicionario->base->raizManifesto = manifesto->raiz;
+        substituirManifesto(dicionario, manifesto);
     }
 
-    return raiz;
+    if (controlo != NULL)
+        pthread_mutex_unlock(&controlo->trincoEscrita);
+    if (diario != NULL)
+    {
+        pthread_mutex_unlock(&diario->trinco);
+        compactarDiarioSePedido(dicionario);
+    }
+
+    resultado->segundos = (agoraNanossegundos() - inicio) / 1e9;
+    return sucesso;
 }
 
-// Função para remover uma palavra do dicionário.
-void removerPalavra(Dicionario *dicionario, const char *palavra)
+// *********************************** VIGIA DO FICHEIRO (INOTIFY) ***********************************
+
+// Lê os eventos pendentes e indica se algum é do ficheiro vigiado (gravado ou substituído por outro com o seu nome).
+static bool lerEventosVigia(VigiaFicheiro *vigia)
 {
-    // Verificar se a palavra é válida.
-    if (palavra == NULL || strlen(palavra) == 0)
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool relevante = false;
+    ssize_t bytes;
+
+    while ((bytes = read(vigia->inotify, buffer, sizeof(buffer))) > 0)
     {
-        printf("Palavra inválida.\n");
-        return;
+        for (char *posicao = buffer; posicao < buffer + bytes;)
+        {
+            const struct inotify_event *evento = (const struct inotify_event *)posicao;
+            if (evento->len > 0 && strcmp(evento->name, vigia->nomeBase) == 0)
+                relevante = true;
+            posicao += sizeof(struct inotify_event) + evento->len;
+        }
     }
 
-    // Chamar a função auxiliar removerPalavraRecursivo para remover a palavra da árvore.
-    dicionario->raiz = removerPalavraRecursivo(dicionario->raiz, palavra, 0);
+    return relevante;
 }
 
-// *********************************** ACTUALIZAÇÃO ***********************************
-
-// Função para atualizar uma palavra existente no dicionário.
-void atualizarPalavra(Dicionario *dicionario, const char *palavraAntiga, const char *palavraNova)
+// Thread da vigia: espera pelos eventos da pasta e, depois de ESPERA_VIGIA_MS sem eventos novos (um editor pode
+// gravar em várias escritas), recarrega o ficheiro.
+static void *vigiarFicheiro(void *argumento)
 {
-    // Verificar se as palavras são válidas.
-    if (palavraAntiga == NULL || strlen(palavraAntiga) == 0 || palavraNova == NULL || strlen(palavraNova) == 0)
+    Dicionario *dicionario = (Dicionario *)argumento;
+    VigiaFicheiro *vigia = dicionario->vigia;
+    struct pollfd descritores[2] = {{vigia->inotify, POLLIN, 0}, {vigia->paragem[0], POLLIN, 0}};
+
+    for (;;)
     {
-        printf("Palavra inválida.\n");
-        return;
-    }
+        int prontos = poll(descritores, 2, -1);
+        if (prontos < 0 && errno == EINTR)
+            continue;
+        if (prontos < 0 || descritores[1].revents != 0)
+            break;
+        if (!lerEventosVigia(vigia))
+            continue;
+
+        while ((prontos = poll(descritores, 2, ESPERA_VIGIA_MS)) > 0 && descritores[1].revents == 0)
+            lerEventosVigia(vigia);
+        if (prontos > 0)
+            break;
+
+        ResultadoRecarga resultado;
+        bool sucesso = recarregarFicheiro(dicionario, vigia->nomeFicheiro, &resultado);
+
+        pthread_mutex_lock(&vigia->trinco);
+        if (sucesso)
+        {
+            vigia->ultima = resultado;
+            vigia->recargas++;
+        }
+        else
+            vigia->falhas++;
+        pthread_mutex_unlock(&vigia->trinco);
 
-    // Remover a palavra antiga do dicionário.
-    removerPalavra(dicionario, palavraAntiga);
+        if (sucesso && resultado.alterado)
+            printf("\n[%s recarregado: %zu inseridas, %zu removidas, %zu pesos alterados em %.2f ms]\n",
+                   vigia->nomeFicheiro, resultado.inseridas, resultado.removidas, resultado.pesosAlterados,
+                   resultado.segundos * 1e3);
+    }
 
-    // Inserir a nova palavra no dicionário.
-    inserirPalavra(dicionario, palavraNova);
+    return NULL;
 }
 
-// *********************************** IMPRESSÃO DE TODAS AS PALAVRAS COM O MESMO PREFIXO DE ENTRADA ***********************************
-
-// Função auxiliar para imprimir todas as palavras na TST que começam com o prefixo fornecido.
-void palavrasComPrefixoAuxiliar(NoTST *no, char *buffer, int profundidade)
+// Liga a vigia: o modo concorrente é ligado (a thread da vigia escreve enquanto as outras consultam), a primeira
+// recarga guarda a cópia do ficheiro e a pasta do ficheiro passa a ser vigiada (os editores que gravam num ficheiro
+// temporário e lhe mudam o nome substituem o ficheiro, e uma vigia do próprio ficheiro deixaria de os ver).
+bool ligarVigiaFicheiro(Dicionario *dicionario, const char *nomeFicheiro)
 {
-    if (no == NULL)
-        return;
+    char pasta[FILENAME_MAX];
+    ResultadoRecarga resultado;
 
-    // Armazenar o caractere neste nó.
-    buffer[profundidade] = no->caractere;
+    if (dicionario->vigia != NULL)
+        return true;
+    if (strlen(nomeFicheiro) >= FILENAME_MAX || !ligarModoConcorrente(dicionario) ||
+        !recarregarFicheiro(dicionario, nomeFicheiro, &resultado))
+        return false;
 
-    // Se o nó atual marca o fim de uma palavra, imprimi-la.
-    if (no->fim_palavra)
+    VigiaFicheiro *vigia = (VigiaFicheiro *)calloc(1, sizeof(VigiaFicheiro));
+    if (vigia == NULL)
+        return false;
+
+    strcpy(vigia->nomeFicheiro, nomeFicheiro);
+    const char *barra = strrchr(vigia->nomeFicheiro, '/');
+    vigia->nomeBase = barra != NULL ? barra + 1 : vigia->nomeFicheiro;
+    if (barra == NULL)
+        strcpy(pasta, ".");
+    else if (barra == vigia->nomeFicheiro)
+        strcpy(pasta, "/");
+    else
+        snprintf(pasta, sizeof(pasta), "%.*s", (int)(barra - vigia->nomeFicheiro), vigia->nomeFicheiro);
+
+    vigia->inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    vigia->paragem[0] = vigia->paragem[1] = -1;
+    if (vigia->inotify < 0 || inotify_add_watch(vigia->inotify, pasta, IN_CLOSE_WRITE | IN_MOVED_TO) < 0 ||
+        pipe(vigia->paragem) != 0)
     {
-        buffer[profundidade + 1] = '\0';
-        printf("%s\n", buffer);
+        if (vigia->inotify >= 0)
+            close(vigia->inotify);
+        free(vigia);
+        return false;
     }
 
-    // Percorrer os nós filhos.
-    palavrasComPrefixoAuxiliar(no->esquerda, buffer, profundidade + 1);
-    palavrasComPrefixoAuxiliar(no->centro, buffer, profundidade + 1);
-    palavrasComPrefixoAuxiliar(no->direito, buffer, profundidade + 1);
+    pthread_mutex_init(&vigia->trinco, NULL);
+    vigia->ultima = resultado;
+    dicionario->vigia = vigia;
+
+    if (pthread_create(&vigia->thread, NULL, vigiarFicheiro, dicionario) != 0)
+    {
+        dicionario->vigia = NULL;
+        pthread_mutex_destroy(&vigia->trinco);
+        close(vigia->paragem[0]);
+        close(vigia->paragem[1]);
+        close(vigia->inotify);
+        free(vigia);
+        return false;
+    }
+    return true;
 }
 
-// Função para imprimir todas as palavras no dicionário que começam com o prefixo fornecido.
-void palavrasComPrefixo(Dicionario *dicionario, const char *prefixo)
+// Desliga a vigia: acorda a thread pelo canal de paragem e espera que ela termine.
+void desligarVigiaFicheiro(Dicionario *dicionario)
 {
-    int i;
+    VigiaFicheiro *vigia = dicionario->vigia;
 
-    // Verificar se o prefixo é válido.
-    if (prefixo == NULL || strlen(prefixo) == 0)
-    {
-        printf("Prefixo inválido.\n");
+    if (vigia == NULL)
         return;
-    }
 
-    // Buffer para armazenar a palavra enquanto a trie é percorrida.
-    char buffer[MAX_TAMANHO_PALAVRA];
+    while (write(vigia->paragem[1], "", 1) < 0 && errno == EINTR)
+        ;
+    pthread_join(vigia->thread, NULL);
 
-    // Nó atual para percorrer a trie.
-    NoTST *noAtual = dicionario->raiz;
+    dicionario->vigia = NULL;
+    pthread_mutex_destroy(&vigia->trinco);
+    close(vigia->paragem[0]);
+    close(vigia->paragem[1]);
+    close(vigia->inotify);
+    free(vigia);
+}
 
-    // Procurar o nó que corresponde ao último caractere do prefixo.
-    for (i = 0; i < (int)strlen(prefixo); i++)
-    {
-        while (noAtual != NULL)
-        {
-            if (prefixo[i] < noAtual->caractere)
-                noAtual = noAtual->esquerda;
-            else if (prefixo[i] > noAtual->caractere)
-                noAtual = noAtual->direito;
-            else
-            {
-                // Se este for o último caractere do prefixo, chamar a função auxiliar.
-                if (i == (int)strlen(prefixo) - 1)
-                    palavrasComPrefixoAuxiliar(noAtual->centro, buffer, 0);
-                else
-                    noAtual = noAtual->centro;
-                break;
-            }
-        }
-    }
+// Copia o estado da vigia (o resultado da última recarga e os contadores).
+bool consultarVigiaFicheiro(const Dicionario *dicionario, ResultadoRecarga *ultima, size_t *recargas, size_t *falhas)
+{
+    VigiaFicheiro *vigia = dicionario->vigia;
+
+    if (vigia == NULL)
+        return false;
+
+    pthread_mutex_lock(&vigia->trinco);
+    *ultima = vigia->ultima;
+    *recargas = vigia->recargas;
+    *falhas = vigia->falhas;
+    pthread_mutex_unlock(&vigia->trinco);
+    return true;
 }
 
-// *********************************** IMPRESSÃO DA PALAVRA COM O PREFIXO MAIS LONGO ***********************************
+// *********************************** DIÁRIO DE ALTERAÇÕES ***********************************
 
-// Função para retornar o prefixo mais longo de uma palavra que existe no dicionário.
-char *prefixoMaisLongo(Dicionario *dicionario, const char *palavra)
+// Struct auxiliar com uma entrada lida do diário (as palavras apontam para dentro do conteúdo lido, sem '\0').
+typedef struct
+{
+    EntradaDiario cabecalho;
+    const char *palavra;
+    const char *palavraNova;
+    size_t tamanho; // Bytes ocupados pela entrada no ficheiro.
+} EntradaLidaDiario;
+
+// Struct auxiliar com o efeito acumulado das alterações a uma palavra durante a compactação (palavra NULL marca um
+// lugar livre da tabela).
+typedef struct
 {
+    const char *palavra;
+    uint8_t comprimento;
+    uint8_t tipo;        // DIARIO_INSERIR, DIARIO_INSERIR_COM_PESO ou DIARIO_REMOVER.
+    bool escrita;        // Se a entrada que resume a palavra já foi escrita no diário novo.
+    uint32_t peso;
+    uint64_t sequencia;  // Última entrada que alterou a palavra (é a sequência da entrada que a resume).
+} EfeitoPalavra;
+
+// Calcula a verificação de uma entrada: 32 bits do XXH64 do cabeçalho (com a verificação a 0) e das palavras.
+static uint32_t verificacaoEntradaDiario(const EntradaDiario *cabecalho, const char *palavras, size_t comprimento)
+{
+    unsigned char entrada[sizeof(EntradaDiario) + 2 * MAX_TAMANHO_PALAVRA];
+    EntradaDiario copia = *cabecalho;
 
-    int i;
+    copia.verificacao = 0;
+    memcpy(entrada, &copia, sizeof(copia));
+    memcpy(entrada + sizeof(copia), palavras, comprimento);
+    return (uint32_t)hashXXH64(entrada, sizeof(copia) + comprimento, 0);
+}
 
-    if (palavra == NULL || strlen(palavra) == 0)
-    {
-        printf("Palavra inválida.\n");
-        return NULL;
-    }
+// Lê a entrada que começa em 'posicao'. Devolve falso se ela estiver incompleta ou corrompida (o diário válido acaba
+// aí: é o que fica de uma escrita interrompida).
+static bool lerEntradaDiario(const unsigned char *dados, size_t tamanho, size_t posicao, EntradaLidaDiario *entrada)
+{
+    const EntradaDiario *cabecalho = &entrada->cabecalho;
 
-    // Buffer para armazenar o prefixo enquanto a trie é percorrida.
-    char buffer[MAX_TAMANHO_PALAVRA];
-    int comprimento = 0;
+    if (tamanho - posicao < sizeof(EntradaDiario))
+        return false;
+    memcpy(&entrada->cabecalho, dados + posicao, sizeof(EntradaDiario));
+
+    size_t comprimento = (size_t)cabecalho->comprimento + cabecalho->comprimentoNovo;
+    if (cabecalho->sequencia == 0 || cabecalho->tipo < DIARIO_INSERIR || cabecalho->tipo > DIARIO_ATUALIZAR ||
+        cabecalho->comprimento == 0 || cabecalho->comprimento >= MAX_TAMANHO_PALAVRA ||
+        cabecalho->comprimentoNovo >= MAX_TAMANHO_PALAVRA ||
+        (cabecalho->tipo == DIARIO_ATUALIZAR) != (cabecalho->comprimentoNovo != 0) ||
+        tamanho - posicao - sizeof(EntradaDiario) < comprimento)
+        return false;
+
+    entrada->palavra = (const char *)dados + posicao + sizeof(EntradaDiario);
+    entrada->palavraNova = entrada->palavra + cabecalho->comprimento;
+    entrada->tamanho = sizeof(EntradaDiario) + comprimento;
+    return verificacaoEntradaDiario(cabecalho, entrada->palavra, comprimento) == cabecalho->verificacao;
+}
 
-    // Nó atual para percorrer a trie.
-    NoTST *noAtual = dicionario->raiz;
+// Acrescenta uma entrada a um buffer que cresce para o dobro quando enche. Devolve falso se faltar memória.
+static bool acrescentarEntradaDiario(unsigned char **buffer, size_t *usado, size_t *capacidade, TipoEntradaDiario tipo,
+                                     uint64_t sequencia, uint32_t peso, const char *palavra, size_t comprimento,
+                                     const char *palavraNova, size_t comprimentoNovo)
+{
+    EntradaDiario cabecalho;
+    size_t tamanho = sizeof(EntradaDiario) + comprimento + comprimentoNovo;
 
-    // Procurar o nó que corresponde ao último caractere da palavra.
-    for (i = 0; i < (int)strlen(palavra); i++)
+    if (*capacidade - *usado < tamanho)
     {
-        while (noAtual != NULL)
-        {
-            if (palavra[i] < noAtual->caractere)
-                noAtual = noAtual->esquerda;
-            else if (palavra[i] > noAtual->caractere)
-                noAtual = noAtual->direito;
-            else
-            {
-                buffer[comprimento] = noAtual->caractere;
-                comprimento++;
+        size_t nova = *capacidade ? *capacidade * 2 : 4096;
+        while (nova - *usado < tamanho)
+            nova *= 2;
+        unsigned char *maior = (unsigned char *)realloc(*buffer, nova);
+        if (maior == NULL)
+            return false;
+        *buffer = maior;
+        *capacidade = nova;
+    }
 
-                if (noAtual->fim_palavra)
-                    buffer[comprimento] = '\0';
+    memset(&cabecalho, 0, sizeof(cabecalho));
+    cabecalho.sequencia = sequencia;
+    cabecalho.peso = peso;
+    cabecalho.tipo = (uint8_t)tipo;
+    cabecalho.comprimento = (uint8_t)comprimento;
+    cabecalho.comprimentoNovo = (uint8_t)comprimentoNovo;
+
+    char *palavras = (char *)*buffer + *usado + sizeof(EntradaDiario);
+    memcpy(palavras, palavra, comprimento);
+    if (comprimentoNovo > 0)
+        memcpy(palavras + comprimento, palavraNova, comprimentoNovo);
+    cabecalho.verificacao = verificacaoEntradaDiario(&cabecalho, palavras, comprimento + comprimentoNovo);
+    memcpy(*buffer + *usado, &cabecalho, sizeof(cabecalho));
+    *usado += tamanho;
+    return true;
+}
 
-                noAtual = noAtual->centro;
-                break;
-            }
-        }
+// Aplica uma alteração ao dicionário com as funções que não a registam.
+static void aplicarEntradaDiario(Dicionario *dicionario, TipoEntradaDiario tipo, const char *palavra,
+                                 const char *palavraNova, uint32_t peso)
+{
+    switch (tipo)
+    {
+    case DIARIO_INSERIR:
+        inserirPalavra(dicionario, palavra);
+        break;
+    case DIARIO_INSERIR_COM_PESO:
+        inserirPalavraComPeso(dicionario, palavra, peso);
+        break;
+    case DIARIO_REMOVER:
+        removerPalavra(dicionario, palavra);
+        break;
+    case DIARIO_ATUALIZAR:
+        atualizarPalavra(dicionario, palavra, palavraNova);
+        break;
     }
+}
 
-    char *prefixo = (char *)malloc(sizeof(char) * (strlen(buffer) + 1));
-    strcpy(prefixo, buffer);
-    return prefixo;
+// Escreve todos os bytes (write pode escrever só uma parte). Devolve falso se a escrita falhar.
+static bool escreverTudo(int descritor, const unsigned char *dados, size_t tamanho)
+{
+    while (tamanho > 0)
+    {
+        ssize_t escritos = write(descritor, dados, tamanho);
+        if (escritos < 0 && errno == EINTR)
+            continue;
+        if (escritos <= 0)
+            return false;
+        dados += escritos;
+        tamanho -= (size_t)escritos;
+    }
+    return true;
 }
 
-// *********************************** IMPRESSÃO DE TODAS AS PALAVRAS COM A MESMA DISTÂNCIA DE EDIÇÃO ***********************************
+// Sincroniza a pasta de um ficheiro, para que a criação ou a mudança de nome do ficheiro também fique no disco.
+static bool sincronizarPasta(const char *nomeFicheiro)
+{
+    char pasta[FILENAME_MAX];
+
+    snprintf(pasta, sizeof(pasta), "%s", nomeFicheiro);
+    char *barra = strrchr(pasta, '/');
+    if (barra == NULL)
+        snprintf(pasta, sizeof(pasta), ".");
+    else if (barra == pasta)
+        barra[1] = '\0';
+    else
+        *barra = '\0';
 
-// Função que retorna o menor de três números.
-int min(int a, int b, int c) {
-    if (a < b) return (a < c)? a : c;
-    else return (b < c)? b : c;
+    int descritor = open(pasta, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (descritor < 0)
+        return false;
+    bool sucesso = fsync(descritor) == 0;
+    close(descritor);
+    return sucesso;
 }
 
-// Função que calcula a distância de edição entre duas palavras.
-int distanciaEdicao(char *palavra1, char *palavra2) {
-    int comprimento1 = strlen(palavra1);
-    int comprimento2 = strlen(palavra2);
-    
-    int matriz[comprimento1+1][comprimento2+1];
-
-    for (int i=0; i<=comprimento1; i++) {
-        for (int j=0; j<=comprimento2; j++) {
-            if (i == 0)
-                matriz[i][j] = j;
-            else if (j == 0)
-                matriz[i][j] = i;
-            else if (palavra1[i-1] == palavra2[j-1])
-                matriz[i][j] = matriz[i-1][j-1];
-            else
-                matriz[i][j] = 1 + min(matriz[i][j-1],  // Inserção
-                                       matriz[i-1][j],  // Remoção
-                                       matriz[i-1][j-1] // Substituição
-                                      );
-        }
-    }
-
-    return matriz[comprimento1][comprimento2];
+// Indica se o diário deve ser compactado: passou do limite e cresceu para o dobro desde a última compactação (um
+// diário só com palavras diferentes quase não encolhe, e não deve ser compactado a cada escrita). Chamada com o
+// trinco do ficheiro.
+static bool precisaCompactacao(const DiarioAlteracoes *diario)
+{
+    return diario->tamanhoFicheiro > LIMITE_COMPACTACAO_DIARIO && diario->tamanhoFicheiro > 2 * diario->tamanhoCompactado;
 }
 
+// Thread escritora: grava de uma só vez todas as entradas acumuladas desde a escrita anterior e torna-as duráveis com
+// um único fdatasync (group commit). Enquanto uma escrita decorre, as alterações seguintes juntam-se no outro buffer.
+static void *escreverDiario(void *argumento)
+{
+    Dicionario *dicionario = (Dicionario *)argumento;
+    DiarioAlteracoes *diario = dicionario->diario;
 
-// Função auxiliar que encontra todas as palavras que estão a uma certa distância de edição de uma palavra base.
-void palavrasPorDistanciaMinimaAux(NoTST *no, char *buffer, int profundidade, const char *palavraBase, int distancia) {
-    if (no == NULL)
-        return;
-    
-    // Vai para o nó esquerdo
-    palavrasPorDistanciaMinimaAux(no->esquerda, buffer, profundidade, palavraBase, distancia);
+    pthread_mutex_lock(&diario->trinco);
+    for (;;)
+    {
+        while (diario->usado == 0 && !diario->parar)
+            pthread_cond_wait(&diario->pendente, &diario->trinco);
+        if (diario->usado == 0)
+            break;
+
+        // Trocar os buffers: as próximas entradas vão para o que foi escrito na volta anterior.
+        unsigned char *lote = diario->buffer;
+        size_t tamanho = diario->usado, capacidade = diario->capacidade;
+        diario->buffer = diario->lote;
+        diario->capacidade = diario->capacidadeLote;
+        diario->usado = 0;
+        diario->lote = lote;
+        diario->capacidadeLote = capacidade;
+        uint64_t sequencia = dicionario->sequenciaDiario;
+        bool falhou = diario->estatisticas.falhou;
+        pthread_mutex_unlock(&diario->trinco);
+
+        // Depois de uma escrita falhada o fim do diário pode ter uma entrada cortada; as seguintes nunca seriam lidas.
+        bool sucesso = false, compactar = false;
+        if (!falhou)
+        {
+            pthread_mutex_lock(&diario->trincoFicheiro);
+            sucesso = escreverTudo(diario->descritor, lote, tamanho) && fdatasync(diario->descritor) == 0;
+            if (sucesso)
+                diario->tamanhoFicheiro += tamanho;
+            compactar = precisaCompactacao(diario);
+            pthread_mutex_unlock(&diario->trincoFicheiro);
+        }
 
-    // Adiciona o caractere do nó no buffer e verifica se o nó é o fim de uma palavra
-    buffer[profundidade] = no->caractere;
-    if (no->fim_palavra) {
-        buffer[profundidade + 1] = '\0';
-        if (distanciaEdicao(buffer, strlen(buffer), palavraBase, strlen(palavraBase)) == distancia) {
-            printf("%s\n", buffer);
+        pthread_mutex_lock(&diario->trinco);
+        if (sucesso)
+        {
+            diario->estatisticas.sequenciaDuravel = sequencia;
+            diario->estatisticas.sincronizacoes++;
+        }
+        else
+            diario->estatisticas.falhou = true;
+        if (compactar && !diario->compactando)
+            diario->compactacaoPedida = true;
+        pthread_cond_broadcast(&diario->duravel);
+
+        // Quem espera com epoll (o servidor) é avisado depois de a sequência durável ser atualizada.
+        if (diario->aviso >= 0)
+        {
+            uint64_t um = 1;
+            ssize_t escritos = write(diario->aviso, &um, sizeof(um));
+            (void)escritos; // O contador só falha se estiver cheio, e nesse caso já está legível.
         }
     }
+    pthread_mutex_unlock(&diario->trinco);
+    return NULL;
+}
 
-    // Vai para o nó do meio
-    palavrasPorDistanciaMinimaAux(no->centro, buffer, profundidade + 1, palavraBase, distancia);
+// Copia uma representação compacta para memória alocada (a original pode pertencer a um instantâneo mapeado).
+static TSTCompacta *copiarTSTCompacta(const TSTCompacta *origem)
+{
+    TSTCompacta *copia = (TSTCompacta *)malloc(sizeof(TSTCompacta));
+    if (copia == NULL)
+        return NULL;
 
-    // Vai para o nó direito
-    palavrasPorDistanciaMinimaAux(no->direito, buffer, profundidade, palavraBase, distancia);
+    *copia = *origem;
+    copia->instantaneo.dados = NULL;
+    copia->instantaneo.tamanho = 0;
+    copia->nos = (NoCompacto *)malloc((size_t)origem->totalNos * sizeof(NoCompacto));
+    copia->pesos = origem->pesos != NULL ? (uint32_t *)malloc((size_t)origem->totalNos * sizeof(uint32_t)) : NULL;
+    if (copia->nos == NULL || (origem->pesos != NULL && copia->pesos == NULL))
+    {
+        destruirTSTCompacta(copia);
+        return NULL;
+    }
+
+    memcpy(copia->nos, origem->nos, (size_t)origem->totalNos * sizeof(NoCompacto));
+    if (origem->pesos != NULL)
+        memcpy(copia->pesos, origem->pesos, (size_t)origem->totalNos * sizeof(uint32_t));
+    return copia;
 }
 
-// Imprime todas as palavras que estão a uma certa distância de edição de uma palavra base.
-void palavrasPorDistanciaMinima(Dicionario *dicionario, const char *palavraBase, int distancia) {
-    // Verifica se o dicionário é válido
-    if (dicionario == NULL || dicionario->raiz == NULL) {
-        printf("Dicionario vazio ou invalido.\n");
-        return;
+// Copia um manifesto (NULL se não houver ou faltar memória).
+static ManifestoFicheiro *copiarManifesto(const ManifestoFicheiro *origem)
+{
+    if (origem == NULL)
+        return NULL;
+
+    ManifestoFicheiro *copia = (ManifestoFicheiro *)malloc(sizeof(ManifestoFicheiro));
+    if (copia == NULL)
+        return NULL;
+
+    *copia = *origem;
+    copia->hashes = origem->totalBlocos > 0 ? (uint64_t *)malloc(origem->totalBlocos * sizeof(uint64_t)) : NULL;
+    if (origem->totalBlocos > 0 && copia->hashes == NULL)
+    {
+        free(copia);
+        return NULL;
     }
+    if (origem->totalBlocos > 0)
+        memcpy(copia->hashes, origem->hashes, origem->totalBlocos * sizeof(uint64_t));
+    return copia;
+}
 
-    // Buffer para armazenar a palavra enquanto percorre a Trie
-    char buffer[MAX_TAMANHO_PALAVRA];
-    palavrasPorDistanciaMinimaAux(dicionario->raiz, buffer, 0, palavraBase, distancia);
+// Liberta a cópia das palavras usada pela compactação.
+static void libertarCopiaCompactacao(DiarioAlteracoes *diario)
+{
+    destruirTSTCompacta(diario->copia);
+    if (diario->copiaManifesto != NULL)
+        libertarManifesto(diario->copiaManifesto);
+    free(diario->copiaManifesto);
+    free(diario->copiaHash);
+    diario->copia = NULL;
+    diario->copiaManifesto = NULL;
+    diario->copiaHash = NULL;
 }
 
+// Procura (ou acrescenta) o lugar de uma palavra na tabela de efeitos, com 'capacidade' lugares (potência de 2).
+static EfeitoPalavra *procurarEfeito(EfeitoPalavra *tabela, size_t capacidade, const char *palavra, size_t comprimento)
+{
+    size_t lugar = (size_t)hashXXH64(palavra, comprimento, 0) & (capacidade - 1);
+
+    while (tabela[lugar].palavra != NULL &&
+           (tabela[lugar].comprimento != comprimento || memcmp(tabela[lugar].palavra, palavra, comprimento) != 0))
+        lugar = (lugar + 1) & (capacidade - 1);
 
-// *********************************** VERIFICAÇÃO ORTOGRÁFICA DO FICHEIRO DE TEXTO ***********************************
+    if (tabela[lugar].palavra == NULL)
+    {
+        tabela[lugar].palavra = palavra;
+        tabela[lugar].comprimento = (uint8_t)comprimento;
+    }
+    return &tabela[lugar];
+}
 
-// Função para tratar palavra não encontrada no dicionário
-void tratarPalavraNaoEncontrada(Dicionario *dicionario, FILE *fileOutput, const char *palavra)
+// Compõe o efeito acumulado de uma palavra com mais uma alteração. Remover ou inserir com peso substituem tudo o que
+// veio antes; inserir sem peso não muda uma palavra já inserida, mas depois de uma remoção deixa-a com peso 0 (o peso
+// que ela tinha no ficheiro de texto já não conta).
+static void comporEfeito(EfeitoPalavra *efeito, TipoEntradaDiario tipo, uint32_t peso, uint64_t sequencia)
 {
-    // Imprimir a palavra
-    printf("A palavra '%s' não foi encontrada no dicionário.\n", palavra);
-    // Perguntar ao usuário se ele deseja adicionar a palavra ao dicionário
-    char opcao;
-    printf("Deseja adicionar '%s' ao dicionario? (s/n): ", palavra);
-    scanf(" %c", &opcao);
-    // Se o usuário responder afirmativamente
-    if (opcao == 's' || opcao == 'S')
+    if (tipo == DIARIO_INSERIR && efeito->tipo == DIARIO_REMOVER)
     {
-        // Adicionar a palavra ao dicionário
-        inserirPalavra(dicionario, palavra);
-        // Imprimir uma mensagem indicando que a palavra foi adicionada
-        printf("A palavra '%s' foi adicionada ao dicionário.\n", palavra);
-        // Escrever a palavra no ficheiro de saída
-        fprintf(fileOutput, "%s ", palavra);
+        efeito->tipo = DIARIO_INSERIR_COM_PESO;
+        efeito->peso = 0;
     }
-    else
+    else if (tipo != DIARIO_INSERIR || efeito->tipo == 0)
     {
-        // Se o usuário responder negativamente, imprimir uma mensagem indicando que a palavra foi marcada como errada
-        printf("A palavra '%s' foi marcada como errada.\n", palavra);
-        // Escrever a palavra no ficheiro de saída entre colchetes para indicar que está errada
-        fprintf(fileOutput, "[%s] ", palavra);
+        efeito->tipo = (uint8_t)tipo;
+        efeito->peso = peso;
     }
+    efeito->sequencia = sequencia;
 }
 
-// Função para verificar a ortografia de um ficheiro de texto usando o dicionário
-void verificarOrtografia(Dicionario *dicionario, const char *ficheiroTexto)
+// Escreve a entrada que resume uma palavra, se esta for a última entrada que a alterou e ainda não foi escrita.
+static bool escreverEfeito(EfeitoPalavra *tabela, size_t capacidade, const char *palavra, size_t comprimento,
+                           uint64_t sequencia, unsigned char **buffer, size_t *usado, size_t *capacidadeBuffer)
 {
-    // Abrir o ficheiro para leitura
-    FILE *file = fopen(ficheiroTexto, "r");
-    // Se o ficheiro não puder ser aberto, imprimir uma mensagem de erro e retornar
-    if (file == NULL)
-    {
-        printf("Não foi possível abrir o ficheiro %s.\n", ficheiroTexto);
-        return;
-    }
+    EfeitoPalavra *efeito = procurarEfeito(tabela, capacidade, palavra, comprimento);
+    if (efeito->escrita || efeito->sequencia != sequencia)
+        return true;
 
-    // Criar um novo ficheiro para a saída
-    FILE *fileOutput = fopen("ficheiroTexto_atualizado.txt", "w");
-    // Se o ficheiro de saída não puder ser criado, imprimir uma mensagem de erro, fechar o ficheiro de entrada e retornar
-    if (fileOutput == NULL)
+    efeito->escrita = true;
+    return acrescentarEntradaDiario(buffer, usado, capacidadeBuffer, (TipoEntradaDiario)efeito->tipo, sequencia, efeito->peso,
+                                    palavra, comprimento, NULL, 0);
+}
+
+// Reescreve o diário com uma só entrada por palavra para as entradas até 'sequencia' (já incluídas no instantâneo) e
+// as entradas seguintes tal e qual. O diário novo é escrito ao lado, sincronizado e renomeado por cima do antigo, que
+// continua válido se algo falhar pelo caminho. Chamada com o trinco do ficheiro.
+static bool reescreverDiario(DiarioAlteracoes *diario, uint64_t sequencia)
+{
+    FicheiroMapeado ficheiro;
+    EntradaLidaDiario entrada;
+    char nomeTemporario[FILENAME_MAX + sizeof(".tmp")];
+    CabecalhoDiario cabecalho;
+    unsigned char *buffer = NULL;
+    size_t usado = 0, capacidadeBuffer = 0, alteradas = 0;
+
+    if (!mapearFicheiro(diario->nomeDiario, &ficheiro))
+        return false;
+
+    // Contar as palavras alteradas até 'sequencia' e encontrar onde começam as entradas que ficam tal e qual (as
+    // sequências crescem ao longo do ficheiro).
+    size_t posicao = sizeof(CabecalhoDiario), fimResumidas;
+    while (lerEntradaDiario(ficheiro.dados, ficheiro.tamanho, posicao, &entrada) &&
+           entrada.cabecalho.sequencia <= sequencia)
     {
-        printf("Não foi possível criar o ficheiro de saída.\n");
-        fclose(file);
-        return;
+        alteradas += entrada.cabecalho.tipo == DIARIO_ATUALIZAR ? 2 : 1;
+        posicao += entrada.tamanho;
     }
+    fimResumidas = posicao;
 
-    // Criar um buffer para armazenar cada palavra
-    char palavra[MAX_TAMANHO_PALAVRA];
-    // Ler palavras do ficheiro uma de cada vez
-    while (fscanf(file, "%s", palavra) == 1)
+    size_t capacidade = 16;
+    while (capacidade < alteradas * 2)
+        capacidade *= 2;
+    EfeitoPalavra *tabela = (EfeitoPalavra *)calloc(capacidade, sizeof(EfeitoPalavra));
+    bool sucesso = tabela != NULL;
+
+    // Primeira passagem: o efeito final de cada palavra.
+    for (posicao = sizeof(CabecalhoDiario); sucesso && posicao < fimResumidas; posicao += entrada.tamanho)
     {
-        // Se a palavra não estiver no dicionário
-        if (!consultarPalavra(dicionario, palavra))
+        lerEntradaDiario(ficheiro.dados, ficheiro.tamanho, posicao, &entrada);
+        const EntradaDiario *lida = &entrada.cabecalho;
+        EfeitoPalavra *efeito = procurarEfeito(tabela, capacidade, entrada.palavra, lida->comprimento);
+        if (lida->tipo == DIARIO_ATUALIZAR)
         {
-            tratarPalavraNaoEncontrada(dicionario, fileOutput, palavra);
+            comporEfeito(efeito, DIARIO_REMOVER, 0, lida->sequencia);
+            efeito = procurarEfeito(tabela, capacidade, entrada.palavraNova, lida->comprimentoNovo);
+            comporEfeito(efeito, DIARIO_INSERIR, 0, lida->sequencia);
         }
         else
+            comporEfeito(efeito, (TipoEntradaDiario)lida->tipo, lida->peso, lida->sequencia);
+    }
+
+    // Segunda passagem: cada palavra é escrita no lugar da última entrada que a alterou, o que mantém as sequências
+    // por ordem crescente no diário novo.
+    memset(&cabecalho, 0, sizeof(cabecalho));
+    memcpy(cabecalho.assinatura, ASSINATURA_DIARIO, sizeof(ASSINATURA_DIARIO));
+    cabecalho.versao = VERSAO_DIARIO;
+    capacidadeBuffer = sizeof(cabecalho) + (ficheiro.tamanho - fimResumidas) + alteradas * (sizeof(EntradaDiario) + 16);
+    buffer = sucesso ? (unsigned char *)malloc(capacidadeBuffer) : NULL;
+    sucesso = buffer != NULL;
+    if (sucesso)
+    {
+        memcpy(buffer, &cabecalho, sizeof(cabecalho));
+        usado = sizeof(cabecalho);
+    }
+    for (posicao = sizeof(CabecalhoDiario); sucesso && posicao < fimResumidas; posicao += entrada.tamanho)
+    {
+        lerEntradaDiario(ficheiro.dados, ficheiro.tamanho, posicao, &entrada);
+        const EntradaDiario *lida = &entrada.cabecalho;
+        sucesso = escreverEfeito(tabela, capacidade, entrada.palavra, lida->comprimento, lida->sequencia, &buffer,
+                                 &usado, &capacidadeBuffer) &&
+                  (lida->tipo != DIARIO_ATUALIZAR ||
+                   escreverEfeito(tabela, capacidade, entrada.palavraNova, lida->comprimentoNovo, lida->sequencia,
+                                  &buffer, &usado, &capacidadeBuffer));
+    }
+    free(tabela);
+
+    // As entradas posteriores à cópia seguem-se tal e qual.
+    if (sucesso && capacidadeBuffer - usado < ficheiro.tamanho - fimResumidas)
+    {
+        unsigned char *maior = (unsigned char *)realloc(buffer, usado + (ficheiro.tamanho - fimResumidas));
+        sucesso = maior != NULL;
+        if (sucesso)
+            buffer = maior;
+    }
+    if (sucesso && ficheiro.tamanho > fimResumidas)
+    {
+        memcpy(buffer + usado, ficheiro.dados + fimResumidas, ficheiro.tamanho - fimResumidas);
+        usado += ficheiro.tamanho - fimResumidas;
+    }
+    desmapearFicheiro(&ficheiro);
+
+    // Escrever ao lado, sincronizar e só então substituir; o descritor novo continua a receber as escritas.
+    snprintf(nomeTemporario, sizeof(nomeTemporario), "%s.tmp", diario->nomeDiario);
+    int descritor = sucesso ? open(nomeTemporario, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644) : -1;
+    sucesso = descritor >= 0 && escreverTudo(descritor, buffer, usado) && fdatasync(descritor) == 0 &&
+              rename(nomeTemporario, diario->nomeDiario) == 0;
+    free(buffer);
+    if (!sucesso)
+    {
+        if (descritor >= 0)
         {
-            // Se a palavra estiver no dicionário, escrevê-la no ficheiro de saída
-            fprintf(fileOutput, "%s ", palavra);
+            close(descritor);
+            remove(nomeTemporario);
         }
+        return false;
     }
 
-    // Fechar os ficheiros
-    fclose(file);
-    fclose(fileOutput);
-    // Imprimir uma mensagem indicando que a verificação de ortografia foi concluída e o nome do ficheiro de saída
-    printf("Verificação de ortografia concluída. O ficheiro atualizado foi salvo como 'ficheiroTexto_atualizado.txt'.\n");
+    sincronizarPasta(diario->nomeDiario);
+    close(diario->descritor);
+    diario->descritor = descritor;
+    diario->tamanhoFicheiro = usado;
+    diario->tamanhoCompactado = usado;
+    return true;
 }
 
-// *********************************** IMPRESSÃO DE TODAS AS PALAVRAS EM ORDEM ***********************************
+// Copia o manifesto e o hash da origem e fixa a sequência a que a cópia das palavras corresponde. Chamada com o
+// trinco do diário, que ordena as alterações registadas: a Trie copiada tem de ser a desta sequência.
+static bool copiarOrigemCompactacao(Dicionario *dicionario)
+{
+    DiarioAlteracoes *diario = dicionario->diario;
 
-// Função auxiliar para percurso em ordem na TST
-void percursoEmOrdem(NoTST *no, char *buffer, int profundidade)
+    diario->sequenciaCopia = dicionario->sequenciaDiario;
+    diario->copiaManifesto = copiarManifesto(dicionario->manifesto);
+    diario->copiaHash = dicionario->hash_ficheiro != NULL ? strdup(dicionario->hash_ficheiro) : NULL;
+    return (dicionario->manifesto == NULL || diario->copiaManifesto != NULL) &&
+           (dicionario->hash_ficheiro == NULL || diario->copiaHash != NULL);
+}
+
+// Thread da compactação: grava o instantâneo da cópia das palavras e reescreve o diário sem as entradas que ele já
+// inclui. As alterações continuam a ser registadas (e sincronizadas) enquanto ela trabalha.
+static void *compactarDiario(void *argumento)
 {
-    if (no == NULL)
+    Dicionario *dicionario = (Dicionario *)argumento;
+    DiarioAlteracoes *diario = dicionario->diario;
+    uint64_t tamanhoOrigem, tamanhoDepois;
+    int64_t modificacaoOrigem, modificacaoDepois;
+    bool instantaneo = false, reescrito = false;
+
+    // No modo concorrente (sem cópia feita por quem lançou a thread), a cópia das palavras é feita aqui: a raiz
+    // publicada é lida com o trinco do diário (junto com a sequência) e os seus nós ficam vivos pela época desta
+    // leitura, sem parar quem altera o dicionário.
+    if (diario->copia == NULL)
     {
-        return;
+        pthread_mutex_lock(&diario->trinco);
+        LeitorEpoca *leitor = iniciarLeituraConcorrente(dicionario);
+        NoTST *raiz = __atomic_load_n(&dicionario->raiz, __ATOMIC_SEQ_CST);
+        bool copiada = copiarOrigemCompactacao(dicionario);
+        pthread_mutex_unlock(&diario->trinco);
+
+        if (copiada)
+            diario->copia = construirTSTCompacta(raiz);
+        terminarLeituraConcorrente(dicionario, leitor);
     }
 
-    // Percorrer a subárvore esquerda
-    percursoEmOrdem(no->esquerda, buffer, profundidade);
+    // O instantâneo fica associado à origem pelo tamanho e pelo instante de modificação, portanto só é gravado se a
+    // origem ainda for a que o hash copiado descreve; de outro modo, o próximo arranque aceitaria palavras antigas.
+    // Sem instantâneo, o diário compactado continua a bastar para repor as alterações sobre o ficheiro de texto.
+    if (diario->copia != NULL && diario->copiaHash != NULL &&
+        identificarOrigem(diario->nomeOrigem, &tamanhoOrigem, &modificacaoOrigem))
+    {
+        char *hash = gerarHashFicheiro(diario->nomeOrigem);
+        instantaneo = hash != NULL && strcmp(hash, diario->copiaHash) == 0 &&
+                      identificarOrigem(diario->nomeOrigem, &tamanhoDepois, &modificacaoDepois) &&
+                      tamanhoDepois == tamanhoOrigem && modificacaoDepois == modificacaoOrigem &&
+                      escreverInstantaneo(diario->copia, diario->copiaManifesto, diario->copiaHash,
+                                          diario->nomeInstantaneo, tamanhoOrigem, modificacaoOrigem,
+                                          diario->sequenciaCopia);
+        free(hash);
+    }
 
-    // Armazenar o caractere deste nó
-    buffer[profundidade] = no->caractere;
+    // As entradas incluídas na cópia têm de estar no disco antes de o diário ser reescrito sem elas.
+    pthread_mutex_lock(&diario->trinco);
+    while (diario->estatisticas.sequenciaDuravel < diario->sequenciaCopia && !diario->estatisticas.falhou)
+        pthread_cond_wait(&diario->duravel, &diario->trinco);
+    bool reescrever = diario->copia != NULL && !diario->estatisticas.falhou;
+    pthread_mutex_unlock(&diario->trinco);
 
-    // Se este nó marca o fim de uma palavra, imprimir a palavra
-    if (no->fim_palavra)
+    if (reescrever)
     {
-        buffer[profundidade + 1] = '\0';
-        printf("%s\n", buffer);
+        pthread_mutex_lock(&diario->trincoFicheiro);
+        reescrito = reescreverDiario(diario, diario->sequenciaCopia);
+        pthread_mutex_unlock(&diario->trincoFicheiro);
     }
 
-    // Percorrer a subárvore do meio
-    percursoEmOrdem(no->centro, buffer, profundidade + 1);
-
-    // Percorrer a subárvore direita
-    percursoEmOrdem(no->direito, buffer, profundidade);
+    pthread_mutex_lock(&diario->trinco);
+    if (reescrito)
+        diario->estatisticas.compactacoes++;
+    if (instantaneo)
+        diario->estatisticas.instantaneos++;
+    libertarCopiaCompactacao(diario);
+    diario->compactando = false;
+    pthread_mutex_unlock(&diario->trinco);
+    return NULL;
 }
 
-// Função para imprimir todas as palavras no dicionário em ordem
-void imprimirIndice(Dicionario *dicionario)
+// Copia as palavras, o manifesto e o hash tal como estão depois da última entrada registada e lança a thread da
+// compactação (só a pedida pelo crescimento do diário, com 'soPedida'). Chamada sem o trinco do diário: a cópia da
+// Trie não atrasa a thread escritora nem quem espera pelas suas entradas. No modo concorrente, quem a copia é a
+// própria thread da compactação; fora dele, nenhuma outra thread pode percorrer a Trie, e a cópia é feita por quem
+// altera o dicionário, que é também o único que a pode alterar entre a sequência lida e a cópia.
+static bool iniciarCompactacao(Dicionario *dicionario, bool soPedida)
 {
-    char buffer[MAX_TAMANHO_PALAVRA];
-    percursoEmOrdem(dicionario->raiz, buffer, 0);
-    system("pause");
-}
+    DiarioAlteracoes *diario = dicionario->diario;
+    bool concorrente = dicionario->concorrencia != NULL;
 
-// *********************************** VERIFICAÇÃO DA INTEGRIDADE DO FICHEIRO DE TEXTO ***********************************
+    pthread_mutex_lock(&diario->trinco);
+    if (diario->compactando || (soPedida && !diario->compactacaoPedida))
+    {
+        pthread_mutex_unlock(&diario->trinco);
+        return false;
+    }
 
-// Verifica a integridade do ficheiro comparando o hash atual do ficheiro com o hash armazenado no dicionário.
-bool verificarIntegridadeFicheiro(Dicionario *dicionario, const char *nomeFicheiro)
-{
-    // Gera o hash atual do ficheiro.
-    char *hashAtual = gerarHashFicheiro(nomeFicheiro);
+    // A compactação anterior já terminou ('compactando' é falso): só falta juntar a sua thread.
+    if (diario->compactadorPorJuntar)
+    {
+        pthread_join(diario->compactador, NULL);
+        diario->compactadorPorJuntar = false;
+    }
+    diario->compactacaoPedida = false;
+    diario->compactando = true;
+    bool sucesso = concorrente || copiarOrigemCompactacao(dicionario);
+    pthread_mutex_unlock(&diario->trinco);
 
-    // Compara o hash atual com o hash armazenado.
-    // Se a função compararHashFicheiro retorna verdadeiro, a integridade do ficheiro está preservada.
-    // Se retorna falso, o ficheiro foi alterado desde a última verificação.
-    bool integridadePreservada = compararHashFicheiro(dicionario, hashAtual);
+    if (sucesso && !concorrente)
+    {
+        diario->copia = dicionario->compacta != NULL ? copiarTSTCompacta(dicionario->compacta)
+                                                     : construirTSTCompacta(dicionario->raiz);
+        sucesso = diario->copia != NULL;
+    }
 
-    // Libera a memória alocada para o hash atual.
-    free(hashAtual);
+    pthread_mutex_lock(&diario->trinco);
+    if (sucesso)
+        sucesso = pthread_create(&diario->compactador, NULL, compactarDiario, dicionario) == 0;
+    if (sucesso)
+        diario->compactadorPorJuntar = true;
+    else
+    {
+        libertarCopiaCompactacao(diario);
+        diario->compactando = false;
+    }
+    pthread_mutex_unlock(&diario->trinco);
+    return sucesso;
+}
 
-    return integridadePreservada;
+// Liberta o diário (sem threads a correr).
+static void libertarDiario(DiarioAlteracoes *diario)
+{
+    if (diario->descritor >= 0)
+        close(diario->descritor);
+    if (diario->aviso >= 0)
+        close(diario->aviso);
+    libertarCopiaCompactacao(diario);
+    free(diario->buffer);
+    free(diario->lote);
+    pthread_mutex_destroy(&diario->trinco);
+    pthread_mutex_destroy(&diario->trincoFicheiro);
+    pthread_cond_destroy(&diario->pendente);
+    pthread_cond_destroy(&diario->duravel);
+    free(diario);
 }
 
-// ================================ FUNÇÕES DE HASH ==================================
-// As funções relacionadas ao hash do ficheiro são implementadas aqui.
+// Abre (ou cria) o diário do ficheiro de texto e repõe as alterações que o dicionário ainda não inclui.
+bool abrirDiarioAlteracoes(Dicionario *dicionario, const char *nomeOrigem, size_t *repostas)
+{
+    FicheiroMapeado ficheiro;
+    EntradaLidaDiario entrada;
+    CabecalhoDiario cabecalho;
+    char palavra[MAX_TAMANHO_PALAVRA], palavraNova[MAX_TAMANHO_PALAVRA];
+
+    if (repostas != NULL)
+        *repostas = 0;
+    if (dicionario->diario != NULL)
+        return false;
 
-// *********************************** GERANDO O HASH PARA O ARQUIVO DE TEXTO ***********************************
+    DiarioAlteracoes *diario = (DiarioAlteracoes *)calloc(1, sizeof(DiarioAlteracoes));
+    if (diario == NULL)
+        return false;
+    snprintf(diario->nomeDiario, sizeof(diario->nomeDiario), "%s%s", nomeOrigem, EXTENSAO_DIARIO);
+    snprintf(diario->nomeInstantaneo, sizeof(diario->nomeInstantaneo), "%s%s", nomeOrigem, EXTENSAO_INSTANTANEO);
+    snprintf(diario->nomeOrigem, sizeof(diario->nomeOrigem), "%s", nomeOrigem);
+    pthread_mutex_init(&diario->trinco, NULL);
+    pthread_mutex_init(&diario->trincoFicheiro, NULL);
+    pthread_cond_init(&diario->pendente, NULL);
+    pthread_cond_init(&diario->duravel, NULL);
+    diario->aviso = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    diario->descritor = open(diario->nomeDiario, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (diario->descritor < 0 || !mapearFicheiro(diario->nomeDiario, &ficheiro))
+    {
+        libertarDiario(diario);
+        return false;
+    }
 
-// Esta função gera um hash para um arquivo especificado
-char *gerarHashFicheiro(const char *nomeFicheiro)
-{
-    // Abre o arquivo no modo de leitura
-    FILE *ficheiro = fopen(nomeFicheiro, "r");
-    // Se o arquivo não pôde ser aberto, imprime um erro e retorna NULL
-    if (ficheiro == NULL)
+    // Um diário novo recebe o cabeçalho; um ficheiro que não seja um diário nunca é reescrito.
+    size_t posicao = sizeof(CabecalhoDiario);
+    bool sucesso = true;
+    if (ficheiro.tamanho == 0)
     {
-        printf("Erro ao abrir o ficheiro: %s\n", nomeFicheiro);
-        return NULL;
+        memset(&cabecalho, 0, sizeof(cabecalho));
+        memcpy(cabecalho.assinatura, ASSINATURA_DIARIO, sizeof(ASSINATURA_DIARIO));
+        cabecalho.versao = VERSAO_DIARIO;
+        sucesso = escreverTudo(diario->descritor, (const unsigned char *)&cabecalho, sizeof(cabecalho)) &&
+                  fdatasync(diario->descritor) == 0 && sincronizarPasta(diario->nomeDiario);
     }
+    else
+    {
+        sucesso = ficheiro.tamanho >= sizeof(cabecalho);
+        if (sucesso)
+        {
+            memcpy(&cabecalho, ficheiro.dados, sizeof(cabecalho));
+            sucesso = memcmp(cabecalho.assinatura, ASSINATURA_DIARIO, sizeof(ASSINATURA_DIARIO)) == 0 &&
+                      cabecalho.versao == VERSAO_DIARIO;
+        }
 
-    // Inicia a variável hash com o valor 5381, que é um valor inicial comum para este algoritmo de hash
-    unsigned long hash = 5381;
-    int c;
+        // Repor as entradas que o dicionário ainda não inclui (as do instantâneo já lá estão).
+        uint64_t ultima = dicionario->sequenciaDiario;
+        while (sucesso && lerEntradaDiario(ficheiro.dados, ficheiro.tamanho, posicao, &entrada))
+        {
+            const EntradaDiario *lida = &entrada.cabecalho;
+            if (lida->sequencia > dicionario->sequenciaDiario)
+            {
+                memcpy(palavra, entrada.palavra, lida->comprimento);
+                palavra[lida->comprimento] = '\0';
+                memcpy(palavraNova, entrada.palavraNova, lida->comprimentoNovo);
+                palavraNova[lida->comprimentoNovo] = '\0';
+                aplicarEntradaDiario(dicionario, (TipoEntradaDiario)lida->tipo, palavra, palavraNova, lida->peso);
+                diario->estatisticas.repostas++;
+            }
+            if (lida->sequencia > ultima)
+                ultima = lida->sequencia;
+            posicao += entrada.tamanho;
+        }
+        dicionario->sequenciaDiario = ultima;
 
-    // Lê o arquivo caractere por caractere até o final
-    while ((c = fgetc(ficheiro)) != EOF)
-    {
-        // Calcula o hash usando o algoritmo djb2
-        hash = ((hash << 5) + hash) + c; // hash * 33 + c
+        // O que sobra depois da última entrada válida é uma escrita interrompida: as alterações seguintes vêm depois.
+        if (sucesso && posicao < ficheiro.tamanho)
+            sucesso = ftruncate(diario->descritor, (off_t)posicao) == 0 && fdatasync(diario->descritor) == 0;
     }
+    desmapearFicheiro(&ficheiro);
 
-    // Fecha o arquivo
-    fclose(ficheiro);
+    diario->tamanhoFicheiro = posicao;
+    diario->tamanhoCompactado = posicao / 2;
+    diario->estatisticas.sequenciaDuravel = dicionario->sequenciaDiario;
+    diario->compactacaoPedida = precisaCompactacao(diario);
+    if (repostas != NULL)
+        *repostas = diario->estatisticas.repostas;
 
-    // Aloca memória para a string que vai guardar o hash
-    // O tamanho máximo de um unsigned long em decimal é 20 caracteres
-    // Mais um para o caractere nulo no final
-    char *hashStr = malloc(21 * sizeof(char));
-    // Se a alocação falhar, imprime um erro e retorna NULL
-    if (hashStr == NULL)
+    dicionario->diario = diario;
+    if (!sucesso || pthread_create(&diario->escritor, NULL, escreverDiario, dicionario) != 0)
     {
-        printf("Erro ao alocar memória para o hash.\n");
-        return NULL;
+        dicionario->diario = NULL;
+        libertarDiario(diario);
+        return false;
     }
+    return true;
+}
 
-    // Converte o valor do hash para uma string
-    sprintf(hashStr, "%lu", hash);
+// Fecha o diário depois de gravar as entradas pendentes e de a compactação em curso terminar.
+void fecharDiarioAlteracoes(Dicionario *dicionario)
+{
+    DiarioAlteracoes *diario = dicionario->diario;
+    if (diario == NULL)
+        return;
 
-    // Retorna a string com o hash do arquivo
-    return hashStr;
-}
+    pthread_mutex_lock(&diario->trinco);
+    diario->parar = true;
+    pthread_cond_signal(&diario->pendente);
+    pthread_mutex_unlock(&diario->trinco);
 
-// *********************************** COMPARANDO O HASH ARMAZENADO DO FICHEIRO DE TEXTO ***********************************
+    pthread_join(diario->escritor, NULL);
+    if (diario->compactadorPorJuntar)
+        pthread_join(diario->compactador, NULL);
 
-// Esta função compara o hash armazenado no dicionário com um hash fornecido
-bool compararHashFicheiro(Dicionario *dicionario, const char *hashComparacao)
+    dicionario->diario = NULL;
+    libertarDiario(diario);
+}
+
+// Aplica uma alteração e acrescenta-a ao diário, sem esperar pela escrita.
+uint64_t aplicarAlteracaoRegistada(Dicionario *dicionario, TipoEntradaDiario tipo, const char *palavra,
+                                   const char *palavraNova, uint32_t peso)
 {
-    // Se ambos os hashes são NULL, eles são considerados iguais
-    if (dicionario->hash_ficheiro == NULL && hashComparacao == NULL)
+    DiarioAlteracoes *diario = dicionario->diario;
+
+    // A alteração é aplicada com o trinco do diário, para que a ordem das entradas seja a ordem em memória.
+    if (diario != NULL)
+        pthread_mutex_lock(&diario->trinco);
+    uint64_t sequencia = aplicarAlteracaoRegistadaComTrinco(dicionario, tipo, palavra, palavraNova, peso);
+    if (diario != NULL)
     {
-        return true;
+        bool compactar = diario->compactacaoPedida && !diario->compactando;
+        pthread_mutex_unlock(&diario->trinco);
+        if (compactar)
+            iniciarCompactacao(dicionario, true);
     }
+    return sequencia;
+}
 
-    // Se apenas um dos hashes é NULL, eles são considerados diferentes
-    if (dicionario->hash_ficheiro == NULL || hashComparacao == NULL)
+// Aplica uma alteração e acrescenta-a ao diário, com o trinco do diário já tomado.
+uint64_t aplicarAlteracaoRegistadaComTrinco(Dicionario *dicionario, TipoEntradaDiario tipo, const char *palavra,
+                                            const char *palavraNova, uint32_t peso)
+{
+    DiarioAlteracoes *diario = dicionario->diario;
+    size_t comprimento = strlen(palavra);
+    size_t comprimentoNovo = tipo == DIARIO_ATUALIZAR ? strlen(palavraNova) : 0;
+
+    // Palavras que o diário não guarda (nem a Trie aceita) são rejeitadas sem alterar nada: a repetição do diário
+    // também as recusa, e a memória tem de coincidir com o que o diário reconstrói.
+    if (comprimento == 0 || comprimento >= MAX_TAMANHO_PALAVRA ||
+        (tipo == DIARIO_ATUALIZAR && (comprimentoNovo == 0 || comprimentoNovo >= MAX_TAMANHO_PALAVRA)))
+        return 0;
+
+    // Sem diário, a alteração fica só em memória.
+    if (diario == NULL)
     {
-        return false;
+        aplicarEntradaDiario(dicionario, tipo, palavra, palavraNova, peso);
+        return 0;
     }
 
-    // Compara os dois hashes
-    // Se a função strcmp retorna 0, significa que as strings são iguais
-    if (strcmp(dicionario->hash_ficheiro, hashComparacao) == 0)
+    uint64_t sequencia = dicionario->sequenciaDiario + 1;
+    if (diario->estatisticas.falhou ||
+        !acrescentarEntradaDiario(&diario->buffer, &diario->usado, &diario->capacidade, tipo, sequencia, peso, palavra,
+                                  comprimento, palavraNova, comprimentoNovo))
     {
-        return true;
+        diario->estatisticas.falhou = true;
+        sequencia = SEQUENCIA_DIARIO_FALHADA;
     }
     else
     {
+        dicionario->sequenciaDiario = sequencia;
+        diario->estatisticas.entradas++;
+        pthread_cond_signal(&diario->pendente);
+    }
+    aplicarEntradaDiario(dicionario, tipo, palavra, palavraNova, peso);
+    return sequencia;
+}
+
+// Espera que a thread escritora grave a entrada 'sequencia'.
+bool esperarDiario(Dicionario *dicionario, uint64_t sequencia)
+{
+    DiarioAlteracoes *diario = dicionario->diario;
+    if (diario == NULL)
+        return false;
+
+    pthread_mutex_lock(&diario->trinco);
+    while (diario->estatisticas.sequenciaDuravel < sequencia && !diario->estatisticas.falhou)
+        pthread_cond_wait(&diario->duravel, &diario->trinco);
+    bool duravel = diario->estatisticas.sequenciaDuravel >= sequencia;
+    pthread_mutex_unlock(&diario->trinco);
+    return duravel;
+}
+
+// Indica se uma entrada do diário já está no disco, sem esperar pela escrita em curso.
+bool consultarDiarioDuravel(Dicionario *dicionario, uint64_t sequencia, bool *falhou)
+{
+    DiarioAlteracoes *diario = dicionario->diario;
+    if (diario == NULL)
+    {
+        if (falhou != NULL)
+            *falhou = true;
         return false;
     }
+
+    // Só o trinco do diário: o da escrita fica tomado durante o fdatasync.
+    pthread_mutex_lock(&diario->trinco);
+    bool duravel = diario->estatisticas.sequenciaDuravel >= sequencia;
+    if (falhou != NULL)
+        *falhou = !duravel && diario->estatisticas.falhou;
+    pthread_mutex_unlock(&diario->trinco);
+    return duravel;
 }
 
-// ================================ FUNÇÕES DO MENU ==================================
-// As funções relacionadas ao menu principal são implementadas aqui.
+// Devolve o descritor que avisa das escritas do diário.
+int descritorAvisoDiario(const Dicionario *dicionario)
+{
+    return dicionario->diario != NULL ? dicionario->diario->aviso : -1;
+}
 
-// *********************************** CARREGANDO AS PALAVRAS DO FICHEIRO PARA A TRIE TST (O DICIONÁRIO) ***********************************
+// Insere uma palavra e espera que a alteração fique no diário.
+bool inserirPalavraDuravel(Dicionario *dicionario, const char *palavra)
+{
+    uint64_t sequencia = aplicarAlteracaoRegistada(dicionario, DIARIO_INSERIR, palavra, NULL, 0);
+    return sequencia != 0 && esperarDiario(dicionario, sequencia);
+}
 
-// Função para carregar as palavras do ficheiro e preenchê-las na TRIE TST
-void carregarPalavrasDoFicheiro(Dicionario *dicionario, const char *nomeFicheiro)
+// Insere uma palavra com peso (ou substitui o peso) e espera que a alteração fique no diário.
+bool inserirPalavraComPesoDuravel(Dicionario *dicionario, const char *palavra, uint32_t peso)
 {
-    // Abrir o ficheiro em modo de leitura
-    FILE *file = fopen(nomeFicheiro, "r");
+    uint64_t sequencia = aplicarAlteracaoRegistada(dicionario, DIARIO_INSERIR_COM_PESO, palavra, NULL, peso);
+    return sequencia != 0 && esperarDiario(dicionario, sequencia);
+}
 
-    // Verificar se o ficheiro foi aberto com sucesso
-    if (file == NULL)
-    {
-        // Imprimir uma mensagem de erro se o ficheiro não puder ser aberto
-        printf("Não foi possível abrir o ficheiro %s.\n", nomeFicheiro);
-        perror("Erro");
-        system("pause");
+// Remove uma palavra e espera que a alteração fique no diário.
+bool removerPalavraDuravel(Dicionario *dicionario, const char *palavra)
+{
+    uint64_t sequencia = aplicarAlteracaoRegistada(dicionario, DIARIO_REMOVER, palavra, NULL, 0);
+    return sequencia != 0 && esperarDiario(dicionario, sequencia);
+}
+
+// Atualiza uma palavra e espera que a alteração fique no diário.
+bool atualizarPalavraDuravel(Dicionario *dicionario, const char *palavraAntiga, const char *palavraNova)
+{
+    uint64_t sequencia = aplicarAlteracaoRegistada(dicionario, DIARIO_ATUALIZAR, palavraAntiga, palavraNova, 0);
+    return sequencia != 0 && esperarDiario(dicionario, sequencia);
+}
+
+// Lança a compactação do diário, se não houver uma em curso.
+bool compactarDiarioAlteracoes(Dicionario *dicionario)
+{
+    DiarioAlteracoes *diario = dicionario->diario;
+    if (diario == NULL)
+        return false;
+
+    return iniciarCompactacao(dicionario, false);
+}
+
+// Lança a compactação pedida pelo crescimento do diário, se não houver uma em curso.
+bool compactarDiarioSePedido(Dicionario *dicionario)
+{
+    return dicionario->diario != NULL && iniciarCompactacao(dicionario, true);
+}
+
+// Espera que a compactação em curso termine.
+void esperarCompactacaoDiario(Dicionario *dicionario)
+{
+    DiarioAlteracoes *diario = dicionario->diario;
+    if (diario == NULL)
         return;
-    }
 
-    char palavra[MAX_TAMANHO_PALAVRA];
+    pthread_mutex_lock(&diario->trinco);
+    bool juntar = diario->compactadorPorJuntar;
+    diario->compactadorPorJuntar = false;
+    pthread_mutex_unlock(&diario->trinco);
+    if (juntar)
+        pthread_join(diario->compactador, NULL);
+}
 
-    // Ler palavras do ficheiro até que não haja mais palavras para ler
-    while (fscanf(file, "%s", palavra) == 1)
+// Copia os contadores do diário.
+bool consultarDiarioAlteracoes(const Dicionario *dicionario, EstatisticasDiario *estatisticas)
+{
+    DiarioAlteracoes *diario = dicionario->diario;
+    if (diario == NULL)
+        return false;
+
+    pthread_mutex_lock(&diario->trinco);
+    *estatisticas = diario->estatisticas;
+    estatisticas->ultimaSequencia = dicionario->sequenciaDiario;
+    pthread_mutex_unlock(&diario->trinco);
+
+    pthread_mutex_lock(&diario->trincoFicheiro);
+    estatisticas->tamanhoFicheiro = diario->tamanhoFicheiro;
+    pthread_mutex_unlock(&diario->trincoFicheiro);
+    return true;
+}
+
+// *********************************** EXECUÇÃO DO MENU PRINCIPAL ***********************************
+
+// Função para mostrar as palavras com o prefixo por páginas, a partir da primeira que não é menor do que 'inicio'
+// (NULL para começar no princípio).
+void paginarPalavrasComPrefixo(Dicionario *dicionario, const char *prefixo, const char *inicio)
+{
+    CursorDicionario cursor;
+    char pagina[PALAVRAS_POR_PAGINA * MAX_TAMANHO_PALAVRA];
+    char continuar = 's';
+
+    if (!abrirCursor(&cursor, dicionario, prefixo))
     {
-        // Inserir cada palavra lida na TRIE TST
-        inserirPalavra(dicionario, palavra);
+        printf("Prefixo inválido.\n");
+        return;
     }
+    if (inicio != NULL)
+        posicionarCursor(&cursor, inicio);
 
-    // Fechar o ficheiro
-    fclose(file);
+    while (continuar == 's' || continuar == 'S')
+    {
+        size_t copiadas = proximasPalavras(&cursor, pagina, sizeof(pagina), PALAVRAS_POR_PAGINA);
+        const char *palavra = pagina;
 
-    // Gerar e armazenar o hash do ficheiro
-    char *hash = gerarHashFicheiro(nomeFicheiro);
-    dicionario->hash_ficheiro = hash;
+        for (size_t i = 0; i < copiadas; i++)
+        {
+            printf("%s\n", palavra);
+            palavra += strlen(palavra) + 1;
+        }
 
-    // Imprimir uma mensagem de sucesso
-    printf("As palavras foram carregadas com sucesso do ficheiro %s.\n", nomeFicheiro);
-    system("pause");
+        if (copiadas < PALAVRAS_POR_PAGINA)
+            break;
+        printf("Mostrar mais palavras? (s/n): ");
+        scanf(" %c", &continuar);
+    }
+    fecharCursor(&cursor);
 }
 
-// *********************************** EXECUÇÃO DO MENU PRINCIPAL ***********************************
-
 // Função para executar a opção escolhida no Menu Principal
 void executarOpcao(Dicionario *dicionario, int opcao, const char *nomeFicheiro)
 {
     // Variáveis para armazenar as palavras fornecidas pelo usuário
     char palavra[MAX_TAMANHO_PALAVRA], novaPalavra[MAX_TAMANHO_PALAVRA];
 
-    // Variável para armazenar distância minima fornecida pelo usuário
-    int distancia;
+    // Variáveis para armazenar a distância mínima e o modo de procura fornecidos pelo usuário
+    int distancia, modo;
 
     // Estrutura switch-case para lidar com a opção escolhida pelo usuário
     switch (opcao)
@@ -749,20 +8163,31 @@ void executarOpcao(Dicionario *dicionario, int opcao, const char *nomeFicheiro)
     case 1: // Opção para inserir nova palavra
         printf("Insira a nova palavra: ");
         scanf(" %s", palavra);  // Lê uma palavra do teclado, ignorando espaços em branco iniciais
-        inserirPalavra(dicionario, palavra);
+        if (!inserirPalavraDuravel(dicionario, palavra))
+            printf("[A palavra foi inserida só em memória: não ficou guardada no diário de alterações].\n");
                 system("pause");
 
         break;
     case 2: // Opção para consultar uma palavra
         printf("Insira a palavra a ser consultada: ");
         scanf(" %s", palavra);  // Lê uma palavra do teclado, ignorando espaços em branco iniciais
-        consultarPalavra(dicionario, palavra);
-       
+        if (consultarPalavra(dicionario, palavra))
+            printf("Encontrado!!\n");
+        else
+            printf("Não encontrado!!\n");
+        system("pause");
         break;
     case 3: // Opção para remover uma palavra
         printf("Insira a palavra a ser removida: ");
         scanf(" %s", palavra);  // Lê uma palavra do teclado, ignorando espaços em branco iniciais
-        removerPalavra(dicionario, palavra);
+        if (contemPalavra(dicionario, palavra)) {
+            if (!removerPalavraDuravel(dicionario, palavra))
+                printf("[A palavra foi removida só em memória: a remoção não ficou guardada no diário de alterações].\n");
+            else
+                printf("[Palavra removida com sucesso!].\n");
+        } else {
+            printf("[A palavra não está na TRIE TST criada!].\n");
+        }
                 system("pause");
 
         break;
@@ -773,14 +8198,17 @@ void executarOpcao(Dicionario *dicionario, int opcao, const char *nomeFicheiro)
         printf("Insira a nova palavra: ");
         scanf(" %s", novaPalavra);  // Lê uma palavra do teclado, ignorando espaços em branco iniciais
 
-        atualizarPalavra(dicionario, palavra, novaPalavra);
+        if (!atualizarPalavraDuravel(dicionario, palavra, novaPalavra))
+            printf("[A atualização não ficou guardada no diário de alterações].\n");
                system("pause");
 
         break;
     case 5: // Opção para exibir palavras com o mesmo prefixo
         printf("Insira o prefixo: ");
         scanf(" %s", palavra);  // Lê uma palavra do teclado, ignorando espaços em branco iniciais
-        palavrasComPrefixo(dicionario, palavra);
+        printf("Começar na palavra (- para começar no início): ");
+        scanf(" %s", novaPalavra);
+        paginarPalavrasComPrefixo(dicionario, palavra, strcmp(novaPalavra, "-") == 0 ? NULL : novaPalavra);
         system("pause");
         break;
     case 6: // Opção para exibir o prefixo mais longo
@@ -796,7 +8224,10 @@ void executarOpcao(Dicionario *dicionario, int opcao, const char *nomeFicheiro)
         printf("Insira a distância mínima: ");
         scanf("%d", &distancia);
 
-        palavrasPorDistanciaMinima(dicionario, palavra, distancia);
+        printf("Modo (0 = exatamente essa distância, 1 = até essa distância): ");
+        scanf("%d", &modo);
+
+        palavrasPorDistanciaMinima(dicionario, palavra, distancia, modo == 1 ? DISTANCIA_MAXIMA : DISTANCIA_EXATA);
         system("pause");
         break;
     case 8: // Opção para verificar ortografia
@@ -809,14 +8240,295 @@ void executarOpcao(Dicionario *dicionario, int opcao, const char *nomeFicheiro)
         system("pause");
         break;
     case 10: // Opção para verificar a integridade do arquivo
-        if(verificarIntegridadeFicheiro(dicionario, nomeFicheiro)){
-            printf("Preservado!");
-        }else{
-            printf("Alterado");
+        {
+            IntervaloFicheiro intervalos[MAX_INTERVALOS_ALTERADOS];
+            size_t alterados;
+
+            if (!verificarAlteracoesFicheiro(dicionario, nomeFicheiro, intervalos, MAX_INTERVALOS_ALTERADOS, &alterados)) {
+                printf("Não foi possível ler o ficheiro %s.\n", nomeFicheiro);
+            } else if (alterados == 0) {
+                printf("Preservado!\n");
+            } else {
+                // Mostrar os intervalos de bytes que mudaram desde que o ficheiro foi carregado
+                printf("Alterado (%zu intervalo(s) de bytes):\n", alterados);
+                for (size_t i = 0; i < alterados && i < MAX_INTERVALOS_ALTERADOS; i++)
+                    printf("  bytes %llu a %llu\n", (unsigned long long)intervalos[i].inicio,
+                           (unsigned long long)intervalos[i].fim - 1);
+                if (alterados > MAX_INTERVALOS_ALTERADOS)
+                    printf("  ... e mais %zu\n", alterados - MAX_INTERVALOS_ALTERADOS);
+            }
+        }
+                system("pause");
+
+        break;
+    case 11: // Opção para comparar o layout de ponteiros com o layout compacto
+        relatorioLayouts(dicionario);
+        system("pause");
+        break;
+    case 12: // Opção para congelar (layout compacto ou minimizado) ou descongelar o dicionário
+        if (dicionario->compacta == NULL) {
+            printf("Partilhar os sufixos iguais (layout minimizado)? (s/n): ");
+            scanf(" %s", palavra);
+            if (palavra[0] == 's' || palavra[0] == 'S') {
+                if (congelarDicionarioMinimizado(dicionario))
+                    printf("Dicionário congelado no layout minimizado (%u nós).\n", dicionario->compacta->totalNos - 1);
+            } else if (congelarDicionario(dicionario))
+                printf("Dicionário congelado no layout compacto (%u nós).\n", dicionario->compacta->totalNos - 1);
+        } else if (descongelarDicionario(dicionario)) {
+            printf("Dicionário descongelado (%zu nós).\n", dicionario->arena.nosEmUso);
+        }
+        system("pause");
+        break;
+    case 13: // Opção para ligar ou desligar o rastreio das consultas
+        dicionario->rastrearConsultas = !dicionario->rastrearConsultas;
+        printf("Rastreio das consultas %s.\n", dicionario->rastrearConsultas ? "ligado" : "desligado");
+#ifndef DICIONARIO_RASTREIO
+        if (dicionario->rastrearConsultas)
+            printf("Os passos só são mostrados num programa compilado com -DDICIONARIO_RASTREIO (make RASTREIO=1).\n");
+#endif
+        system("pause");
+        break;
+    case 14: // Opção para verificar a ortografia de um ficheiro sem interação
+    {
+        char ficheiroSaida[FILENAME_MAX], ficheiroRelatorio[FILENAME_MAX];
+        OpcoesVerificacao opcoes = {NULL, NULL, 0, 0, false, false};
+        char sugerir;
+        ResultadoVerificacao resultado;
+
+        printf("Insira o ficheiro de texto: ");
+        scanf(" %s", palavra);
+        printf("Insira o ficheiro de saída anotado (- para nenhum): ");
+        scanf(" %s", ficheiroSaida);
+        printf("Insira o ficheiro do relatório (- para nenhum): ");
+        scanf(" %s", ficheiroRelatorio);
+        printf("Insira o número de threads (0 para usar todos os processadores): ");
+        scanf("%d", &opcoes.totalThreads);
+        if (opcoes.totalThreads <= 0)
+            opcoes.totalThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+        opcoes.ficheiroSaida = strcmp(ficheiroSaida, "-") != 0 ? ficheiroSaida : NULL;
+        opcoes.ficheiroRelatorio = strcmp(ficheiroRelatorio, "-") != 0 ? ficheiroRelatorio : NULL;
+
+        // As sugestões só vão para o relatório: sem ele, não vale a pena perguntar.
+        if (opcoes.ficheiroRelatorio != NULL)
+        {
+            printf("Acrescentar sugestões de correção ao relatório? (s/n): ");
+            scanf(" %c", &sugerir);
+            opcoes.sugerir = sugerir == 's' || sugerir == 'S';
+        }
+        if (dicionario->dobrado != NULL)
+        {
+            printf("Aceitar as palavras que só diferem em maiúsculas e acentos? (s/n): ");
+            scanf(" %c", &sugerir);
+            opcoes.ignorarAcentos = sugerir == 's' || sugerir == 'S';
+        }
+
+        if (verificarOrtografiaEmLote(dicionario, palavra, &opcoes, &resultado))
+        {
+            printf("%zu palavras verificadas em %zu linhas, %zu erradas.\n", resultado.palavras, resultado.linhas, resultado.erradas);
+            printf("%zu bytes em %.3f s (%.1f MB/s).\n", resultado.bytes, resultado.segundos,
+                   resultado.segundos > 0 ? resultado.bytes / resultado.segundos / 1e6 : 0.0);
+        }
+        system("pause");
+        break;
+    }
+    case 15: // Opção para mostrar os contadores da cache de sugestões
+    {
+        EstatisticasCacheSugestoes estatisticas;
+        estatisticasCacheSugestoes(dicionario, &estatisticas);
+
+        size_t consultas = estatisticas.acertos + estatisticas.falhas;
+        printf("Cache de sugestões: %zu entradas.\n",
+               dicionario->sugestoes != NULL ? dicionario->sugestoes->totalConjuntos * VIAS_CACHE_SUGESTOES : 0);
+        printf("Acertos: %zu  Falhas: %zu  (%.1f%% de acertos)\n", estatisticas.acertos, estatisticas.falhas,
+               consultas > 0 ? 100.0 * (double)estatisticas.acertos / (double)consultas : 0.0);
+        printf("Invalidadas por alterações: %zu  Revalidadas: %zu  Substituídas: %zu\n", estatisticas.invalidadas,
+               estatisticas.revalidadas, estatisticas.substituidas);
+        system("pause");
+        break;
+    }
+    case 16: // Opção para ligar ou desligar o filtro de Bloom
+        // No modo concorrente, trocar o filtro é uma escrita: é feita com o trinco dos escritores.
+        if (dicionario->concorrencia != NULL)
+            pthread_mutex_lock(&dicionario->concorrencia->trincoEscrita);
+
+        if (dicionario->filtro != NULL)
+        {
+            desligarFiltroDicionario(dicionario);
+            printf("Filtro de Bloom desligado.\n");
+        }
+        else if (construirFiltroDicionario(dicionario))
+        {
+            printf("Filtro de Bloom ligado: %zu palavras em %zu KiB.\n", dicionario->filtro->inseridas,
+                   (size_t)dicionario->filtro->totalBlocos * PALAVRAS_POR_BLOCO_FILTRO * sizeof(uint64_t) / 1024);
+        }
+        else
+        {
+            printf("Não foi possível construir o filtro de Bloom.\n");
+        }
+
+        if (dicionario->concorrencia != NULL)
+            pthread_mutex_unlock(&dicionario->concorrencia->trincoEscrita);
+        system("pause");
+        break;
+    case 17: // Opção para ligar ou desligar o modo concorrente (leitores sem trincos, escritas por cópia do caminho)
+        if (dicionario->concorrencia != NULL)
+        {
+            desligarModoConcorrente(dicionario);
+            printf("Modo concorrente desligado.\n");
         }
+        else if (ligarModoConcorrente(dicionario))
+        {
+            printf("Modo concorrente ligado: as inserções e remoções copiam o caminho alterado.\n");
+        }
+        else
+        {
+            printf("Não foi possível ligar o modo concorrente.\n");
+        }
+        system("pause");
+        break;
+    case 18: // Opção para servir o dicionário a outros processos num socket Unix
+        printf("Insira o caminho do socket: ");
+        scanf(" %s", palavra);
+        if (!servirDicionario(dicionario, palavra))
+            printf("Não foi possível iniciar o servidor.\n");
+        system("pause");
+        break;
+    case 19: // Opção para mostrar as estatísticas das operações (contadores e histogramas de latência)
+        imprimirEstatisticasDicionario(stdout);
+        printf("Reiniciar as estatísticas? (s/n): ");
+        scanf(" %s", palavra);
+        if (palavra[0] == 's' || palavra[0] == 'S')
+            reiniciarEstatisticasDicionario();
+        system("pause");
+        break;
+    case 20: // Opção para mostrar as k palavras de maior peso (frequência) com um prefixo
+    {
+        int k;
+
+        printf("Insira o prefixo: ");
+        scanf(" %s", palavra);
+        printf("Insira quantas sugestões mostrar (0 para %d): ", SUGESTOES_AUTOCOMPLETAR);
+        scanf("%d", &k);
+        autocompletarPrefixo(dicionario, palavra, k > 0 ? (size_t)k : SUGESTOES_AUTOCOMPLETAR);
+        system("pause");
+        break;
+    }
+    case 21: // Opção para vigiar o ficheiro e recarregar as alterações automaticamente (ou mostrar e desligar a vigia)
+    {
+        ResultadoRecarga ultima;
+        size_t recargas, falhas;
+
+        if (consultarVigiaFicheiro(dicionario, &ultima, &recargas, &falhas))
+        {
+            printf("A vigiar %s: %zu recarga(s), %zu falha(s).\n", dicionario->vigia->nomeFicheiro, recargas, falhas);
+            printf("Última recarga (%s): %zu inseridas, %zu removidas, %zu pesos alterados, %llu bytes comparados em %.2f ms.\n",
+                   ultima.incremental ? "incremental" : "completa", ultima.inseridas, ultima.removidas,
+                   ultima.pesosAlterados, (unsigned long long)ultima.bytesComparados, ultima.segundos * 1e3);
+            printf("Desligar a vigia? (s/n): ");
+            scanf(" %s", palavra);
+            if (palavra[0] == 's' || palavra[0] == 'S')
+            {
+                desligarVigiaFicheiro(dicionario);
+                printf("Vigia do ficheiro desligada (o modo concorrente continua ligado).\n");
+            }
+        }
+        else if (ligarVigiaFicheiro(dicionario, nomeFicheiro))
+        {
+            printf("A vigiar %s: as alterações gravadas são recarregadas automaticamente (modo concorrente ligado).\n",
+                   nomeFicheiro);
+        }
+        else
+        {
+            printf("Não foi possível vigiar o ficheiro %s.\n", nomeFicheiro);
+        }
+        system("pause");
+        break;
+    }
+    case 22: // Opção para mostrar o diário de alterações e compactá-lo num instantâneo
+    {
+        EstatisticasDiario diario;
+
+        if (!consultarDiarioAlteracoes(dicionario, &diario))
+        {
+            printf("O diário de alterações não está aberto.\n");
+            system("pause");
+            break;
+        }
+
+        printf("Diário %s%s: %llu bytes, última entrada %llu (no disco até à %llu).\n", nomeFicheiro, EXTENSAO_DIARIO,
+               (unsigned long long)diario.tamanhoFicheiro, (unsigned long long)diario.ultimaSequencia,
+               (unsigned long long)diario.sequenciaDuravel);
+        printf("%zu entrada(s) reposta(s) no arranque, %zu registada(s) desde então em %zu escrita(s) sincronizada(s).\n",
+               diario.repostas, diario.entradas, diario.sincronizacoes);
+        printf("%zu compactação(ões), %zu com instantâneo.%s\n", diario.compactacoes, diario.instantaneos,
+               diario.falhou ? " Uma escrita falhou: as alterações seguintes ficam só em memória." : "");
+        printf("Compactar o diário agora? (s/n): ");
+        scanf(" %s", palavra);
+        if (palavra[0] == 's' || palavra[0] == 'S')
+        {
+            if (compactarDiarioAlteracoes(dicionario))
+                printf("A compactação está a decorrer em segundo plano.\n");
+            else
+                printf("Já há uma compactação em curso (ou faltou memória).\n");
+        }
+        system("pause");
+        break;
+    }
+    case 23: // Opção para ligar ou desligar o índice dobrado e consultar uma palavra sem maiúsculas nem acentos
+    {
+        bool primeira = true;
+
+        if (dicionario->dobrado == NULL)
+        {
+            dicionario->dobrarAoCarregar = true;
+            if (!construirIndiceDobrado(dicionario))
+            {
+                printf("Não foi possível construir o índice dobrado.\n");
                 system("pause");
+                break;
+            }
+        }
+
+        printf("Índice dobrado: %zu formas de %zu grafias.\n", dicionario->dobrado->totalFormas,
+               dicionario->dobrado->totalGrafias - dicionario->dobrado->retiradas);
+        printf("Insira a palavra a consultar (- para desligar o índice): ");
+        scanf(" %s", palavra);
+        if (strcmp(palavra, "-") == 0)
+        {
+            dicionario->dobrarAoCarregar = false;
+            desligarIndiceDobrado(dicionario);
+            printf("Índice dobrado desligado.\n");
+        }
+        else if (procurarPalavraDobrada(dicionario, palavra, imprimirGrafiaDobrada, &primeira) > 0)
+            printf("\n");
+        else
+            printf("Nenhuma palavra do dicionário tem a forma dobrada de '%s'.\n", palavra);
+        system("pause");
+        break;
+    }
+    case 24: // Opção para compactar a Trie (podar os ramos sem palavras, reequilibrar os níveis e reagrupar os nós)
+    {
+        ResultadoCompactacao resultado;
+
+        if (!compactarTrie(dicionario, &resultado))
+        {
+            printf("A compactação só trabalha sobre a Trie de ponteiros, fora do modo concorrente (ou faltou memória).\n");
+            system("pause");
+            break;
+        }
 
+        printf("Compactação concluída em %zu fatia(s) de até %d nós.\n", resultado.fatias, NOS_POR_FATIA_COMPACTACAO);
+        printf("Nós: %zu -> %zu (%zu podados, %zu níveis reequilibrados).\n", resultado.nosAntes, resultado.nosDepois,
+               resultado.nosPodados, resultado.niveisReequilibrados);
+        printf("Memória da arena: %.1f KiB -> %.1f KiB (%.1f KiB recuperados).\n", resultado.bytesAntes / 1024.0,
+               resultado.bytesDepois / 1024.0,
+               resultado.bytesAntes > resultado.bytesDepois ? (resultado.bytesAntes - resultado.bytesDepois) / 1024.0 : 0.0);
+        printf("Nós comparados por palavra: %.2f -> %.2f em média, %u -> %u no máximo.\n", resultado.profundidadeAntes,
+               resultado.profundidadeDepois, resultado.profundidadeMaximaAntes, resultado.profundidadeMaximaDepois);
+        system("pause");
         break;
+    }
     default:
         printf("Opção inválida! Por favor, escolha uma opção válida.\n");
     }
@@ -848,6 +8560,20 @@ void menu(int opcao_selecionada)
     printf("%s[8] Verificador ortográfico\n", opcao_selecionada == 8 ? "\033[1;32m->\033[0m" : "  ");
     printf("%s[9] Índice\n", opcao_selecionada == 9 ? "\033[1;32m->\033[0m" : "  ");
     printf("%s[10] Verificar integridade do ficheiro\n", opcao_selecionada == 10 ? "\033[1;32m->\033[0m" : "  ");
+    printf("%s[11] Relatório dos layouts (memória e ns/consulta)\n", opcao_selecionada == 11 ? "\033[1;32m->\033[0m" : "  ");
+    printf("%s[12] Congelar/descongelar (layout compacto ou minimizado)\n", opcao_selecionada == 12 ? "\033[1;32m->\033[0m" : "  ");
+    printf("%s[13] Ligar/desligar rastreio das consultas\n", opcao_selecionada == 13 ? "\033[1;32m->\033[0m" : "  ");
+    printf("%s[14] Verificador ortográfico em lote (sem interação)\n", opcao_selecionada == 14 ? "\033[1;32m->\033[0m" : "  ");
+    printf("%s[15] Estatísticas da cache de sugestões\n", opcao_selecionada == 15 ? "\033[1;32m->\033[0m" : "  ");
+    printf("%s[16] Ligar/desligar filtro de Bloom\n", opcao_selecionada == 16 ? "\033[1;32m->\033[0m" : "  ");
+    printf("%s[17] Ligar/desligar modo concorrente\n", opcao_selecionada == 17 ? "\033[1;32m->\033[0m" : "  ");
+    printf("%s[18] Servidor local (socket Unix)\n", opcao_selecionada == 18 ? "\033[1;32m->\033[0m" : "  ");
+    printf("%s[19] Estatísticas das operações\n", opcao_selecionada == 19 ? "\033[1;32m->\033[0m" : "  ");
+    printf("%s[20] Autocompletar (palavras de maior peso com um prefixo)\n", opcao_selecionada == 20 ? "\033[1;32m->\033[0m" : "  ");
+    printf("%s[21] Vigiar o ficheiro (recarregar as alterações automaticamente)\n", opcao_selecionada == 21 ? "\033[1;32m->\033[0m" : "  ");
+    printf("%s[22] Diário de alterações (estado e compactação)\n", opcao_selecionada == 22 ? "\033[1;32m->\033[0m" : "  ");
+    printf("%s[23] Índice sem maiúsculas nem acentos (consultar ou desligar)\n", opcao_selecionada == 23 ? "\033[1;32m->\033[0m" : "  ");
+    printf("%s[24] Compactar a Trie (podar, reequilibrar e reagrupar os nós)\n", opcao_selecionada == 24 ? "\033[1;32m->\033[0m" : "  ");
     printf("%s[0] Sair\n", opcao_selecionada == 0 ? "\033[1;32m->\033[0m" : "  ");
     printf("\n");
 }
@@ -894,6 +8620,9 @@ void iniciarPrograma()
 {
     // Inicializar o dicionário
     Dicionario *dicionario = inicializarDicionario();
+    // O programa interativo aceita as palavras sem maiúsculas nem acentos (ver a verificação ortográfica)
+    if (dicionario != NULL)
+        dicionario->dobrarAoCarregar = true;
     system("pause");
     // Obtendo o nome do arquivo passando o caminho até ele.
     const char *nomeFicheiro = "dictionary.txt";
@@ -0,0 +1,837 @@
+// ================================ DEFINIÇÕES DO SISTEMA ============================
+
+// Ativa as extensões POSIX/GNU (epoll, accept4, MSG_NOSIGNAL) antes de incluir qualquer biblioteca.
+#define _GNU_SOURCE
+
+// ================================ BIBLIOTECAS INCLUÍDAS ============================
+
+// Biblioteca personalizada para operações específicas do dicionário.
+#include "dicionario.h"
+
+// Biblioteca padrão do C para funções gerais, como alocação de memória.
+#include <stdlib.h>
+
+// Biblioteca padrão do C para entrada e saída de dados.
+#include <stdio.h>
+
+// Biblioteca padrão de strings do C (memcpy, memchr, memmove).
+#include <string.h>
+
+// Biblioteca padrão do C para medir o tempo (estatísticas do servidor).
+#include <time.h>
+
+// Bibliotecas POSIX para sockets Unix, epoll e sinais.
+#include <errno.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// ================================ FUNÇÕES DO SERVIDOR ==============================
+// As implementações das funções do servidor declaradas no arquivo 'dicionario.h' ocorrem aqui.
+//
+// Cada pedido é uma trama "u32 comprimento | u8 operação | u32 identificador | dados", em little-endian, onde o
+// comprimento conta os bytes que se seguem a ele. Cada resposta é "u32 comprimento | u8 estado | u32 identificador |
+// dados". Um cliente pode enviar vários pedidos sem esperar pelas respostas (pipelining): o servidor processa todas
+// as tramas completas que recebeu de uma vez e devolve as respostas pela mesma ordem, com uma só escrita.
+
+// Struct auxiliar com o estado de uma ligação de um cliente.
+typedef struct LigacaoServidor
+{
+    int descritor;
+    unsigned char *entrada;          // Bytes recebidos ainda por processar.
+    size_t tamanhoEntrada, capacidadeEntrada;
+    unsigned char *saida;            // Respostas ainda por enviar (a partir de 'enviados').
+    size_t tamanhoSaida, enviados, capacidadeSaida;
+    bool registada;                  // Se a ligação está no epoll (sai dele enquanto espera pelo diário).
+    uint32_t eventos;                // Eventos pedidos ao epoll enquanto está registada.
+    bool fimEntrada;                 // O cliente fechou o seu lado: fecha-se depois de responder.
+    bool falhou;                     // Falta de memória ou trama inválida: a ligação é fechada.
+    uint64_t sequenciaDiario;        // Última alteração registada cuja resposta está na saída (0 se não houver);
+                                     // enquanto não estiver no disco, a ligação não envia nem processa pedidos.
+    struct LigacaoServidor *anterior, *proxima; // Lista das ligações abertas (fechadas no fim do servidor).
+} LigacaoServidor;
+
+// Struct auxiliar com o estado do servidor.
+typedef struct
+{
+    int epoll;
+    int avisoDiario;                 // Descritor que avisa das escritas do diário (-1: espera-se com esperarDiario).
+    LigacaoServidor *ligacoes;       // Ligações abertas.
+    size_t totalLigacoes;            // Ligações aceites desde o início.
+    size_t pedidos;                  // Pedidos atendidos desde o início.
+} EstadoServidor;
+
+// Indica se foi pedido o fim do servidor (por sinal ou pela operação OPERACAO_ENCERRAR).
+static volatile sig_atomic_t servidorTerminar = 0;
+
+// Trata SIGINT e SIGTERM: o ciclo de eventos termina na próxima iteração.
+static void tratarSinalServidor(int sinal)
+{
+    (void)sinal;
+    servidorTerminar = 1;
+}
+
+// *********************************** CODIFICAÇÃO ***********************************
+
+// Lê um inteiro de 16 bits em little-endian.
+static uint16_t lerU16(const unsigned char *dados)
+{
+    return (uint16_t)(dados[0] | (dados[1] << 8));
+}
+
+// Lê um inteiro de 32 bits em little-endian.
+static uint32_t lerU32(const unsigned char *dados)
+{
+    return (uint32_t)dados[0] | ((uint32_t)dados[1] << 8) | ((uint32_t)dados[2] << 16) | ((uint32_t)dados[3] << 24);
+}
+
+// Escreve um inteiro de 32 bits em little-endian.
+static void escreverU32(unsigned char *dados, uint32_t valor)
+{
+    dados[0] = (unsigned char)valor;
+    dados[1] = (unsigned char)(valor >> 8);
+    dados[2] = (unsigned char)(valor >> 16);
+    dados[3] = (unsigned char)(valor >> 24);
+}
+
+// Garante espaço para mais 'tamanho' bytes na saída de uma ligação.
+static bool reservarSaida(LigacaoServidor *ligacao, size_t tamanho)
+{
+    if (ligacao->tamanhoSaida + tamanho <= ligacao->capacidadeSaida)
+        return true;
+
+    size_t capacidade = ligacao->capacidadeSaida ? ligacao->capacidadeSaida : 1 << 16;
+    while (capacidade < ligacao->tamanhoSaida + tamanho)
+        capacidade *= 2;
+
+    unsigned char *maior = (unsigned char *)realloc(ligacao->saida, capacidade);
+    if (maior == NULL)
+    {
+        ligacao->falhou = true;
+        return false;
+    }
+    ligacao->saida = maior;
+    ligacao->capacidadeSaida = capacidade;
+    return true;
+}
+
+// Acrescenta bytes à resposta em construção.
+static bool acrescentarSaida(LigacaoServidor *ligacao, const void *dados, size_t tamanho)
+{
+    if (!reservarSaida(ligacao, tamanho))
+        return false;
+
+    memcpy(ligacao->saida + ligacao->tamanhoSaida, dados, tamanho);
+    ligacao->tamanhoSaida += tamanho;
+    return true;
+}
+
+// Acrescenta um inteiro de 32 bits à resposta em construção.
+static bool acrescentarU32(LigacaoServidor *ligacao, uint32_t valor)
+{
+    unsigned char dados[4];
+    escreverU32(dados, valor);
+    return acrescentarSaida(ligacao, dados, sizeof(dados));
+}
+
+// Reserva o cabeçalho de uma resposta e devolve a posição onde ele começa.
+static size_t iniciarResposta(LigacaoServidor *ligacao, uint32_t identificador)
+{
+    size_t inicio = ligacao->tamanhoSaida;
+    unsigned char cabecalho[TAMANHO_CABECALHO_TRAMA] = {0};
+
+    escreverU32(cabecalho + 5, identificador);
+    acrescentarSaida(ligacao, cabecalho, sizeof(cabecalho));
+    return inicio;
+}
+
+// Preenche o comprimento e o estado de uma resposta cujos dados já foram acrescentados. Se a resposta não chegou a
+// ser construída por falta de memória, a ligação é fechada.
+static void terminarResposta(LigacaoServidor *ligacao, size_t inicio, EstadoResposta estado)
+{
+    if (ligacao->falhou)
+        return;
+
+    // Uma resposta de erro não leva dados.
+    if (estado != RESPOSTA_OK)
+        ligacao->tamanhoSaida = inicio + TAMANHO_CABECALHO_TRAMA;
+
+    escreverU32(ligacao->saida + inicio, (uint32_t)(ligacao->tamanhoSaida - inicio - 4));
+    ligacao->saida[inicio + 4] = (unsigned char)estado;
+}
+
+// Copia uma palavra dos dados de um pedido para um buffer terminado em '\0'. Rejeita palavras vazias, longas demais
+// ou com bytes nulos.
+static bool lerPalavraPedido(const unsigned char *dados, size_t tamanho, char *palavra)
+{
+    if (tamanho == 0 || tamanho >= MAX_TAMANHO_PALAVRA || memchr(dados, '\0', tamanho) != NULL)
+        return false;
+
+    memcpy(palavra, dados, tamanho);
+    palavra[tamanho] = '\0';
+    return true;
+}
+
+// *********************************** OPERAÇÕES ***********************************
+
+// Struct auxiliar para acrescentar resultados de enumerações à resposta, até um limite.
+typedef struct
+{
+    LigacaoServidor *ligacao;
+    uint32_t total;
+    uint32_t limite;
+} ResultadosServidor;
+
+// Acrescenta uma palavra de uma procura por prefixo (u8 comprimento | bytes).
+static bool acrescentarPalavraPrefixo(const char *palavra, void *contexto)
+{
+    ResultadosServidor *resultados = (ResultadosServidor *)contexto;
+    unsigned char comprimento = (unsigned char)strlen(palavra);
+
+    if (!acrescentarSaida(resultados->ligacao, &comprimento, 1) ||
+        !acrescentarSaida(resultados->ligacao, palavra, comprimento))
+        return false;
+
+    return ++resultados->total < resultados->limite;
+}
+
+// Acrescenta uma palavra de uma procura por distância (u8 distância | u8 comprimento | bytes), até ao limite.
+static void acrescentarPalavraDistancia(const char *palavra, int distancia, void *contexto)
+{
+    ResultadosServidor *resultados = (ResultadosServidor *)contexto;
+    unsigned char cabecalho[2] = {(unsigned char)distancia, (unsigned char)strlen(palavra)};
+
+    if (resultados->total >= resultados->limite || resultados->ligacao->falhou)
+        return;
+
+    if (acrescentarSaida(resultados->ligacao, cabecalho, sizeof(cabecalho)))
+        acrescentarSaida(resultados->ligacao, palavra, cabecalho[1]);
+    resultados->total++;
+}
+
+// Acrescenta uma sugestão do autocompletar (u32 peso | u8 comprimento | bytes).
+static void acrescentarPalavraPeso(const char *palavra, uint32_t peso, void *contexto)
+{
+    ResultadosServidor *resultados = (ResultadosServidor *)contexto;
+    unsigned char comprimento = (unsigned char)strlen(palavra);
+
+    if (resultados->ligacao->falhou)
+        return;
+
+    if (acrescentarU32(resultados->ligacao, peso) && acrescentarSaida(resultados->ligacao, &comprimento, 1))
+        acrescentarSaida(resultados->ligacao, palavra, comprimento);
+    resultados->total++;
+}
+
+// Aplica uma alteração pedida pelo cliente e regista-a no diário (se estiver aberto); a resposta só é enviada depois
+// de a alteração estar no disco (ver esperarAlteracoes). Uma alteração que o diário já não regista
+// (SEQUENCIA_DIARIO_FALHADA) nunca fica no disco: a ligação é fechada sem a confirmar.
+static void registarAlteracaoPedido(Dicionario *dicionario, LigacaoServidor *ligacao, TipoEntradaDiario tipo,
+                                    const char *palavra, uint32_t peso)
+{
+    uint64_t sequencia = aplicarAlteracaoRegistada(dicionario, tipo, palavra, NULL, peso);
+    if (sequencia > ligacao->sequenciaDiario)
+        ligacao->sequenciaDiario = sequencia;
+}
+
+// Executa um pedido e acrescenta a sua resposta à saída da ligação.
+static void executarPedido(Dicionario *dicionario, LigacaoServidor *ligacao, uint8_t operacao, uint32_t identificador,
+                           const unsigned char *dados, size_t tamanho)
+{
+    char palavra[MAX_TAMANHO_PALAVRA];
+    size_t inicio = iniciarResposta(ligacao, identificador);
+    EstadoResposta estado = RESPOSTA_OK;
+
+    switch (operacao)
+    {
+    case OPERACAO_CONSULTAR: // dados: palavra -> u8 existe
+    {
+        if (!lerPalavraPedido(dados, tamanho, palavra))
+        {
+            estado = RESPOSTA_PEDIDO_INVALIDO;
+            break;
+        }
+        unsigned char existe = contemPalavra(dicionario, palavra);
+        acrescentarSaida(ligacao, &existe, 1);
+        break;
+    }
+    case OPERACAO_CONSULTAR_LOTE: // dados: u32 total | (u8 comprimento | bytes)* -> u32 encontradas | mapa de bits
+    {
+        if (tamanho < 4)
+        {
+            estado = RESPOSTA_PEDIDO_INVALIDO;
+            break;
+        }
+
+        uint32_t total = lerU32(dados);
+        size_t posicao = 4, encontradas = 0;
+        size_t inicioMapa = ligacao->tamanhoSaida + 4;
+
+        // O mapa de bits é reservado e zerado antes de percorrer as palavras.
+        if (total > tamanho || !acrescentarU32(ligacao, 0) || !reservarSaida(ligacao, (total + 7) / 8))
+        {
+            estado = ligacao->falhou ? RESPOSTA_FALHA : RESPOSTA_PEDIDO_INVALIDO;
+            break;
+        }
+        memset(ligacao->saida + inicioMapa, 0, (total + 7) / 8);
+        ligacao->tamanhoSaida += (total + 7) / 8;
+
+        for (uint32_t i = 0; i < total && estado == RESPOSTA_OK; i++)
+        {
+            size_t comprimento = posicao < tamanho ? dados[posicao] : 0;
+            if (posicao + 1 + comprimento > tamanho || !lerPalavraPedido(dados + posicao + 1, comprimento, palavra))
+            {
+                estado = RESPOSTA_PEDIDO_INVALIDO;
+                break;
+            }
+            posicao += 1 + comprimento;
+
+            if (contemPalavra(dicionario, palavra))
+            {
+                ligacao->saida[inicioMapa + i / 8] |= (unsigned char)(1 << (i % 8));
+                encontradas++;
+            }
+        }
+
+        if (estado == RESPOSTA_OK)
+            escreverU32(ligacao->saida + inicioMapa - 4, (uint32_t)encontradas);
+        break;
+    }
+    case OPERACAO_PREFIXO: // dados: u16 limite | prefixo -> u32 total | (u8 comprimento | bytes)*
+    {
+        char prefixo[MAX_TAMANHO_PALAVRA];
+        if (tamanho < 2 || tamanho - 2 >= MAX_TAMANHO_PALAVRA || memchr(dados + 2, '\0', tamanho - 2) != NULL)
+        {
+            estado = RESPOSTA_PEDIDO_INVALIDO;
+            break;
+        }
+        memcpy(prefixo, dados + 2, tamanho - 2);
+        prefixo[tamanho - 2] = '\0';
+
+        ResultadosServidor resultados = {ligacao, 0, lerU16(dados) ? lerU16(dados) : MAX_RESULTADOS_SERVIDOR};
+        size_t posicaoTotal = ligacao->tamanhoSaida;
+        if (acrescentarU32(ligacao, 0))
+            procurarPorPrefixo(dicionario, prefixo, acrescentarPalavraPrefixo, &resultados);
+        if (!ligacao->falhou)
+            escreverU32(ligacao->saida + posicaoTotal, resultados.total);
+        break;
+    }
+    case OPERACAO_AUTOCOMPLETAR: // dados: u16 k | prefixo -> u32 total | (u32 peso | u8 comprimento | bytes)*
+    {
+        char prefixo[MAX_TAMANHO_PALAVRA];
+        if (tamanho < 2 || tamanho - 2 >= MAX_TAMANHO_PALAVRA || memchr(dados + 2, '\0', tamanho - 2) != NULL)
+        {
+            estado = RESPOSTA_PEDIDO_INVALIDO;
+            break;
+        }
+        memcpy(prefixo, dados + 2, tamanho - 2);
+        prefixo[tamanho - 2] = '\0';
+
+        // k = 0 pede o número de sugestões por omissão; nunca mais do que MAX_RESULTADOS_SERVIDOR.
+        size_t k = lerU16(dados) ? lerU16(dados) : SUGESTOES_AUTOCOMPLETAR;
+        if (k > MAX_RESULTADOS_SERVIDOR)
+            k = MAX_RESULTADOS_SERVIDOR;
+
+        ResultadosServidor resultados = {ligacao, 0, (uint32_t)k};
+        size_t posicaoTotal = ligacao->tamanhoSaida;
+        if (acrescentarU32(ligacao, 0))
+            melhoresComPrefixo(dicionario, prefixo, k, acrescentarPalavraPeso, &resultados);
+        if (!ligacao->falhou)
+            escreverU32(ligacao->saida + posicaoTotal, resultados.total);
+        break;
+    }
+    case OPERACAO_PREFIXO_MAIS_LONGO: // dados: palavra -> prefixo mais longo que é palavra (pode ser vazio)
+    {
+        if (!lerPalavraPedido(dados, tamanho, palavra))
+        {
+            estado = RESPOSTA_PEDIDO_INVALIDO;
+            break;
+        }
+        char *prefixo = prefixoMaisLongo(dicionario, palavra);
+        if (prefixo == NULL)
+        {
+            estado = RESPOSTA_FALHA;
+            break;
+        }
+        acrescentarSaida(ligacao, prefixo, strlen(prefixo));
+        free(prefixo);
+        break;
+    }
+    case OPERACAO_DISTANCIA: // dados: u8 distância | u8 modo | u16 limite | palavra -> u32 total | (u8 d | u8 c | bytes)*
+    {
+        if (tamanho < 4 || dados[1] > DISTANCIA_MAXIMA || !lerPalavraPedido(dados + 4, tamanho - 4, palavra))
+        {
+            estado = RESPOSTA_PEDIDO_INVALIDO;
+            break;
+        }
+
+        ResultadosServidor resultados = {ligacao, 0, lerU16(dados + 2) ? lerU16(dados + 2) : MAX_RESULTADOS_SERVIDOR};
+        size_t posicaoTotal = ligacao->tamanhoSaida;
+        if (acrescentarU32(ligacao, 0))
+            procurarPorDistancia(dicionario, palavra, dados[0], (ModoDistancia)dados[1], acrescentarPalavraDistancia,
+                                 &resultados);
+        if (!ligacao->falhou)
+            escreverU32(ligacao->saida + posicaoTotal, resultados.total);
+        break;
+    }
+    case OPERACAO_INSERIR: // dados: palavra -> u8 (1 se a palavra era nova)
+    case OPERACAO_REMOVER: // dados: palavra -> u8 (1 se a palavra existia)
+    {
+        if (!lerPalavraPedido(dados, tamanho, palavra))
+        {
+            estado = RESPOSTA_PEDIDO_INVALIDO;
+            break;
+        }
+
+        bool existia = contemPalavra(dicionario, palavra);
+        unsigned char alterou = operacao == OPERACAO_INSERIR ? !existia : existia;
+        if (alterou)
+            registarAlteracaoPedido(dicionario, ligacao, operacao == OPERACAO_INSERIR ? DIARIO_INSERIR : DIARIO_REMOVER,
+                                    palavra, 0);
+        acrescentarSaida(ligacao, &alterou, 1);
+        break;
+    }
+    case OPERACAO_INSERIR_COM_PESO: // dados: u32 peso | palavra -> u8 (1 se a palavra era nova, 0 se só mudou o peso)
+    {
+        if (tamanho < 4 || !lerPalavraPedido(dados + 4, tamanho - 4, palavra))
+        {
+            estado = RESPOSTA_PEDIDO_INVALIDO;
+            break;
+        }
+
+        // Um peso igual ao que a palavra já tem não altera nada: não vai ao diário nem espera por ele.
+        uint32_t peso = lerU32(dados), pesoAtual = 0;
+        unsigned char nova = !pesoPalavra(dicionario, palavra, &pesoAtual);
+        if (nova || pesoAtual != peso)
+            registarAlteracaoPedido(dicionario, ligacao, DIARIO_INSERIR_COM_PESO, palavra, peso);
+        acrescentarSaida(ligacao, &nova, 1);
+        break;
+    }
+    case OPERACAO_ENCERRAR: // sem dados: o servidor termina depois de enviar as respostas pendentes
+        servidorTerminar = 1;
+        break;
+    case OPERACAO_ESTATISTICAS: // sem dados -> texto de imprimirEstatisticasDicionario
+    {
+        char *texto = NULL;
+        size_t tamanhoTexto = 0;
+        FILE *memoria = open_memstream(&texto, &tamanhoTexto);
+        if (memoria == NULL)
+        {
+            estado = RESPOSTA_FALHA;
+            break;
+        }
+        imprimirEstatisticasDicionario(memoria);
+        fclose(memoria);
+        acrescentarSaida(ligacao, texto, tamanhoTexto);
+        free(texto);
+        break;
+    }
+    default:
+        estado = RESPOSTA_OPERACAO_DESCONHECIDA;
+    }
+
+    if (ligacao->falhou && estado == RESPOSTA_OK)
+        estado = RESPOSTA_FALHA;
+    terminarResposta(ligacao, inicio, estado);
+}
+
+// *********************************** LIGAÇÕES ***********************************
+
+// Processa todas as tramas completas que estão na entrada (pipelining), parando se a saída pendente ficar grande
+// demais. Devolve falso se a ligação tiver de ser fechada.
+static bool processarEntrada(Dicionario *dicionario, LigacaoServidor *ligacao, EstadoServidor *servidor)
+{
+    size_t posicao = 0;
+
+    while (ligacao->tamanhoEntrada - posicao >= 4 &&
+           ligacao->tamanhoSaida - ligacao->enviados < MAX_SAIDA_PENDENTE_SERVIDOR)
+    {
+        uint32_t comprimento = lerU32(ligacao->entrada + posicao);
+        if (comprimento < TAMANHO_CABECALHO_TRAMA - 4 || comprimento > MAX_PEDIDO_SERVIDOR)
+            return false;
+        if (ligacao->tamanhoEntrada - posicao - 4 < comprimento)
+            break;
+
+        const unsigned char *trama = ligacao->entrada + posicao;
+        executarPedido(dicionario, ligacao, trama[4], lerU32(trama + 5), trama + TAMANHO_CABECALHO_TRAMA,
+                       comprimento - (TAMANHO_CABECALHO_TRAMA - 4));
+        if (ligacao->falhou)
+            return false;
+
+        posicao += 4 + comprimento;
+        servidor->pedidos++;
+    }
+
+    // Guardar a trama incompleta (ou as que ficaram à espera) no início do buffer.
+    memmove(ligacao->entrada, ligacao->entrada + posicao, ligacao->tamanhoEntrada - posicao);
+    ligacao->tamanhoEntrada -= posicao;
+    return true;
+}
+
+// Indica se há pelo menos uma trama completa (ou inválida) à espera na entrada.
+static bool haTramaCompleta(const LigacaoServidor *ligacao)
+{
+    return ligacao->tamanhoEntrada >= 4 && ligacao->tamanhoEntrada - 4 >= lerU32(ligacao->entrada);
+}
+
+// Verifica se as alterações cujas respostas estão na saída já estão no diário: todas as tramas recebidas de uma vez
+// partilham a mesma espera (e, em regra, o mesmo fdatasync). Com o aviso do diário o ciclo de eventos não bloqueia:
+// se ainda não estiverem, 'sequenciaDiario' fica e a ligação é retomada quando o aviso chegar
+// (ver retomarLigacoesDuraveis). Devolve falso se a escrita do diário falhou.
+static bool esperarAlteracoes(Dicionario *dicionario, LigacaoServidor *ligacao, const EstadoServidor *servidor)
+{
+    if (ligacao->sequenciaDiario == 0)
+        return true;
+
+    bool duravel, falhou = false;
+    if (servidor->avisoDiario < 0)
+        duravel = esperarDiario(dicionario, ligacao->sequenciaDiario);
+    else
+    {
+        duravel = consultarDiarioDuravel(dicionario, ligacao->sequenciaDiario, &falhou);
+        if (!duravel && !falhou)
+            return true;
+    }
+    ligacao->sequenciaDiario = 0;
+    if (!duravel)
+        fprintf(stderr, "Servidor: o diário de alterações falhou; a ligação é fechada.\n");
+    return duravel;
+}
+
+// Envia o máximo possível da saída pendente sem bloquear. Devolve falso se a ligação falhou.
+static bool enviarSaida(LigacaoServidor *ligacao)
+{
+    while (ligacao->enviados < ligacao->tamanhoSaida)
+    {
+        ssize_t enviados = send(ligacao->descritor, ligacao->saida + ligacao->enviados,
+                                ligacao->tamanhoSaida - ligacao->enviados, MSG_NOSIGNAL);
+        if (enviados < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        ligacao->enviados += (size_t)enviados;
+    }
+
+    ligacao->tamanhoSaida = 0;
+    ligacao->enviados = 0;
+    return true;
+}
+
+// Processa os pedidos recebidos e envia as respostas, repetindo enquanto a saída esvaziar e houver pedidos que
+// ficaram à espera por causa do controlo de fluxo. Devolve falso se a ligação tiver de ser fechada.
+static bool atenderLigacao(Dicionario *dicionario, LigacaoServidor *ligacao, EstadoServidor *servidor)
+{
+    do
+    {
+        // Uma ligação à espera do diário só continua quando as suas alterações estiverem no disco.
+        if ((ligacao->sequenciaDiario == 0 && !processarEntrada(dicionario, ligacao, servidor)) ||
+            !esperarAlteracoes(dicionario, ligacao, servidor))
+            return false;
+        if (ligacao->sequenciaDiario != 0)
+            return true;
+        if (!enviarSaida(ligacao))
+            return false;
+    } while (ligacao->tamanhoSaida == 0 && haTramaCompleta(ligacao));
+
+    // Um cliente que fechou o seu lado já recebeu tudo: a trama incompleta que sobrar nunca vai terminar.
+    return !(ligacao->fimEntrada && ligacao->tamanhoSaida == 0);
+}
+
+// Atualiza os eventos pedidos ao epoll: escrita enquanto houver saída pendente e leitura enquanto ela não for
+// grande demais (controlo de fluxo de um cliente que envia pedidos sem ler as respostas). Uma ligação à espera do
+// diário sai do epoll, que a acordaria sem parar com o EPOLLHUP ou o EPOLLERR de um cliente que fechou (assinalados
+// mesmo sem eventos pedidos), e volta a entrar quando for retomada pelo aviso.
+static void atualizarEventos(int epoll, LigacaoServidor *ligacao)
+{
+    struct epoll_event evento;
+
+    if (ligacao->sequenciaDiario != 0)
+    {
+        if (ligacao->registada)
+            epoll_ctl(epoll, EPOLL_CTL_DEL, ligacao->descritor, NULL);
+        ligacao->registada = false;
+        return;
+    }
+
+    bool pendente = ligacao->enviados < ligacao->tamanhoSaida;
+    bool aLer = !ligacao->fimEntrada && ligacao->tamanhoSaida - ligacao->enviados < MAX_SAIDA_PENDENTE_SERVIDOR;
+    uint32_t eventos = (aLer ? EPOLLIN : 0) | (pendente ? EPOLLOUT : 0);
+
+    if (ligacao->registada && eventos == ligacao->eventos)
+        return; // Caso habitual: só leitura, já registada.
+
+    evento.events = eventos;
+    evento.data.ptr = ligacao;
+    epoll_ctl(epoll, ligacao->registada ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, ligacao->descritor, &evento);
+    ligacao->registada = true;
+    ligacao->eventos = eventos;
+}
+
+// Fecha uma ligação e liberta os seus buffers.
+static void fecharLigacao(EstadoServidor *servidor, LigacaoServidor *ligacao)
+{
+    if (ligacao->anterior != NULL)
+        ligacao->anterior->proxima = ligacao->proxima;
+    else
+        servidor->ligacoes = ligacao->proxima;
+    if (ligacao->proxima != NULL)
+        ligacao->proxima->anterior = ligacao->anterior;
+
+    if (ligacao->registada)
+        epoll_ctl(servidor->epoll, EPOLL_CTL_DEL, ligacao->descritor, NULL);
+    close(ligacao->descritor);
+    free(ligacao->entrada);
+    free(ligacao->saida);
+    free(ligacao);
+}
+
+// Lê tudo o que o cliente enviou até ao momento. Devolve falso se a ligação falhou.
+static bool receberEntrada(LigacaoServidor *ligacao)
+{
+    for (;;)
+    {
+        if (ligacao->capacidadeEntrada - ligacao->tamanhoEntrada < 4096)
+        {
+            size_t capacidade = ligacao->capacidadeEntrada ? ligacao->capacidadeEntrada * 2 : 1 << 16;
+            if (capacidade > 2 * (size_t)MAX_PEDIDO_SERVIDOR + (1 << 16))
+                return true; // Buffer cheio: processar antes de ler mais.
+
+            unsigned char *maior = (unsigned char *)realloc(ligacao->entrada, capacidade);
+            if (maior == NULL)
+                return false;
+            ligacao->entrada = maior;
+            ligacao->capacidadeEntrada = capacidade;
+        }
+
+        ssize_t lidos = recv(ligacao->descritor, ligacao->entrada + ligacao->tamanhoEntrada,
+                             ligacao->capacidadeEntrada - ligacao->tamanhoEntrada, 0);
+        if (lidos > 0)
+        {
+            ligacao->tamanhoEntrada += (size_t)lidos;
+            continue;
+        }
+        if (lidos == 0)
+        {
+            ligacao->fimEntrada = true;
+            return true;
+        }
+        if (errno == EINTR)
+            continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+// Aceita todas as ligações pendentes no socket de escuta.
+static void aceitarLigacoes(int escuta, EstadoServidor *servidor)
+{
+    for (;;)
+    {
+        int descritor = accept4(escuta, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (descritor < 0)
+            return;
+
+        LigacaoServidor *ligacao = (LigacaoServidor *)calloc(1, sizeof(LigacaoServidor));
+        struct epoll_event evento;
+        evento.events = EPOLLIN;
+        evento.data.ptr = ligacao;
+
+        if (ligacao == NULL || epoll_ctl(servidor->epoll, EPOLL_CTL_ADD, descritor, &evento) != 0)
+        {
+            free(ligacao);
+            close(descritor);
+            continue;
+        }
+
+        ligacao->descritor = descritor;
+        ligacao->registada = true;
+        ligacao->eventos = EPOLLIN;
+        ligacao->proxima = servidor->ligacoes;
+        if (servidor->ligacoes != NULL)
+            servidor->ligacoes->anterior = ligacao;
+        servidor->ligacoes = ligacao;
+        servidor->totalLigacoes++;
+    }
+}
+
+// Depois de uma escrita do diário, retoma as ligações cujas alterações já estão no disco (ou fecha-as, se a escrita
+// falhou): envia as respostas retidas e processa os pedidos que entretanto ficaram à espera.
+static void retomarLigacoesDuraveis(Dicionario *dicionario, EstadoServidor *servidor)
+{
+    uint64_t avisos;
+    while (read(servidor->avisoDiario, &avisos, sizeof(avisos)) < 0 && errno == EINTR)
+        ;
+
+    LigacaoServidor *proxima;
+    for (LigacaoServidor *ligacao = servidor->ligacoes; ligacao != NULL; ligacao = proxima)
+    {
+        proxima = ligacao->proxima;
+        if (ligacao->sequenciaDiario == 0)
+            continue;
+
+        if (atenderLigacao(dicionario, ligacao, servidor))
+            atualizarEventos(servidor->epoll, ligacao);
+        else
+            fecharLigacao(servidor, ligacao);
+    }
+}
+
+// Cria o socket Unix de escuta (só acessível ao utilizador atual).
+static int criarSocketEscuta(const char *caminhoSocket)
+{
+    struct sockaddr_un endereco;
+
+    if (strlen(caminhoSocket) >= sizeof(endereco.sun_path))
+    {
+        printf("O caminho do socket é longo demais: %s\n", caminhoSocket);
+        return -1;
+    }
+
+    int escuta = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (escuta < 0)
+        return -1;
+
+    memset(&endereco, 0, sizeof(endereco));
+    endereco.sun_family = AF_UNIX;
+    strcpy(endereco.sun_path, caminhoSocket);
+
+    // Um socket deixado por uma execução anterior impediria o bind.
+    unlink(caminhoSocket);
+    mode_t mascara = umask(0077);
+    int ligado = bind(escuta, (struct sockaddr *)&endereco, sizeof(endereco));
+    umask(mascara);
+
+    if (ligado != 0 || listen(escuta, SOMAXCONN) != 0)
+    {
+        perror("Erro no socket do servidor");
+        close(escuta);
+        return -1;
+    }
+    return escuta;
+}
+
+// *********************************** CICLO DE EVENTOS ***********************************
+
+// Serve o dicionário no socket Unix indicado até receber SIGINT/SIGTERM ou a operação OPERACAO_ENCERRAR.
+// Um só thread atende todas as ligações com epoll; as alterações e as consultas são executadas pela ordem de chegada.
+// O fdatasync do diário fica na thread escritora: as respostas às alterações esperam pelo seu aviso, no mesmo epoll,
+// enquanto as outras ligações continuam a ser atendidas.
+bool servirDicionario(Dicionario *dicionario, const char *caminhoSocket)
+{
+    struct epoll_event eventos[MAX_EVENTOS_SERVIDOR];
+    struct sigaction acao, anteriorInt, anteriorTerm;
+    EstadoServidor servidor = {-1, descritorAvisoDiario(dicionario), NULL, 0, 0};
+    struct timespec inicio, fim;
+    CompactacaoTrie compactacao;
+    bool compactando = false;
+
+    int escuta = criarSocketEscuta(caminhoSocket);
+    if (escuta < 0)
+        return false;
+
+    servidor.epoll = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event evento;
+    evento.events = EPOLLIN;
+    evento.data.ptr = NULL; // O socket de escuta é o único evento sem ligação associada.
+    bool registado = servidor.epoll >= 0 && epoll_ctl(servidor.epoll, EPOLL_CTL_ADD, escuta, &evento) == 0;
+
+    // O aviso do diário é identificado pelo próprio estado do servidor.
+    evento.data.ptr = &servidor;
+    if (registado && servidor.avisoDiario >= 0)
+        registado = epoll_ctl(servidor.epoll, EPOLL_CTL_ADD, servidor.avisoDiario, &evento) == 0;
+    if (!registado)
+    {
+        perror("Erro no epoll do servidor");
+        if (servidor.epoll >= 0)
+            close(servidor.epoll);
+        close(escuta);
+        unlink(caminhoSocket);
+        return false;
+    }
+
+    memset(&acao, 0, sizeof(acao));
+    acao.sa_handler = tratarSinalServidor;
+    sigaction(SIGINT, &acao, &anteriorInt);
+    sigaction(SIGTERM, &acao, &anteriorTerm);
+    servidorTerminar = 0;
+
+    printf("Servidor à escuta em %s (Ctrl+C para terminar).\n", caminhoSocket);
+    fflush(stdout);
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+
+    while (!servidorTerminar)
+    {
+        // Durante uma compactação da Trie, o epoll não espera: sem pedidos, o tempo livre avança-a uma fatia.
+        int total = epoll_wait(servidor.epoll, eventos, MAX_EVENTOS_SERVIDOR, compactando ? 0 : -1);
+        if (total < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            perror("Erro no epoll do servidor");
+            break;
+        }
+        if (total == 0 && compactando)
+        {
+            compactando = !avancarCompactacaoTrie(dicionario, &compactacao, NOS_POR_FATIA_COMPACTACAO);
+            continue;
+        }
+
+        bool avisado = false;
+        for (int i = 0; i < total; i++)
+        {
+            LigacaoServidor *ligacao = (LigacaoServidor *)eventos[i].data.ptr;
+            if (ligacao == NULL)
+            {
+                aceitarLigacoes(escuta, &servidor);
+                continue;
+            }
+            if (eventos[i].data.ptr == &servidor)
+            {
+                avisado = true;
+                continue;
+            }
+
+            // Ler o que chegou, processar todas as tramas completas e responder com uma só escrita.
+            bool aberta = true;
+            if (eventos[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                aberta = receberEntrada(ligacao);
+            if (aberta)
+                aberta = atenderLigacao(dicionario, ligacao, &servidor);
+
+            if (aberta)
+                atualizarEventos(servidor.epoll, ligacao);
+            else
+                fecharLigacao(&servidor, ligacao);
+        }
+
+        // As ligações retomadas só são atendidas depois das deste lote, que podem referir as que forem fechadas.
+        if (avisado)
+            retomarLigacoesDuraveis(dicionario, &servidor);
+
+        // Depois de muitas remoções, começar a compactação, que avança quando não houver pedidos.
+        if (!compactando && trieDeveSerCompactada(dicionario))
+            compactando = iniciarCompactacaoTrie(dicionario, &compactacao);
+    }
+
+    if (compactando)
+        cancelarCompactacaoTrie(&compactacao);
+
+    clock_gettime(CLOCK_MONOTONIC, &fim);
+    double segundos = (double)(fim.tv_sec - inicio.tv_sec) + (double)(fim.tv_nsec - inicio.tv_nsec) / 1e9;
+    printf("Servidor terminado: %zu ligações, %zu pedidos em %.1f s (%.0f pedidos/s).\n", servidor.totalLigacoes,
+           servidor.pedidos, segundos, segundos > 0 ? (double)servidor.pedidos / segundos : 0.0);
+
+    while (servidor.ligacoes != NULL)
+        fecharLigacao(&servidor, servidor.ligacoes);
+
+    sigaction(SIGINT, &anteriorInt, NULL);
+    sigaction(SIGTERM, &anteriorTerm, NULL);
+    close(servidor.epoll);
+    close(escuta);
+    unlink(caminhoSocket);
+    return true;
+}
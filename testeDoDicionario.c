@@ -0,0 +1,1285 @@
+// ================================ DEFINIÇÕES DO SISTEMA ============================
+
+// Ativa as extensões POSIX/GNU (mkstemp, dup) antes de incluir qualquer biblioteca.
+#define _GNU_SOURCE
+
+// ================================ BIBLIOTECAS INCLUÍDAS ============================
+
+// Biblioteca personalizada para operações específicas do dicionário.
+#include "dicionario.h"
+
+// Biblioteca padrão do C para funções gerais, como alocação de memória.
+#include <stdlib.h>
+
+// Biblioteca padrão do C para entrada e saída de dados.
+#include <stdio.h>
+
+// Biblioteca padrão de strings do C.
+#include <string.h>
+
+// Bibliotecas POSIX para ficheiros temporários e descritores (mkstemp, dup, unlink, usleep).
+#include <fcntl.h>
+#include <unistd.h>
+
+// Bibliotecas POSIX para o cliente do servidor (socket Unix e o sinal que o termina se a ligação falhar).
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// ================================ CONSTANTES DOS TESTES ============================
+
+// Pares de palavras comparados com a programação dinâmica de referência.
+#define PARES_DISTANCIA 20000
+
+// Candidatas de cada lote da distância vetorizada (não múltiplo de 4 nem de 2, para passar pelo núcleo escalar).
+#define CANDIDATAS_LOTE 37
+
+// Palavras inseridas em cada teste do dicionário e fração delas removida antes de verificar.
+#define PALAVRAS_TESTE 20000
+#define FRACAO_REMOVIDAS_TESTE 3
+
+// Palavras base de cada layout na comparação da procura por distância com a força bruta.
+#define PROCURAS_DISTANCIA 60
+
+// Palavras desconhecidas consultadas na cache de sugestões e alterações feitas entre as consultas.
+#define CONSULTAS_SUGESTOES 200
+#define RONDAS_SUGESTOES 40
+
+// Alterações registadas no diário antes de o reabrir.
+#define ALTERACOES_TESTE 3000
+
+// Prefixos consultados no autocompletar e palavras ausentes consultadas no filtro de Bloom.
+#define PREFIXOS_AUTOCOMPLETAR 200
+#define AUSENTES_FILTRO 20000
+
+// Palavras inseridas pela thread escritora no teste concorrente e threads leitoras que as consultam ao mesmo tempo.
+#define ESCRITAS_CONCORRENTES 20000
+#define LEITORES_CONCORRENTES 3
+
+// Tempo máximo (em passos de 10 ms) à espera do servidor ou da vigia do ficheiro.
+#define ESPERAS_TESTE 500
+
+// ================================ ESTRUTURAS DOS TESTES ============================
+
+// Struct que define o conjunto de palavras que um dicionário deve conter (o modelo dos testes), com os pesos.
+typedef struct
+{
+    char (*palavras)[MAX_TAMANHO_PALAVRA];
+    uint32_t *pesos;
+    bool *presentes;
+    size_t total;
+} ModeloPalavras;
+
+// Struct que define o que a procura por distância deve encontrar: as palavras presentes do modelo que satisfazem o
+// modo pedido, pela mesma ordem (a da Trie).
+typedef struct
+{
+    const ModeloPalavras *modelo;
+    const char *palavraBase;
+    int distancia;
+    ModoDistancia modo;
+    size_t proxima;
+    size_t encontradas;
+} ProcuraEsperada;
+
+// Struct que define o estado partilhado do teste concorrente: a thread escritora insere as palavras "concorrenteN"
+// por ordem de N, e as leitoras verificam que nunca veem uma sem todas as anteriores.
+typedef struct
+{
+    Dicionario *dicionario;
+    const ModeloPalavras *modelo;
+    int escritas;   // Palavras já publicadas pela escritora (lido pelas leitoras).
+    bool terminar;  // A escritora terminou.
+    size_t falhas;  // Inconsistências vistas pelas leitoras.
+} EstadoConcorrente;
+
+// Struct que define o que o autocompletar devolveu: os pesos visitados, pela ordem, para comparar com a força bruta.
+typedef struct
+{
+    const Dicionario *dicionario;
+    const char *prefixo;
+    uint32_t pesos[2 * SUGESTOES_AUTOCOMPLETAR];
+    size_t total;
+} AutocompletarObtido;
+
+// Struct que define o servidor lançado numa thread pelo teste do protocolo.
+typedef struct
+{
+    Dicionario *dicionario;
+    const char *caminho;
+    bool resultado; // O que servirDicionario devolveu.
+} ServidorTeste;
+
+// ================================ ESTADO DOS TESTES ================================
+
+// Estado do gerador pseudoaleatório (xorshift64*), fixo para que todas as execuções testem as mesmas palavras.
+static uint64_t estadoAleatorio = 0x9E3779B97F4A7C15ULL;
+
+// Verificações falhadas no teste atual e no total.
+static size_t falhasTeste, falhasTotal;
+
+// Onde os resultados são escritos (o stdout original; as mensagens da biblioteca são descartadas).
+static FILE *resultados;
+
+// Regista uma verificação falhada, mostrando só as primeiras de cada teste.
+#define VERIFICAR(condicao)                                                                                            \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condicao) && falhasTeste++ < 10)                                                                         \
+            fprintf(resultados, "  %s:%d: falhou: %s\n", __FILE__, __LINE__, #condicao);                               \
+    } while (0)
+
+// ================================ AUXILIARES ======================================
+
+// Devolve o próximo número do gerador pseudoaleatório.
+static uint64_t proximoAleatorio(void)
+{
+    estadoAleatorio ^= estadoAleatorio >> 12;
+    estadoAleatorio ^= estadoAleatorio << 25;
+    estadoAleatorio ^= estadoAleatorio >> 27;
+    return estadoAleatorio * 0x2545F4914F6CDD1DULL;
+}
+
+// Gera uma palavra com entre 1 e 'maximo' caracteres de um alfabeto pequeno (para haver prefixos e sufixos comuns),
+// com alguns bytes acima de 127 (que são negativos num char com sinal).
+static int gerarPalavra(char *palavra, int maximo)
+{
+    static const char letras[] = "aaeeiioosrnt";
+    int comprimento = 1 + (int)(proximoAleatorio() % (uint64_t)maximo);
+
+    for (int i = 0; i < comprimento; i++)
+    {
+        uint64_t aleatorio = proximoAleatorio();
+        palavra[i] = aleatorio % 8 == 0 ? (char)(0x80 + (aleatorio >> 8) % 0x7F) : letras[(aleatorio >> 8) % 12];
+    }
+    palavra[comprimento] = '\0';
+    return comprimento;
+}
+
+// Distância de edição pela programação dinâmica completa, a referência dos núcleos bit-paralelos.
+static int distanciaReferencia(const char *palavra1, int comprimento1, const char *palavra2, int comprimento2)
+{
+    int linhas[2][MAX_TAMANHO_PALAVRA + 1];
+
+    for (int j = 0; j <= comprimento2; j++)
+        linhas[0][j] = j;
+    for (int i = 1; i <= comprimento1; i++)
+    {
+        int *anterior = linhas[(i - 1) % 2], *atual = linhas[i % 2];
+        atual[0] = i;
+        for (int j = 1; j <= comprimento2; j++)
+        {
+            int custo = palavra1[i - 1] != palavra2[j - 1];
+            atual[j] = min(anterior[j] + 1, atual[j - 1] + 1, anterior[j - 1] + custo);
+        }
+    }
+    return linhas[comprimento1 % 2][comprimento2];
+}
+
+// Compara duas palavras pela ordem da Trie, que compara os caracteres como char.
+static int compararPalavras(const void *a, const void *b)
+{
+    const char *palavra1 = (const char *)a, *palavra2 = (const char *)b;
+
+    while (*palavra1 != '\0' && *palavra1 == *palavra2)
+    {
+        palavra1++;
+        palavra2++;
+    }
+    if (*palavra1 == '\0' || *palavra2 == '\0')
+        return (*palavra1 != '\0') - (*palavra2 != '\0');
+    return *palavra1 < *palavra2 ? -1 : 1;
+}
+
+// Gera o modelo: palavras distintas, ordenadas pela ordem da Trie, todas ausentes e com pesos aleatórios.
+static bool gerarModelo(ModeloPalavras *modelo, size_t total)
+{
+    modelo->palavras = malloc(total * sizeof(*modelo->palavras));
+    modelo->pesos = malloc(total * sizeof(uint32_t));
+    modelo->presentes = calloc(total, sizeof(bool));
+    if (modelo->palavras == NULL || modelo->pesos == NULL || modelo->presentes == NULL)
+        return false;
+
+    for (size_t i = 0; i < total; i++)
+        gerarPalavra(modelo->palavras[i], 12);
+    qsort(modelo->palavras, total, sizeof(*modelo->palavras), compararPalavras);
+
+    size_t distintas = 0;
+    for (size_t i = 0; i < total; i++)
+        if (distintas == 0 || strcmp(modelo->palavras[distintas - 1], modelo->palavras[i]) != 0)
+            memmove(modelo->palavras[distintas++], modelo->palavras[i], MAX_TAMANHO_PALAVRA);
+    modelo->total = distintas;
+
+    for (size_t i = 0; i < modelo->total; i++)
+        modelo->pesos[i] = (uint32_t)(proximoAleatorio() % 1000);
+    return true;
+}
+
+// Liberta o modelo.
+static void libertarModelo(ModeloPalavras *modelo)
+{
+    free(modelo->palavras);
+    free(modelo->pesos);
+    free(modelo->presentes);
+}
+
+// Insere todas as palavras do modelo e remove uma em cada FRACAO_REMOVIDAS_TESTE, para deixar ramos mortos na Trie.
+static void preencherDicionario(Dicionario *dicionario, ModeloPalavras *modelo)
+{
+    for (size_t i = 0; i < modelo->total; i++)
+    {
+        inserirPalavraComPeso(dicionario, modelo->palavras[i], modelo->pesos[i]);
+        modelo->presentes[i] = true;
+    }
+    for (size_t i = 0; i < modelo->total; i += FRACAO_REMOVIDAS_TESTE)
+    {
+        removerPalavra(dicionario, modelo->palavras[i]);
+        modelo->presentes[i] = false;
+    }
+}
+
+// Verifica que o cursor devolve exatamente as palavras presentes do modelo, pela ordem, e com os pesos certos.
+static void verificarPalavras(Dicionario *dicionario, const ModeloPalavras *modelo)
+{
+    CursorDicionario cursor;
+    size_t i = 0;
+
+    VERIFICAR(abrirCursor(&cursor, dicionario, ""));
+    while (avancarCursor(&cursor))
+    {
+        while (i < modelo->total && !modelo->presentes[i])
+            i++;
+        VERIFICAR(i < modelo->total && strcmp(cursor.palavra, modelo->palavras[i]) == 0);
+        if (i < modelo->total)
+            i++;
+    }
+    fecharCursor(&cursor);
+    while (i < modelo->total && !modelo->presentes[i])
+        i++;
+    VERIFICAR(i == modelo->total);
+
+    for (i = 0; i < modelo->total; i++)
+    {
+        uint32_t peso = 0;
+        VERIFICAR(pesoPalavra(dicionario, modelo->palavras[i], &peso) == modelo->presentes[i]);
+        VERIFICAR(!modelo->presentes[i] || peso == modelo->pesos[i]);
+    }
+}
+
+// Escreve as palavras presentes do modelo num ficheiro de texto, uma por linha com o seu peso. O ficheiro é escrito ao
+// lado e renomeado por cima, como fazem os editores (e como a vigia espera).
+static bool escreverModelo(const char *nome, const ModeloPalavras *modelo)
+{
+    char temporario[FILENAME_MAX + sizeof(".novo")];
+
+    snprintf(temporario, sizeof(temporario), "%s.novo", nome);
+    FILE *ficheiro = fopen(temporario, "w");
+    if (ficheiro == NULL)
+        return false;
+    for (size_t i = 0; i < modelo->total; i++)
+        if (modelo->presentes[i])
+            fprintf(ficheiro, "%s %u\n", modelo->palavras[i], (unsigned)modelo->pesos[i]);
+    return fclose(ficheiro) == 0 && rename(temporario, nome) == 0;
+}
+
+// Compara duas palavras com strcmp (para qsort e bsearch sobre vetores de palavras).
+static int compararTexto(const void *a, const void *b)
+{
+    return strcmp((const char *)a, (const char *)b);
+}
+
+// Visitante que aceita todas as palavras (as procuras devolvem quantas visitou).
+static bool continuarVisita(const char *palavra, void *contexto)
+{
+    (void)palavra;
+    (void)contexto;
+    return true;
+}
+
+// Cria um ficheiro temporário vazio e devolve falso se não for possível.
+static bool criarTemporario(char *nome, size_t tamanhoNome)
+{
+    snprintf(nome, tamanhoNome, "%s/testeDoDicionarioXXXXXX", getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp");
+    int descritor = mkstemp(nome);
+    if (descritor < 0)
+        return false;
+    close(descritor);
+    return true;
+}
+
+// ================================ TESTES ==========================================
+
+// Compara os núcleos bit-paralelos (escalar, limitado e em lote, vetorizado quando há AVX2/SSE2) com a referência.
+static void testarDistancia(void)
+{
+    char padraoTexto[MAX_PADRAO_BIT_PARALELO + 1], candidatas[CANDIDATAS_LOTE][MAX_TAMANHO_PALAVRA];
+    const char *ponteiros[CANDIDATAS_LOTE];
+    int comprimentos[CANDIDATAS_LOTE], exatas[CANDIDATAS_LOTE], obtidas[CANDIDATAS_LOTE];
+    PadraoBitParalelo padrao;
+
+    for (size_t par = 0; par < PARES_DISTANCIA / CANDIDATAS_LOTE; par++)
+    {
+        // Padrões curtos (os das procuras) e, de vez em quando, do tamanho máximo de uma palavra de máquina.
+        int comprimentoPadrao = gerarPalavra(padraoTexto, par % 10 == 0 ? MAX_PADRAO_BIT_PARALELO : 12);
+        VERIFICAR(prepararPadraoBitParalelo(&padrao, padraoTexto, comprimentoPadrao));
+
+        for (int i = 0; i < CANDIDATAS_LOTE; i++)
+        {
+            // Metade das candidatas são variações do padrão, para haver distâncias pequenas.
+            if (i % 2 == 0)
+                comprimentos[i] = gerarPalavra(candidatas[i], 20);
+            else
+            {
+                comprimentos[i] = comprimentoPadrao;
+                memcpy(candidatas[i], padraoTexto, (size_t)comprimentoPadrao + 1);
+                candidatas[i][proximoAleatorio() % (uint64_t)comprimentoPadrao] = 'z';
+                if (comprimentoPadrao > 1 && i % 3 == 0)
+                    candidatas[i][--comprimentos[i]] = '\0';
+            }
+            ponteiros[i] = candidatas[i];
+            exatas[i] = distanciaReferencia(padraoTexto, comprimentoPadrao, candidatas[i], comprimentos[i]);
+
+            VERIFICAR(distanciaEdicaoBitParalela(&padrao, candidatas[i], comprimentos[i]) == exatas[i]);
+            VERIFICAR(distanciaEdicao(padraoTexto, comprimentoPadrao, candidatas[i], comprimentos[i]) == exatas[i]);
+            for (int limite = 0; limite <= 3; limite++)
+                VERIFICAR(distanciaEdicaoLimitada(&padrao, candidatas[i], comprimentos[i], limite) ==
+                          (exatas[i] <= limite ? exatas[i] : limite + 1));
+        }
+
+        distanciaEdicaoLote(&padrao, ponteiros, comprimentos, CANDIDATAS_LOTE, -1, obtidas);
+        for (int i = 0; i < CANDIDATAS_LOTE; i++)
+            VERIFICAR(obtidas[i] == exatas[i]);
+        int limite = (int)(par % 4);
+        distanciaEdicaoLote(&padrao, ponteiros, comprimentos, CANDIDATAS_LOTE, limite, obtidas);
+        for (int i = 0; i < CANDIDATAS_LOTE; i++)
+            VERIFICAR(obtidas[i] == (exatas[i] <= limite ? exatas[i] : limite + 1));
+    }
+}
+
+// Compara cada palavra encontrada com a próxima palavra do modelo que a força bruta aceitaria.
+static void verificarPalavraDistancia(const char *palavra, int distancia, void *contexto)
+{
+    ProcuraEsperada *esperada = (ProcuraEsperada *)contexto;
+    const ModeloPalavras *modelo = esperada->modelo;
+    int comprimentoBase = (int)strlen(esperada->palavraBase), exata = -1;
+
+    for (; esperada->proxima < modelo->total; esperada->proxima++)
+    {
+        const char *candidata = modelo->palavras[esperada->proxima];
+        if (!modelo->presentes[esperada->proxima])
+            continue;
+        exata = distanciaReferencia(esperada->palavraBase, comprimentoBase, candidata, (int)strlen(candidata));
+        if (exata == esperada->distancia || (esperada->modo == DISTANCIA_MAXIMA && exata < esperada->distancia))
+            break;
+    }
+
+    VERIFICAR(esperada->proxima < modelo->total && strcmp(palavra, modelo->palavras[esperada->proxima]) == 0);
+    VERIFICAR(distancia == exata);
+    esperada->proxima++;
+    esperada->encontradas++;
+}
+
+// Compara a procura por distância (linhas da programação dinâmica ao longo da Trie) com a força bruta sobre o modelo,
+// nos três layouts.
+static void testarProcuraDistancia(void)
+{
+    ModeloPalavras modelo;
+    char palavraBase[MAX_TAMANHO_PALAVRA];
+
+    Dicionario *dicionario = inicializarDicionario();
+    VERIFICAR(dicionario != NULL && gerarModelo(&modelo, PALAVRAS_TESTE / 4));
+    if (dicionario == NULL)
+        return;
+    preencherDicionario(dicionario, &modelo);
+
+    for (int layout = 0; layout < 3; layout++)
+    {
+        if (layout == 1)
+            VERIFICAR(congelarDicionario(dicionario));
+        else if (layout == 2)
+            VERIFICAR(congelarDicionarioMinimizado(dicionario));
+
+        for (int k = 0; k < PROCURAS_DISTANCIA; k++)
+        {
+            // Palavras do modelo (presentes ou não) e, algumas vezes, palavras novas.
+            if (k % 3 == 0)
+                gerarPalavra(palavraBase, 12);
+            else
+                strcpy(palavraBase, modelo.palavras[proximoAleatorio() % modelo.total]);
+
+            ProcuraEsperada esperada = {&modelo, palavraBase, 1 + k % 3, k % 2 ? DISTANCIA_MAXIMA : DISTANCIA_EXATA, 0, 0};
+            size_t encontradas = procurarPorDistancia(dicionario, palavraBase, esperada.distancia, esperada.modo,
+                                                      verificarPalavraDistancia, &esperada);
+            VERIFICAR(encontradas == esperada.encontradas);
+
+            // Nenhuma palavra aceite pela força bruta ficou por encontrar.
+            for (; esperada.proxima < modelo.total; esperada.proxima++)
+            {
+                const char *candidata = modelo.palavras[esperada.proxima];
+                int exata = distanciaReferencia(palavraBase, (int)strlen(palavraBase), candidata, (int)strlen(candidata));
+                VERIFICAR(!modelo.presentes[esperada.proxima] || !(exata == esperada.distancia ||
+                          (esperada.modo == DISTANCIA_MAXIMA && exata < esperada.distancia)));
+            }
+        }
+    }
+
+    destruirDicionario(dicionario);
+    libertarModelo(&modelo);
+}
+
+// Compara as sugestões da cache com as calculadas sem ela (a cache é desligada só durante o cálculo).
+static void verificarSugestoes(Dicionario *dicionario, const char *palavra)
+{
+    char comCache[TAMANHO_SUGESTOES], semCache[TAMANHO_SUGESTOES];
+    CacheSugestoes *cache = dicionario->sugestoes;
+
+    size_t total = sugerirCorrecoes(dicionario, palavra, comCache, sizeof(comCache));
+    dicionario->sugestoes = NULL;
+    VERIFICAR(sugerirCorrecoes(dicionario, palavra, semCache, sizeof(semCache)) == total);
+    dicionario->sugestoes = cache;
+    VERIFICAR(strcmp(comCache, semCache) == 0);
+}
+
+// Verifica que a cache de sugestões nunca devolve sugestões desatualizadas: entre rondas de consultas, insere e
+// remove palavras perto de algumas das consultadas (que têm de ser recalculadas) e longe das outras (que são
+// revalidadas pelas palavras alteradas), e por fim faz mais alterações do que a cache recorda.
+static void testarCacheSugestoes(void)
+{
+    ModeloPalavras modelo;
+    char (*consultas)[MAX_TAMANHO_PALAVRA] = malloc(CONSULTAS_SUGESTOES * sizeof(*consultas));
+    EstatisticasCacheSugestoes estatisticas;
+
+    Dicionario *dicionario = inicializarDicionario();
+    VERIFICAR(dicionario != NULL && consultas != NULL && gerarModelo(&modelo, PALAVRAS_TESTE / 4));
+    if (dicionario == NULL || consultas == NULL)
+        return;
+    VERIFICAR(dicionario->sugestoes != NULL);
+    preencherDicionario(dicionario, &modelo);
+
+    // Consultas: palavras removidas do modelo (desconhecidas, mas com vizinhas) e palavras novas.
+    for (size_t i = 0; i < CONSULTAS_SUGESTOES; i++)
+    {
+        size_t j = proximoAleatorio() % modelo.total;
+        while (modelo.presentes[j])
+            j = (j + 1) % modelo.total;
+        if (i % 2 == 0)
+            strcpy(consultas[i], modelo.palavras[j]);
+        else
+            gerarPalavra(consultas[i], 12);
+    }
+
+    for (int ronda = 0; ronda <= RONDAS_SUGESTOES; ronda++)
+    {
+        for (size_t i = 0; i < CONSULTAS_SUGESTOES; i++)
+            verificarSugestoes(dicionario, consultas[i]);
+
+        // Uma alteração perto de uma consulta (uma letra trocada) e outra longe de todas (palavra comprida).
+        char palavra[MAX_TAMANHO_PALAVRA];
+        strcpy(palavra, consultas[proximoAleatorio() % CONSULTAS_SUGESTOES]);
+        palavra[proximoAleatorio() % strlen(palavra)] = 'x';
+        if (ronda % 2 == 0)
+            inserirPalavra(dicionario, palavra);
+        else
+            removerPalavra(dicionario, modelo.palavras[proximoAleatorio() % modelo.total]);
+        snprintf(palavra, sizeof(palavra), "zzzzzzzzzzzzzzzzzzzz%d", ronda);
+        inserirPalavra(dicionario, palavra);
+    }
+
+    // Mais alterações do que a cache recorda: todas as entradas antigas têm de ser recalculadas.
+    for (int i = 0; i < 2 * ALTERACOES_CACHE_SUGESTOES; i++)
+    {
+        char palavra[MAX_TAMANHO_PALAVRA];
+        snprintf(palavra, sizeof(palavra), "yyyyyyyyyyyyyyyyyyyy%d", i);
+        inserirPalavra(dicionario, palavra);
+    }
+    strcpy(consultas[0], "yyyyyyyyyyyyyyyyyyyy");
+    for (size_t i = 0; i < CONSULTAS_SUGESTOES; i++)
+        verificarSugestoes(dicionario, consultas[i]);
+
+    estatisticasCacheSugestoes(dicionario, &estatisticas);
+    VERIFICAR(estatisticas.revalidadas > 0 && estatisticas.invalidadas > 0 && estatisticas.acertos > 0);
+
+    free(consultas);
+    destruirDicionario(dicionario);
+    libertarModelo(&modelo);
+}
+
+// Verifica a ordem do cursor: todas as palavras, as de um prefixo, o reposicionamento e a leitura por páginas.
+static void testarCursor(void)
+{
+    ModeloPalavras modelo;
+    CursorDicionario cursor;
+    char pagina[256];
+
+    Dicionario *dicionario = inicializarDicionario();
+    VERIFICAR(dicionario != NULL && gerarModelo(&modelo, PALAVRAS_TESTE));
+    if (dicionario == NULL)
+        return;
+    preencherDicionario(dicionario, &modelo);
+    verificarPalavras(dicionario, &modelo);
+
+    // Prefixo de um só caractere e chave no meio das palavras com esse prefixo.
+    const char *prefixo = "e", *chave = "ens";
+    size_t i = 0;
+    VERIFICAR(abrirCursor(&cursor, dicionario, prefixo));
+    posicionarCursor(&cursor, chave);
+    while (avancarCursor(&cursor))
+    {
+        while (i < modelo.total && (!modelo.presentes[i] || strncmp(modelo.palavras[i], prefixo, 1) != 0 ||
+                                    compararPalavras(modelo.palavras[i], chave) < 0))
+            i++;
+        VERIFICAR(i < modelo.total && strcmp(cursor.palavra, modelo.palavras[i]) == 0);
+        if (i < modelo.total)
+            i++;
+    }
+    fecharCursor(&cursor);
+
+    // As páginas juntas dão as mesmas palavras que o cursor, uma a uma.
+    i = 0;
+    VERIFICAR(abrirCursor(&cursor, dicionario, ""));
+    for (size_t copiadas; (copiadas = proximasPalavras(&cursor, pagina, sizeof(pagina), 16)) > 0;)
+    {
+        for (const char *palavra = pagina; copiadas > 0; copiadas--, palavra += strlen(palavra) + 1)
+        {
+            while (i < modelo.total && !modelo.presentes[i])
+                i++;
+            VERIFICAR(i < modelo.total && strcmp(palavra, modelo.palavras[i]) == 0);
+            if (i < modelo.total)
+                i++;
+        }
+    }
+    fecharCursor(&cursor);
+
+    destruirDicionario(dicionario);
+    libertarModelo(&modelo);
+}
+
+// Verifica que a compactação da Trie e os layouts congelados guardam exatamente as mesmas palavras e pesos.
+static void testarCompactacao(void)
+{
+    ModeloPalavras modelo;
+    ResultadoCompactacao resultado;
+
+    Dicionario *dicionario = inicializarDicionario();
+    VERIFICAR(dicionario != NULL && gerarModelo(&modelo, PALAVRAS_TESTE));
+    if (dicionario == NULL)
+        return;
+    preencherDicionario(dicionario, &modelo);
+
+    VERIFICAR(compactarTrie(dicionario, &resultado) && !resultado.falhou);
+    VERIFICAR(resultado.nosDepois <= resultado.nosAntes);
+    verificarPalavras(dicionario, &modelo);
+
+    // Depois de compactada, a Trie continua a aceitar alterações.
+    removerPalavra(dicionario, modelo.palavras[1]);
+    modelo.presentes[1] = false;
+    inserirPalavraComPeso(dicionario, modelo.palavras[0], modelo.pesos[0]);
+    modelo.presentes[0] = true;
+    verificarPalavras(dicionario, &modelo);
+
+    VERIFICAR(congelarDicionario(dicionario));
+    verificarPalavras(dicionario, &modelo);
+    VERIFICAR(congelarDicionarioMinimizado(dicionario));
+    verificarPalavras(dicionario, &modelo);
+    VERIFICAR(descongelarDicionario(dicionario));
+    verificarPalavras(dicionario, &modelo);
+
+    destruirDicionario(dicionario);
+    libertarModelo(&modelo);
+}
+
+// Guarda e volta a carregar o instantâneo binário (compacto e minimizado) e rejeita um instantâneo corrompido.
+static void testarInstantaneo(void)
+{
+    ModeloPalavras modelo;
+    char nome[FILENAME_MAX];
+
+    Dicionario *dicionario = inicializarDicionario();
+    VERIFICAR(dicionario != NULL && gerarModelo(&modelo, PALAVRAS_TESTE) && criarTemporario(nome, sizeof(nome)));
+    if (dicionario == NULL)
+        return;
+    preencherDicionario(dicionario, &modelo);
+
+    for (int minimizado = 0; minimizado <= 1; minimizado++)
+    {
+        if (minimizado)
+            VERIFICAR(congelarDicionarioMinimizado(dicionario));
+        VERIFICAR(guardarInstantaneo(dicionario, nome, NULL));
+
+        Dicionario *carregado = inicializarDicionario();
+        VERIFICAR(carregado != NULL && carregarInstantaneo(carregado, nome, NULL));
+        if (carregado != NULL)
+        {
+            verificarPalavras(carregado, &modelo);
+            destruirDicionario(carregado);
+        }
+    }
+
+    // Um byte trocado no meio dos nós é detetado pelo hash do instantâneo.
+    FILE *ficheiro = fopen(nome, "r+b");
+    VERIFICAR(ficheiro != NULL);
+    if (ficheiro != NULL)
+    {
+        fseek(ficheiro, 0, SEEK_END);
+        long tamanho = ftell(ficheiro);
+        fseek(ficheiro, tamanho / 2, SEEK_SET);
+        int byte = fgetc(ficheiro);
+        fseek(ficheiro, tamanho / 2, SEEK_SET);
+        fputc(byte ^ 0x55, ficheiro);
+        fclose(ficheiro);
+
+        Dicionario *corrompido = inicializarDicionario();
+        VERIFICAR(corrompido != NULL && !carregarInstantaneo(corrompido, nome, NULL));
+        destruirDicionario(corrompido);
+    }
+
+    unlink(nome);
+    destruirDicionario(dicionario);
+    libertarModelo(&modelo);
+}
+
+// Regista alterações no diário, reabre o ficheiro e verifica que a reposição reconstrói o mesmo dicionário, também
+// depois de uma entrada cortada no fim e de uma compactação do diário.
+static void testarDiario(void)
+{
+    ModeloPalavras modelo;
+    char nome[FILENAME_MAX], nomeDiario[FILENAME_MAX + sizeof(EXTENSAO_DIARIO)];
+    char nomeInstantaneo[FILENAME_MAX + sizeof(EXTENSAO_INSTANTANEO)];
+    size_t repostas = 0;
+
+    VERIFICAR(gerarModelo(&modelo, PALAVRAS_TESTE / 4) && criarTemporario(nome, sizeof(nome)));
+    snprintf(nomeDiario, sizeof(nomeDiario), "%s%s", nome, EXTENSAO_DIARIO);
+    snprintf(nomeInstantaneo, sizeof(nomeInstantaneo), "%s%s", nome, EXTENSAO_INSTANTANEO);
+
+    // Inserções (com e sem peso), substituições de peso e remoções, pela mesma ordem no modelo.
+    Dicionario *dicionario = inicializarDicionario();
+    VERIFICAR(dicionario != NULL && abrirDiarioAlteracoes(dicionario, nome, NULL));
+    uint64_t ultima = 0;
+    for (size_t k = 0; k < ALTERACOES_TESTE; k++)
+    {
+        size_t i = proximoAleatorio() % modelo.total;
+        TipoEntradaDiario tipo = k % 4 == 3 ? DIARIO_REMOVER : DIARIO_INSERIR_COM_PESO;
+        if (tipo == DIARIO_INSERIR_COM_PESO)
+            modelo.pesos[i] = (uint32_t)k;
+        modelo.presentes[i] = tipo != DIARIO_REMOVER;
+        uint64_t sequencia = aplicarAlteracaoRegistada(dicionario, tipo, modelo.palavras[i], NULL, modelo.pesos[i]);
+        VERIFICAR(sequencia > ultima);
+        ultima = sequencia;
+    }
+    VERIFICAR(esperarDiario(dicionario, ultima));
+    verificarPalavras(dicionario, &modelo);
+    destruirDicionario(dicionario);
+
+    // Reabrir: todas as entradas são repostas.
+    dicionario = inicializarDicionario();
+    VERIFICAR(abrirDiarioAlteracoes(dicionario, nome, &repostas) && repostas == ALTERACOES_TESTE);
+    verificarPalavras(dicionario, &modelo);
+    destruirDicionario(dicionario);
+
+    // Uma entrada meio escrita no fim é descartada sem perder as anteriores.
+    FILE *ficheiro = fopen(nomeDiario, "ab");
+    VERIFICAR(ficheiro != NULL);
+    if (ficheiro != NULL)
+    {
+        fwrite("\x10\0\0\0\0\0\0\0cortada", 1, 15, ficheiro);
+        fclose(ficheiro);
+    }
+    dicionario = inicializarDicionario();
+    VERIFICAR(abrirDiarioAlteracoes(dicionario, nome, &repostas) && repostas == ALTERACOES_TESTE);
+    verificarPalavras(dicionario, &modelo);
+
+    // A compactação reescreve o diário com uma entrada por palavra; a reposição dá o mesmo resultado.
+    VERIFICAR(compactarDiarioAlteracoes(dicionario));
+    destruirDicionario(dicionario);
+    unlink(nomeInstantaneo);
+    dicionario = inicializarDicionario();
+    VERIFICAR(abrirDiarioAlteracoes(dicionario, nome, &repostas) && repostas < ALTERACOES_TESTE);
+    verificarPalavras(dicionario, &modelo);
+    destruirDicionario(dicionario);
+
+    unlink(nomeInstantaneo);
+    unlink(nomeDiario);
+    unlink(nome);
+    libertarModelo(&modelo);
+}
+
+// Verifica o filtro de Bloom: nenhuma palavra adicionada é rejeitada, poucas ausentes passam, o filtro do dicionário
+// acompanha as alterações e um lote carregado outra vez não volta a contar as palavras que já lá estavam.
+static void testarFiltroBloom(void)
+{
+    ModeloPalavras modelo;
+    char palavra[MAX_TAMANHO_PALAVRA];
+    size_t falsosPositivos = 0;
+
+    VERIFICAR(gerarModelo(&modelo, PALAVRAS_TESTE));
+    FiltroBloom *filtro = criarFiltroBloom(modelo.total);
+    Dicionario *dicionario = inicializarDicionario();
+    FatiaPalavra *fatias = malloc(modelo.total * sizeof(FatiaPalavra));
+    VERIFICAR(filtro != NULL && dicionario != NULL && fatias != NULL);
+    if (filtro == NULL || dicionario == NULL || fatias == NULL)
+        return;
+
+    for (size_t i = 0; i < modelo.total; i++)
+        adicionarFiltroBloom(filtro, modelo.palavras[i], strlen(modelo.palavras[i]));
+    VERIFICAR(filtro->inseridas == modelo.total);
+    for (size_t i = 0; i < modelo.total; i++)
+        VERIFICAR(talvezContenhaFiltroBloom(filtro, modelo.palavras[i], strlen(modelo.palavras[i])));
+
+    // As palavras ausentes usam letras que o gerador não usa.
+    for (size_t k = 0; k < AUSENTES_FILTRO; k++)
+    {
+        int comprimento = snprintf(palavra, sizeof(palavra), "ausente%zu", k);
+        falsosPositivos += talvezContenhaFiltroBloom(filtro, palavra, (size_t)comprimento);
+    }
+    VERIFICAR(falsosPositivos * 100 < AUSENTES_FILTRO);
+    destruirFiltroBloom(filtro);
+
+    // O mesmo lote carregado duas vezes: da segunda, nenhuma palavra é nova e o filtro não conta nenhuma.
+    size_t inseridas = 0;
+    VERIFICAR(construirFiltroDicionario(dicionario));
+    for (int vez = 0; vez < 2; vez++)
+    {
+        for (size_t i = 0; i < modelo.total; i++)
+        {
+            fatias[i].inicio = modelo.palavras[i];
+            fatias[i].comprimento = (int)strlen(modelo.palavras[i]);
+            fatias[i].peso = modelo.pesos[i];
+            modelo.presentes[i] = true;
+        }
+        VERIFICAR(inserirPalavrasEmLote(dicionario, fatias, modelo.total));
+        VERIFICAR(dicionario->filtro != NULL);
+        if (dicionario->filtro == NULL)
+            break;
+        if (vez == 0)
+            inseridas = dicionario->filtro->inseridas;
+        VERIFICAR(dicionario->filtro->inseridas == inseridas && inseridas == modelo.total);
+    }
+
+    // Remoções e inserções depois da construção: o filtro nunca rejeita uma palavra presente.
+    for (size_t i = 0; i < modelo.total; i += FRACAO_REMOVIDAS_TESTE)
+    {
+        removerPalavra(dicionario, modelo.palavras[i]);
+        modelo.presentes[i] = false;
+    }
+    for (size_t i = 0; i < modelo.total; i += 2 * FRACAO_REMOVIDAS_TESTE)
+    {
+        inserirPalavraComPeso(dicionario, modelo.palavras[i], modelo.pesos[i]);
+        modelo.presentes[i] = true;
+    }
+    for (size_t i = 0; i < modelo.total; i++)
+        VERIFICAR(contemPalavra(dicionario, modelo.palavras[i]) == modelo.presentes[i]);
+    verificarPalavras(dicionario, &modelo);
+
+    free(fatias);
+    destruirDicionario(dicionario);
+    libertarModelo(&modelo);
+}
+
+// Verifica o índice dobrado: grafias com maiúsculas e acentos, a sua manutenção pelas inserções e remoções, e a
+// comparação com as formas dobradas de todas as palavras do modelo.
+static void testarIndiceDobrado(void)
+{
+    static const char *grafias[] = {"Ação", "ação", "ACAO", "Maçã", "casa"};
+    ModeloPalavras modelo;
+    char forma[MAX_TAMANHO_PALAVRA];
+
+    Dicionario *dicionario = inicializarDicionario();
+    VERIFICAR(dicionario != NULL && gerarModelo(&modelo, PALAVRAS_TESTE / 4));
+    if (dicionario == NULL)
+        return;
+
+    for (size_t i = 0; i < sizeof(grafias) / sizeof(grafias[0]); i++)
+        inserirPalavra(dicionario, grafias[i]);
+    VERIFICAR(construirIndiceDobrado(dicionario));
+    VERIFICAR(contemPalavraDobrada(dicionario, "acao", 4) && contemPalavraDobrada(dicionario, "AÇÃO", strlen("AÇÃO")));
+    VERIFICAR(contemPalavraDobrada(dicionario, "maca", 4) && contemPalavraDobrada(dicionario, "CASA", 4));
+    VERIFICAR(!contemPalavraDobrada(dicionario, "casas", 5) && !contemPalavraDobrada(dicionario, "aca", 3));
+    VERIFICAR(procurarPalavraDobrada(dicionario, "acao", continuarVisita, NULL) == 3);
+
+    // As alterações mantêm o índice.
+    removerPalavra(dicionario, "ACAO");
+    inserirPalavra(dicionario, "Casa");
+    VERIFICAR(procurarPalavraDobrada(dicionario, "ação", continuarVisita, NULL) == 2);
+    VERIFICAR(procurarPalavraDobrada(dicionario, "casa", continuarVisita, NULL) == 2);
+    removerPalavra(dicionario, "Ação");
+    removerPalavra(dicionario, "ação");
+    VERIFICAR(!contemPalavraDobrada(dicionario, "acao", 4));
+
+    // Todas as palavras do modelo: encontradas se alguma presente tiver a mesma forma dobrada.
+    preencherDicionario(dicionario, &modelo);
+    VERIFICAR(construirIndiceDobrado(dicionario));
+    char (*formas)[MAX_TAMANHO_PALAVRA] = malloc(modelo.total * sizeof(*formas));
+    size_t totalFormas = 0;
+    VERIFICAR(formas != NULL);
+    for (size_t i = 0; formas != NULL && i < modelo.total; i++)
+        if (modelo.presentes[i])
+            dobrarPalavra(modelo.palavras[i], strlen(modelo.palavras[i]), formas[totalFormas++]);
+    if (formas != NULL)
+        qsort(formas, totalFormas, sizeof(*formas), compararTexto);
+    for (size_t i = 0; formas != NULL && i < modelo.total; i++)
+    {
+        size_t comprimento = strlen(modelo.palavras[i]);
+        dobrarPalavra(modelo.palavras[i], comprimento, forma);
+        bool esperada = bsearch(forma, formas, totalFormas, sizeof(*formas), compararTexto) != NULL;
+        VERIFICAR(contemPalavraDobrada(dicionario, modelo.palavras[i], comprimento) == esperada);
+    }
+
+    free(formas);
+    destruirDicionario(dicionario);
+    libertarModelo(&modelo);
+}
+
+// Guarda cada palavra devolvida pelo autocompletar, verificando o prefixo, o peso e a ordem decrescente.
+static void guardarPalavraAutocompletar(const char *palavra, uint32_t peso, void *contexto)
+{
+    AutocompletarObtido *obtido = (AutocompletarObtido *)contexto;
+    uint32_t pesoGuardado = 0;
+
+    VERIFICAR(strncmp(palavra, obtido->prefixo, strlen(obtido->prefixo)) == 0);
+    VERIFICAR(pesoPalavra(obtido->dicionario, palavra, &pesoGuardado) && pesoGuardado == peso);
+    VERIFICAR(obtido->total == 0 || peso <= obtido->pesos[obtido->total - 1]);
+    VERIFICAR(obtido->total < 2 * SUGESTOES_AUTOCOMPLETAR);
+    if (obtido->total < 2 * SUGESTOES_AUTOCOMPLETAR)
+        obtido->pesos[obtido->total++] = peso;
+}
+
+// Ordena pesos por ordem decrescente.
+static int compararPesosDecrescentes(const void *a, const void *b)
+{
+    uint32_t peso1 = *(const uint32_t *)a, peso2 = *(const uint32_t *)b;
+    return (peso1 < peso2) - (peso1 > peso2);
+}
+
+// Compara as k melhores palavras de um prefixo com a força bruta sobre o modelo (os pesos, porque os empates podem vir
+// por qualquer ordem), na Trie de ponteiros e no layout compacto.
+static void testarAutocompletar(void)
+{
+    ModeloPalavras modelo;
+    char prefixo[4];
+
+    Dicionario *dicionario = inicializarDicionario();
+    uint32_t *esperados = malloc(PALAVRAS_TESTE * sizeof(uint32_t));
+    VERIFICAR(dicionario != NULL && esperados != NULL && gerarModelo(&modelo, PALAVRAS_TESTE));
+    if (dicionario == NULL || esperados == NULL)
+        return;
+    preencherDicionario(dicionario, &modelo);
+
+    for (int layout = 0; layout < 2; layout++)
+    {
+        if (layout == 1)
+            VERIFICAR(congelarDicionario(dicionario));
+
+        for (int k = 0; k < PREFIXOS_AUTOCOMPLETAR; k++)
+        {
+            // Prefixos de 0 a 3 caracteres de uma palavra do modelo.
+            const char *palavra = modelo.palavras[proximoAleatorio() % modelo.total];
+            size_t comprimento = (size_t)k % 4;
+            if (comprimento > strlen(palavra))
+                comprimento = strlen(palavra);
+            memcpy(prefixo, palavra, comprimento);
+            prefixo[comprimento] = '\0';
+
+            size_t totalEsperados = 0;
+            for (size_t i = 0; i < modelo.total; i++)
+                if (modelo.presentes[i] && strncmp(modelo.palavras[i], prefixo, comprimento) == 0)
+                    esperados[totalEsperados++] = modelo.pesos[i];
+            qsort(esperados, totalEsperados, sizeof(uint32_t), compararPesosDecrescentes);
+
+            size_t melhores = k % 3 == 0 ? 1 : (size_t)(k % 3) * SUGESTOES_AUTOCOMPLETAR;
+            AutocompletarObtido obtido = {dicionario, prefixo, {0}, 0};
+            size_t visitadas = melhoresComPrefixo(dicionario, prefixo, melhores, guardarPalavraAutocompletar, &obtido);
+            VERIFICAR(visitadas == obtido.total);
+            VERIFICAR(obtido.total == (totalEsperados < melhores ? totalEsperados : melhores));
+            for (size_t i = 0; i < obtido.total && i < totalEsperados; i++)
+                VERIFICAR(obtido.pesos[i] == esperados[i]);
+        }
+    }
+
+    free(esperados);
+    destruirDicionario(dicionario);
+    libertarModelo(&modelo);
+}
+
+// Recarrega o ficheiro depois de palavras entrarem, saírem e mudarem de peso (a primeira recarga compara o ficheiro
+// inteiro, as seguintes só as linhas alteradas) e, por fim, deixa a vigia dar pela gravação sozinha.
+static void testarRecarga(void)
+{
+    ModeloPalavras modelo;
+    ResultadoRecarga resultado;
+    char nome[FILENAME_MAX];
+    size_t recargas = 0, falhas = 0;
+
+    Dicionario *dicionario = inicializarDicionario();
+    VERIFICAR(dicionario != NULL && gerarModelo(&modelo, PALAVRAS_TESTE / 4) && criarTemporario(nome, sizeof(nome)));
+    if (dicionario == NULL)
+        return;
+    for (size_t i = 0; i < modelo.total; i++)
+        modelo.presentes[i] = i % 2 == 0;
+    VERIFICAR(escreverModelo(nome, &modelo) && carregarFicheiroMapeado(dicionario, nome, NULL));
+    verificarPalavras(dicionario, &modelo);
+
+    for (int ronda = 0; ronda <= 3; ronda++)
+    {
+        size_t entram = 0, saem = 0, mudam = 0;
+
+        // Alterações em posições aleatórias, no máximo uma por palavra (para contar o que a recarga deve ver).
+        for (size_t i = proximoAleatorio() % 7; i < modelo.total; i += 1 + proximoAleatorio() % 97)
+        {
+            if (!modelo.presentes[i])
+                entram++;
+            else if (proximoAleatorio() % 2 == 0)
+            {
+                modelo.pesos[i]++;
+                mudam++;
+                continue;
+            }
+            else
+                saem++;
+            modelo.presentes[i] = !modelo.presentes[i];
+        }
+
+        VERIFICAR(escreverModelo(nome, &modelo) && recarregarFicheiro(dicionario, nome, &resultado));
+        VERIFICAR(resultado.alterado && resultado.incremental == (ronda > 0));
+        VERIFICAR(resultado.inseridas == entram && resultado.removidas == saem && resultado.pesosAlterados == mudam);
+        verificarPalavras(dicionario, &modelo);
+    }
+    VERIFICAR(recarregarFicheiro(dicionario, nome, &resultado) && !resultado.alterado);
+
+    // A vigia recarrega o ficheiro quando ele é substituído.
+    VERIFICAR(ligarVigiaFicheiro(dicionario, nome));
+    modelo.presentes[1] = !modelo.presentes[1];
+    VERIFICAR(escreverModelo(nome, &modelo));
+    for (int espera = 0; espera < ESPERAS_TESTE && recargas == 0; espera++)
+    {
+        usleep(10000);
+        VERIFICAR(consultarVigiaFicheiro(dicionario, &resultado, &recargas, &falhas));
+    }
+    desligarVigiaFicheiro(dicionario);
+    VERIFICAR(recargas > 0 && falhas == 0);
+    verificarPalavras(dicionario, &modelo);
+
+    unlink(nome);
+    destruirDicionario(dicionario);
+    libertarModelo(&modelo);
+}
+
+// Thread escritora do teste concorrente: publica as palavras "concorrenteN" por ordem.
+static void *escreverConcorrente(void *argumento)
+{
+    EstadoConcorrente *estado = (EstadoConcorrente *)argumento;
+    char palavra[MAX_TAMANHO_PALAVRA];
+
+    for (int n = 0; n < ESCRITAS_CONCORRENTES; n++)
+    {
+        snprintf(palavra, sizeof(palavra), "concorrente%d", n);
+        inserirPalavra(estado->dicionario, palavra);
+        __atomic_store_n(&estado->escritas, n + 1, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&estado->terminar, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// Thread leitora do teste concorrente: o que a escritora já publicou está visível, uma palavra visível implica as
+// anteriores, as palavras do modelo nunca desaparecem e um cursor vê as palavras por ordem.
+static void *lerConcorrente(void *argumento)
+{
+    EstadoConcorrente *estado = (EstadoConcorrente *)argumento;
+    const ModeloPalavras *modelo = estado->modelo;
+    uint64_t aleatorio = (uint64_t)(uintptr_t)&aleatorio | 1;
+    char palavra[MAX_TAMANHO_PALAVRA], anterior[MAX_TAMANHO_PALAVRA];
+    size_t falhas = 0;
+
+    for (int volta = 0; !__atomic_load_n(&estado->terminar, __ATOMIC_ACQUIRE); volta++)
+    {
+        aleatorio ^= aleatorio << 13;
+        aleatorio ^= aleatorio >> 7;
+        aleatorio ^= aleatorio << 17;
+
+        int escritas = __atomic_load_n(&estado->escritas, __ATOMIC_ACQUIRE);
+        if (escritas > 0)
+        {
+            snprintf(palavra, sizeof(palavra), "concorrente%d", (int)(aleatorio % (uint64_t)escritas));
+            falhas += !contemPalavra(estado->dicionario, palavra);
+        }
+
+        int seguinte = escritas + (int)(aleatorio % 64);
+        snprintf(palavra, sizeof(palavra), "concorrente%d", seguinte);
+        if (contemPalavra(estado->dicionario, palavra))
+        {
+            snprintf(palavra, sizeof(palavra), "concorrente%d", seguinte - 1);
+            falhas += !contemPalavra(estado->dicionario, palavra);
+        }
+
+        size_t i = (size_t)(aleatorio >> 20) % modelo->total;
+        falhas += modelo->presentes[i] != contemPalavra(estado->dicionario, modelo->palavras[i]);
+
+        if (volta % 256 == 0)
+        {
+            CursorDicionario cursor;
+            size_t vistas = 0;
+            anterior[0] = '\0';
+            if (abrirCursor(&cursor, estado->dicionario, "concorrente"))
+            {
+                while (avancarCursor(&cursor))
+                {
+                    falhas += vistas > 0 && compararPalavras(anterior, cursor.palavra) >= 0;
+                    strcpy(anterior, cursor.palavra);
+                    vistas++;
+                }
+                fecharCursor(&cursor);
+            }
+            falhas += vistas < (size_t)escritas;
+        }
+    }
+
+    __atomic_fetch_add(&estado->falhas, falhas, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+// Intercala uma thread escritora com várias leitoras no modo concorrente e verifica o dicionário no fim.
+static void testarConcorrencia(void)
+{
+    ModeloPalavras modelo;
+    pthread_t escritora, leitoras[LEITORES_CONCORRENTES];
+    char palavra[MAX_TAMANHO_PALAVRA];
+
+    Dicionario *dicionario = inicializarDicionario();
+    VERIFICAR(dicionario != NULL && gerarModelo(&modelo, PALAVRAS_TESTE / 4));
+    if (dicionario == NULL)
+        return;
+    preencherDicionario(dicionario, &modelo);
+    VERIFICAR(construirFiltroDicionario(dicionario) && ligarModoConcorrente(dicionario));
+
+    EstadoConcorrente estado = {dicionario, &modelo, 0, false, 0};
+    for (int i = 0; i < LEITORES_CONCORRENTES; i++)
+        VERIFICAR(pthread_create(&leitoras[i], NULL, lerConcorrente, &estado) == 0);
+    VERIFICAR(pthread_create(&escritora, NULL, escreverConcorrente, &estado) == 0);
+    pthread_join(escritora, NULL);
+    for (int i = 0; i < LEITORES_CONCORRENTES; i++)
+        pthread_join(leitoras[i], NULL);
+    VERIFICAR(estado.falhas == 0);
+
+    // As palavras da escritora saem (também no modo concorrente) e fica exatamente o modelo.
+    for (int n = 0; n < ESCRITAS_CONCORRENTES; n++)
+    {
+        snprintf(palavra, sizeof(palavra), "concorrente%d", n);
+        VERIFICAR(contemPalavra(dicionario, palavra));
+        removerPalavra(dicionario, palavra);
+    }
+    desligarModoConcorrente(dicionario);
+    verificarPalavras(dicionario, &modelo);
+
+    destruirDicionario(dicionario);
+    libertarModelo(&modelo);
+}
+
+// Escreve um inteiro de 32 bits em little-endian (a ordem do protocolo do servidor).
+static void escreverU32Teste(unsigned char *destino, uint32_t valor)
+{
+    for (int i = 0; i < 4; i++)
+        destino[i] = (unsigned char)(valor >> (8 * i));
+}
+
+// Lê um inteiro de 32 bits em little-endian.
+static uint32_t lerU32Teste(const unsigned char *origem)
+{
+    return (uint32_t)origem[0] | (uint32_t)origem[1] << 8 | (uint32_t)origem[2] << 16 | (uint32_t)origem[3] << 24;
+}
+
+// Acrescenta um pedido ao buffer (u32 comprimento | u8 operação | u32 identificador | dados) e devolve o seu tamanho.
+static size_t escreverPedido(unsigned char *buffer, uint8_t operacao, uint32_t identificador, const void *dados,
+                             size_t tamanho)
+{
+    escreverU32Teste(buffer, (uint32_t)(TAMANHO_CABECALHO_TRAMA - 4 + tamanho));
+    buffer[4] = operacao;
+    escreverU32Teste(buffer + 5, identificador);
+    memcpy(buffer + TAMANHO_CABECALHO_TRAMA, dados, tamanho);
+    return TAMANHO_CABECALHO_TRAMA + tamanho;
+}
+
+// Lê exatamente 'tamanho' bytes do socket. Devolve falso se a ligação fechar antes.
+static bool lerTudoTeste(int descritor, unsigned char *destino, size_t tamanho)
+{
+    while (tamanho > 0)
+    {
+        ssize_t lidos = read(descritor, destino, tamanho);
+        if (lidos <= 0)
+            return false;
+        destino += lidos;
+        tamanho -= (size_t)lidos;
+    }
+    return true;
+}
+
+// Lê uma resposta do servidor e verifica o seu identificador e estado. Devolve o tamanho dos dados (0 se falhar).
+static size_t lerRespostaTeste(int descritor, uint32_t identificador, EstadoResposta estado, unsigned char *dados,
+                               size_t capacidade)
+{
+    unsigned char cabecalho[TAMANHO_CABECALHO_TRAMA];
+
+    if (!lerTudoTeste(descritor, cabecalho, sizeof(cabecalho)))
+    {
+        VERIFICAR(!"resposta em falta");
+        return 0;
+    }
+    size_t tamanho = lerU32Teste(cabecalho) - (TAMANHO_CABECALHO_TRAMA - 4);
+    VERIFICAR(cabecalho[4] == estado && lerU32Teste(cabecalho + 5) == identificador && tamanho <= capacidade);
+    if (tamanho > capacidade || !lerTudoTeste(descritor, dados, tamanho))
+        return 0;
+    return tamanho;
+}
+
+// Thread do servidor do teste do protocolo.
+static void *servirTeste(void *argumento)
+{
+    ServidorTeste *servidor = (ServidorTeste *)argumento;
+    servidor->resultado = servirDicionario(servidor->dicionario, servidor->caminho);
+    return NULL;
+}
+
+// Fala com o servidor por um socket Unix: os pedidos seguem todos de uma vez e as respostas vêm pela mesma ordem.
+static void testarServidor(void)
+{
+    ModeloPalavras modelo;
+    struct sockaddr_un endereco;
+    char caminho[sizeof(endereco.sun_path)];
+    unsigned char pedidos[1024], resposta[256], dados[64];
+    size_t usado = 0;
+    pthread_t thread;
+
+    Dicionario *dicionario = inicializarDicionario();
+    VERIFICAR(dicionario != NULL && gerarModelo(&modelo, PALAVRAS_TESTE / 4) && criarTemporario(caminho, sizeof(caminho)));
+    if (dicionario == NULL)
+        return;
+    preencherDicionario(dicionario, &modelo);
+    unlink(caminho);
+
+    ServidorTeste servidor = {dicionario, caminho, false};
+    VERIFICAR(pthread_create(&thread, NULL, servirTeste, &servidor) == 0);
+
+    // O servidor demora a criar o socket: tentar até ele aceitar a ligação.
+    memset(&endereco, 0, sizeof(endereco));
+    endereco.sun_family = AF_UNIX;
+    memcpy(endereco.sun_path, caminho, sizeof(caminho));
+    int ligacao = -1;
+    for (int espera = 0; espera < ESPERAS_TESTE && ligacao < 0; espera++)
+    {
+        ligacao = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (ligacao >= 0 && connect(ligacao, (struct sockaddr *)&endereco, sizeof(endereco)) != 0)
+        {
+            close(ligacao);
+            ligacao = -1;
+            usleep(10000);
+        }
+    }
+    VERIFICAR(ligacao >= 0);
+    if (ligacao < 0)
+    {
+        kill(getpid(), SIGTERM);
+        pthread_join(thread, NULL);
+        destruirDicionario(dicionario);
+        libertarModelo(&modelo);
+        return;
+    }
+
+    // Nenhuma palavra do modelo começa por "serv" (o gerador não usa o 'v').
+    usado += escreverPedido(pedidos + usado, OPERACAO_INSERIR, 1, "servidor", 8);
+    usado += escreverPedido(pedidos + usado, OPERACAO_INSERIR, 2, "servidor", 8);
+    usado += escreverPedido(pedidos + usado, OPERACAO_CONSULTAR, 3, "servidor", 8);
+    usado += escreverPedido(pedidos + usado, OPERACAO_CONSULTAR, 4, "servida", 7);
+    escreverU32Teste(dados, 40);
+    memcpy(dados + 4, "servidor", 8);
+    usado += escreverPedido(pedidos + usado, OPERACAO_INSERIR_COM_PESO, 5, dados, 12);
+    escreverU32Teste(dados, 90);
+    memcpy(dados + 4, "servir", 6);
+    usado += escreverPedido(pedidos + usado, OPERACAO_INSERIR_COM_PESO, 6, dados, 10);
+    usado += escreverPedido(pedidos + usado, OPERACAO_PREFIXO, 7, "\0\0serv", 6);
+    usado += escreverPedido(pedidos + usado, OPERACAO_AUTOCOMPLETAR, 8, "\1\0serv", 6);
+    usado += escreverPedido(pedidos + usado, OPERACAO_REMOVER, 9, "servidor", 8);
+    usado += escreverPedido(pedidos + usado, OPERACAO_CONSULTAR, 10, "servidor", 8);
+    usado += escreverPedido(pedidos + usado, 99, 11, "", 0);
+    usado += escreverPedido(pedidos + usado, OPERACAO_CONSULTAR, 12, "", 0);
+    usado += escreverPedido(pedidos + usado, OPERACAO_ENCERRAR, 13, "", 0);
+    VERIFICAR(write(ligacao, pedidos, usado) == (ssize_t)usado);
+
+    static const unsigned char respostasSimples[][2] = {{1, 1}, {2, 0}, {3, 1}, {4, 0}, {5, 0}, {6, 1}};
+    for (size_t i = 0; i < sizeof(respostasSimples) / sizeof(respostasSimples[0]); i++)
+    {
+        size_t tamanho = lerRespostaTeste(ligacao, respostasSimples[i][0], RESPOSTA_OK, resposta, sizeof(resposta));
+        VERIFICAR(tamanho == 1 && resposta[0] == respostasSimples[i][1]);
+    }
+
+    // Prefixo: as duas palavras pela ordem da Trie. Autocompletar: só a de maior peso.
+    size_t tamanho = lerRespostaTeste(ligacao, 7, RESPOSTA_OK, resposta, sizeof(resposta));
+    VERIFICAR(tamanho == 4 + 9 + 7 && lerU32Teste(resposta) == 2 && memcmp(resposta + 4, "\10servidor\6servir", 16) == 0);
+    tamanho = lerRespostaTeste(ligacao, 8, RESPOSTA_OK, resposta, sizeof(resposta));
+    VERIFICAR(tamanho == 4 + 4 + 7 && lerU32Teste(resposta) == 1 && lerU32Teste(resposta + 4) == 90 &&
+              memcmp(resposta + 8, "\6servir", 7) == 0);
+
+    tamanho = lerRespostaTeste(ligacao, 9, RESPOSTA_OK, resposta, sizeof(resposta));
+    VERIFICAR(tamanho == 1 && resposta[0] == 1);
+    tamanho = lerRespostaTeste(ligacao, 10, RESPOSTA_OK, resposta, sizeof(resposta));
+    VERIFICAR(tamanho == 1 && resposta[0] == 0);
+    lerRespostaTeste(ligacao, 11, RESPOSTA_OPERACAO_DESCONHECIDA, resposta, sizeof(resposta));
+    lerRespostaTeste(ligacao, 12, RESPOSTA_PEDIDO_INVALIDO, resposta, sizeof(resposta));
+    lerRespostaTeste(ligacao, 13, RESPOSTA_OK, resposta, sizeof(resposta));
+
+    close(ligacao);
+    pthread_join(thread, NULL);
+    VERIFICAR(servidor.resultado);
+
+    uint32_t peso = 0;
+    VERIFICAR(pesoPalavra(dicionario, "servir", &peso) && peso == 90 && !contemPalavra(dicionario, "servidor"));
+    removerPalavra(dicionario, "servir");
+    verificarPalavras(dicionario, &modelo);
+
+    destruirDicionario(dicionario);
+    libertarModelo(&modelo);
+}
+
+// ================================ PROGRAMA PRINCIPAL ==============================
+
+// Executa um teste e mostra o seu resultado.
+static void executarTeste(const char *nome, void (*teste)(void))
+{
+    falhasTeste = 0;
+    teste();
+    fprintf(resultados, "%-12s %s\n", nome, falhasTeste == 0 ? "ok" : "FALHOU");
+    if (falhasTeste > 10)
+        fprintf(resultados, "  (%zu verificações falhadas)\n", falhasTeste);
+    falhasTotal += falhasTeste;
+}
+
+int main(void)
+{
+    // A biblioteca escreve mensagens no stdout; os resultados dos testes ficam com ele e as mensagens são descartadas.
+    fflush(stdout);
+    resultados = fdopen(dup(STDOUT_FILENO), "w");
+    int nulo = open("/dev/null", O_WRONLY);
+    if (resultados == NULL || nulo < 0)
+    {
+        perror("Erro ao preparar a saída dos testes");
+        return 1;
+    }
+    dup2(nulo, STDOUT_FILENO);
+    close(nulo);
+
+    executarTeste("distancia", testarDistancia);
+    executarTeste("procura", testarProcuraDistancia);
+    executarTeste("sugestoes", testarCacheSugestoes);
+    executarTeste("cursor", testarCursor);
+    executarTeste("compactacao", testarCompactacao);
+    executarTeste("instantaneo", testarInstantaneo);
+    executarTeste("diario", testarDiario);
+    executarTeste("bloom", testarFiltroBloom);
+    executarTeste("dobrado", testarIndiceDobrado);
+    executarTeste("autocompleta", testarAutocompletar);
+    executarTeste("recarga", testarRecarga);
+    executarTeste("concorrencia", testarConcorrencia);
+    executarTeste("servidor", testarServidor);
+
+    fprintf(resultados, falhasTotal == 0 ? "Todos os testes passaram.\n" : "%zu verificações falharam.\n",
+            falhasTotal);
+    fclose(resultados);
+    return falhasTotal == 0 ? 0 : 1;
+}